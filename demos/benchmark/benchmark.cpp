@@ -0,0 +1,1203 @@
+/// @file
+/// @version 1.0
+///
+/// @section LICENSE
+///
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+///
+/// @section DESCRIPTION
+///
+/// Loopback benchmarks for the TCP, UDP and HTTP paths against in-process servers. Every result is printed to stdout as one JSON
+/// object per line so runs of different releases can be compared by scripts.
+///
+/// Usage: benchmark [sync|async|threaded] [seconds per benchmark] [name filter]
+///  - sync: blocking API calls, servers run in their own threads
+///  - async: delegate API, sakit::update() is pumped from the main thread
+///  - threaded: delegate API with sakit::init(true)
+/// The "udp_channel" benchmark runs two UdpChannels against each other in-process with simulated loss, latency and jitter and
+/// verifies that every reliable message arrives exactly once and in order.
+/// The "http_server" benchmark always runs HttpServer on its own I/O threads and drives it wrk-style with a fixed number of
+/// keep-alive connections, each on its own client thread with blocking calls.
+///
+/// Linux build example (next to the hltypes checkout, same layout as the other projects):
+///  g++ -std=c++11 -O2 -I../../include -I../../../hltypes/include benchmark.cpp -L<lib dir> -lsakit -lhltypes -lpthread -o benchmark
+
+#define LOG_TAG "benchmark"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <chrono>
+
+#include <hltypes/harray.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+#include <hltypes/hthread.h>
+
+#include <sakit/HttpResponse.h>
+#include <sakit/HttpServer.h>
+#include <sakit/HttpServerHandler.h>
+#include <sakit/HttpServerRequest.h>
+#include <sakit/HttpServerResponse.h>
+#include <sakit/HttpSocket.h>
+#include <sakit/HttpSocketDelegate.h>
+#include <sakit/LatencyHistogram.h>
+#include <sakit/MetricsSnapshot.h>
+#include <sakit/sakit.h>
+#include <sakit/Socket.h>
+#include <sakit/TcpServer.h>
+#include <sakit/TcpServerDelegate.h>
+#include <sakit/TcpSocket.h>
+#include <sakit/TcpSocketDelegate.h>
+#include <sakit/UdpChannel.h>
+#include <sakit/UdpChannelDelegate.h>
+#include <sakit/UdpServer.h>
+#include <sakit/UdpServerDelegate.h>
+#include <sakit/UdpSocket.h>
+#include <sakit/UdpSocketDelegate.h>
+#include <sakit/Url.h>
+
+#define BENCHMARK_HOST "127.0.0.1"
+#define TCP_PORT_THROUGHPUT 52000
+#define TCP_PORT_PING_PONG 52001
+#define TCP_PORT_CONNECT 52002
+#define TCP_PORT_HTTP 52003
+#define TCP_PORT_HTTP_SERVER 52004
+#define TCP_PORT_SMALL_MESSAGES 52005
+#define UDP_PORT_PPS 52100
+#define THROUGHPUT_CHUNK_SIZE 65536
+#define PING_PONG_SIZE 64
+#define SMALL_MESSAGE_SIZE 32
+#define SMALL_MESSAGES_PER_TICK 64
+#define DATAGRAM_SIZE 64
+#define UDP_CHANNEL_MESSAGE_SIZE 256
+#define UDP_CHANNEL_BACKLOG 64
+#define UDP_CHANNEL_LOSS 0.05f
+#define UDP_CHANNEL_LATENCY 0.01f
+#define UDP_CHANNEL_JITTER 0.002f
+#define HTTP_RESPONSE "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 13\r\n\r\nHello, world!"
+#define HTTP_SERVER_BODY "Hello, world!"
+#define HTTP_SERVER_THREADS 2
+#define HTTP_SERVER_CONNECTIONS 8
+
+static hstr mode = "sync";
+static float duration = 2.0f;
+static hstr filter = "";
+static std::atomic<bool> running(false);
+static std::atomic<int64_t> serverBytes(0);
+static std::atomic<int64_t> serverCount(0);
+static std::atomic<int64_t> clientBytes(0);
+static std::atomic<int64_t> clientCount(0);
+static sakit::LatencyHistogram latencies;
+static hmutex latenciesMutex;
+static sakit::TcpServer* tcpServer = NULL;
+static sakit::UdpServer* udpServer = NULL;
+
+static int64_t _now()
+{
+	return (int64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double _seconds(int64_t start)
+{
+	return (_now() - start) / 1000000.0;
+}
+
+static void _addLatency(int64_t value)
+{
+	hmutex::ScopeLock lock(&latenciesMutex);
+	latencies.add(value);
+}
+
+static void _reset()
+{
+	running = true;
+	serverBytes = 0;
+	serverCount = 0;
+	clientBytes = 0;
+	clientCount = 0;
+	hmutex::ScopeLock lock(&latenciesMutex);
+	latencies.clear();
+}
+
+static bool _isEnabled(chstr name)
+{
+	return (filter == "" || name.contains(filter));
+}
+
+static void _report(chstr name, chstr unit, double value, int64_t operations, double seconds)
+{
+	printf("{\"benchmark\":\"%s\",\"api\":\"%s\",\"value\":%.3f,\"unit\":\"%s\",\"operations\":%lld,\"seconds\":%.3f}\n",
+		name.cStr(), mode.cStr(), value, unit.cStr(), (long long)operations, seconds);
+	fflush(stdout);
+}
+
+static void _reportLatency(chstr name, double seconds)
+{
+	hmutex::ScopeLock lock(&latenciesMutex);
+	printf("{\"benchmark\":\"%s\",\"api\":\"%s\",\"value\":%lld,\"unit\":\"us\",\"operations\":%lld,\"seconds\":%.3f,\"mean\":%.1f,\"p90\":%lld,\"p99\":%lld,\"p999\":%lld,\"max\":%lld}\n",
+		name.cStr(), mode.cStr(), (long long)latencies.getPercentile(50.0), (long long)latencies.getCount(), seconds, latencies.getMean(),
+		(long long)latencies.getPercentile(90.0), (long long)latencies.getPercentile(99.0), (long long)latencies.getPercentile(99.9), (long long)latencies.getMax());
+	fflush(stdout);
+}
+
+/// @brief Lets the delegate API do its work, either by updating directly or by waiting for the update thread.
+static void _pump()
+{
+	if (mode == "threaded")
+	{
+		hthread::sleep(1.0f);
+	}
+	else
+	{
+		sakit::update();
+	}
+}
+
+static void _pumpFor(float seconds)
+{
+	int64_t start = _now();
+	while (_seconds(start) < seconds)
+	{
+		_pump();
+	}
+}
+
+static hstream* _makeStream(int size)
+{
+	hstream* stream = new hstream();
+	harray<unsigned char> data;
+	for_iter (i, 0, size)
+	{
+		data += (unsigned char)(i & 0xFF);
+	}
+	stream->writeRaw(&data[0], size);
+	stream->rewind();
+	return stream;
+}
+
+static sakit::TcpServer* _createTcpServer(sakit::TcpServerDelegate* serverDelegate, sakit::TcpSocketDelegate* acceptedDelegate, unsigned short port)
+{
+	sakit::TcpServer* server = new sakit::TcpServer(serverDelegate, acceptedDelegate);
+	if (!server->bind(sakit::Host(BENCHMARK_HOST), port))
+	{
+		hlog::errorf(LOG_TAG, "Could not bind TCP server to port %d!", port);
+		delete server;
+		return NULL;
+	}
+	return server;
+}
+
+static void _destroyTcpServer()
+{
+	if (tcpServer != NULL)
+	{
+		if (tcpServer->isRunning())
+		{
+			tcpServer->stopAsync();
+			while (tcpServer->isRunning())
+			{
+				_pump();
+			}
+		}
+		tcpServer->unbind();
+		delete tcpServer;
+		tcpServer = NULL;
+	}
+}
+
+/******* delegates *******************************************************************************************/
+
+class NullServerDelegate : public sakit::TcpServerDelegate
+{
+public:
+	void onAccepted(sakit::TcpServer* server, sakit::TcpSocket* socket)
+	{
+		++serverCount;
+	}
+
+} nullServerDelegate;
+
+class NullSocketDelegate : public sakit::TcpSocketDelegate
+{
+} nullSocketDelegate;
+
+/// @brief Accepted sockets start receiving immediately.
+class ReceivingServerDelegate : public sakit::TcpServerDelegate
+{
+public:
+	void onAccepted(sakit::TcpServer* server, sakit::TcpSocket* socket)
+	{
+		++serverCount;
+		socket->startReceiveAsync();
+	}
+
+} receivingServerDelegate;
+
+/// @brief Accepted sockets are closed right away.
+class ClosingServerDelegate : public sakit::TcpServerDelegate
+{
+public:
+	void onAccepted(sakit::TcpServer* server, sakit::TcpSocket* socket)
+	{
+		++serverCount;
+		socket->disconnect();
+	}
+
+} closingServerDelegate;
+
+class SinkSocketDelegate : public sakit::TcpSocketDelegate
+{
+public:
+	void onReceived(sakit::TcpSocket* socket, hstream* stream)
+	{
+		serverBytes += stream->size();
+	}
+
+} sinkSocketDelegate;
+
+class EchoSocketDelegate : public sakit::TcpSocketDelegate
+{
+public:
+	void onReceived(sakit::TcpSocket* socket, hstream* stream)
+	{
+		this->pending.writeRaw(*stream);
+		this->_flush(socket);
+	}
+
+	void onSendFinished(sakit::Socket* socket)
+	{
+		this->_flush((sakit::TcpSocket*)socket);
+	}
+
+protected:
+	hstream pending;
+
+	void _flush(sakit::TcpSocket* socket)
+	{
+		// the previous echo might still be finishing
+		if (this->pending.size() > 0 && !socket->isSending())
+		{
+			this->pending.rewind();
+			if (socket->sendAsync(&this->pending))
+			{
+				this->pending.clear();
+			}
+			else
+			{
+				this->pending.seek(0, hseek::End);
+			}
+		}
+	}
+
+} echoSocketDelegate;
+
+class HttpResponderDelegate : public sakit::TcpSocketDelegate
+{
+public:
+	void onReceived(sakit::TcpSocket* socket, hstream* stream)
+	{
+		hstr& request = this->requests[socket];
+		request += hstr((char*)&(*stream)[0], (int)stream->size());
+		if (request.contains("\r\n\r\n"))
+		{
+			this->requests.removeKey(socket);
+			socket->sendAsync(HTTP_RESPONSE);
+		}
+	}
+
+	void onSendFinished(sakit::Socket* socket)
+	{
+		// the client closes its side after every request since keep-alive is not used
+		((sakit::TcpSocket*)socket)->stopReceiveAsync();
+	}
+
+	void onReceiveFinished(sakit::Socket* socket)
+	{
+		++serverCount;
+		((sakit::TcpSocket*)socket)->disconnect();
+	}
+
+protected:
+	hmap<sakit::TcpSocket*, hstr> requests;
+
+} httpResponderDelegate;
+
+class ThroughputClientDelegate : public sakit::TcpSocketDelegate
+{
+public:
+	hstream* stream;
+
+	void onConnected(sakit::Connector* connector, sakit::Host remoteHost, unsigned short remotePort)
+	{
+		((sakit::TcpSocket*)connector)->sendAsync(this->stream);
+	}
+
+	void onSent(sakit::Socket* socket, int byteCount)
+	{
+		clientBytes += byteCount;
+	}
+
+	void onSendFinished(sakit::Socket* socket)
+	{
+		if (running)
+		{
+			this->stream->rewind();
+			socket->sendAsync(this->stream);
+		}
+	}
+
+} throughputClientDelegate;
+
+class PingPongClientDelegate : public sakit::TcpSocketDelegate
+{
+public:
+	hstream* stream;
+	int64_t sendTime;
+	int received;
+
+	void onConnected(sakit::Connector* connector, sakit::Host remoteHost, unsigned short remotePort)
+	{
+		sakit::TcpSocket* socket = (sakit::TcpSocket*)connector;
+		socket->startReceiveAsync();
+		this->_ping(socket);
+	}
+
+	void onReceived(sakit::TcpSocket* socket, hstream* stream)
+	{
+		this->received += (int)stream->size();
+		if (this->received >= PING_PONG_SIZE)
+		{
+			_addLatency(_now() - this->sendTime);
+			++clientCount;
+			if (running)
+			{
+				this->_ping(socket);
+			}
+		}
+	}
+
+	void onSendFinished(sakit::Socket* socket)
+	{
+		// a pong can arrive before the send was reported as finished
+		if (this->sendTime == 0 && running)
+		{
+			this->_ping((sakit::TcpSocket*)socket);
+		}
+	}
+
+protected:
+	void _ping(sakit::TcpSocket* socket)
+	{
+		this->received = 0;
+		this->stream->rewind();
+		this->sendTime = 0;
+		if (socket->sendAsync(this->stream))
+		{
+			this->sendTime = _now();
+		}
+	}
+
+} pingPongClientDelegate;
+
+class ConnectClientDelegate : public sakit::TcpSocketDelegate
+{
+public:
+	int64_t connectTime;
+
+	void onConnected(sakit::Connector* connector, sakit::Host remoteHost, unsigned short remotePort)
+	{
+		_addLatency(_now() - this->connectTime);
+		++clientCount;
+		connector->disconnectAsync();
+	}
+
+	void onDisconnected(sakit::Connector* connector, sakit::Host remoteHost, unsigned short remotePort)
+	{
+		if (running)
+		{
+			this->connectTime = _now();
+			connector->connectAsync(sakit::Host(BENCHMARK_HOST), TCP_PORT_CONNECT);
+		}
+	}
+
+	void onConnectFailed(sakit::Connector* connector, sakit::Host remoteHost, unsigned short remotePort)
+	{
+		hlog::error(LOG_TAG, "Connect failed!");
+		running = false;
+	}
+
+} connectClientDelegate;
+
+class UdpCountingServerDelegate : public sakit::UdpServerDelegate
+{
+public:
+	void onReceived(sakit::UdpServer* server, sakit::Host remoteHost, unsigned short remotePort, hstream* stream)
+	{
+		++serverCount;
+		serverBytes += stream->size();
+	}
+
+} udpCountingServerDelegate;
+
+class UdpClientDelegate : public sakit::UdpSocketDelegate
+{
+public:
+	hstream* stream;
+
+	void onSendFinished(sakit::Socket* socket)
+	{
+		++clientCount;
+		if (running)
+		{
+			this->stream->rewind();
+			socket->sendAsync(this->stream);
+		}
+	}
+
+} udpClientDelegate;
+
+/// @brief Datagrams are passed straight to the other channel, the simulated network of the sending channel sits in between.
+class UdpChannelPeerDelegate : public sakit::UdpChannelDelegate
+{
+public:
+	sakit::UdpChannel* peer;
+	int64_t expected;
+	bool failed;
+
+	UdpChannelPeerDelegate() : peer(NULL), expected(0), failed(false)
+	{
+	}
+
+	void onSendDatagram(sakit::UdpChannel* channel, hstream* stream)
+	{
+		this->peer->processDatagram(stream);
+	}
+
+	void onReceived(sakit::UdpChannel* channel, hstream* stream, sakit::Delivery delivery, int lane)
+	{
+		int64_t index = -1;
+		stream->readRaw(&index, sizeof(index));
+		if (index != this->expected)
+		{
+			hlog::errorf(LOG_TAG, "UDP channel message %lld arrived, expected %lld!", (long long)index, (long long)this->expected);
+			this->failed = true;
+			return;
+		}
+		++this->expected;
+		++serverCount;
+		serverBytes += stream->size();
+	}
+
+	void onFailed(sakit::UdpChannel* channel)
+	{
+		hlog::error(LOG_TAG, "UDP channel failed!");
+		this->failed = true;
+	}
+
+};
+
+class HelloHandler : public sakit::HttpServerHandler
+{
+public:
+	void onRequest(sakit::HttpServer* server, sakit::HttpServerRequest* request, sakit::HttpServerResponse* response)
+	{
+		response->headers["Content-Type"] = "text/plain";
+		response->setBody(HTTP_SERVER_BODY);
+		++serverCount;
+	}
+
+} helloHandler;
+
+class HttpClientDelegate : public sakit::HttpSocketDelegate
+{
+public:
+	sakit::Url url;
+	int64_t requestTime;
+
+	void onExecuteCompleted(sakit::HttpSocket* socket, sakit::HttpResponse* response, sakit::Url url)
+	{
+		if (response->statusCode == sakit::HttpResponse::Code::Ok)
+		{
+			_addLatency(_now() - this->requestTime);
+			++clientCount;
+		}
+		this->execute(socket);
+	}
+
+	void onExecuteFailed(sakit::HttpSocket* socket, sakit::HttpResponse* response, sakit::Url url)
+	{
+		hlog::error(LOG_TAG, "HTTP request failed!");
+		running = false;
+	}
+
+	void execute(sakit::HttpSocket* socket)
+	{
+		if (running)
+		{
+			this->requestTime = _now();
+			socket->executeGetAsync(this->url);
+		}
+	}
+
+} httpClientDelegate;
+
+/******* sync servers ****************************************************************************************/
+
+static sakit::TcpSocket* _acceptSync()
+{
+	sakit::TcpSocket* socket = NULL;
+	while (running && socket == NULL)
+	{
+		socket = tcpServer->accept();
+	}
+	if (socket != NULL)
+	{
+		socket->setTimeout(0.1f, 0.0001f);
+	}
+	return socket;
+}
+
+static void _syncSinkServer(hthread* thread)
+{
+	sakit::TcpSocket* socket = _acceptSync();
+	hstream stream(THROUGHPUT_CHUNK_SIZE);
+	while (running && socket != NULL)
+	{
+		serverBytes += socket->receive(&stream);
+		stream.clear(THROUGHPUT_CHUNK_SIZE);
+	}
+}
+
+static void _syncEchoServer(hthread* thread)
+{
+	sakit::TcpSocket* socket = _acceptSync();
+	hstream stream;
+	while (running && socket != NULL)
+	{
+		if (socket->receive(&stream, PING_PONG_SIZE) > 0)
+		{
+			stream.rewind();
+			socket->send(&stream);
+			stream.clear();
+		}
+	}
+}
+
+static void _syncAcceptServer(hthread* thread)
+{
+	sakit::TcpSocket* socket = NULL;
+	while (running)
+	{
+		socket = tcpServer->accept();
+		if (socket != NULL)
+		{
+			++serverCount;
+			socket->disconnect();
+			tcpServer->getSockets(); // deletes disconnected sockets
+		}
+	}
+}
+
+static void _syncHttpServer(hthread* thread)
+{
+	sakit::TcpSocket* socket = NULL;
+	hstr request;
+	while (running)
+	{
+		socket = tcpServer->accept();
+		if (socket == NULL)
+		{
+			continue;
+		}
+		socket->setTimeout(0.1f, 0.0001f);
+		request = "";
+		while (running && !request.contains("\r\n\r\n"))
+		{
+			request += socket->receive();
+		}
+		if (running)
+		{
+			socket->send(HTTP_RESPONSE);
+			++serverCount;
+		}
+		socket->disconnect();
+		tcpServer->getSockets(); // deletes disconnected sockets
+	}
+}
+
+/// @brief One keep-alive connection that sends the next request as soon as the previous response arrived.
+static void _httpServerClient(hthread* thread)
+{
+	sakit::TcpSocket* client = new sakit::TcpSocket(&nullSocketDelegate);
+	if (!client->connect(sakit::Host(BENCHMARK_HOST), TCP_PORT_HTTP_SERVER))
+	{
+		hlog::error(LOG_TAG, "Could not connect to HTTP server!");
+		delete client;
+		return;
+	}
+	hstr request = hsprintf("GET /hello HTTP/1.1\r\nHost: %s:%d\r\n\r\n", BENCHMARK_HOST, TCP_PORT_HTTP_SERVER);
+	hstr response;
+	int64_t time = 0;
+	while (running)
+	{
+		time = _now();
+		if (client->send(request) != request.size())
+		{
+			hlog::error(LOG_TAG, "HTTP server request failed!");
+			break;
+		}
+		response = "";
+		while (running && !response.endsWith(HTTP_SERVER_BODY))
+		{
+			response += client->receive();
+		}
+		if (response.startsWith("HTTP/1.1 200") && response.endsWith(HTTP_SERVER_BODY))
+		{
+			_addLatency(_now() - time);
+			++clientCount;
+		}
+	}
+	client->disconnect();
+	delete client;
+}
+
+static void _syncUdpServer(hthread* thread)
+{
+	hstream stream;
+	sakit::Host host;
+	unsigned short port = 0;
+	while (running)
+	{
+		stream.clear();
+		udpServer->receive(&stream, host, port);
+		if (stream.size() > 0)
+		{
+			++serverCount;
+			serverBytes += stream.size();
+		}
+	}
+}
+
+/******* benchmarks ******************************************************************************************/
+
+static void _benchTcpThroughput()
+{
+	_reset();
+	bool async = (mode != "sync");
+	tcpServer = _createTcpServer(&receivingServerDelegate, &sinkSocketDelegate, TCP_PORT_THROUGHPUT);
+	if (tcpServer == NULL)
+	{
+		return;
+	}
+	hstream* stream = _makeStream(THROUGHPUT_CHUNK_SIZE);
+	sakit::TcpSocket* client = NULL;
+	hthread thread(&_syncSinkServer, "benchmark server");
+	int64_t start = _now();
+	if (!async)
+	{
+		thread.start();
+		client = new sakit::TcpSocket(&nullSocketDelegate);
+		if (client->connect(sakit::Host(BENCHMARK_HOST), TCP_PORT_THROUGHPUT))
+		{
+			start = _now();
+			while (_seconds(start) < duration)
+			{
+				stream->rewind();
+				clientBytes += client->send(stream);
+			}
+		}
+	}
+	else
+	{
+		tcpServer->startAsync();
+		throughputClientDelegate.stream = stream;
+		client = new sakit::TcpSocket(&throughputClientDelegate);
+		client->connectAsync(sakit::Host(BENCHMARK_HOST), TCP_PORT_THROUGHPUT);
+		_pumpFor(duration);
+	}
+	double seconds = _seconds(start);
+	running = false;
+	if (!async)
+	{
+		thread.join();
+	}
+	else
+	{
+		// let the last chunk finish so the client can be deleted safely
+		_pumpFor(0.1f);
+	}
+	int64_t received = serverBytes;
+	_report("tcp_throughput", "MB/s", received / seconds / 1048576.0, received, seconds);
+	delete client;
+	_destroyTcpServer();
+	delete stream;
+}
+
+static void _benchTcpPingPong()
+{
+	_reset();
+	bool async = (mode != "sync");
+	tcpServer = _createTcpServer(&receivingServerDelegate, &echoSocketDelegate, TCP_PORT_PING_PONG);
+	if (tcpServer == NULL)
+	{
+		return;
+	}
+	hstream* stream = _makeStream(PING_PONG_SIZE);
+	sakit::TcpSocket* client = NULL;
+	hthread thread(&_syncEchoServer, "benchmark server");
+	int64_t start = _now();
+	if (!async)
+	{
+		thread.start();
+		client = new sakit::TcpSocket(&nullSocketDelegate);
+		client->setTimeout(1.0f, 0.0001f);
+		if (client->connect(sakit::Host(BENCHMARK_HOST), TCP_PORT_PING_PONG))
+		{
+			hstream reply;
+			int64_t time = 0;
+			start = _now();
+			while (_seconds(start) < duration)
+			{
+				time = _now();
+				stream->rewind();
+				client->send(stream);
+				reply.clear();
+				if (client->receive(&reply, PING_PONG_SIZE) == PING_PONG_SIZE)
+				{
+					_addLatency(_now() - time);
+					++clientCount;
+				}
+			}
+		}
+	}
+	else
+	{
+		tcpServer->startAsync();
+		pingPongClientDelegate.stream = stream;
+		client = new sakit::TcpSocket(&pingPongClientDelegate);
+		client->connectAsync(sakit::Host(BENCHMARK_HOST), TCP_PORT_PING_PONG);
+		_pumpFor(duration);
+	}
+	double seconds = _seconds(start);
+	running = false;
+	if (!async)
+	{
+		thread.join();
+	}
+	else
+	{
+		_pumpFor(0.1f);
+		client->stopReceive();
+	}
+	_report("tcp_ping_pong", "round-trips/s", clientCount / seconds, clientCount, seconds);
+	_reportLatency("tcp_ping_pong_latency", seconds);
+	delete client;
+	_destroyTcpServer();
+	delete stream;
+}
+
+/// @brief Sends many tiny messages per tick like a game server, either one system call each or gathered in a batch per tick.
+static void _benchTcpSmallMessages(bool batched)
+{
+	_reset();
+	hstr name = (batched ? "tcp_small_messages_batched" : "tcp_small_messages");
+	tcpServer = _createTcpServer(&receivingServerDelegate, &sinkSocketDelegate, TCP_PORT_SMALL_MESSAGES);
+	if (tcpServer == NULL)
+	{
+		return;
+	}
+	hstream* stream = _makeStream(SMALL_MESSAGE_SIZE);
+	hthread thread(&_syncSinkServer, "benchmark server");
+	thread.start();
+	sakit::TcpSocket* client = new sakit::TcpSocket(&nullSocketDelegate);
+	int64_t start = _now();
+	if (client->connect(sakit::Host(BENCHMARK_HOST), TCP_PORT_SMALL_MESSAGES))
+	{
+		start = _now();
+		while (_seconds(start) < duration)
+		{
+			// a producer has to pace itself when the network can't keep up
+			while (client->getSendQueueSize() > THROUGHPUT_CHUNK_SIZE)
+			{
+				hthread::sleep(0.1f);
+			}
+			if (batched)
+			{
+				client->beginBatch();
+			}
+			for_iter (i, 0, SMALL_MESSAGES_PER_TICK)
+			{
+				stream->rewind();
+				// only asynchronous sends are batched
+				if (batched)
+				{
+					client->sendAsync(stream);
+				}
+				else
+				{
+					client->send(stream);
+				}
+			}
+			if (batched)
+			{
+				client->flushBatch();
+			}
+		}
+		while (client->getSendQueueSize() > 0)
+		{
+			hthread::sleep(1.0f);
+		}
+	}
+	double seconds = _seconds(start);
+	// give the server a moment to read the rest
+	hthread::sleep(100.0f);
+	running = false;
+	thread.join();
+	int64_t messages = serverBytes / SMALL_MESSAGE_SIZE;
+	_report(name, "messages/s", messages / seconds, messages, seconds);
+	sakit::MetricsSnapshot metrics = client->getMetrics();
+	_report(name + "_send_calls", "calls/message", (messages > 0 ? metrics.sendCalls / (double)messages : 0.0), metrics.sendCalls, seconds);
+	delete client;
+	_destroyTcpServer();
+	delete stream;
+}
+
+static void _benchConnectRate()
+{
+	_reset();
+	bool async = (mode != "sync");
+	tcpServer = _createTcpServer(&closingServerDelegate, &nullSocketDelegate, TCP_PORT_CONNECT);
+	if (tcpServer == NULL)
+	{
+		return;
+	}
+	sakit::TcpSocket* client = NULL;
+	hthread thread(&_syncAcceptServer, "benchmark server");
+	int64_t start = _now();
+	if (!async)
+	{
+		thread.start();
+		int64_t time = 0;
+		while (_seconds(start) < duration)
+		{
+			client = new sakit::TcpSocket(&nullSocketDelegate);
+			time = _now();
+			if (!client->connect(sakit::Host(BENCHMARK_HOST), TCP_PORT_CONNECT))
+			{
+				delete client;
+				break;
+			}
+			_addLatency(_now() - time);
+			++clientCount;
+			client->disconnect();
+			delete client;
+		}
+		client = NULL;
+	}
+	else
+	{
+		tcpServer->startAsync();
+		client = new sakit::TcpSocket(&connectClientDelegate);
+		connectClientDelegate.connectTime = _now();
+		client->connectAsync(sakit::Host(BENCHMARK_HOST), TCP_PORT_CONNECT);
+		while (running && _seconds(start) < duration)
+		{
+			_pump();
+		}
+	}
+	double seconds = _seconds(start);
+	running = false;
+	if (!async)
+	{
+		thread.join();
+	}
+	else
+	{
+		_pumpFor(0.1f);
+	}
+	_report("tcp_connect_rate", "connects/s", clientCount / seconds, clientCount, seconds);
+	_reportLatency("tcp_connect_latency", seconds);
+	_report("tcp_accept_rate", "accepts/s", serverCount / seconds, serverCount, seconds);
+	if (client != NULL)
+	{
+		delete client;
+	}
+	_destroyTcpServer();
+}
+
+static void _benchUdp()
+{
+	_reset();
+	bool async = (mode != "sync");
+	udpServer = new sakit::UdpServer(&udpCountingServerDelegate);
+	if (!udpServer->bind(sakit::Host(BENCHMARK_HOST), UDP_PORT_PPS))
+	{
+		hlog::errorf(LOG_TAG, "Could not bind UDP server to port %d!", UDP_PORT_PPS);
+		delete udpServer;
+		udpServer = NULL;
+		return;
+	}
+	udpServer->setTimeout(0.1f, 0.0001f);
+	hstream* stream = _makeStream(DATAGRAM_SIZE);
+	sakit::UdpSocket* client = NULL;
+	hthread thread(&_syncUdpServer, "benchmark server");
+	int64_t start = _now();
+	if (!async)
+	{
+		thread.start();
+		client = new sakit::UdpSocket(&udpClientDelegate);
+		if (client->setDestination(sakit::Host(BENCHMARK_HOST), UDP_PORT_PPS))
+		{
+			start = _now();
+			while (_seconds(start) < duration)
+			{
+				stream->rewind();
+				if (client->send(stream) > 0)
+				{
+					++clientCount;
+				}
+			}
+		}
+	}
+	else
+	{
+		udpServer->startAsync();
+		udpClientDelegate.stream = stream;
+		client = new sakit::UdpSocket(&udpClientDelegate);
+		if (client->setDestination(sakit::Host(BENCHMARK_HOST), UDP_PORT_PPS))
+		{
+			client->sendAsync(stream);
+			_pumpFor(duration);
+		}
+	}
+	double seconds = _seconds(start);
+	running = false;
+	if (!async)
+	{
+		thread.join();
+	}
+	else
+	{
+		_pumpFor(0.1f);
+		udpServer->stopAsync();
+		while (udpServer->isRunning())
+		{
+			_pump();
+		}
+	}
+	_report("udp_pps_sent", "datagrams/s", clientCount / seconds, clientCount, seconds);
+	_report("udp_pps_received", "datagrams/s", serverCount / seconds, serverCount, seconds);
+	delete client;
+	udpServer->unbind();
+	delete udpServer;
+	udpServer = NULL;
+	delete stream;
+}
+
+static void _benchUdpChannel()
+{
+	_reset();
+	UdpChannelPeerDelegate clientDelegate;
+	UdpChannelPeerDelegate serverDelegate;
+	sakit::UdpChannel client(&clientDelegate);
+	sakit::UdpChannel server(&serverDelegate);
+	clientDelegate.peer = &server;
+	serverDelegate.peer = &client;
+	client.setSimulatedLoss(UDP_CHANNEL_LOSS);
+	client.setSimulatedLatency(UDP_CHANNEL_LATENCY);
+	client.setSimulatedJitter(UDP_CHANNEL_JITTER);
+	server.setSimulatedLoss(UDP_CHANNEL_LOSS);
+	server.setSimulatedLatency(UDP_CHANNEL_LATENCY);
+	server.setSimulatedJitter(UDP_CHANNEL_JITTER);
+	hstream* stream = _makeStream(UDP_CHANNEL_MESSAGE_SIZE);
+	int64_t index = 0;
+	int64_t start = _now();
+	while (_seconds(start) < duration && !clientDelegate.failed && !serverDelegate.failed)
+	{
+		while (client.getQueuedCount() < UDP_CHANNEL_BACKLOG)
+		{
+			stream->rewind();
+			stream->writeRaw(&index, sizeof(index));
+			stream->rewind();
+			client.send(stream);
+			++index;
+			++clientCount;
+		}
+		client.update();
+		server.update();
+		hthread::sleep(0.1f);
+	}
+	double seconds = _seconds(start);
+	_report("udp_channel_reliable", "messages/s", serverCount / seconds, serverCount, seconds);
+	_report("udp_channel_goodput", "MB/s", serverBytes / seconds / 1048576.0, serverBytes, seconds);
+	_report("udp_channel_retransmits", "retransmits/s", client.getRetransmitCount() / seconds, client.getRetransmitCount(), seconds);
+	delete stream;
+}
+
+static void _benchHttp()
+{
+	_reset();
+	bool async = (mode != "sync");
+	tcpServer = _createTcpServer(&receivingServerDelegate, &httpResponderDelegate, TCP_PORT_HTTP);
+	if (tcpServer == NULL)
+	{
+		return;
+	}
+	sakit::Url url(hsprintf("http://%s:%d/benchmark", BENCHMARK_HOST, TCP_PORT_HTTP));
+	sakit::HttpSocket* client = new sakit::HttpSocket(&httpClientDelegate);
+	hthread thread(&_syncHttpServer, "benchmark server");
+	int64_t start = _now();
+	if (!async)
+	{
+		thread.start();
+		sakit::HttpResponse response;
+		int64_t time = 0;
+		while (_seconds(start) < duration)
+		{
+			time = _now();
+			if (!client->executeGet(&response, url))
+			{
+				hlog::error(LOG_TAG, "HTTP request failed!");
+				break;
+			}
+			if (response.statusCode == sakit::HttpResponse::Code::Ok)
+			{
+				_addLatency(_now() - time);
+				++clientCount;
+			}
+		}
+	}
+	else
+	{
+		tcpServer->startAsync();
+		httpClientDelegate.url = url;
+		httpClientDelegate.execute(client);
+		while (running && _seconds(start) < duration)
+		{
+			_pump();
+		}
+	}
+	double seconds = _seconds(start);
+	running = false;
+	if (!async)
+	{
+		thread.join();
+	}
+	else
+	{
+		while (client->isExecuting())
+		{
+			_pump();
+		}
+		_pumpFor(0.1f);
+	}
+	_report("http_requests", "requests/s", clientCount / seconds, clientCount, seconds);
+	_reportLatency("http_request_latency", seconds);
+	delete client;
+	_destroyTcpServer();
+}
+
+static void _benchHttpServer()
+{
+	_reset();
+	sakit::HttpServer* server = new sakit::HttpServer(&receivingServerDelegate, HTTP_SERVER_THREADS);
+	server->addRoute("GET", "/hello", &helloHandler);
+	if (!server->bind(sakit::Host(BENCHMARK_HOST), TCP_PORT_HTTP_SERVER))
+	{
+		hlog::errorf(LOG_TAG, "Could not bind HTTP server to port %d!", TCP_PORT_HTTP_SERVER);
+		delete server;
+		return;
+	}
+	tcpServer = server;
+	tcpServer->startAsync();
+	harray<hthread*> threads;
+	for_iter (i, 0, HTTP_SERVER_CONNECTIONS)
+	{
+		threads += new hthread(&_httpServerClient, "benchmark client");
+	}
+	int64_t start = _now();
+	foreach (hthread*, it, threads)
+	{
+		(*it)->start();
+	}
+	while (_seconds(start) < duration)
+	{
+		_pump();
+	}
+	double seconds = _seconds(start);
+	running = false;
+	foreach (hthread*, it, threads)
+	{
+		(*it)->join();
+		delete (*it);
+	}
+	_report("http_server_requests", "requests/s", clientCount / seconds, clientCount, seconds);
+	_reportLatency("http_server_request_latency", seconds);
+	_destroyTcpServer();
+}
+
+int main(int argc, char** argv)
+{
+	if (argc > 1)
+	{
+		mode = argv[1];
+	}
+	if (mode != "sync" && mode != "async" && mode != "threaded")
+	{
+		printf("Usage: %s [sync|async|threaded] [seconds] [filter]\n", argv[0]);
+		return 1;
+	}
+	if (argc > 2)
+	{
+		duration = (float)atof(argv[2]);
+	}
+	if (argc > 3)
+	{
+		filter = argv[3];
+	}
+	hlog::setLevelWrite(false);
+	sakit::init(mode == "threaded");
+	// short polling intervals, otherwise the retry frequency dominates every measurement
+	sakit::setGlobalTimeout(1.0f, 0.0001f);
+	if (_isEnabled("tcp_throughput"))
+	{
+		_benchTcpThroughput();
+	}
+	if (_isEnabled("tcp_ping_pong"))
+	{
+		_benchTcpPingPong();
+	}
+	if (_isEnabled("tcp_small_messages"))
+	{
+		_benchTcpSmallMessages(false);
+		_benchTcpSmallMessages(true);
+	}
+	if (_isEnabled("tcp_connect"))
+	{
+		_benchConnectRate();
+	}
+	if (_isEnabled("udp"))
+	{
+		_benchUdp();
+	}
+	if (_isEnabled("udp_channel"))
+	{
+		_benchUdpChannel();
+	}
+	if (_isEnabled("http"))
+	{
+		_benchHttp();
+	}
+	if (_isEnabled("http_server"))
+	{
+		_benchHttpServer();
+	}
+	hlog::setLevelWrite(true);
+	hlog::write(LOG_TAG, "Global metrics:\n" + sakit::getGlobalMetrics().toString());
+	sakit::destroy();
+	return 0;
+}
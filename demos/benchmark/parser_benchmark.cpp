@@ -0,0 +1,239 @@
+/// @file
+/// @version 1.0
+///
+/// @section LICENSE
+///
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+///
+/// @section DESCRIPTION
+///
+/// Micro-benchmark for HttpResponse::parseFromRaw() and Url::set(). Every response sample is parsed in one piece for timing and
+/// then fed split at every possible byte boundary and byte by byte, verifying that the result is always identical to the one piece
+/// result. Response parsing is repeated with every DelimiterScanner implementation available on the CPU, "scalar" being the
+/// reference. Every result is printed to stdout as one JSON object per line, a non-zero exit code means that verification failed.
+///
+/// Usage: parser_benchmark [iterations]
+///
+/// Linux build example (next to the hltypes checkout, same layout as the other projects):
+///  g++ -std=c++11 -O2 -I../../include -I../../../hltypes/include parser_benchmark.cpp -L<lib dir> -lsakit -lhltypes -lpthread -o parser_benchmark
+
+#define LOG_TAG "parser_benchmark"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <new>
+
+#include <hltypes/hlog.h>
+#include <hltypes/hstring.h>
+
+#include <sakit/DelimiterScanner.h>
+#include <sakit/HttpResponse.h>
+#include <sakit/sakit.h>
+#include <sakit/Url.h>
+
+#include "parser_samples.h"
+
+#define MAX_FULL_SPLIT_SIZE 2048
+
+static std::atomic<int64_t> allocations(0);
+
+// every heap allocation in the process is counted, including the ones done by hltypes containers
+void* operator new(size_t size)
+{
+	++allocations;
+	void* result = malloc(size > 0 ? size : 1);
+	if (result == NULL)
+	{
+		throw std::bad_alloc();
+	}
+	return result;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	free(pointer);
+}
+
+static int64_t _now()
+{
+	return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void _report(chstr benchmark, chstr sample, double nsPerByte, double nsPerOperation, double allocationsPerOperation, int bytes)
+{
+	printf("{\"benchmark\":\"%s\",\"sample\":\"%s\",\"scanner\":\"%s\",\"bytes\":%d,\"ns_per_byte\":%.3f,\"ns_per_operation\":%.1f,\"allocations\":%.1f}\n",
+		benchmark.cStr(), sample.cStr(), sakit::DelimiterScanner::getImplementation().cStr(), bytes, nsPerByte, nsPerOperation, allocationsPerOperation);
+	fflush(stdout);
+}
+
+static void _reportMismatch(chstr sample, int firstSize, int chunkSize, chstr expected, chstr actual)
+{
+	printf("{\"benchmark\":\"http_response_split\",\"sample\":\"%s\",\"scanner\":\"%s\",\"error\":\"mismatch\",\"first\":%d,\"chunk\":%d}\n",
+		sample.cStr(), sakit::DelimiterScanner::getImplementation().cStr(), firstSize, chunkSize);
+	hlog::error(LOG_TAG, "Expected:\n" + expected + "\nActual:\n" + actual);
+	fflush(stdout);
+}
+
+/// @brief Many long headers, stresses the line and colon scanning.
+static hstr _makeLargeHeaderResponse()
+{
+	harray<hstr> lines;
+	lines += "HTTP/1.1 200 OK";
+	for_iter (i, 0, 200)
+	{
+		lines += hsprintf("X-Large-Header-%03d: %s", i, hstr('v', 64 + i % 32).cStr());
+	}
+	lines += "Content-Length: 2";
+	lines += "";
+	lines += "ok";
+	return lines.joined("\r\n");
+}
+
+/// @brief Many tiny chunks, stresses the chunk size line scanning.
+static hstr _makeSmallChunksResponse()
+{
+	harray<hstr> chunks;
+	chunks += "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n";
+	for_iter (i, 0, 2000)
+	{
+		chunks += hsprintf("%x\r\n%s\r\n", i % 8 + 1, hstr('c', i % 8 + 1).cStr());
+	}
+	chunks += "0\r\n\r\n";
+	return chunks.joined("");
+}
+
+static int _benchResponse(const ParserSample& sample, int iterations, chstr expected)
+{
+	const unsigned char* data = (const unsigned char*)sample.data;
+	int size = (int)strlen(sample.data);
+	sakit::HttpResponse response;
+	// one piece
+	int64_t allocationsStart = allocations;
+	int64_t start = _now();
+	for_iter (i, 0, iterations)
+	{
+		_parseResponse(&response, data, size, size, size);
+	}
+	double time = (double)(_now() - start);
+	double allocationCount = (double)(allocations - allocationsStart) / iterations;
+	_report("http_response", sample.name, time / iterations / size, time / iterations, allocationCount, size);
+	// byte by byte, the worst case for incremental parsing
+	allocationsStart = allocations;
+	start = _now();
+	for_iter (i, 0, iterations)
+	{
+		_parseResponse(&response, data, size, 1, 1);
+	}
+	time = (double)(_now() - start);
+	allocationCount = (double)(allocations - allocationsStart) / iterations;
+	_report("http_response_bytewise", sample.name, time / iterations / size, time / iterations, allocationCount, size);
+	// correctness of every possible split, large samples are only checked at a limited number of positions
+	int failed = 0;
+	hstr actual;
+	int step = hmax(size / MAX_FULL_SPLIT_SIZE, 1);
+	for (int i = 0; i <= size; i += step)
+	{
+		_parseResponse(&response, data, size, i, size);
+		actual = _describeResponse(response);
+		if (actual != expected)
+		{
+			_reportMismatch(sample.name, i, size, expected, actual);
+			++failed;
+		}
+	}
+	_parseResponse(&response, data, size, 1, 1);
+	actual = _describeResponse(response);
+	if (actual != expected)
+	{
+		_reportMismatch(sample.name, 1, 1, expected, actual);
+		++failed;
+	}
+	return failed;
+}
+
+static void _benchUrl(const ParserSample& sample, int iterations)
+{
+	hstr string = sample.data;
+	sakit::Url url;
+	int64_t allocationsStart = allocations;
+	int64_t start = _now();
+	for_iter (i, 0, iterations)
+	{
+		url.set(string);
+	}
+	double time = (double)(_now() - start);
+	double allocationCount = (double)(allocations - allocationsStart) / iterations;
+	_report("url_set", sample.name, time / iterations / string.size(), time / iterations, allocationCount, string.size());
+	allocationsStart = allocations;
+	start = _now();
+	for_iter (i, 0, iterations)
+	{
+		string = url.toString();
+	}
+	time = (double)(_now() - start);
+	allocationCount = (double)(allocations - allocationsStart) / iterations;
+	_report("url_to_string", sample.name, time / iterations / string.size(), time / iterations, allocationCount, string.size());
+}
+
+int main(int argc, char** argv)
+{
+	int iterations = 10000;
+	if (argc > 1)
+	{
+		iterations = hmax(atoi(argv[1]), 1);
+	}
+	hlog::setLevelWrite(false);
+	hlog::setLevelWarn(false);
+	sakit::init();
+	hstr largeHeader = _makeLargeHeaderResponse();
+	hstr smallChunks = _makeSmallChunksResponse();
+	harray<ParserSample> samples;
+	for_iter (i, 0, RESPONSE_SAMPLE_COUNT)
+	{
+		samples += responseSamples[i];
+	}
+	ParserSample sample = { "synthetic_large_headers", largeHeader.cStr() };
+	samples += sample;
+	sample.name = "synthetic_small_chunks";
+	sample.data = smallChunks.cStr();
+	samples += sample;
+	// the expected results always come from the scalar implementation
+	harray<hstr> expected;
+	sakit::HttpResponse response;
+	sakit::DelimiterScanner::setImplementation("scalar");
+	foreach (ParserSample, it, samples)
+	{
+		_parseResponse(&response, (const unsigned char*)(*it).data, (int)strlen((*it).data), (int)strlen((*it).data), (int)strlen((*it).data));
+		expected += _describeResponse(response);
+	}
+	int failed = 0;
+	harray<hstr> implementations = sakit::DelimiterScanner::getAvailableImplementations();
+	foreach (hstr, it, implementations)
+	{
+		sakit::DelimiterScanner::setImplementation(*it);
+		for_iter (i, 0, samples.size())
+		{
+			failed += _benchResponse(samples[i], iterations, expected[i]);
+		}
+	}
+	for_iter (i, 0, URL_SAMPLE_COUNT)
+	{
+		_benchUrl(urlSamples[i], iterations);
+	}
+	sakit::destroy();
+	return (failed == 0 ? 0 : 1);
+}
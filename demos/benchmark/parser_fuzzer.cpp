@@ -0,0 +1,68 @@
+/// @file
+/// @version 1.0
+///
+/// @section LICENSE
+///
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+///
+/// @section DESCRIPTION
+///
+/// libFuzzer target for HttpResponse::parseFromRaw() and Url::set(). The first two bytes of the input select how the rest is split
+/// before it is fed into the response parser, the result has to be identical to parsing the data in one piece. The same data is
+/// then used as a URL which must not crash and must stay valid when parsed again from its own string representation.
+///
+/// Linux build example (the library should be built with -fsanitize=fuzzer-no-link,address as well):
+///  clang++ -std=c++11 -g -O1 -fsanitize=fuzzer,address -I../../include -I../../../hltypes/include parser_fuzzer.cpp -L<lib dir> -lsakit -lhltypes -lpthread -o parser_fuzzer
+/// The responses from parser_samples.h make a good starting corpus.
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <hltypes/hlog.h>
+#include <hltypes/hstring.h>
+
+#include <sakit/HttpResponse.h>
+#include <sakit/sakit.h>
+#include <sakit/Url.h>
+
+#include "parser_samples.h"
+
+static bool initialized = false;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	if (!initialized)
+	{
+		hlog::setLevelWrite(false);
+		hlog::setLevelWarn(false);
+		sakit::init();
+		initialized = true;
+	}
+	if (size < 2 || size > 65536)
+	{
+		return 0;
+	}
+	int firstSize = (int)data[0];
+	int chunkSize = (int)data[1] + 1;
+	data += 2;
+	int dataSize = (int)size - 2;
+	sakit::HttpResponse response;
+	_parseResponse(&response, data, dataSize, dataSize, dataSize);
+	hstr expected = _describeResponse(response);
+	_parseResponse(&response, data, dataSize, firstSize, chunkSize);
+	if (_describeResponse(response) != expected)
+	{
+		abort();
+	}
+	hstr string((const char*)data, dataSize);
+	if (string != "")
+	{
+		sakit::Url url(string);
+		if (url.isValid() && !sakit::Url(url.toString()).isValid())
+		{
+			abort();
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,152 @@
+/// @file
+/// @version 1.0
+///
+/// @section LICENSE
+///
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+///
+/// @section DESCRIPTION
+///
+/// Recorded and synthetic HTTP responses and URLs shared by the parser benchmark and the parser fuzzer. Also contains the helpers
+/// that feed raw data into an HttpResponse the same way HttpSocket does and that compare parse results.
+
+#ifndef SAKIT_PARSER_SAMPLES_H
+#define SAKIT_PARSER_SAMPLES_H
+
+#include <string.h>
+
+#include <hltypes/harray.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
+#include <sakit/HttpResponse.h>
+
+struct ParserSample
+{
+	const char* name;
+	const char* data;
+};
+
+static const ParserSample responseSamples[] =
+{
+	{ "minimal",
+		"HTTP/1.1 200 OK\r\n"
+		"Content-Length: 13\r\n"
+		"\r\n"
+		"Hello, world!" },
+	{ "recorded_json",
+		"HTTP/1.1 200 OK\r\n"
+		"Date: Mon, 12 Oct 2026 09:14:02 GMT\r\n"
+		"Server: nginx/1.24.0\r\n"
+		"Content-Type: application/json; charset=utf-8\r\n"
+		"Content-Length: 107\r\n"
+		"Connection: keep-alive\r\n"
+		"Cache-Control: private, max-age=0, no-cache\r\n"
+		"ETag: W/\"6b-ZmVkY2JhOTg3NjU0MzIx\"\r\n"
+		"Vary: Accept-Encoding\r\n"
+		"X-Request-Id: 5f0c9a3e-0b7d-4c1e-9d8a-6e2f4b1a7c30\r\n"
+		"\r\n"
+		"{\"id\":4711,\"name\":\"benchmark\",\"tags\":[\"alpha\",\"beta\",\"gamma\"],\"score\":98.25,\"active\":true,\"owner\":{\"id\":1}}" },
+	{ "recorded_redirect",
+		"HTTP/1.1 301 Moved Permanently\r\n"
+		"Date: Mon, 12 Oct 2026 09:14:03 GMT\r\n"
+		"Server: Apache\r\n"
+		"Location: http://www.example.com/index.html\r\n"
+		"Content-Length: 0\r\n"
+		"Content-Type: text/html; charset=iso-8859-1\r\n"
+		"\r\n" },
+	{ "recorded_chunked",
+		"HTTP/1.1 200 OK\r\n"
+		"Date: Mon, 12 Oct 2026 09:14:04 GMT\r\n"
+		"Content-Type: text/html; charset=utf-8\r\n"
+		"Transfer-Encoding: chunked\r\n"
+		"Connection: keep-alive\r\n"
+		"\r\n"
+		"19\r\n"
+		"<html><head></head><body>\r\n"
+		"10\r\n"
+		"<p>chunk two</p>\r\n"
+		"E\r\n"
+		"</body></html>\r\n"
+		"0\r\n"
+		"\r\n" },
+	{ "synthetic_many_headers",
+		"HTTP/1.1 200 OK\r\n"
+		"X-Header-00: value 00\r\nX-Header-01: value 01\r\nX-Header-02: value 02\r\nX-Header-03: value 03\r\n"
+		"X-Header-04: value 04\r\nX-Header-05: value 05\r\nX-Header-06: value 06\r\nX-Header-07: value 07\r\n"
+		"X-Header-08: value 08\r\nX-Header-09: value 09\r\nX-Header-10: value 10\r\nX-Header-11: value 11\r\n"
+		"X-Header-12: value 12\r\nX-Header-13: value 13\r\nX-Header-14: value 14\r\nX-Header-15: value 15\r\n"
+		"X-Empty:\r\n"
+		"X-Colons: a:b:c\r\n"
+		"Content-Length: 4\r\n"
+		"\r\n"
+		"done" },
+	{ "synthetic_chunked_small",
+		"HTTP/1.1 200 OK\r\n"
+		"Transfer-Encoding: chunked\r\n"
+		"\r\n"
+		"1\r\na\r\n1\r\nb\r\n2\r\ncd\r\n3\r\nefg\r\n4\r\nhijk\r\n0\r\n\r\n" },
+};
+
+static const ParserSample urlSamples[] =
+{
+	{ "simple", "http://www.example.com/" },
+	{ "port_path", "http://127.0.0.1:8080/api/v1/items" },
+	{ "query", "http://www.example.com/search?q=socket&page=2&sort=desc" },
+	{ "encoded", "http://www.example.com/a%20b/c%2Fd?name=J%C3%BCrgen&x=%26#frag%20ment" },
+	{ "dot_segments", "http://www.example.com/a/./b/../c/../../d/e" },
+	{ "long", "http://cdn.example.com/assets/images/2026/10/12/thumbnails/large/0123456789abcdef0123456789abcdef.png?width=1920&height=1080&quality=85&format=webp" },
+};
+
+#define RESPONSE_SAMPLE_COUNT ((int)(sizeof(responseSamples) / sizeof(ParserSample)))
+#define URL_SAMPLE_COUNT ((int)(sizeof(urlSamples) / sizeof(ParserSample)))
+
+/// @brief Appends raw data to the response and parses it, same as HttpSocket does after every receive.
+static void _feedResponse(sakit::HttpResponse* response, const unsigned char* data, int size)
+{
+	if (size <= 0)
+	{
+		return;
+	}
+	response->raw.seek(0, hseek::End);
+	int64_t position = response->raw.position();
+	response->raw.writeRaw(data, size);
+	response->raw.seek(position, hseek::Start);
+	response->parseFromRaw();
+}
+
+/// @brief Feeds data in chunks of chunkSize bytes, except for the first chunk which has firstSize bytes.
+static void _parseResponse(sakit::HttpResponse* response, const unsigned char* data, int size, int firstSize, int chunkSize)
+{
+	response->clear();
+	firstSize = hclamp(firstSize, 0, size);
+	_feedResponse(response, data, firstSize);
+	for (int i = firstSize; i < size; i += chunkSize)
+	{
+		_feedResponse(response, &data[i], hmin(chunkSize, size - i));
+	}
+}
+
+/// @brief Turns everything that was parsed into a string so results of different feeding patterns can be compared.
+static hstr _describeResponse(sakit::HttpResponse& response)
+{
+	harray<hstr> lines;
+	lines += response.protocol;
+	lines += hstr((int)response.statusCode.value);
+	lines += response.statusMessage;
+	foreach_m (hstr, it, response.headers) // already sorted by key
+	{
+		lines += it->first + ": " + it->second;
+	}
+	lines += hstr(response.headersComplete ? "headers complete" : "headers incomplete");
+	lines += hstr(response.bodyComplete ? "body complete" : "body incomplete");
+	if (response.body.size() > 0)
+	{
+		lines += hstr((const char*)&response.body[0], (int)response.body.size());
+	}
+	return lines.joined('\n');
+}
+
+#endif
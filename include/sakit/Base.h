@@ -19,7 +19,9 @@
 #include <hltypes/hstring.h>
 
 #include "Host.h"
+#include "MetricsSnapshot.h"
 #include "sakitExport.h"
+#include "SocketOptions.h"
 #include "State.h"
 
 namespace sakit
@@ -38,11 +40,22 @@ namespace sakit
 
 		void setTimeout(float timeout, float retryFrequency = 0.01f);
 
+		/// @return The options that were requested with setOptions().
+		SocketOptions getOptions() const;
+		/// @note Applied immediately if the OS socket already exists, otherwise as soon as it is created.
+		/// @return False if at least one option could not be applied.
+		bool setOptions(const SocketOptions& options);
+		/// @return The values currently reported by the OS socket. Options that can't be read back are Unset.
+		SocketOptions getEffectiveOptions() const;
+		/// @return Counters and latencies of this socket or server.
+		MetricsSnapshot getMetrics() const;
+
 		virtual void update(float timeDelta = 0.0f) = 0;
 
 	protected:
 		PlatformSocket* socket;
-		State state;
+		/// @note Changes that depend on the current state have to use compareExchange(), sending and receiving don't lock mutexState.
+		AtomicState state;
 		hmutex mutexState;
 		Host localHost;
 		unsigned short localPort;
@@ -45,7 +45,7 @@ namespace sakit
 	protected:
 		Binder(PlatformSocket* socket, BinderDelegate* binderDelegate);
 
-		void _integrate(State* stateValue, hmutex* mutexStateValue, Host* localHost, unsigned short* localPort);
+		void _integrate(AtomicState* stateValue, hmutex* mutexStateValue, Host* localHost, unsigned short* localPort);
 		void _update(float timeDelta = 0.0f);
 
 		bool _canBind(State state);
@@ -55,7 +55,7 @@ namespace sakit
 		Binder(const Binder& other); // prevents copying
 
 		PlatformSocket* _socket;
-		State* _state;
+		AtomicState* _state;
 		hmutex* _mutexState;
 		Host* _localHost;
 		unsigned short* _localPort;
@@ -0,0 +1,52 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines transport level statistics of a TCP connection as reported by the OS.
+
+#ifndef SAKIT_CONNECTION_STATS_H
+#define SAKIT_CONNECTION_STATS_H
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstring.h>
+
+#include "sakitExport.h"
+
+namespace sakit
+{
+	/// @note Values the platform does not report are set to -1.
+	class sakitExport ConnectionStats
+	{
+	public:
+		/// @brief Tick count in milliseconds when the stats were read.
+		int64_t time;
+		/// @brief Smoothed round trip time in milliseconds.
+		float rtt;
+		/// @brief Round trip time variance in milliseconds.
+		float rttVariance;
+		/// @brief Congestion window in bytes.
+		int64_t congestionWindow;
+		/// @brief Total number of retransmitted segments.
+		int retransmits;
+		/// @brief Total number of bytes acknowledged by the remote side.
+		int64_t bytesAcked;
+		/// @brief Most recent delivery rate estimate in bytes per second.
+		int64_t deliveryRate;
+		/// @brief Current pacing rate in bytes per second.
+		int64_t pacingRate;
+
+		ConnectionStats();
+		~ConnectionStats();
+
+		hstr toString() const;
+
+	};
+
+}
+#endif
@@ -43,7 +43,7 @@ namespace sakit
 	protected:
 		Connector(PlatformSocket* socket, ConnectorDelegate* connectorDelegate);
 
-		void _integrate(State* stateValue, hmutex* mutexStateValue, Host* remoteHost, unsigned short* remotePort, Host* localHost, unsigned short* localPort, float* timeout, float* retryFrequency);
+		void _integrate(AtomicState* stateValue, hmutex* mutexStateValue, Host* remoteHost, unsigned short* remotePort, Host* localHost, unsigned short* localPort, float* timeout, float* retryFrequency);
 		void _update(float timeDelta = 0.0f);
 
 		bool _canConnect(State state);
@@ -53,7 +53,7 @@ namespace sakit
 		Connector(const Connector& other); // prevents copying
 
 		PlatformSocket* _socket;
-		State* _state;
+		AtomicState* _state;
 		hmutex* _mutexState;
 		Host* _remoteHost;
 		unsigned short* _remotePort;
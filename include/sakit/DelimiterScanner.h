@@ -0,0 +1,43 @@
+/// @file
+/// @version 1.2
+///
+/// @section LICENSE
+///
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+///
+/// @section DESCRIPTION
+///
+/// Defines a vectorized scanner for protocol delimiters like CR, LF and colons.
+
+#ifndef SAKIT_DELIMITER_SCANNER_H
+#define SAKIT_DELIMITER_SCANNER_H
+
+#include <hltypes/harray.h>
+#include <hltypes/hstring.h>
+
+#include "sakitExport.h"
+
+namespace sakit
+{
+	/// @note The implementation is chosen at runtime: AVX2 and SSE2 on x86 CPUs that support them, a scalar loop otherwise.
+	class sakitExport DelimiterScanner
+	{
+	public:
+		/// @return Offset of the first occurrence of value or -1 if not found.
+		static int findByte(const unsigned char* data, int size, unsigned char value);
+		/// @return Offset of the CR of the first CR LF sequence or -1 if not found.
+		static int findLineEnd(const unsigned char* data, int size);
+
+		static hstr getImplementation();
+		static harray<hstr> getAvailableImplementations();
+		/// @note Meant for benchmarks and tests, not thread-safe while other threads are scanning.
+		static bool setImplementation(chstr name);
+
+	private:
+		DelimiterScanner() { }
+
+	};
+
+}
+#endif
@@ -0,0 +1,34 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines delivery guarantees for messages sent over a UdpChannel.
+
+#ifndef SAKIT_DELIVERY_H
+#define SAKIT_DELIVERY_H
+
+#include <hltypes/henum.h>
+
+#include "sakitExport.h"
+
+namespace sakit
+{
+	HL_ENUM_CLASS_PREFIX_DECLARE(sakitExport, Delivery,
+	(
+		/// @brief Messages can get lost, duplicated or arrive out of order.
+		HL_ENUM_DECLARE(Delivery, Unreliable);
+		/// @brief Messages can get lost, older messages than the last one received on the same lane are dropped.
+		HL_ENUM_DECLARE(Delivery, UnreliableSequenced);
+		/// @brief Messages always arrive, exactly once and in the order they were sent on the same lane.
+		HL_ENUM_DECLARE(Delivery, ReliableOrdered);
+
+	));
+
+}
+#endif
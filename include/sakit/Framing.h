@@ -0,0 +1,36 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines message framing modes for TCP sockets.
+
+#ifndef SAKIT_FRAMING_H
+#define SAKIT_FRAMING_H
+
+#include <hltypes/henum.h>
+
+#include "sakitExport.h"
+
+namespace sakit
+{
+	HL_ENUM_CLASS_PREFIX_DECLARE(sakitExport, Framing,
+	(
+		/// @brief Received data is handed out as it arrives.
+		HL_ENUM_DECLARE(Framing, None);
+		/// @brief Every message is prefixed with its size as 32 bit unsigned integer in network byte order.
+		HL_ENUM_DECLARE(Framing, Fixed32);
+		/// @brief Every message is prefixed with its size as unsigned LEB128 varint of up to 5 bytes.
+		HL_ENUM_DECLARE(Framing, Varint);
+		/// @brief Every message is terminated with the delimiter which can't be part of the message itself.
+		HL_ENUM_DECLARE(Framing, Delimiter);
+
+	));
+
+}
+#endif
@@ -0,0 +1,146 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a client-side cache for HTTP responses.
+
+#ifndef SAKIT_HTTP_CACHE_H
+#define SAKIT_HTTP_CACHE_H
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
+#include "HttpResponse.h"
+#include "sakitExport.h"
+#include "Url.h"
+
+namespace sakit
+{
+	class HttpSocket;
+
+	/// @brief Keeps responses to GET requests in memory and optionally on disk, see HttpSocket::setCache().
+	/// @note Freshness follows Cache-Control (no-store, no-cache, max-age) and Expires. Stale responses with an ETag or
+	/// Last-Modified are revalidated with If-None-Match and If-Modified-Since and a 304 Not Modified is answered with the cached
+	/// response. Responses with Vary are kept as separate variants for every combination of values of the request headers named
+	/// in Vary. Requests with Range or Authorization headers bypass the cache. The cache can be shared between sockets.
+	class sakitExport HttpCache
+	{
+	public:
+		friend class HttpSocket;
+
+		/// @param[in] path Directory for the on-disk cache, an empty path keeps responses only in memory.
+		HttpCache(int64_t maxMemorySize = 4194304LL, chstr path = "", int64_t maxDiskSize = 67108864LL);
+		~HttpCache();
+
+		HL_DEFINE_GET(int64_t, maxMemorySize, MaxMemorySize);
+		HL_DEFINE_GET(hstr, path, Path);
+		HL_DEFINE_GET(int64_t, maxDiskSize, MaxDiskSize);
+		/// @brief Requests answered from the cache without contacting the server.
+		int64_t getHits();
+		/// @brief Requests answered from the cache after the server confirmed it with 304 Not Modified.
+		int64_t getRevalidations();
+		/// @brief Requests that had to transfer the response from the server.
+		int64_t getMisses();
+		/// @return Portion of requests that didn't transfer the response, including revalidations.
+		float getHitRatio();
+		int64_t getMemorySize();
+		int64_t getDiskSize();
+		/// @brief Responses currently held in memory.
+		int getEntryCount();
+
+		/// @brief Removes all responses from memory and disk.
+		void clear();
+
+	protected:
+		class Entry
+		{
+		public:
+			hstr key;
+			HttpResponse::Code statusCode;
+			hstr statusMessage;
+			hmap<hstr, hstr> headers;
+			/// @brief Keys of the stored variants of a response with Vary. Such an entry only holds the Vary header, the
+			/// variants are separate entries.
+			harray<hstr> variants;
+			hstream body;
+			/// @brief In seconds since the epoch.
+			int64_t storeTime;
+			/// @brief In seconds, 0 means that it has to be revalidated before every use.
+			int64_t lifetime;
+			int64_t lastUse;
+
+			Entry();
+
+			int64_t getSize();
+
+		};
+
+		int64_t maxMemorySize;
+		hstr path;
+		int64_t maxDiskSize;
+		int64_t hits;
+		int64_t revalidations;
+		int64_t misses;
+		int64_t memorySize;
+		int64_t diskSize;
+		int64_t useCounter;
+		hmap<hstr, Entry*> entries;
+		/// @brief File sizes of the on-disk cache by file name.
+		hmap<hstr, int64_t> diskFiles;
+		/// @brief File names of the on-disk cache, oldest first.
+		harray<hstr> diskOrder;
+		hmutex mutex;
+
+		/// @brief Copies a fresh response into the given response or adds validators for a stale one to the request headers.
+		/// @return True if the response was answered from the cache and no request has to be sent.
+		bool _prepare(chstr method, Url& url, hmap<hstr, hstr>& customHeaders, HttpResponse* response);
+		/// @brief Stores a received response or replaces a 304 Not Modified with the revalidated response.
+		/// @param[in] customHeaders The request headers as given by the user, without validators added by _prepare().
+		void _update(chstr method, Url& url, hmap<hstr, hstr>& customHeaders, HttpResponse* response);
+
+		Entry* _find(chstr key);
+		/// @brief Same as _find(), but resolves a response with Vary to the variant for the given request headers.
+		Entry* _findVariant(chstr key, hmap<hstr, hstr>& customHeaders);
+		/// @brief Records the variant in the entry for its Vary header, variants for a different Vary header are removed.
+		void _addVariant(chstr key, chstr vary, chstr variantKey);
+		void _store(Entry* entry);
+		void _remove(chstr key);
+		void _trimMemory();
+		void _trimDisk();
+		Entry* _readEntry(chstr filename, chstr key);
+		bool _writeEntry(Entry* entry);
+		void _removeFile(chstr filename);
+
+		static hstr _makeKey(chstr method, Url& url);
+		static hstr _makeVariantKey(chstr key, chstr vary, hmap<hstr, hstr>& customHeaders);
+		static hstr _makeFilename(chstr key);
+		static bool _isCacheable(chstr method, hmap<hstr, hstr>& customHeaders);
+		/// @return Freshness lifetime in seconds or -1 if the response must not be stored.
+		static int64_t _calculateLifetime(hmap<hstr, hstr>& headers, int64_t now);
+		/// @return Seconds since the epoch or -1 if the date is not valid.
+		static int64_t _parseHttpDate(chstr value);
+		/// @brief Copies all headers except the hop-by-hop ones which only applied to the connection that transferred them.
+		static void _copyHeaders(hmap<hstr, hstr>& source, hmap<hstr, hstr>& destination);
+		/// @brief Merges only the headers of a 304 Not Modified that may update a stored response, e.g. never Content-Length.
+		static void _updateHeaders(hmap<hstr, hstr>& source, hmap<hstr, hstr>& destination);
+		/// @brief Looks up a header with a case-insensitive name.
+		static bool _tryGetHeader(hmap<hstr, hstr>& headers, chstr name, hstr& value);
+		static void _copyEntry(Entry* entry, HttpResponse* response);
+
+	private:
+		HttpCache(const HttpCache& other); // prevents copying
+
+	};
+
+}
+#endif
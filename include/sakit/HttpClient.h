@@ -0,0 +1,91 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a HTTP client that executes many requests concurrently on a few threads.
+
+#ifndef SAKIT_HTTP_CLIENT_H
+#define SAKIT_HTTP_CLIENT_H
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstring.h>
+
+#include "Base.h"
+#include "sakitExport.h"
+#include "Url.h"
+
+namespace sakit
+{
+	class HttpClientDelegate;
+	class HttpClientRequest;
+	class HttpClientThread;
+
+	/// @brief Every thread drives all of its requests step by step instead of blocking on one of them, so the number of
+	/// concurrent requests isn't bound to the number of threads.
+	/// @note Every request uses its own connection that is closed afterwards, HttpClientPool should be used for keep-alive
+	/// connections. Requests above the concurrency limit are queued in order. Delegate callbacks are called during update().
+	class sakitExport HttpClient : public Base
+	{
+	public:
+		friend class HttpClientThread;
+
+		HttpClient(HttpClientDelegate* clientDelegate, int maxConcurrentRequests = 16, int threadCount = 1);
+		~HttpClient();
+
+		HL_DEFINE_GET(int, maxConcurrentRequests, MaxConcurrentRequests);
+		HL_DEFINE_GET(int, threadCount, ThreadCount);
+		int getPendingRequestCount();
+		int getActiveRequestCount();
+
+		void update(float timeDelta = 0.0f) override;
+
+		/// @param[in] deadline Time in seconds after which the request fails, including the time spent waiting in the queue. 0
+		/// uses the timeout of the client.
+		/// @return Handle of the request or NULL if the URL is not valid.
+		HttpClientRequest* execute(chstr method, Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>(), float deadline = 0.0f);
+		HttpClientRequest* executeOptions(Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>(), float deadline = 0.0f);
+		HttpClientRequest* executeGet(Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>(), float deadline = 0.0f);
+		HttpClientRequest* executeHead(Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>(), float deadline = 0.0f);
+		HttpClientRequest* executePost(Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>(), float deadline = 0.0f);
+		HttpClientRequest* executePut(Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>(), float deadline = 0.0f);
+		HttpClientRequest* executeDelete(Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>(), float deadline = 0.0f);
+
+		/// @brief Cancels the request if it isn't done yet and deletes it.
+		/// @note The request must not be accessed afterwards. Requests that weren't released are deleted with the client.
+		void release(HttpClientRequest* request);
+
+	protected:
+		HttpClientDelegate* clientDelegate;
+		int maxConcurrentRequests;
+		int threadCount;
+		harray<HttpClientThread*> threads;
+		int nextId;
+		/// @brief All requests that weren't released yet.
+		harray<HttpClientRequest*> requests;
+		harray<HttpClientRequest*> pendingRequests;
+		int activeCount;
+		/// @brief Requests that are done, but weren't reported to the delegate yet.
+		harray<HttpClientRequest*> doneRequests;
+		hmutex requestsMutex;
+
+		/// @return The next queued request or NULL if there is none or the concurrency limit was reached.
+		HttpClientRequest* _takePendingRequest();
+		void _finishRequest(HttpClientRequest* request, State state, bool timedOut);
+		void _expirePendingRequests();
+
+	private:
+		HttpClient(const HttpClient& other); // prevents copying
+
+	};
+
+}
+#endif
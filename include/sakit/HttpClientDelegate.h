@@ -0,0 +1,36 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a HTTP client delegate.
+
+#ifndef SAKIT_HTTP_CLIENT_DELEGATE_H
+#define SAKIT_HTTP_CLIENT_DELEGATE_H
+
+#include "sakitExport.h"
+
+namespace sakit
+{
+	class HttpClient;
+	class HttpClientRequest;
+
+	class sakitExport HttpClientDelegate
+	{
+	public:
+		HttpClientDelegate();
+		virtual ~HttpClientDelegate();
+
+		virtual void onRequestCompleted(HttpClient* client, HttpClientRequest* request);
+		/// @note HttpClientRequest::isTimedOut() tells whether the deadline of the request has passed.
+		virtual void onRequestFailed(HttpClient* client, HttpClientRequest* request);
+
+	};
+
+}
+#endif
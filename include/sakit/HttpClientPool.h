@@ -0,0 +1,131 @@
+/// @file
+/// @version 1.2
+///
+/// @section LICENSE
+///
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+///
+/// @section DESCRIPTION
+///
+/// Defines a pool of persistent HTTP connections that are shared between requests.
+
+#ifndef SAKIT_HTTP_CLIENT_POOL_H
+#define SAKIT_HTTP_CLIENT_POOL_H
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstring.h>
+
+#include "HttpSocketDelegate.h"
+#include "sakitExport.h"
+#include "Url.h"
+
+namespace sakit
+{
+	class HttpResponse;
+	class HttpSocket;
+
+	/// @brief Keeps idle keep-alive connections per host:port and hands requests to them.
+	/// @note Async requests that can't get a connection due to the per-host limit are queued until one becomes free. Delegate
+	/// callbacks are forwarded to the delegate of the pool with the pooled HttpSocket that executed the request.
+	class sakitExport HttpClientPool : protected HttpSocketDelegate
+	{
+	public:
+		HttpClientPool(HttpSocketDelegate* socketDelegate, int maxConnectionsPerHost = 4, float idleTimeout = 4.0f);
+		~HttpClientPool();
+
+		HL_DEFINE_GETSET(int, maxConnectionsPerHost, MaxConnectionsPerHost);
+		/// @brief Idle connections older than this many seconds are closed instead of being reused.
+		HL_DEFINE_GETSET(float, idleTimeout, IdleTimeout);
+		HL_DEFINE_ISSET(reportProgress, ReportProgress);
+		/// @brief Requests that got an already open connection.
+		int64_t getHits();
+		/// @brief Requests that had to open a new connection.
+		int64_t getMisses();
+		/// @brief Idle connections that were closed due to the idle timeout.
+		int64_t getExpired();
+		/// @brief Async requests that had to wait for a free connection.
+		int64_t getQueued();
+		int getConnectionCount();
+		int getIdleConnectionCount();
+		int getPendingRequestCount();
+
+		bool execute(HttpResponse* response, chstr method, Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		bool executeOptions(HttpResponse* response, Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		bool executeGet(HttpResponse* response, Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		bool executeHead(HttpResponse* response, Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		bool executePost(HttpResponse* response, Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		bool executePut(HttpResponse* response, Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		bool executeDelete(HttpResponse* response, Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+
+		bool executeAsync(chstr method, Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		bool executeOptionsAsync(Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		bool executeGetAsync(Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		bool executeHeadAsync(Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		bool executePostAsync(Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		bool executePutAsync(Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		bool executeDeleteAsync(Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+
+		/// @brief Closes idle connections that exceeded the idle timeout, should be called regularly so they don't stay open
+		/// until the next request.
+		void update(float timeDelta = 0.0f);
+		/// @brief Closes all connections that are currently not executing anything.
+		void closeIdleConnections();
+
+	protected:
+		class Request
+		{
+		public:
+			hstr method;
+			Url url;
+			hstr customBody;
+			hmap<hstr, hstr> customHeaders;
+			bool reused;
+			bool retried;
+
+			Request(chstr method, Url url, chstr customBody, hmap<hstr, hstr> customHeaders);
+
+		};
+
+		HttpSocketDelegate* socketDelegate;
+		int maxConnectionsPerHost;
+		float idleTimeout;
+		bool reportProgress;
+		int64_t hits;
+		int64_t misses;
+		int64_t expired;
+		int64_t queued;
+		/// @brief All sockets owned by the pool. They are only deleted in the destructor since deleting a socket during a delegate
+		/// callback isn't allowed, disconnected sockets are reused for any host instead.
+		harray<HttpSocket*> sockets;
+		/// @brief host:port of every connected socket, idle or executing.
+		hmap<HttpSocket*, hstr> socketKeys;
+		/// @brief Time in milliseconds since when connected sockets are idle.
+		hmap<HttpSocket*, int64_t> idleTimes;
+		harray<HttpSocket*> freeSockets;
+		hmap<HttpSocket*, Request*> activeRequests;
+		harray<Request*> pendingRequests;
+		hmutex mutex;
+
+		void onExecuteProgress(HttpSocket* socket, HttpResponse* response, Url url) override;
+		void onExecuteCompleted(HttpSocket* socket, HttpResponse* response, Url url) override;
+		void onExecuteFailed(HttpSocket* socket, HttpResponse* response, Url url) override;
+
+		HttpSocket* _acquire(chstr key, bool& reused);
+		void _release(HttpSocket* socket);
+		void _expireIdleSockets();
+		bool _startRequest(HttpSocket* socket, Request* request);
+		void _startPendingRequests();
+
+		static hstr _makeKey(Url& url);
+
+	private:
+		HttpClientPool(const HttpClientPool& other); // prevents copying
+
+	};
+
+}
+#endif
@@ -0,0 +1,81 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a handle for a request executed by HttpClient.
+
+#ifndef SAKIT_HTTP_CLIENT_REQUEST_H
+#define SAKIT_HTTP_CLIENT_REQUEST_H
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstring.h>
+
+#include "sakitExport.h"
+#include "State.h"
+#include "Url.h"
+
+namespace sakit
+{
+	class HttpClient;
+	class HttpClientThread;
+	class HttpResponse;
+
+	/// @note The state is Idle while the request waits for a free slot, Running while it is executed and Finished or Failed once
+	/// it is done. Requests are owned by the HttpClient that created them and have to be released through HttpClient::release().
+	class sakitExport HttpClientRequest
+	{
+	public:
+		friend class HttpClient;
+		friend class HttpClientThread;
+
+		HL_DEFINE_GET(int, id, Id);
+		HL_DEFINE_GET(hstr, method, Method);
+		HL_DEFINE_GET(Url, url, Url);
+		/// @note Must not be accessed before the request is done.
+		HL_DEFINE_GET(HttpResponse*, response, Response);
+		State getState();
+		bool isDone();
+		/// @return True if the request failed because its deadline passed.
+		bool isTimedOut();
+
+		/// @brief Blocks the calling thread until the request is done.
+		/// @param[in] timeout Maximum time to wait in seconds, 0 waits until the deadline of the request has passed.
+		/// @return True if the request is done.
+		/// @note Delegate callbacks are still only called in the update of the HttpClient.
+		bool wait(float timeout = 0.0f);
+
+	protected:
+		int id;
+		hstr method;
+		Url url;
+		hstr customBody;
+		hmap<hstr, hstr> customHeaders;
+		HttpResponse* response;
+		State state;
+		bool timedOut;
+		/// @brief htickCount() value in milliseconds when the request fails.
+		int64_t deadline;
+		/// @brief Set when released while running, the thread executing the request deletes it then.
+		bool released;
+		hmutex mutex;
+
+		HttpClientRequest(int id, chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders, int64_t deadline);
+		~HttpClientRequest();
+
+		void _setDone(State state, bool timedOut);
+
+	private:
+		HttpClientRequest(const HttpClientRequest& other); // prevents copying
+
+	};
+
+}
+#endif
@@ -0,0 +1,125 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a downloader that fetches large HTTP resources in byte ranges over several connections.
+
+#ifndef SAKIT_HTTP_DOWNLOADER_H
+#define SAKIT_HTTP_DOWNLOADER_H
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
+#include "HttpSocketDelegate.h"
+#include "sakitExport.h"
+#include "State.h"
+#include "Url.h"
+
+namespace sakit
+{
+	class HttpDownloaderDelegate;
+	class HttpResponse;
+	class HttpSocket;
+
+	/// @brief Splits the resource into pieces that are requested with Range headers and written into the sink at their offsets.
+	/// @note The first piece also tells whether the server supports ranges, only then the remaining pieces are fetched over up
+	/// to maxConnections connections in parallel. A piece that fails is requested again from the first byte that is missing.
+	/// If-Range with the ETag or Last-Modified of the first response makes sure that pieces of a changed resource aren't mixed.
+	/// Servers without range support send the whole resource in one response. Delegate callbacks are called during the update of
+	/// the internally used HttpSockets.
+	class sakitExport HttpDownloader : protected HttpSocketDelegate
+	{
+	public:
+		HttpDownloader(HttpDownloaderDelegate* downloaderDelegate, int maxConnections = 4, int pieceSize = 1048576);
+		~HttpDownloader();
+
+		HL_DEFINE_GET(int, maxConnections, MaxConnections);
+		/// @note Every connection keeps up to one piece in memory.
+		HL_DEFINE_GET(int, pieceSize, PieceSize);
+		/// @brief How often a piece is requested again without receiving anything before the download fails.
+		HL_DEFINE_GETSET(int, maxRetries, MaxRetries);
+		Url getUrl();
+		/// @return Total size or -1 if it isn't known (yet).
+		int64_t getSize();
+		int64_t getReceived();
+		/// @return Idle, Running, Finished or Failed.
+		State getState();
+
+		/// @param[in] sink Receives the data at the respective offsets so it has to support seeking. It isn't owned and has to
+		/// stay valid until the download is done.
+		bool start(Url url, hsbase* sink, hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		bool abort();
+
+	protected:
+		class Piece
+		{
+		public:
+			int64_t start;
+			/// @brief Last byte, inclusive like in the Range header.
+			int64_t end;
+			int retries;
+
+			Piece();
+			Piece(int64_t start, int64_t end);
+
+		};
+
+		HttpDownloaderDelegate* downloaderDelegate;
+		int maxConnections;
+		int pieceSize;
+		int maxRetries;
+		Url url;
+		hsbase* sink;
+		hmap<hstr, hstr> customHeaders;
+		State state;
+		int64_t size;
+		int64_t received;
+		/// @brief Strong ETag or Last-Modified of the first response, sent as If-Range.
+		hstr validator;
+		/// @brief Set once the first response confirmed that the server supports ranges.
+		bool rangesSupported;
+		/// @brief All sockets owned by the downloader. They are only deleted in the destructor since deleting a socket during a
+		/// delegate callback isn't allowed.
+		harray<HttpSocket*> sockets;
+		/// @brief Aborted sockets might still be finishing up and aren't used again.
+		harray<HttpSocket*> retiredSockets;
+		hmap<HttpSocket*, Piece> activePieces;
+		harray<Piece> pendingPieces;
+		hmutex mutex;
+
+		void onExecuteCompleted(HttpSocket* socket, HttpResponse* response, Url url) override;
+		void onExecuteFailed(HttpSocket* socket, HttpResponse* response, Url url) override;
+
+		/// @param[in] completed Whether the request completed or failed, in which case the received data is still used.
+		/// @return Running while the download goes on, Failed if it can't be continued.
+		State _processResponse(Piece& piece, HttpResponse* response, bool completed);
+		/// @return Number of bytes that were written into the sink or -1 if writing failed.
+		int64_t _writePiece(Piece& piece, HttpResponse* response);
+		/// @brief Puts the remaining part of the piece back at the front of the queue.
+		State _retryPiece(Piece& piece, int64_t written);
+		/// @brief Queues pieces from the given offset to the end or just one piece if the size isn't known.
+		void _queuePieces(int64_t start);
+		/// @return Running while the download goes on, Failed if no piece could be requested.
+		State _startPendingPieces();
+		void _stopSockets();
+		void _reportResult(State result, bool progress);
+
+		static bool _parseContentRange(chstr value, int64_t& start, int64_t& end, int64_t& size);
+
+	private:
+		HttpDownloader(const HttpDownloader& other); // prevents copying
+
+	};
+
+}
+#endif
@@ -0,0 +1,38 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a HTTP downloader delegate.
+
+#ifndef SAKIT_HTTP_DOWNLOADER_DELEGATE_H
+#define SAKIT_HTTP_DOWNLOADER_DELEGATE_H
+
+#include <hltypes/hltypesUtil.h>
+
+#include "sakitExport.h"
+
+namespace sakit
+{
+	class HttpDownloader;
+
+	class sakitExport HttpDownloaderDelegate
+	{
+	public:
+		HttpDownloaderDelegate();
+		virtual ~HttpDownloaderDelegate();
+
+		/// @param[in] size Total size or -1 if it isn't known.
+		virtual void onDownloadProgress(HttpDownloader* downloader, int64_t received, int64_t size);
+		virtual void onDownloadCompleted(HttpDownloader* downloader);
+		virtual void onDownloadFailed(HttpDownloader* downloader);
+
+	};
+
+}
+#endif
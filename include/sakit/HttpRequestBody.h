@@ -0,0 +1,54 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a source for HTTP request bodies that are uploaded in pieces.
+
+#ifndef SAKIT_HTTP_REQUEST_BODY_H
+#define SAKIT_HTTP_REQUEST_BODY_H
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
+#include "sakitExport.h"
+
+namespace sakit
+{
+	/// @brief Reads from a stream or a file. Data that is produced on the fly can be provided by a subclass that overrides read().
+	/// @note Only one piece of the body is kept in memory at a time while uploading.
+	class sakitExport HttpRequestBody
+	{
+	public:
+		/// @brief Uses the data from the current position of the stream to its end.
+		/// @note The stream isn't owned and has to stay valid until the upload is done.
+		HttpRequestBody(hsbase* stream);
+		/// @brief Uses the whole file.
+		HttpRequestBody(chstr filename);
+		virtual ~HttpRequestBody();
+
+		/// @return Size in bytes or -1 if unknown in which case chunked transfer encoding is used.
+		virtual int64_t getSize();
+		/// @return Number of bytes written into data, 0 when the end was reached or -1 on error.
+		virtual int read(unsigned char* data, int size);
+
+	protected:
+		hsbase* stream;
+		bool streamOwned;
+
+		/// @brief Used by subclasses that produce the data themselves.
+		HttpRequestBody();
+
+	private:
+		HttpRequestBody(const HttpRequestBody& other); // prevents copying
+
+	};
+
+}
+#endif
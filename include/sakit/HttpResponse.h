@@ -13,6 +13,7 @@
 #ifndef SAKIT_HTTP_RESPONSE_H
 #define SAKIT_HTTP_RESPONSE_H
 
+#include <hltypes/harray.h>
 #include <hltypes/henum.h>
 #include <hltypes/hltypesUtil.h>
 #include <hltypes/hmap.h>
@@ -121,24 +122,55 @@ namespace sakit
 		hstream raw;
 		bool headersComplete;
 		bool bodyComplete;
+		/// @brief Set when the received data can't be parsed, e.g. an invalid chunk size. Nothing is parsed anymore then.
+		bool invalid;
+		/// @brief Bodies with a gzip or deflate Content-Encoding are decoded while parsing so body contains the decoded data.
+		/// @note The encoded data is still available in raw. Requires sakit to be built with _SAKIT_ZLIB, otherwise bodies are
+		/// always left as they are. Not reset by clear().
+		bool contentDecoding;
 
 		HttpResponse();
+		~HttpResponse();
 
 		void clear();
 		void parseFromRaw();
 		bool hasNewData();
 		int consumeNewData();
+		/// @brief Moves raw data that was received after the end of this response into another response.
+		/// @note Used for pipelining where the data of the next response can follow right away.
+		void moveExcessData(HttpResponse* other);
 
 		HttpResponse* clone() const;
 
 	protected:
 		int chunkSize;
 		int chunkRead;
+		int chunkDelimiterRemaining;
+		bool readingTrailers;
 		int newDataSize;
+		/// @brief Offset in raw where parsing continues.
+		int parsePosition;
+		/// @brief Offset in raw where the header line that is currently being scanned starts.
+		int lineStart;
+		/// @brief Start and size of every header name and value in raw, 4 values per header line.
+		harray<int> headerSpans;
+		/// @brief Decompression state, created once the first encoded body data arrives.
+		void* decoder;
 
-		void _getRawData(hstr& data, int& size);
 		void _readHeaders();
+		void _readStatusLine(const char* data, int size);
+		void _addHeaderSpan(const char* data, int start, int size);
+		void _materializeHeaders();
 		void _readBody();
+		/// @brief Moves body data from the current position in raw into body.
+		/// @return Number of bytes consumed from raw.
+		int _writeBody(int count);
+		/// @return False if the body isn't encoded and has to be written as it is.
+		bool _decodeBody(const unsigned char* data, int size);
+		void _destroyDecoder();
+
+	private:
+		HttpResponse(const HttpResponse& other); // prevents copying
 
 	};
 
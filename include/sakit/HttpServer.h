@@ -0,0 +1,101 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines an embedded HTTP/1.1 server.
+
+#ifndef SAKIT_HTTP_SERVER_H
+#define SAKIT_HTTP_SERVER_H
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstring.h>
+
+#include "sakitExport.h"
+#include "TcpServer.h"
+
+namespace sakit
+{
+	class HttpServerHandler;
+	class HttpServerThread;
+	class TcpServerDelegate;
+	class TcpSocket;
+
+	/// @brief Serves HTTP/1.1 requests with keep-alive and pipelining on a fixed number of I/O threads.
+	/// @note Accepted connections are distributed over the I/O threads which each handle all of their connections, there is no
+	/// thread per connection. Requests are dispatched to the handler of the matching route on the I/O thread, see
+	/// HttpServerHandler. Requests without a route get 404 Not Found or 405 Method Not Allowed. The server delegate gets the
+	/// usual bind and start/stop callbacks, onAccepted() isn't called since the connections are owned by the I/O threads.
+	class sakitExport HttpServer : public TcpServer
+	{
+	public:
+		friend class HttpServerThread;
+
+		/// @param[in] threadCount Number of I/O threads that share all connections.
+		HttpServer(TcpServerDelegate* serverDelegate, int threadCount = 1);
+		~HttpServer();
+
+		/// @brief Idle connections are closed after this many seconds.
+		HL_DEFINE_GETSET(float, keepAliveTimeout, KeepAliveTimeout);
+		/// @brief Requests with larger headers are answered with 413 and the connection is closed.
+		HL_DEFINE_GETSET(int, maxHeaderSize, MaxHeaderSize);
+		/// @brief Requests with larger bodies are answered with 413 and the connection is closed.
+		HL_DEFINE_GETSET(int, maxBodySize, MaxBodySize);
+		int getConnectionCount();
+		int64_t getRequestCount();
+
+		/// @param[in] method Method to match, an empty method matches all methods. HEAD requests also match GET routes.
+		/// @param[in] path Path to match, a path ending with "*" matches all paths starting with the part before it. Exact
+		/// matches are preferred, otherwise the longest matching prefix is used.
+		/// @note The handler isn't owned and has to stay valid as long as it's used by the server.
+		void addRoute(chstr method, chstr path, HttpServerHandler* handler);
+		bool removeRoute(chstr method, chstr path);
+
+		void update(float timeDelta = 0.0f) override;
+
+	protected:
+		class Route
+		{
+		public:
+			hstr method;
+			hstr path;
+			HttpServerHandler* handler;
+
+			Route();
+			Route(chstr method, chstr path, HttpServerHandler* handler);
+
+		};
+
+		harray<HttpServerThread*> threads;
+		/// @brief The I/O thread that gets the next accepted connection.
+		int nextThread;
+		float keepAliveTimeout;
+		int maxHeaderSize;
+		int maxBodySize;
+		int connectionCount;
+		int64_t requestCount;
+		harray<Route> routes;
+		hmutex routesMutex;
+		hmutex statsMutex;
+		hmutex acceptMutex;
+
+		/// @return An accepted connection if it's the given thread's turn, otherwise NULL.
+		TcpSocket* _takeAcceptedSocket(HttpServerThread* thread);
+		/// @param[out] pathFound Whether a route matched the path, but not the method.
+		HttpServerHandler* _findHandler(chstr method, chstr path, bool& pathFound);
+		void _updateStats(int connectionChange, int requestChange);
+
+	private:
+		HttpServer(const HttpServer& other); // prevents copying
+
+	};
+
+}
+#endif
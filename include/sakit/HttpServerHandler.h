@@ -0,0 +1,38 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a handler for requests to a route of a HttpServer.
+
+#ifndef SAKIT_HTTP_SERVER_HANDLER_H
+#define SAKIT_HTTP_SERVER_HANDLER_H
+
+#include "sakitExport.h"
+
+namespace sakit
+{
+	class HttpServer;
+	class HttpServerRequest;
+	class HttpServerResponse;
+
+	class sakitExport HttpServerHandler
+	{
+	public:
+		HttpServerHandler();
+		virtual ~HttpServerHandler();
+
+		/// @brief Fills in the response which is sent once this returns.
+		/// @note Called on one of the I/O threads of the server, not during update(), so it has to be thread-safe and shouldn't
+		/// block since other connections of the same thread have to wait meanwhile.
+		virtual void onRequest(HttpServer* server, HttpServerRequest* request, HttpServerResponse* response);
+
+	};
+
+}
+#endif
@@ -0,0 +1,83 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a HTTP request received by a HttpServer.
+
+#ifndef SAKIT_HTTP_SERVER_REQUEST_H
+#define SAKIT_HTTP_SERVER_REQUEST_H
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
+#include "Host.h"
+#include "HttpResponse.h"
+#include "sakitExport.h"
+
+namespace sakit
+{
+	class sakitExport HttpServerRequest
+	{
+	public:
+		friend class HttpServerThread;
+		friend class WebSocket;
+
+		hstr method;
+		/// @brief Path without the query, e.g. "/health".
+		hstr path;
+		/// @brief Everything after the "?" in the request target.
+		hstr query;
+		hstr protocol;
+		hmap<hstr, hstr> headers;
+		/// @note Chunked bodies are already decoded.
+		hstream body;
+		Host remoteHost;
+		unsigned short remotePort;
+
+		HttpServerRequest();
+		~HttpServerRequest();
+
+		/// @brief Header names are case-insensitive so this should be used instead of accessing headers directly.
+		hstr getHeader(chstr name, chstr defaultValue = "") const;
+		/// @return True if the client wants to keep the connection open after the response.
+		bool isKeepAlive() const;
+
+		void clear();
+
+	protected:
+		bool headersComplete;
+		bool bodyComplete;
+		/// @brief Offset where the header line that is currently being scanned starts.
+		int lineStart;
+		/// @brief Offset where scanning continues.
+		int parsePosition;
+		bool chunked;
+		int contentLength;
+		bool readingTrailers;
+		/// @brief Status code for the error response if the request is malformed.
+		HttpResponse::Code error;
+
+		/// @brief Parses the data incrementally, the data has to start with the request and can only grow between calls.
+		/// @return Size of the request in data once it's complete, 0 if more data is needed or -1 if the request is malformed.
+		int _parse(const unsigned char* data, int size, int maxHeaderSize, int maxBodySize);
+		bool _readRequestLine(chstr line);
+		/// @brief Determines how the body is transferred once the headers are complete.
+		bool _prepareBody(int maxBodySize);
+		int _readBody(const unsigned char* data, int size);
+		int _readChunkedBody(const unsigned char* data, int size, int maxBodySize);
+
+	private:
+		HttpServerRequest(const HttpServerRequest& other); // prevents copying
+
+	};
+
+}
+#endif
@@ -0,0 +1,65 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a HTTP response sent by a HttpServer.
+
+#ifndef SAKIT_HTTP_SERVER_RESPONSE_H
+#define SAKIT_HTTP_SERVER_RESPONSE_H
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
+#include "HttpResponse.h"
+#include "sakitExport.h"
+
+namespace sakit
+{
+	class HttpRequestBody;
+
+	class sakitExport HttpServerResponse
+	{
+	public:
+		friend class HttpServerThread;
+
+		HttpResponse::Code statusCode;
+		/// @note Content-Length, Transfer-Encoding and Connection are set by the server.
+		hmap<hstr, hstr> headers;
+		hstream body;
+
+		HttpServerResponse();
+		~HttpServerResponse();
+
+		/// @brief Sends the body with chunked transfer encoding instead of a Content-Length.
+		HL_DEFINE_ISSET(chunked, Chunked);
+		HL_DEFINE_GET(HttpRequestBody*, bodyStream, BodyStream);
+		/// @brief Sends the body piece by piece from the given source instead of body, e.g. for large files.
+		/// @note The source is owned by the response. If its size is unknown, chunked transfer encoding is used.
+		void setBodyStream(HttpRequestBody* value);
+
+		void setBody(chstr value);
+
+	protected:
+		bool chunked;
+		HttpRequestBody* bodyStream;
+
+		/// @param[in] bodySize Size of the body or -1 if it's sent chunked.
+		hstr _makeHeader(chstr protocol, bool keepAlive, int64_t bodySize);
+
+		static hstr _getStatusMessage(HttpResponse::Code code);
+
+	private:
+		HttpServerResponse(const HttpServerResponse& other); // prevents copying
+
+	};
+
+}
+#endif
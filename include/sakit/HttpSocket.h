@@ -13,6 +13,7 @@
 #ifndef SAKIT_HTTP_SOCKET_H
 #define SAKIT_HTTP_SOCKET_H
 
+#include <hltypes/harray.h>
 #include <hltypes/henum.h>
 #include <hltypes/hltypesUtil.h>
 #include <hltypes/hmap.h>
@@ -60,6 +61,8 @@
 
 namespace sakit
 {
+	class HttpCache;
+	class HttpRequestBody;
 	class HttpResponse;
 	class HttpSocketDelegate;
 	class HttpSocketThread;
@@ -69,6 +72,9 @@ namespace sakit
 	class sakitExport HttpSocket : public SocketBase
 	{
 	public:
+		friend class HttpClientPool;
+		friend class HttpClientThread;
+
 		HL_ENUM_CLASS_PREFIX_DECLARE(sakitExport, Protocol,
 		(
 			HL_ENUM_DECLARE(Protocol, Http11);
@@ -79,7 +85,14 @@ namespace sakit
 
 		HL_DEFINE_ISSET(keepAlive, KeepAlive);
 		HL_DEFINE_ISSET(reportProgress, ReportProgress);
+		HL_DEFINE_IS(compressionEnabled, CompressionEnabled);
+		/// @brief Requests gzip or deflate encoded bodies and decodes them while receiving, see HttpResponse::contentDecoding.
+		/// @return False if sakit was built without _SAKIT_ZLIB.
+		bool setCompressionEnabled(bool value);
 		HL_DEFINE_GETSET(Protocol, protocol, Protocol);
+		/// @brief GET requests are answered from the cache when possible and their responses are stored in it.
+		/// @note The cache isn't owned by the socket. Pipelined requests and uploads don't use the cache.
+		HL_DEFINE_GETSET(HttpCache*, cache, Cache);
 		HL_DEFINE_SET(unsigned short, remotePort, RemotePort);
 		/// @note This is due to keepAlive which has to be set beforehand
 		bool isConnected();
@@ -124,6 +137,18 @@ namespace sakit
 		bool executeTraceAsync(chstr customBody, hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
 		bool executeConnectAsync(chstr customBody, hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
 
+		/// @brief Streams the body from its source in pieces instead of building the whole request in memory.
+		/// @note The body isn't owned and has to stay valid until the request is done. Upload progress is reported through
+		/// onUploadProgress(), in update() for async requests.
+		bool executeUpload(HttpResponse* response, chstr method, Url url, HttpRequestBody* body, hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		bool executeUploadAsync(chstr method, Url url, HttpRequestBody* body, hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+
+		/// @brief Sends a request for every URL back-to-back on one persistent connection and parses the responses in order.
+		/// @note Every response is reported through onExecuteCompleted() with its URL as soon as it is complete. After a connection
+		/// failure, requests without a response are sent again on a new connection if the method is idempotent, otherwise they are
+		/// reported through onExecuteFailed(). All URLs need the same host and port and keep-alive has to be enabled.
+		bool executePipelinedAsync(chstr method, harray<Url> urls, hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+
 		bool abort();
 
 		static unsigned short DefaultPort;
@@ -134,29 +159,54 @@ namespace sakit
 		Protocol protocol;
 		bool keepAlive;
 		bool reportProgress;
+		bool compressionEnabled;
+		HttpCache* cache;
 		Url url;
+		/// @brief Method and headers of the running async request if its response goes into the cache.
+		hstr cacheMethod;
+		hmap<hstr, hstr> cacheHeaders;
+		/// @brief Uploaded byte count that was last reported to the delegate.
+		int64_t uploadReported;
 
 		bool _executeMethod(HttpResponse* response, chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders);
 		bool _executeMethod(HttpResponse* response, chstr method, chstr customBody, hmap<hstr, hstr>& customHeaders);
-		bool _executeMethodInternal(HttpResponse* response, chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders);
+		bool _executeMethodInternal(HttpResponse* response, chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders, HttpRequestBody* body = NULL);
 
 		bool _executeMethodAsync(chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders);
 		bool _executeMethodAsync(chstr method, chstr customBody, hmap<hstr, hstr>& customHeaders);
-		bool _executeMethodInternalAsync(chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders);
+		bool _executeMethodInternalAsync(chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders, HttpRequestBody* body = NULL);
 
 		int _send(hstream* stream, int count) override;
 		bool _sendAsync(hstream* stream, int count);
 		void _terminateConnection();
+		/// @brief Closes a persistent connection that is not executing anything.
+		void _closeConnection();
+		/// @return True if the persistent connection goes to the same host and port as the given URL.
+		bool _isConnectedTo(Url& url);
 
 		int _receiveHttpDirect(HttpResponse* response);
+		bool _sendBodyDirect(HttpRequestBody* body, int64_t size);
+
+		void _updateUploadProgress();
+
+		void _updatePipeline();
 
 		bool _canExecute(State state);
 		bool _canAbort(State state);
 
 		hstr _processRequest(chstr method, Url url, chstr customBody, hmap<hstr, hstr> customHeaders);
+		hstr _processUploadRequest(chstr method, Url url, int64_t bodySize, hmap<hstr, hstr> customHeaders);
 
 		hstr _makeProtocol();
 
+		static hstr _makeRequest(chstr method, Url& url, chstr customBody, hmap<hstr, hstr> customHeaders, bool keepAlive, chstr protocol);
+		/// @brief Only the request line and the headers, the body follows separately with a Content-Length or chunked.
+		/// @param[in] bodySize Size of the body or -1 if it's unknown.
+		static hstr _makeUploadRequest(chstr method, Url& url, int64_t bodySize, hmap<hstr, hstr> customHeaders, bool keepAlive, chstr protocol);
+		static void _applyDefaultHeaders(Url& url, hmap<hstr, hstr>& customHeaders, bool keepAlive);
+		/// @return True if repeating a request with this method has the same effect as sending it once, so it can be retried safely.
+		static bool _isIdempotent(chstr method);
+
 	private:
 		HttpSocket(const HttpSocket& other); // prevents copying
 
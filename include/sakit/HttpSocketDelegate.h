@@ -32,7 +32,10 @@ namespace sakit
 
 		virtual void onExecuteProgress(HttpSocket* socket, HttpResponse* response, Url url);
 		virtual void onExecuteCompleted(HttpSocket* socket, HttpResponse* response, Url url);
+		/// @note The response contains whatever was received before the failure, e.g. to resume a download with a Range header.
 		virtual void onExecuteFailed(HttpSocket* socket, HttpResponse* response, Url url);
+		/// @param[in] size Size of the whole body or -1 if it is unknown.
+		virtual void onUploadProgress(HttpSocket* socket, int64_t sent, int64_t size);
 
 	};
 
@@ -0,0 +1,68 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a log-linear histogram for latency values.
+
+#ifndef SAKIT_LATENCY_HISTOGRAM_H
+#define SAKIT_LATENCY_HISTOGRAM_H
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstring.h>
+
+#include "sakitExport.h"
+
+namespace sakit
+{
+	class AtomicHistogram;
+
+	/// @brief HDR-style histogram with 16 linear sub-buckets per power of 2 which keeps the relative error below 6.25%.
+	/// @note Values are in microseconds and clamped to roughly 71 minutes.
+	class sakitExport LatencyHistogram
+	{
+	public:
+		friend class AtomicHistogram;
+
+		LatencyHistogram();
+		~LatencyHistogram();
+
+		HL_DEFINE_GET(int64_t, count, Count);
+		HL_DEFINE_GET(int64_t, min, Min);
+		HL_DEFINE_GET(int64_t, max, Max);
+		HL_DEFINE_GET(int64_t, sum, Sum);
+		double getMean() const;
+		/// @param[in] percentile Value from 0 to 100.
+		/// @return Lower bound of the bucket that contains the percentile or 0 if the histogram is empty.
+		int64_t getPercentile(double percentile) const;
+
+		void add(int64_t value, int64_t count = 1);
+		void merge(const LatencyHistogram& other);
+		void clear();
+
+		hstr toString() const;
+
+		static int getBucketIndex(int64_t value);
+		static int64_t getBucketValue(int index);
+
+		static const int SubBucketBits;
+		static const int BucketCount;
+		static const int64_t MaxValue;
+
+	protected:
+		harray<int64_t> buckets;
+		int64_t count;
+		int64_t min;
+		int64_t max;
+		int64_t sum;
+
+	};
+
+}
+#endif
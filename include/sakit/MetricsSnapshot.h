@@ -0,0 +1,63 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a point-in-time copy of throughput and latency metrics.
+
+#ifndef SAKIT_METRICS_SNAPSHOT_H
+#define SAKIT_METRICS_SNAPSHOT_H
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstring.h>
+
+#include "LatencyHistogram.h"
+#include "sakitExport.h"
+
+namespace sakit
+{
+	class sakitExport MetricsSnapshot
+	{
+	public:
+		int64_t bytesSent;
+		int64_t bytesReceived;
+		/// @brief Completed send()/sendAsync() calls.
+		int64_t messagesSent;
+		/// @brief Received data deliveries (TCP) or datagrams (UDP).
+		int64_t messagesReceived;
+		/// @brief Send related system calls.
+		int64_t sendCalls;
+		/// @brief Receive related system calls.
+		int64_t receiveCalls;
+		/// @brief System calls that returned EAGAIN/EWOULDBLOCK.
+		int64_t wouldBlocks;
+		int64_t accepts;
+		int64_t connects;
+		/// @brief Send batches that were flushed, see Socket::beginBatch().
+		int64_t batchFlushes;
+		/// @brief Sends that were gathered into flushed batches.
+		int64_t batchedSends;
+		/// @brief Bytes waiting in sender threads.
+		int64_t sendQueueDepth;
+		/// @brief Bytes waiting in receiver threads to be delivered to delegates.
+		int64_t receiveQueueDepth;
+		/// @brief Connect durations in microseconds.
+		LatencyHistogram connectLatency;
+		/// @brief Durations from a send call until the delegate is notified of completion in microseconds.
+		LatencyHistogram sendLatency;
+
+		MetricsSnapshot();
+		~MetricsSnapshot();
+
+		/// @return Multi-line text dump of all values.
+		hstr toString() const;
+
+	};
+
+}
+#endif
@@ -13,6 +13,8 @@
 #ifndef SAKIT_SOCKET_H
 #define SAKIT_SOCKET_H
 
+#include <atomic>
+
 #include <hltypes/hltypesUtil.h>
 #include <hltypes/hmutex.h>
 #include <hltypes/hstream.h>
@@ -42,8 +44,31 @@ namespace sakit
 		int send(hstream* stream, int count = INT_MAX);
 		int send(chstr data);
 
+		/// @note While an asynchronous send is running, the data is queued and sent after it, small sends are coalesced into
+		/// fewer system calls. Datagrams keep their boundaries. SocketDelegate::onSendFinished() is called when the queue is empty.
 		bool sendAsync(hstream* stream, int count = INT_MAX);
 		bool sendAsync(chstr data);
+		/// @brief Maximum number of bytes waiting to be sent asynchronously, further sends fail. 0 means unlimited, which is the default.
+		HL_DEFINE_GETSET(int64_t, sendQueueLimit, SendQueueLimit);
+		HL_DEFINE_GET(int64_t, sendQueueHighWatermark, SendQueueHighWatermark);
+		HL_DEFINE_GET(int64_t, sendQueueLowWatermark, SendQueueLowWatermark);
+		/// @brief SocketDelegate::onSendQueueHigh() is called when more than high bytes wait to be sent and onSendQueueLow()
+		/// once it dropped to low bytes again.
+		/// @param[in] high 0 disables the notifications, the default is 1 MB with 256 KB as low watermark.
+		void setSendQueueWatermarks(int64_t high, int64_t low);
+		/// @return Bytes that wait to be sent asynchronously.
+		int64_t getSendQueueSize();
+
+		/// @brief Gathers the data of all following asynchronous sends until flushBatch() sends it at once with as few system calls as possible.
+		/// @note Only asynchronous sends are batched. Synchronous sends fail while batched data wasn't flushed yet so they
+		/// can't overtake it. Not supported on connection-less sockets.
+		bool beginBatch();
+		/// @brief Ends the batch and sends the gathered data asynchronously like sendAsync().
+		bool flushBatch();
+		inline bool isBatching() const { return this->batching.load(std::memory_order_relaxed); }
+		HL_DEFINE_IS(autoBatching, AutoBatching);
+		/// @brief Gathers all asynchronous sends and flushes them at the beginning of every update(), i.e. once per update tick.
+		void setAutoBatching(bool value);
 		bool stopReceive();
 		bool stopReceiveAsync();
 
@@ -52,15 +77,46 @@ namespace sakit
 		SenderThread* sender;
 		ReceiverThread* receiver;
 		State idleState;
+		int64_t sendStartTime;
+		int64_t sendQueueLimit;
+		int64_t sendQueueHighWatermark;
+		int64_t sendQueueLowWatermark;
+		/// @brief Whether the delegate was notified about the high watermark.
+		bool sendQueueHigh;
+		std::atomic<bool> batching;
+		bool autoBatching;
+		hstream* batchStream;
+		/// @brief Number of sends gathered in batchStream.
+		int batchCount;
+		hmutex mutexBatch;
+		/// @brief Results of finished senders that still have to be passed on to the delegate in update().
+		harray<State> sendResults;
 
 		Socket(SocketDelegate* socketDelegate, State idleState);
 
 		int _send(hstream* stream, int count) override;
+		/// @note The optional header and trailer are written around the data directly into the sender's stream.
+		bool _sendAsync(hstream* stream, int count, const unsigned char* header = NULL, int headerSize = 0, const unsigned char* trailer = NULL, int trailerSize = 0);
+		/// @note Ignores batching.
+		bool _sendAsyncDirect(hstream* stream, int count, const unsigned char* header = NULL, int headerSize = 0, const unsigned char* trailer = NULL, int trailerSize = 0);
+		/// @return False if no batch is active, the data has to be sent normally then.
+		bool _addToBatch(const unsigned char* data, int count, const unsigned char* header = NULL, int headerSize = 0, const unsigned char* trailer = NULL, int trailerSize = 0);
+		bool _flushBatch();
+		bool _checkBatchEmpty();
 		bool _prepareReceive(hstream* stream);
 		int _finishReceive(int result);
 		bool _startReceiveAsync(int maxValue);
+		/// @brief These change the state with compare-and-swap so sending and receiving don't have to lock mutexState.
+		bool _beginSending();
+		void _endSending();
+		bool _beginReceiving();
+		void _endReceiving();
 
 		void _updateSending();
+		/// @brief Takes over a finished sender's result without calling the delegate.
+		/// @note mutexState has to be locked.
+		void _collectSendResult();
+		void _updateSendQueue();
 		virtual void _updateReceiving() = 0;
 
 		bool _checkStartReceiveStatus(State receiverState);
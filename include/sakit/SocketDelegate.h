@@ -32,6 +32,10 @@ namespace sakit
 		virtual void onSent(Socket* socket, int byteCount);
 		virtual void onSendFinished(Socket* socket);
 		virtual void onSendFailed(Socket* socket);
+		/// @brief Called when more data waits to be sent than the high watermark allows.
+		virtual void onSendQueueHigh(Socket* socket);
+		/// @brief Called when the waiting data dropped to the low watermark after onSendQueueHigh().
+		virtual void onSendQueueLow(Socket* socket);
 
 		virtual void onReceiveFinished(Socket* socket);
 
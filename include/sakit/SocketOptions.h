@@ -0,0 +1,61 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines low level OS socket options that can be applied to sockets and servers.
+
+#ifndef SAKIT_SOCKET_OPTIONS_H
+#define SAKIT_SOCKET_OPTIONS_H
+
+#include <hltypes/hstring.h>
+
+#include "sakitExport.h"
+
+namespace sakit
+{
+	/// @note Every option set to Unset keeps the system default. Options not supported by the platform are skipped with a warning.
+	class sakitExport SocketOptions
+	{
+	public:
+		/// @brief SO_RCVBUF in bytes.
+		int receiveBufferSize;
+		/// @brief SO_SNDBUF in bytes.
+		int sendBufferSize;
+		/// @brief SO_BUSY_POLL in microseconds (Linux only).
+		int busyPoll;
+		/// @brief TCP_QUICKACK, 0 or 1 (Linux only, the kernel can reset it after each receive).
+		int quickAck;
+		/// @brief TCP_CORK, 0 or 1 (TCP_NOPUSH on BSD/Apple).
+		int cork;
+		/// @brief TCP_NOTSENT_LOWAT in bytes.
+		int notSentLowWatermark;
+		/// @brief SO_KEEPALIVE, 0 or 1.
+		int keepAlive;
+		/// @brief TCP_KEEPIDLE in seconds (TCP_KEEPALIVE on Apple).
+		int keepAliveIdle;
+		/// @brief TCP_KEEPINTVL in seconds.
+		int keepAliveInterval;
+		/// @brief TCP_KEEPCNT as number of probes.
+		int keepAliveCount;
+		/// @brief TCP_USER_TIMEOUT in milliseconds (Linux only).
+		int userTimeout;
+		/// @brief IP_TOS as raw TOS/DSCP byte.
+		int typeOfService;
+
+		SocketOptions();
+		~SocketOptions();
+
+		hstr toString() const;
+
+		static const int Unset;
+
+	};
+
+}
+#endif
@@ -8,11 +8,13 @@
 /// 
 /// @section DESCRIPTION
 /// 
-/// Defines states used internally.
+/// Defines states used internally and a lock-free holder for them.
 
 #ifndef SAKIT_STATE_H
 #define SAKIT_STATE_H
 
+#include <atomic>
+
 #include <hltypes/henum.h>
 
 #include "sakitExport.h"
@@ -35,22 +37,74 @@ namespace sakit
 		HL_ENUM_DECLARE(State, Finished);
 		HL_ENUM_DECLARE(State, Failed);
 
-		static harray<State> allowedBindStates;
-		static harray<State> allowedUnbindStates;
-		static harray<State> allowedConnectStates;
-		static harray<State> allowedDisconnectStates;
-		static harray<State> allowedSendStatesBasic;
-		static harray<State> allowedReceiveStatesBasic;
-		static harray<State> allowedStopReceiveStates;
-		static harray<State> allowedSetDestinationStates;
-		static harray<State> allowedJoinMulticastGroupStates;
-		static harray<State> allowedLeaveMulticastGroupStates;
-		static harray<State> allowedServerStartStates;
-		static harray<State> allowedServerStopStates;
-		static harray<State> allowedHttpExecuteStates;
-		static harray<State> allowedHttpAbortStates;
+		/// @brief Single bits of the states so they can be combined into sets at compile time.
+		/// @note Must match the values in State.cpp.
+		enum Mask
+		{
+			MaskIdle = (1 << 0),
+			MaskBinding = (1 << 1),
+			MaskBound = (1 << 2),
+			MaskUnbinding = (1 << 3),
+			MaskConnecting = (1 << 4),
+			MaskConnected = (1 << 5),
+			MaskDisconnecting = (1 << 6),
+			MaskRunning = (1 << 7),
+			MaskSending = (1 << 8),
+			MaskReceiving = (1 << 9),
+			MaskSendingReceiving = (1 << 10),
+			MaskFinished = (1 << 11),
+			MaskFailed = (1 << 12)
+		};
+
+		/// @return The bit of this state.
+		inline unsigned int getMask() const { return (1u << this->value); }
+
+		static constexpr unsigned int allowedBindStates = MaskIdle;
+		static constexpr unsigned int allowedUnbindStates = MaskBound;
+		static constexpr unsigned int allowedConnectStates = MaskIdle;
+		static constexpr unsigned int allowedDisconnectStates = MaskConnected;
+		/// @note The idle state of the socket has to be added.
+		static constexpr unsigned int allowedSendStatesBasic = MaskReceiving;
+		/// @note The idle state of the socket has to be added.
+		static constexpr unsigned int allowedReceiveStatesBasic = MaskSending;
+		static constexpr unsigned int allowedStopReceiveStates = (MaskReceiving | MaskSendingReceiving);
+		static constexpr unsigned int allowedSetDestinationStates = MaskBound;
+		static constexpr unsigned int allowedJoinMulticastGroupStates = (MaskBound | MaskSending | MaskReceiving | MaskSendingReceiving);
+		static constexpr unsigned int allowedLeaveMulticastGroupStates = (MaskBound | MaskSending | MaskReceiving | MaskSendingReceiving);
+		static constexpr unsigned int allowedServerStartStates = MaskBound;
+		static constexpr unsigned int allowedServerStopStates = MaskRunning;
+		static constexpr unsigned int allowedHttpExecuteStates = (MaskIdle | MaskConnected);
+		static constexpr unsigned int allowedHttpAbortStates = MaskRunning;
 
 	));
 
+	/// @brief Holds a State that can be read and changed by multiple threads without locking.
+	class sakitExport AtomicState
+	{
+	public:
+		AtomicState();
+		AtomicState(const State& state);
+
+		State get() const;
+		/// @return The bit of the current state.
+		unsigned int getMask() const;
+		/// @brief Changes the state only if it still is the expected one.
+		/// @param[in,out] expected Receives the current state if it was a different one.
+		/// @return True if the state was changed.
+		bool compareExchange(State& expected, const State& desired);
+
+		inline operator State() const { return this->get(); }
+		AtomicState& operator=(const State& other);
+		bool operator==(const State& other) const;
+		bool operator!=(const State& other) const;
+
+	protected:
+		std::atomic<unsigned int> value;
+
+	private:
+		AtomicState(const AtomicState& other); // prevents copying
+
+	};
+
 }
 #endif
@@ -15,6 +15,7 @@
 
 #include "sakitExport.h"
 #include "Server.h"
+#include "SocketOptions.h"
 
 namespace sakit
 {
@@ -30,6 +31,8 @@ namespace sakit
 		~TcpServer();
 
 		harray<TcpSocket*> getSockets();
+		/// @brief Options applied to every accepted socket.
+		HL_DEFINE_GETSET(SocketOptions, acceptedOptions, AcceptedOptions);
 
 		void update(float timeDelta = 0.0f) override;
 
@@ -40,6 +43,7 @@ namespace sakit
 		TcpServerThread* tcpServerThread;
 		TcpServerDelegate* tcpServerDelegate;
 		TcpSocketDelegate* acceptedDelegate;
+		SocketOptions acceptedOptions;
 
 		void _updateSockets();
 
@@ -13,9 +13,15 @@
 #ifndef SAKIT_TCP_SOCKET_H
 #define SAKIT_TCP_SOCKET_H
 
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmutex.h>
 #include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
 
+#include "ConnectionStats.h"
 #include "Connector.h"
+#include "Framing.h"
 #include "Host.h"
 #include "sakitExport.h"
 #include "Socket.h"
@@ -24,29 +30,93 @@
 namespace sakit
 {
 	class ConnectorThread;
+	class HttpServerThread;
 	class TcpReceiverThread;
 	class TcpSocketDelegate;
 
 	class sakitExport TcpSocket : public Socket, public Connector
 	{
 	public:
+		friend class HttpServerThread;
+
 		TcpSocket(TcpSocketDelegate* socketDelegate);
 		~TcpSocket();
 
 		bool setNagleAlgorithmActive(bool value);
 
+		HL_DEFINE_GET(Framing, framing, Framing);
+		/// @brief Splits asynchronously received data into messages delivered through TcpSocketDelegate::onReceivedMessage().
+		/// @note Data of an incomplete message received before is discarded.
+		void setFraming(Framing value);
+		/// @brief Terminates messages when Framing::Delimiter is used.
+		HL_DEFINE_GETSET(hstr, framingDelimiter, FramingDelimiter);
+		/// @brief Larger incoming messages stop receiving and outgoing ones are rejected.
+		HL_DEFINE_GETSET(int, maxMessageSize, MaxMessageSize);
+
+		/// @note Values that could not be read are -1.
+		ConnectionStats getConnectionStats();
+		/// @brief Records the connection stats every interval seconds during update() into a ring buffer.
+		/// @param[in] interval Sampling interval in seconds.
+		/// @param[in] capacity Maximum number of samples kept, older samples are overwritten.
+		void startStatsSampling(float interval, int capacity = 60);
+		void stopStatsSampling();
+		bool isStatsSampling();
+		/// @return Recorded samples, oldest first.
+		harray<ConnectionStats> getStatsSamples();
+
 		void update(float timeDelta = 0.0f) override;
 
 		/// @note Keep in mind that only all queued stream data is received at once.
 		int receive(hstream* stream, int maxCount = 0);
 		hstr receive(int maxCount = 0);
 		bool startReceiveAsync(int maxCount = 0);
+		/// @brief Asynchronous receiving stops reading while more than high bytes wait for update() and continues at or below low bytes.
+		/// @param[in] high 0 disables the limit, the default is 16 MB with 4 MB as low watermark.
+		/// @note See also sakit::setGlobalReceiveWatermarks().
+		void setReceiveWatermarks(int64_t high, int64_t low);
+		int64_t getReceiveHighWatermark();
+		int64_t getReceiveLowWatermark();
+		/// @return Whether asynchronous receiving currently doesn't read because of the watermarks.
+		bool isReceivePaused();
+
+		/// @brief Sends the data as one message using the current framing.
+		/// @return Number of sent message bytes, excluding the framing.
+		/// @note Framing and message are written with one gathered write call.
+		int sendMessage(hstream* stream, int count = INT_MAX);
+		int sendMessage(chstr data);
+		bool sendMessageAsync(hstream* stream, int count = INT_MAX);
+		bool sendMessageAsync(chstr data);
 
 	protected:
 		TcpSocketDelegate* tcpSocketDelegate;
 		TcpReceiverThread* tcpReceiver;
+		float statsSamplingInterval;
+		int64_t lastStatsSampleTime;
+		harray<ConnectionStats> statsSamples;
+		int statsSamplesCapacity;
+		int statsSamplesIndex;
+		hmutex mutexStatsSamples;
+		Framing framing;
+		hstr framingDelimiter;
+		int maxMessageSize;
+		/// @brief Holds the beginning of a message that didn't arrive whole yet.
+		hstream framingBuffer;
+		bool framingFailed;
+		/// @brief Whether the delegate was notified about a pause.
+		bool receivePaused;
 
 		void _updateReceiving() override;
+		void _updateReceivePaused();
+		void _updateStatsSampling();
+		void _processReceived(hstream* stream);
+		int _completeMessage(hstream* stream);
+		/// @return Size of the whole message including framing, 0 if it's incomplete and -1 if it's invalid.
+		/// @note requiredSize is the size of the whole message including framing if it's known already, otherwise -1.
+		int _findMessage(const unsigned char* data, int size, int searchOffset, int& payloadOffset, int& payloadSize, int& requiredSize);
+		/// @return Size of the framing data written in front of the message or -1 if the message can't be framed.
+		int _makeMessageHeader(int size, unsigned char* header);
+		int _sendMessageDirect(const unsigned char* header, int headerSize, const unsigned char* data, int size, const unsigned char* trailer, int trailerSize);
+		void _failFraming(chstr message);
 
 		void _activateConnection(Host remoteHost, unsigned short remotePort, Host localHost, unsigned short localPort) override;
 
@@ -32,6 +32,15 @@ namespace sakit
 
 		virtual void onReceived(TcpSocket* socket, hstream* stream);
 		virtual void onReceiveFailed(TcpSocket* socket);
+		/// @brief Called when asynchronous receiving stopped reading because too much received data is waiting for update().
+		/// @note The data stays in the OS buffer so TCP flow control slows down the peer.
+		virtual void onReceivePaused(TcpSocket* socket);
+		/// @brief Called when asynchronous receiving continues reading after it was paused.
+		virtual void onReceiveResumed(TcpSocket* socket);
+		/// @brief Called once for every complete message when framing is used instead of onReceived().
+		/// @param[in] stream The message are the size bytes at the current position.
+		/// @note The stream is only valid during the call and must not be modified.
+		virtual void onReceivedMessage(TcpSocket* socket, hstream* stream, int size);
 
 	};
 
@@ -0,0 +1,242 @@
+/// @file
+/// @version 1.2
+///
+/// @section LICENSE
+///
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+///
+/// @section DESCRIPTION
+///
+/// Defines a reliable, ordered message channel to one peer on top of UDP datagrams.
+
+#ifndef SAKIT_UDP_CHANNEL_H
+#define SAKIT_UDP_CHANNEL_H
+
+#include <limits.h>
+#include <stdint.h>
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
+#include "Delivery.h"
+#include "sakitExport.h"
+
+#define SAKIT_UDP_CHANNEL_LANES 64
+
+namespace sakit
+{
+	class UdpChannelDelegate;
+	class UdpSocket;
+
+	/// @brief Sends messages with a chosen Delivery on up to SAKIT_UDP_CHANNEL_LANES independent lanes to one peer.
+	/// @note Every datagram carries a packet sequence number and selective acknowledgements of the last 33 received packets.
+	/// Reliable messages are retransmitted after an RTT based timeout or when 3 newer packets were acknowledged before them.
+	/// Messages larger than the MTU are fragmented. Sending is limited by a congestion window and paced over time. Received
+	/// datagrams of the peer have to be passed to processDatagram() and update() has to be called regularly. A UdpChannel is not
+	/// thread-safe and must not be deleted during one of its delegate callbacks.
+	class sakitExport UdpChannel
+	{
+	public:
+		/// @param[in] socket Used to send datagrams to its destination. If NULL, datagrams are passed to
+		/// UdpChannelDelegate::onSendDatagram() instead.
+		UdpChannel(UdpChannelDelegate* channelDelegate, UdpSocket* socket = NULL);
+		~UdpChannel();
+
+		HL_DEFINE_GET(UdpSocket*, socket, Socket);
+		/// @brief Maximum datagram size, larger messages are fragmented.
+		HL_DEFINE_GET(int, mtu, Mtu);
+		void setMtu(int value);
+		HL_DEFINE_GETSET(int, maxMessageSize, MaxMessageSize);
+		/// @brief Pacing rate in bytes per second, 0 paces with the congestion window per RTT.
+		HL_DEFINE_GETSET(int, sendRate, SendRate);
+		/// @brief After this many retransmissions of one message the channel fails.
+		HL_DEFINE_GETSET(int, maxRetransmits, MaxRetransmits);
+		HL_DEFINE_IS(failed, Failed);
+		/// @brief Outgoing datagrams are dropped with this probability, meant for testing.
+		HL_DEFINE_GETSET(float, simulatedLoss, SimulatedLoss);
+		/// @brief Outgoing datagrams are delayed by this many seconds, meant for testing.
+		HL_DEFINE_GETSET(float, simulatedLatency, SimulatedLatency);
+		/// @brief Random additional delay in seconds, reorders outgoing datagrams, meant for testing.
+		HL_DEFINE_GETSET(float, simulatedJitter, SimulatedJitter);
+		HL_DEFINE_GET(int, congestionWindow, CongestionWindow);
+		/// @brief Size of sent reliable messages that weren't acknowledged yet.
+		HL_DEFINE_GET(int, bytesInFlight, BytesInFlight);
+		HL_DEFINE_GET(int64_t, retransmitCount, RetransmitCount);
+		/// @brief Smoothed round trip time in seconds, 0 until the first acknowledgement.
+		float getRtt() const;
+		/// @brief Current retransmission timeout in seconds.
+		float getRetransmitTimeout() const;
+		/// @brief Number of messages and fragments that weren't sent yet.
+		int getQueuedCount() const;
+
+		/// @brief Queues the data from the current position of the stream as one message.
+		bool send(hstream* stream, int count = INT_MAX, Delivery delivery = Delivery::ReliableOrdered, int lane = 0);
+		bool send(chstr data, Delivery delivery = Delivery::ReliableOrdered, int lane = 0);
+		/// @brief Processes a datagram received from the peer, received messages are passed to the delegate right away.
+		/// @return False if the datagram wasn't a valid channel datagram.
+		bool processDatagram(hstream* stream);
+		/// @brief Sends queued messages, retransmissions and acknowledgements.
+		void update(float timeDelta = 0.0f);
+		/// @brief Drops all queued and unacknowledged messages and starts over, the peer has to be reset as well.
+		void reset();
+
+	protected:
+		class OutgoingMessage
+		{
+		public:
+			unsigned int id;
+			/// @brief Delivery in the upper 2 bits, lane in the lower 6 bits.
+			unsigned char type;
+			unsigned short sequence;
+			unsigned short fragmentIndex;
+			unsigned short fragmentCount;
+			hstream data;
+			/// @brief Size including the message header.
+			int size;
+			int sendCount;
+			/// @brief Time of the last transmission, 0 if it has to be retransmitted right away.
+			int64_t sendTime;
+
+			OutgoingMessage(unsigned int id, unsigned char type, unsigned short sequence, unsigned short fragmentIndex, unsigned short fragmentCount);
+
+		};
+
+		class SentPacket
+		{
+		public:
+			unsigned short sequence;
+			int64_t time;
+			/// @brief Whether it carries reliable messages and wasn't acknowledged or considered lost yet.
+			bool pending;
+			harray<unsigned int> messageIds;
+
+			SentPacket();
+
+		};
+
+		class MessageHeader
+		{
+		public:
+			unsigned char type;
+			unsigned char flags;
+			unsigned short sequence;
+			unsigned short fragmentIndex;
+			unsigned short fragmentCount;
+			int offset;
+			int size;
+
+			MessageHeader();
+
+		};
+
+		class Reassembly
+		{
+		public:
+			unsigned short fragmentCount;
+			hmap<unsigned short, hstream*> fragments;
+			int size;
+			int64_t time;
+
+			Reassembly(unsigned short fragmentCount, int64_t time);
+			~Reassembly();
+
+		};
+
+		class DelayedDatagram
+		{
+		public:
+			int64_t time;
+			hstream stream;
+
+			DelayedDatagram(int64_t time);
+
+		};
+
+		UdpChannelDelegate* channelDelegate;
+		UdpSocket* socket;
+		int mtu;
+		int maxMessageSize;
+		int sendRate;
+		int maxRetransmits;
+		bool failed;
+		float simulatedLoss;
+		float simulatedLatency;
+		float simulatedJitter;
+		// sending
+		unsigned int nextMessageId;
+		unsigned short sendSequences[3][SAKIT_UDP_CHANNEL_LANES];
+		unsigned short localSequence;
+		harray<OutgoingMessage*> sendQueue;
+		/// @brief Sent reliable messages by ID, the IDs grow with every message so the oldest ones come first.
+		hmap<unsigned int, OutgoingMessage*> unackedMessages;
+		/// @brief Ring of recently sent packets indexed by sequence number.
+		harray<SentPacket> sentPackets;
+		bool ackReceived;
+		unsigned short highestAck;
+		/// @brief Send time of the most recently sent packet that was acknowledged.
+		int64_t latestAckedTime;
+		// RTT, congestion control and pacing, times in microseconds
+		int64_t smoothedRtt;
+		int64_t rttVariance;
+		int64_t retransmitTimeout;
+		int congestionWindow;
+		int slowStartThreshold;
+		int bytesInFlight;
+		int64_t recoveryEndTime;
+		bool paced;
+		int pacingTokens;
+		int64_t lastPacingTime;
+		int64_t retransmitCount;
+		// receiving
+		bool packetReceived;
+		unsigned short remoteSequence;
+		unsigned int receivedBits;
+		bool ackPending;
+		unsigned short receiveSequences[SAKIT_UDP_CHANNEL_LANES];
+		bool sequencedReceived[SAKIT_UDP_CHANNEL_LANES];
+		unsigned short sequencedSequences[SAKIT_UDP_CHANNEL_LANES];
+		/// @brief Reliable messages that arrived ahead of a missing one, by lane and sequence.
+		hmap<unsigned int, hstream*> pendingMessages;
+		/// @brief Incomplete fragmented messages by type and sequence.
+		hmap<unsigned int, Reassembly*> reassemblies;
+		harray<DelayedDatagram*> delayedDatagrams;
+		hstream packet;
+		hstream message;
+
+		void _clear();
+		void _fail();
+		bool _readMessageHeader(const unsigned char* data, int size, int offset, MessageHeader& header);
+		void _markReceived(unsigned short sequence);
+		void _processAcks(unsigned short ack, unsigned int ackBits, int64_t time);
+		void _acknowledgePacket(unsigned short sequence, int64_t time);
+		void _detectLosses(int64_t time);
+		void _addRttSample(int64_t rtt);
+		void _reduceCongestionWindow(int64_t time);
+		/// @return False if a reliable message had to be dropped, the packet mustn't be acknowledged then.
+		bool _receiveMessage(const MessageHeader& header, const unsigned char* data, int64_t time);
+		bool _acceptMessage(int deliveryCode, int lane, unsigned short sequence);
+		void _deliverMessage(int deliveryCode, int lane, unsigned short sequence, hstream* stream);
+		/// @brief Makes room by removing the oldest reassembly that isn't of a reliable message.
+		bool _evictReassembly();
+		void _expireReassemblies(int64_t time);
+		void _updatePacing(int64_t time);
+		harray<OutgoingMessage*> _getDueMessages(int64_t time);
+		void _sendPacket(harray<OutgoingMessage*>& messages, int64_t time);
+		void _sendDatagram(hstream* stream, int64_t time);
+		void _writeDatagram(hstream* stream);
+		void _sendDelayedDatagrams(int64_t time);
+
+		static int _getDeliveryCode(Delivery delivery);
+		static Delivery _getDelivery(int deliveryCode);
+
+	private:
+		UdpChannel(const UdpChannel& other); // prevents copying
+
+	};
+
+}
+#endif
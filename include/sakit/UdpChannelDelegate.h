@@ -0,0 +1,42 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a delegate for the UdpChannel callbacks.
+
+#ifndef SAKIT_UDP_CHANNEL_DELEGATE_H
+#define SAKIT_UDP_CHANNEL_DELEGATE_H
+
+#include <hltypes/hstream.h>
+
+#include "Delivery.h"
+#include "sakitExport.h"
+
+namespace sakit
+{
+	class UdpChannel;
+
+	class sakitExport UdpChannelDelegate
+	{
+	public:
+		UdpChannelDelegate();
+		virtual ~UdpChannelDelegate();
+
+		/// @brief Called for every outgoing datagram of a channel that has no socket.
+		/// @param[in] stream The whole datagram, only valid during the call.
+		virtual void onSendDatagram(UdpChannel* channel, hstream* stream);
+		/// @param[in] stream Whole message with fragments already joined, only valid during the call.
+		virtual void onReceived(UdpChannel* channel, hstream* stream, Delivery delivery, int lane);
+		/// @brief Called when a reliable message still wasn't acknowledged after the maximum number of retransmissions.
+		virtual void onFailed(UdpChannel* channel);
+
+	};
+
+}
+#endif
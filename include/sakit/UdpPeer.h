@@ -0,0 +1,86 @@
+/// @file
+/// @version 1.2
+///
+/// @section LICENSE
+///
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+///
+/// @section DESCRIPTION
+///
+/// Defines a remote peer of a UDP server.
+
+#ifndef SAKIT_UDP_PEER_H
+#define SAKIT_UDP_PEER_H
+
+#include <stdint.h>
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstring.h>
+
+#include "Host.h"
+#include "sakitExport.h"
+
+#define SAKIT_UDP_PEER_ADDRESS_SIZE 128
+
+namespace sakit
+{
+	class UdpServer;
+
+	/// @brief A sender that a UdpServer has received datagrams from, identified by its binary socket address.
+	/// @note Peers are created and deleted only by their UdpServer. The pointer becomes invalid as soon as
+	/// UdpServerDelegate::onPeerRemoved() returns, so the application must not keep it past that call.
+	class sakitExport UdpPeer
+	{
+	public:
+		friend class UdpServer;
+
+		HL_DEFINE_GET(Host, host, Host);
+		HL_DEFINE_GET(unsigned short, port, Port);
+		/// @brief Arbitrary application data, e.g. a session object.
+		/// @note It has to be released in UdpServerDelegate::onPeerRemoved() or before the UdpServer is deleted.
+		HL_DEFINE_GETSET(void*, userData, UserData);
+		HL_DEFINE_GET(int64_t, receivedCount, ReceivedCount);
+		HL_DEFINE_GET(int64_t, receivedBytes, ReceivedBytes);
+		HL_DEFINE_GET(int64_t, sentCount, SentCount);
+		HL_DEFINE_GET(int64_t, sentBytes, SentBytes);
+		HL_DEFINE_GET(int64_t, sendFailedCount, SendFailedCount);
+		/// @brief Tick count in milliseconds when the first datagram of the peer was received.
+		HL_DEFINE_GET(int64_t, addedTime, AddedTime);
+		/// @brief Tick count in milliseconds when the last datagram of the peer was received.
+		HL_DEFINE_GET(int64_t, lastReceivedTime, LastReceivedTime);
+		/// @return Seconds since the last datagram of the peer was received.
+		float getIdleTime() const;
+
+	protected:
+		unsigned char address[SAKIT_UDP_PEER_ADDRESS_SIZE];
+		int addressSize;
+		/// @brief Hash of the raw address bytes, selects the bucket in the peer table.
+		uint64_t hash;
+		/// @brief Next peer in the same bucket of the peer table.
+		UdpPeer* next;
+		Host host;
+		unsigned short port;
+		void* userData;
+		int64_t receivedCount;
+		int64_t receivedBytes;
+		int64_t sentCount;
+		int64_t sentBytes;
+		int64_t sendFailedCount;
+		int64_t addedTime;
+		int64_t lastReceivedTime;
+
+		UdpPeer(const unsigned char* address, int addressSize, uint64_t hash, int64_t time);
+		~UdpPeer();
+
+		bool _hasAddress(const unsigned char* address, int addressSize) const;
+
+		static uint64_t _makeHash(const unsigned char* address, int addressSize);
+
+	private:
+		UdpPeer(const UdpPeer& other); // prevents copying
+
+	};
+
+}
+#endif
@@ -13,29 +13,71 @@
 #ifndef SAKIT_UDP_SERVER_H
 #define SAKIT_UDP_SERVER_H
 
+#include <limits.h>
+#include <stdint.h>
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
 #include "sakitExport.h"
 #include "Server.h"
 #include "Socket.h"
 
 namespace sakit
 {
+	class UdpPeer;
 	class UdpServerDelegate;
 	class UdpServerThread;
 	class UdpSocket;
 
+	/// @note Every sender of received datagrams is tracked as a UdpPeer that can be replied to with sendTo(). Peers are added,
+	/// expired and reported to the delegate only during update().
 	class sakitExport UdpServer : public Server
 	{
 	public:
 		UdpServer(UdpServerDelegate* serverDelegate);
 		~UdpServer();
 
+		/// @brief Seconds without received datagrams after which a peer is removed, 0 keeps peers until removePeer() is called.
+		HL_DEFINE_GETSET(float, peerTimeout, PeerTimeout);
+		/// @brief Datagrams of new peers are dropped while this many peers are known, 0 means no limit.
+		HL_DEFINE_GETSET(int, maxPeers, MaxPeers);
+		int getPeerCount();
+		harray<UdpPeer*> getPeers();
+
 		void update(float timeDelta = 0.0f) override;
 
 		bool receive(hstream* stream, Host& remoteHost, unsigned short& remotePort);
 
+		/// @brief Sends one datagram to the peer through the server's own socket without resolving its address.
+		/// @note The peer must not have been removed yet, see UdpServerDelegate::onPeerRemoved().
+		bool sendTo(UdpPeer* peer, hstream* stream, int count = INT_MAX);
+		bool sendTo(UdpPeer* peer, chstr data);
+		/// @brief Removes the peer right away and calls UdpServerDelegate::onPeerRemoved().
+		/// @note The peer is deleted afterwards, the pointer is invalid once this returns.
+		void removePeer(UdpPeer* peer);
+
 	protected:
 		UdpServerThread* udpServerThread;
 		UdpServerDelegate* udpServerDelegate;
+		float peerTimeout;
+		int maxPeers;
+		/// @brief Hash table of the peers by their binary address, the peers of a bucket are chained through UdpPeer::next.
+		/// @note The bucket count is a power of 2 and doubles when there are more peers than buckets.
+		UdpPeer** peerBuckets;
+		int peerBucketCount;
+		int peerCount;
+		int64_t lastExpireTime;
+		hmutex peersMutex;
+
+		UdpPeer* _findPeer(const unsigned char* address, int addressSize, uint64_t hash);
+		void _addPeer(UdpPeer* peer);
+		bool _removePeer(UdpPeer* peer);
+		void _expirePeers();
 
 	private:
 		UdpServer(const UdpServer& other); // prevents copying
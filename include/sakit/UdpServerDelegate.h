@@ -20,6 +20,7 @@
 
 namespace sakit
 {
+	class UdpPeer;
 	class UdpServer;
 	class UdpSocket;
 
@@ -29,6 +30,13 @@ namespace sakit
 		UdpServerDelegate();
 
 		virtual void onReceived(UdpServer* server, Host remoteHost, unsigned short remotePort, hstream* stream);
+		/// @note The default implementation calls onReceived() with the host and port of the peer.
+		virtual void onPeerReceived(UdpServer* server, UdpPeer* peer, hstream* stream);
+		/// @brief Called before the first datagram of a new peer is passed on, e.g. to attach user data.
+		virtual void onPeerAdded(UdpServer* server, UdpPeer* peer);
+		/// @brief Called before an expired or removed peer is deleted, e.g. to release its user data.
+		/// @note Every reference to the peer has to be dropped here, it must not be used after this call.
+		virtual void onPeerRemoved(UdpServer* server, UdpPeer* peer);
 
 	};
 
@@ -13,7 +13,10 @@
 #ifndef SAKIT_UDP_SOCKET_H
 #define SAKIT_UDP_SOCKET_H
 
+#include <hltypes/harray.h>
+#include <hltypes/hmap.h>
 #include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
 
 #include "Binder.h"
 #include "Host.h"
@@ -59,15 +62,38 @@ namespace sakit
 		bool broadcastAsync(unsigned short remotePort, chstr data);
 		
 		bool joinMulticastGroup(Host interfaceHost, Host groupAddress);
+		/// @param[in] sourceHost If not empty, only datagrams from this source are received (source-specific multicast).
+		/// @param[in] groupDelegate If not NULL, datagrams sent to this group are passed to it instead of the socket's delegate.
+		/// @note The group of a datagram is only known on platforms with IP_PKTINFO or IP_RECVDSTADDR, elsewhere all datagrams
+		/// are passed to UdpSocketDelegate::onReceived() of the socket's delegate.
+		bool joinMulticastGroup(Host interfaceHost, Host groupAddress, Host sourceHost, UdpSocketDelegate* groupDelegate = NULL);
 		bool leaveMulticastGroup(Host interfaceHost, Host groupAddress);
+		bool leaveMulticastGroup(Host interfaceHost, Host groupAddress, Host sourceHost);
 
 	protected:
+		class MulticastMembership
+		{
+		public:
+			Host interfaceHost;
+			Host groupAddress;
+			Host sourceHost;
+
+			MulticastMembership(Host interfaceHost, Host groupAddress, Host sourceHost);
+
+			bool operator==(const MulticastMembership& other) const;
+
+		};
+
 		UdpSocketDelegate* udpSocketDelegate;
 		UdpReceiverThread* udpReceiver;
 		BroadcasterThread* broadcaster;
 		harray<std::pair<Host, Host> > multicastHosts;
+		harray<MulticastMembership> multicastMemberships;
+		/// @brief Delegates for the datagrams of each joined group by group address.
+		hmap<hstr, UdpSocketDelegate*> groupDelegates;
 
 		void _updateReceiving() override;
+		void _dispatchReceived(Host remoteHost, unsigned short remotePort, Host destinationHost, hstream* stream);
 		void _clear();
 		void _activateConnection(Host remoteHost, unsigned short remotePort, Host localHost, unsigned short localPort) override;
 
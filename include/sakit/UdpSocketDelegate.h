@@ -31,6 +31,9 @@ namespace sakit
 		UdpSocketDelegate();
 
 		virtual void onReceived(UdpSocket* socket, Host remoteHost, unsigned short remotePort, hstream* stream);
+		/// @brief Called for datagrams that were sent to a joined multicast group.
+		/// @note The default implementation calls onReceived().
+		virtual void onReceivedMulticast(UdpSocket* socket, Host groupAddress, Host remoteHost, unsigned short remotePort, hstream* stream);
 
 		virtual void onBroadcastFinished(UdpSocket* socket);
 		virtual void onBroadcastFailed(UdpSocket* socket);
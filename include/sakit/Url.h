@@ -22,6 +22,8 @@
 
 #define SAKIT_HTTP_SCHEME "http://"
 #define SAKIT_HTTPS_SCHEME "https://"
+#define SAKIT_WS_SCHEME "ws://"
+#define SAKIT_WSS_SCHEME "wss://"
 
 namespace sakit
 {
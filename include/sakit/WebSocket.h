@@ -0,0 +1,160 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a WebSocket connection (RFC 6455) on top of a TCP socket.
+
+#ifndef SAKIT_WEB_SOCKET_H
+#define SAKIT_WEB_SOCKET_H
+
+#include <limits.h>
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
+#include "sakitExport.h"
+#include "State.h"
+#include "TcpSocketDelegate.h"
+#include "Url.h"
+
+#define SAKIT_WEB_SOCKET_CLOSE_NORMAL 1000
+#define SAKIT_WEB_SOCKET_CLOSE_GOING_AWAY 1001
+#define SAKIT_WEB_SOCKET_CLOSE_PROTOCOL_ERROR 1002
+#define SAKIT_WEB_SOCKET_CLOSE_NO_STATUS 1005
+#define SAKIT_WEB_SOCKET_CLOSE_ABNORMAL 1006
+#define SAKIT_WEB_SOCKET_CLOSE_INVALID_PAYLOAD 1007
+#define SAKIT_WEB_SOCKET_CLOSE_MESSAGE_TOO_BIG 1009
+
+namespace sakit
+{
+	class HttpServerRequest;
+	class TcpSocket;
+	class WebSocketDelegate;
+	class WebSocketServer;
+
+	/// @brief Sends and receives WebSocket messages over a TcpSocket.
+	/// @note Client WebSockets are created directly and connect to a ws:// URL, server WebSockets are created by WebSocketServer
+	/// for every accepted connection. Delegate callbacks happen during sakit::update() or WebSocketServer::update() respectively.
+	/// All messages are sent asynchronously and in order, a WebSocket must not be deleted during one of its delegate callbacks.
+	class sakitExport WebSocket : protected TcpSocketDelegate
+	{
+	public:
+		friend class WebSocketServer;
+
+		WebSocket(WebSocketDelegate* webSocketDelegate);
+		~WebSocket();
+
+		HL_DEFINE_GET(TcpSocket*, socket, Socket);
+		HL_DEFINE_GET(WebSocketServer*, server, Server);
+		/// @brief Receiving a larger message closes the connection with SAKIT_WEB_SOCKET_CLOSE_MESSAGE_TOO_BIG.
+		HL_DEFINE_GETSET(int, maxMessageSize, MaxMessageSize);
+		/// @brief Sent messages are fragmented into frames of at most this size, 0 sends every message as one frame.
+		HL_DEFINE_GETSET(int, maxFrameSize, MaxFrameSize);
+		bool isOpen();
+		bool isClosing();
+
+		/// @note Messages that arrive together with the handshake response are passed to the delegate before this returns.
+		bool connect(Url url, hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		bool connectAsync(Url url, hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+
+		bool sendText(chstr text);
+		/// @brief Sends the data from the current position of the stream.
+		bool sendBinary(hstream* stream, int count = INT_MAX);
+		bool ping(chstr payload = "");
+		/// @brief Starts the closing handshake, the connection is closed once the other side confirmed it.
+		bool close(unsigned short code = SAKIT_WEB_SOCKET_CLOSE_NORMAL, chstr reason = "");
+
+	protected:
+		WebSocketDelegate* webSocketDelegate;
+		TcpSocket* socket;
+		/// @brief The server that accepted the connection, NULL for client WebSockets.
+		WebSocketServer* server;
+		/// @brief Idle, Connecting during the handshake, Connected while open and Disconnecting during the closing handshake.
+		State state;
+		int maxMessageSize;
+		int maxFrameSize;
+		/// @brief Whether the handshake succeeded, onClosed() is only called for opened connections.
+		bool opened;
+		/// @brief Client handshake key.
+		hstr key;
+		/// @brief Handshake data received so far.
+		hstream handshake;
+		/// @brief Used to parse the server handshake.
+		HttpServerRequest* handshakeRequest;
+		/// @brief When a server WebSocket was accepted, the handshake has to be completed within WebSocketServer::getHandshakeTimeout().
+		int64_t acceptTime;
+		/// @brief Frame header bytes received so far, a header can be split between receives.
+		unsigned char header[14];
+		int headerSize;
+		bool frameStarted;
+		unsigned char frameOpcode;
+		bool frameFinal;
+		bool frameMasked;
+		unsigned char frameMask[4];
+		int64_t frameRemaining;
+		/// @brief Offset in the mask where the next payload byte continues.
+		int maskOffset;
+		/// @brief Opcode of the message that is being received, 0 if none.
+		unsigned char messageOpcode;
+		hstream message;
+		/// @brief Payload of the control frame that is being received.
+		hstream control;
+		/// @brief Frames that are sent once the current asynchronous send finished.
+		hstream sendQueue;
+		bool closeSent;
+		bool closeReceived;
+		unsigned short closeCode;
+		hstr closeReason;
+
+		/// @brief Used by WebSocketServer for accepted connections.
+		WebSocket(WebSocketServer* server, TcpSocket* socket);
+
+		void onConnected(Connector* connector, Host remoteHost, unsigned short remotePort) override;
+		void onConnectFailed(Connector* connector, Host remoteHost, unsigned short remotePort) override;
+		void onReceived(TcpSocket* socket, hstream* stream) override;
+		void onReceiveFinished(Socket* socket) override;
+		void onReceiveFailed(TcpSocket* socket) override;
+		void onSendFinished(Socket* socket) override;
+		void onSendFailed(Socket* socket) override;
+
+		bool _prepareConnect(Url& url);
+		hstr _makeHandshake(Url& url, hmap<hstr, hstr> customHeaders);
+		/// @return Number of bytes that belonged to the handshake or -1 if the handshake failed.
+		int _processClientHandshake(const unsigned char* data, int size);
+		int _processServerHandshake(const unsigned char* data, int size);
+		void _failHandshake();
+		void _processData(const unsigned char* data, int size);
+		/// @return Number of bytes used or -1 if the header is invalid.
+		int _readFrameHeader(const unsigned char* data, int size);
+		void _readPayload(const unsigned char* data, int size);
+		/// @return False if no more frames are processed.
+		bool _finishFrame();
+		bool _sendMessage(unsigned char opcode, const unsigned char* data, int size);
+		void _queueFrame(unsigned char opcode, bool final, const unsigned char* data, int size);
+		void _queueClose(unsigned short code, chstr reason);
+		bool _flushSend();
+		/// @brief Closes the connection because of a protocol violation.
+		void _fail(unsigned short code);
+		void _abort();
+		void _updateClose();
+
+		static hstr _makeAccept(chstr key);
+		static void _applyMask(unsigned char* data, int size, const unsigned char* mask, int offset);
+		/// @note Rejects overlong encodings, UTF-16 surrogates and code points above U+10FFFF.
+		static bool _isValidUtf8(const unsigned char* data, int size);
+
+	private:
+		WebSocket(const WebSocket& other); // prevents copying
+
+	};
+
+}
+#endif
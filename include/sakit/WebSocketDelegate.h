@@ -0,0 +1,45 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a delegate for the WebSocket callbacks.
+
+#ifndef SAKIT_WEB_SOCKET_DELEGATE_H
+#define SAKIT_WEB_SOCKET_DELEGATE_H
+
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
+#include "sakitExport.h"
+
+namespace sakit
+{
+	class WebSocket;
+
+	class sakitExport WebSocketDelegate
+	{
+	public:
+		WebSocketDelegate();
+		virtual ~WebSocketDelegate();
+
+		/// @brief Called when the handshake of a client WebSocket has finished.
+		virtual void onOpened(WebSocket* webSocket);
+		virtual void onOpenFailed(WebSocket* webSocket);
+		/// @param[in] message Whole message with fragments already joined, only valid during the call.
+		virtual void onMessage(WebSocket* webSocket, hstream* message, bool binary);
+		virtual void onPong(WebSocket* webSocket, hstream* payload);
+		/// @note Pings are answered automatically.
+		virtual void onPing(WebSocket* webSocket, hstream* payload);
+		/// @param[in] code Status code sent by the other side or 1006 if the connection was lost without a close frame.
+		virtual void onClosed(WebSocket* webSocket, unsigned short code, chstr reason);
+
+	};
+
+}
+#endif
@@ -0,0 +1,80 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a server that accepts WebSocket connections.
+
+#ifndef SAKIT_WEB_SOCKET_SERVER_H
+#define SAKIT_WEB_SOCKET_SERVER_H
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+
+#include "sakitExport.h"
+#include "TcpServer.h"
+#include "TcpSocketDelegate.h"
+
+namespace sakit
+{
+	class Socket;
+	class TcpSocket;
+	class WebSocket;
+	class WebSocketDelegate;
+	class WebSocketServerDelegate;
+
+	/// @brief Performs the WebSocket handshake on every accepted connection and hands the opened WebSockets to the delegate.
+	/// @note The WebSockets are owned by the server. They are deleted during update() after WebSocketDelegate::onClosed() was
+	/// called for them.
+	class sakitExport WebSocketServer : public TcpServer, protected TcpSocketDelegate
+	{
+	public:
+		friend class WebSocket;
+
+		/// @param[in] webSocketDelegate Delegate of all accepted WebSockets.
+		WebSocketServer(WebSocketServerDelegate* serverDelegate, WebSocketDelegate* webSocketDelegate);
+		~WebSocketServer();
+
+		/// @brief Applied to every accepted WebSocket.
+		HL_DEFINE_GETSET(int, maxMessageSize, MaxMessageSize);
+		/// @brief Applied to every accepted WebSocket.
+		HL_DEFINE_GETSET(int, maxFrameSize, MaxFrameSize);
+		/// @brief Connections that didn't complete the handshake after this many seconds are closed.
+		HL_DEFINE_GETSET(float, handshakeTimeout, HandshakeTimeout);
+		/// @return All WebSockets that are open.
+		harray<WebSocket*> getWebSockets();
+
+		void update(float timeDelta = 0.0f) override;
+
+	protected:
+		WebSocketServerDelegate* webSocketServerDelegate;
+		WebSocketDelegate* webSocketDelegate;
+		int maxMessageSize;
+		int maxFrameSize;
+		float handshakeTimeout;
+		harray<WebSocket*> webSockets;
+		/// @brief Accepted sockets report to the server which passes the callbacks on to their WebSocket.
+		hmap<Socket*, WebSocket*> socketWebSockets;
+
+		void onReceived(TcpSocket* socket, hstream* stream) override;
+		void onReceiveFinished(Socket* socket) override;
+		void onReceiveFailed(TcpSocket* socket) override;
+		void onSendFinished(Socket* socket) override;
+		void onSendFailed(Socket* socket) override;
+
+		TcpSocketDelegate* _getSocketDelegate(Socket* socket);
+		void _removeClosedWebSockets();
+
+	private:
+		WebSocketServer(const WebSocketServer& other); // prevents copying
+
+	};
+
+}
+#endif
@@ -0,0 +1,36 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a delegate for the WebSocket server callbacks.
+
+#ifndef SAKIT_WEB_SOCKET_SERVER_DELEGATE_H
+#define SAKIT_WEB_SOCKET_SERVER_DELEGATE_H
+
+#include "sakitExport.h"
+#include "TcpServerDelegate.h"
+
+namespace sakit
+{
+	class WebSocket;
+	class WebSocketServer;
+
+	class sakitExport WebSocketServerDelegate : public TcpServerDelegate
+	{
+	public:
+		WebSocketServerDelegate();
+
+		/// @brief Called when the handshake of an accepted connection has finished.
+		/// @note onAccepted() isn't called since accepted connections are only usable after the handshake.
+		virtual void onOpened(WebSocketServer* server, WebSocket* webSocket);
+
+	};
+
+}
+#endif
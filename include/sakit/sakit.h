@@ -13,10 +13,13 @@
 #ifndef SAKIT_H
 #define SAKIT_H
 
+#include <stdint.h>
+
 #include <hltypes/harray.h>
 #include <hltypes/hstring.h>
 
 #include "Host.h"
+#include "MetricsSnapshot.h"
 #include "NetworkAdapter.h"
 #include "sakitExport.h"
 
@@ -32,10 +35,17 @@ namespace sakit
 	sakitFnExport void update(float timeDelta = 0.0f);
 	sakitFnExport int getBufferSize();
 	sakitFnExport void setBufferSize(int value);
+	/// @brief Limit for data received by all TCP sockets that is waiting for update(), 0 means unlimited.
+	/// @note Sockets with waiting data stop reading above the high watermark and continue at or below the low watermark.
+	sakitFnExport int64_t getGlobalReceiveHighWatermark();
+	sakitFnExport int64_t getGlobalReceiveLowWatermark();
+	sakitFnExport void setGlobalReceiveWatermarks(int64_t high, int64_t low);
 	sakitFnExport float getGlobalTimeout();
 	sakitFnExport float getGlobalRetryFrequency();
 	sakitFnExport void setGlobalTimeout(float globalTimeout, float globalRetryFrequency = 0.01f);
 	sakitFnExport harray<NetworkAdapter> getNetworkAdapters();
+	/// @return Counters and latencies aggregated over all sockets and servers.
+	sakitFnExport MetricsSnapshot getGlobalMetrics();
 	/// @return The IP of the domain/host.
 	sakitFnExport Host resolveHost(Host domain);
 	/// @return The domain/host associated with this IP address.
@@ -12,6 +12,7 @@
 #include <hltypes/hstring.h>
 
 #include "Base.h"
+#include "Metrics.h"
 #include "PlatformSocket.h"
 #include "sakit.h"
 
@@ -58,6 +59,26 @@ namespace sakit
 		this->retryFrequency = hmin(retryFrequency, timeout); // frequency can't be larger than the timeout itself
 	}
 
+	SocketOptions Base::getOptions() const
+	{
+		return this->socket->getOptions();
+	}
+
+	bool Base::setOptions(const SocketOptions& options)
+	{
+		return this->socket->setOptions(options);
+	}
+
+	SocketOptions Base::getEffectiveOptions() const
+	{
+		return this->socket->getEffectiveOptions();
+	}
+
+	MetricsSnapshot Base::getMetrics() const
+	{
+		return this->socket->getMetrics()->getSnapshot();
+	}
+
 	int Base::_sendDirect(hstream* stream, int count)
 	{
 		int sent = 0;
@@ -39,7 +39,7 @@ namespace sakit
 		}
 	}
 
-	void Binder::_integrate(State* stateValue, hmutex* mutexStateValue, Host* localHost, unsigned short* localPort)
+	void Binder::_integrate(AtomicState* stateValue, hmutex* mutexStateValue, Host* localHost, unsigned short* localPort)
 	{
 		this->_state = stateValue;
 		this->_mutexState = mutexStateValue;
@@ -50,19 +50,16 @@ namespace sakit
 
 	bool Binder::isBinding()
 	{
-		hmutex::ScopeLock lock(this->_mutexState);
 		return (*this->_state == State::Binding);
 	}
 
 	bool Binder::isBound()
 	{
-		hmutex::ScopeLock lock(this->_mutexState);
-		return (*this->_state != State::Idle && *this->_state != State::Binding);
+		return ((this->_state->getMask() & (State::MaskIdle | State::MaskBinding)) == 0);
 	}
 
 	bool Binder::isUnbinding()
 	{
-		hmutex::ScopeLock lock(this->_mutexState);
 		return (*this->_state == State::Unbinding);
 	}
 
@@ -139,11 +136,13 @@ namespace sakit
 	{
 		hmutex::ScopeLock lock(this->_mutexState);
 		State state = *this->_state;
-		if (!this->_canBind(state))
+		do
 		{
-			return false;
-		}
-		*this->_state = State::Binding;
+			if (!this->_canBind(state))
+			{
+				return false;
+			}
+		} while (!this->_state->compareExchange(state, State::Binding));
 		lock.release();
 		bool result = this->_socket->bind(localHost, localPort);
 		lock.acquire(this->_mutexState);
@@ -169,11 +168,13 @@ namespace sakit
 	{
 		hmutex::ScopeLock lock(this->_mutexState);
 		State state = *this->_state;
-		if (!this->_canUnbind(state))
+		do
 		{
-			return false;
-		}
-		*this->_state = State::Unbinding;
+			if (!this->_canUnbind(state))
+			{
+				return false;
+			}
+		} while (!this->_state->compareExchange(state, State::Unbinding));
 		lock.release();
 		bool result = this->_socket->disconnect();
 		lock.acquire(this->_mutexState);
@@ -193,11 +194,14 @@ namespace sakit
 	bool Binder::bindAsync(Host localHost, unsigned short localPort)
 	{
 		hmutex::ScopeLock lock(this->_mutexState);
-		if (!this->_canBind(*this->_state))
+		State state = *this->_state;
+		do
 		{
-			return false;
-		}
-		*this->_state = State::Binding;
+			if (!this->_canBind(state))
+			{
+				return false;
+			}
+		} while (!this->_state->compareExchange(state, State::Binding));
 		this->_thread->state = State::Binding;
 		this->_thread->result = State::Running;
 		this->_thread->host = localHost;
@@ -214,11 +218,14 @@ namespace sakit
 	bool Binder::unbindAsync()
 	{
 		hmutex::ScopeLock lock(this->_mutexState);
-		if (!this->_canUnbind(*this->_state))
+		State state = *this->_state;
+		do
 		{
-			return false;
-		}
-		*this->_state = State::Unbinding;
+			if (!this->_canUnbind(state))
+			{
+				return false;
+			}
+		} while (!this->_state->compareExchange(state, State::Unbinding));
 		this->_thread->state = State::Unbinding;
 		this->_thread->result = State::Running;
 		this->_thread->start();
@@ -0,0 +1,37 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/hstring.h>
+
+#include "ConnectionStats.h"
+
+namespace sakit
+{
+	ConnectionStats::ConnectionStats() :
+		time(0LL),
+		rtt(-1.0f),
+		rttVariance(-1.0f),
+		congestionWindow(-1LL),
+		retransmits(-1),
+		bytesAcked(-1LL),
+		deliveryRate(-1LL),
+		pacingRate(-1LL)
+	{
+	}
+
+	ConnectionStats::~ConnectionStats()
+	{
+	}
+
+	hstr ConnectionStats::toString() const
+	{
+		return hsprintf("rtt=%.3f rttVariance=%.3f congestionWindow=%lld retransmits=%d bytesAcked=%lld deliveryRate=%lld pacingRate=%lld",
+			this->rtt, this->rttVariance, (long long)this->congestionWindow, this->retransmits, (long long)this->bytesAcked, (long long)this->deliveryRate, (long long)this->pacingRate);
+	}
+
+}
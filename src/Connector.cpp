@@ -44,7 +44,7 @@ namespace sakit
 		}
 	}
 
-	void Connector::_integrate(State* stateValue, hmutex* mutexStateValue, Host* remoteHost, unsigned short* remotePort, Host* localHost, unsigned short* localPort, float* timeout, float* retryFrequency)
+	void Connector::_integrate(AtomicState* stateValue, hmutex* mutexStateValue, Host* remoteHost, unsigned short* remotePort, Host* localHost, unsigned short* localPort, float* timeout, float* retryFrequency)
 	{
 		this->_state = stateValue;
 		this->_mutexState = mutexStateValue;
@@ -59,19 +59,16 @@ namespace sakit
 
 	bool Connector::isConnecting()
 	{
-		hmutex::ScopeLock lock(this->_mutexState);
 		return (*this->_state == State::Connecting);
 	}
 
 	bool Connector::isConnected()
 	{
-		hmutex::ScopeLock lock(this->_mutexState);
-		return (*this->_state != State::Idle && *this->_state != State::Connecting);
+		return ((this->_state->getMask() & (State::MaskIdle | State::MaskConnecting)) == 0);
 	}
 
 	bool Connector::isDisconnecting()
 	{
-		hmutex::ScopeLock lock(this->_mutexState);
 		return (*this->_state == State::Disconnecting);
 	}
 
@@ -154,11 +151,13 @@ namespace sakit
 	{
 		hmutex::ScopeLock lock(this->_mutexState);
 		State state = *this->_state;
-		if (!this->_canConnect(state))
+		do
 		{
-			return false;
-		}
-		*this->_state = State::Connecting;
+			if (!this->_canConnect(state))
+			{
+				return false;
+			}
+		} while (!this->_state->compareExchange(state, State::Connecting));
 		lock.release();
 		Host localHost;
 		unsigned short localPort = 0;
@@ -183,11 +182,13 @@ namespace sakit
 	{
 		hmutex::ScopeLock lock(this->_mutexState);
 		State state = *this->_state;
-		if (!this->_canDisconnect(state))
+		do
 		{
-			return false;
-		}
-		*this->_state = State::Disconnecting;
+			if (!this->_canDisconnect(state))
+			{
+				return false;
+			}
+		} while (!this->_state->compareExchange(state, State::Disconnecting));
 		lock.release();
 		bool result = this->_socket->disconnect();
 		lock.acquire(this->_mutexState);
@@ -209,11 +210,14 @@ namespace sakit
 	bool Connector::connectAsync(Host remoteHost, unsigned short remotePort)
 	{
 		hmutex::ScopeLock lock(this->_mutexState);
-		if (!this->_canConnect(*this->_state))
+		State state = *this->_state;
+		do
 		{
-			return false;
-		}
-		*this->_state = State::Connecting;
+			if (!this->_canConnect(state))
+			{
+				return false;
+			}
+		} while (!this->_state->compareExchange(state, State::Connecting));
 		this->_thread->state = State::Connecting;
 		this->_thread->result = State::Running;
 		this->_thread->host = remoteHost;
@@ -225,11 +229,14 @@ namespace sakit
 	bool Connector::disconnectAsync()
 	{
 		hmutex::ScopeLock lock(this->_mutexState);
-		if (!this->_canDisconnect(*this->_state))
+		State state = *this->_state;
+		do
 		{
-			return false;
-		}
-		*this->_state = State::Disconnecting;
+			if (!this->_canDisconnect(state))
+			{
+				return false;
+			}
+		} while (!this->_state->compareExchange(state, State::Disconnecting));
 		this->_thread->state = State::Disconnecting;
 		this->_thread->result = State::Running;
 		this->_thread->start();
@@ -0,0 +1,225 @@
+/// @file
+/// @version 1.2
+///
+/// @section LICENSE
+///
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define _SAKIT_SSE2
+#if defined(__GNUC__) || defined(__clang__) || (defined(_MSC_VER) && _MSC_VER >= 1700)
+#define _SAKIT_AVX2
+#endif
+#endif
+#endif
+
+#ifdef _SAKIT_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef _SAKIT_AVX2
+#include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstring.h>
+
+#include "DelimiterScanner.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+namespace sakit
+{
+	typedef int (*FindByteFunction)(const unsigned char*, int, unsigned char);
+
+	static inline int _trailingZeros(unsigned int value)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return __builtin_ctz(value);
+#elif defined(_MSC_VER)
+		unsigned long index = 0;
+		_BitScanForward(&index, value);
+		return (int)index;
+#else
+		int result = 0;
+		while ((value & 1) == 0)
+		{
+			value >>= 1;
+			++result;
+		}
+		return result;
+#endif
+	}
+
+	static int _findByteScalar(const unsigned char* data, int size, unsigned char value)
+	{
+		for_iter (i, 0, size)
+		{
+			if (data[i] == value)
+			{
+				return i;
+			}
+		}
+		return -1;
+	}
+
+#ifdef _SAKIT_SSE2
+	static int _findByteSse2(const unsigned char* data, int size, unsigned char value)
+	{
+		const __m128i pattern = _mm_set1_epi8((char)value);
+		unsigned int mask = 0;
+		int i = 0;
+		for (; i + 16 <= size; i += 16)
+		{
+			mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)&data[i]), pattern));
+			if (mask != 0)
+			{
+				return i + _trailingZeros(mask);
+			}
+		}
+		int result = _findByteScalar(&data[i], size - i, value);
+		return (result >= 0 ? i + result : -1);
+	}
+#endif
+
+#ifdef _SAKIT_AVX2
+	TARGET_AVX2 static int _findByteAvx2(const unsigned char* data, int size, unsigned char value)
+	{
+		const __m256i pattern = _mm256_set1_epi8((char)value);
+		unsigned int mask = 0;
+		int i = 0;
+		for (; i + 32 <= size; i += 32)
+		{
+			mask = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)&data[i]), pattern));
+			if (mask != 0)
+			{
+				return i + _trailingZeros(mask);
+			}
+		}
+		int result = _findByteSse2(&data[i], size - i, value);
+		return (result >= 0 ? i + result : -1);
+	}
+
+	static bool _isAvx2Supported()
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		__builtin_cpu_init();
+		return (__builtin_cpu_supports("avx2") != 0);
+#else
+		int info[4] = { 0 };
+		__cpuid(info, 0);
+		if (info[0] < 7)
+		{
+			return false;
+		}
+		__cpuid(info, 1);
+		// AVX and OSXSAVE are required, otherwise the OS doesn't preserve the YMM registers
+		if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 0x6) != 0x6)
+		{
+			return false;
+		}
+		__cpuidex(info, 7, 0);
+		return ((info[1] & (1 << 5)) != 0);
+#endif
+	}
+#endif
+
+	static FindByteFunction _getFindByteFunction(chstr name)
+	{
+		if (name == "scalar")
+		{
+			return &_findByteScalar;
+		}
+#ifdef _SAKIT_SSE2
+		if (name == "sse2")
+		{
+			return &_findByteSse2;
+		}
+#endif
+#ifdef _SAKIT_AVX2
+		if (name == "avx2" && _isAvx2Supported())
+		{
+			return &_findByteAvx2;
+		}
+#endif
+		return NULL;
+	}
+
+	static hstr _selectImplementation()
+	{
+		harray<hstr> implementations = DelimiterScanner::getAvailableImplementations();
+		return implementations.last();
+	}
+
+	static hstr implementation = _selectImplementation();
+	static FindByteFunction findByteFunction = _getFindByteFunction(implementation);
+
+	int DelimiterScanner::findByte(const unsigned char* data, int size, unsigned char value)
+	{
+		return (*findByteFunction)(data, size, value);
+	}
+
+	int DelimiterScanner::findLineEnd(const unsigned char* data, int size)
+	{
+		int offset = 0;
+		int index = 0;
+		while (offset < size)
+		{
+			index = (*findByteFunction)(&data[offset], size - offset, '\n');
+			if (index < 0)
+			{
+				break;
+			}
+			offset += index;
+			if (offset > 0 && data[offset - 1] == '\r')
+			{
+				return offset - 1;
+			}
+			++offset;
+		}
+		return -1;
+	}
+
+	hstr DelimiterScanner::getImplementation()
+	{
+		return implementation;
+	}
+
+	harray<hstr> DelimiterScanner::getAvailableImplementations()
+	{
+		harray<hstr> result;
+		result += "scalar";
+#ifdef _SAKIT_SSE2
+		result += "sse2";
+#endif
+#ifdef _SAKIT_AVX2
+		if (_isAvx2Supported())
+		{
+			result += "avx2";
+		}
+#endif
+		return result;
+	}
+
+	bool DelimiterScanner::setImplementation(chstr name)
+	{
+		FindByteFunction function = _getFindByteFunction(name);
+		if (function == NULL)
+		{
+			return false;
+		}
+		implementation = name;
+		findByteFunction = function;
+		return true;
+	}
+
+}
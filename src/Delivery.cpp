@@ -0,0 +1,20 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include "Delivery.h"
+
+namespace sakit
+{
+	HL_ENUM_CLASS_DEFINE(Delivery,
+	(
+		HL_ENUM_DEFINE(Delivery, Unreliable);
+		HL_ENUM_DEFINE(Delivery, UnreliableSequenced);
+		HL_ENUM_DEFINE(Delivery, ReliableOrdered);
+
+	));
+}
@@ -0,0 +1,21 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include "Framing.h"
+
+namespace sakit
+{
+	HL_ENUM_CLASS_DEFINE(Framing,
+	(
+		HL_ENUM_DEFINE(Framing, None);
+		HL_ENUM_DEFINE(Framing, Fixed32);
+		HL_ENUM_DEFINE(Framing, Varint);
+		HL_ENUM_DEFINE(Framing, Delimiter);
+
+	));
+}
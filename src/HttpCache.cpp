@@ -0,0 +1,696 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/harray.h>
+#include <hltypes/hdir.h>
+#include <hltypes/hfile.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
+#include "HttpCache.h"
+#include "HttpResponse.h"
+#include "HttpSocket.h"
+#include "sakit.h"
+
+#define FILE_HEADER "sakit-http-cache 2"
+#define FILE_EXTENSION ".cache"
+#define REQUEST_GET "GET"
+#define REQUEST_POST "POST"
+#define REQUEST_PUT "PUT"
+#define REQUEST_DELETE "DELETE"
+
+namespace sakit
+{
+	static const char* months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+	// headers that only apply to the connection that transferred the response
+	static const char* hopByHopHeaders[] = { SAKIT_HTTP_RESPONSE_HEADER_CONNECTION, "Keep-Alive", SAKIT_HTTP_RESPONSE_HEADER_TRANSFER_ENCODING };
+	// headers of a 304 Not Modified that update the stored response, all others still describe the stored body
+	static const char* updatedHeaders[] = { SAKIT_HTTP_RESPONSE_HEADER_CACHE_CONTROLE, SAKIT_HTTP_RESPONSE_HEADER_DATE, SAKIT_HTTP_RESPONSE_HEADER_E_TAG,
+		SAKIT_HTTP_RESPONSE_HEADER_EXPIRES, SAKIT_HTTP_RESPONSE_HEADER_LAST_MODIFIED, SAKIT_HTTP_RESPONSE_HEADER_VARY, SAKIT_HTTP_RESPONSE_HEADER_AGE };
+
+	HttpCache::Entry::Entry() :
+		statusCode(HttpResponse::Code::Undefined),
+		storeTime(0LL),
+		lifetime(0LL),
+		lastUse(0LL)
+	{
+	}
+
+	int64_t HttpCache::Entry::getSize()
+	{
+		int64_t result = this->body.size() + this->key.size();
+		foreach_map (hstr, hstr, it, this->headers)
+		{
+			result += it->first.size() + it->second.size();
+		}
+		foreach (hstr, it, this->variants)
+		{
+			result += (*it).size();
+		}
+		return result;
+	}
+
+	HttpCache::HttpCache(int64_t maxMemorySize, chstr path, int64_t maxDiskSize) :
+		hits(0LL),
+		revalidations(0LL),
+		misses(0LL),
+		memorySize(0LL),
+		diskSize(0LL),
+		useCounter(0LL)
+	{
+		this->maxMemorySize = hmax(maxMemorySize, (int64_t)0);
+		this->path = path;
+		this->maxDiskSize = hmax(maxDiskSize, (int64_t)0);
+		if (this->path != "")
+		{
+			if (!hdir::exists(this->path))
+			{
+				hdir::create(this->path);
+			}
+			harray<hstr> files = hdir::files(this->path);
+			foreach (hstr, it, files)
+			{
+				if ((*it).endsWith(FILE_EXTENSION))
+				{
+					this->diskFiles[*it] = hfile::hsize(hdir::joinPath(this->path, (*it)));
+					this->diskSize += this->diskFiles[*it];
+					this->diskOrder += (*it);
+				}
+			}
+			this->_trimDisk();
+		}
+	}
+
+	HttpCache::~HttpCache()
+	{
+		foreach_map (hstr, Entry*, it, this->entries)
+		{
+			delete it->second;
+		}
+	}
+
+	int64_t HttpCache::getHits()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->hits;
+	}
+
+	int64_t HttpCache::getRevalidations()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->revalidations;
+	}
+
+	int64_t HttpCache::getMisses()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->misses;
+	}
+
+	float HttpCache::getHitRatio()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		int64_t total = this->hits + this->revalidations + this->misses;
+		return (total > 0LL ? (float)(this->hits + this->revalidations) / total : 0.0f);
+	}
+
+	int64_t HttpCache::getMemorySize()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->memorySize;
+	}
+
+	int64_t HttpCache::getDiskSize()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->diskSize;
+	}
+
+	int HttpCache::getEntryCount()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->entries.size();
+	}
+
+	void HttpCache::clear()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		foreach_map (hstr, Entry*, it, this->entries)
+		{
+			delete it->second;
+		}
+		this->entries.clear();
+		this->memorySize = 0LL;
+		harray<hstr> files = this->diskOrder;
+		foreach (hstr, it, files)
+		{
+			this->_removeFile(*it);
+		}
+	}
+
+	bool HttpCache::_prepare(chstr method, Url& url, hmap<hstr, hstr>& customHeaders, HttpResponse* response)
+	{
+		if (!HttpCache::_isCacheable(method, customHeaders))
+		{
+			return false;
+		}
+		hmutex::ScopeLock lock(&this->mutex);
+		Entry* entry = this->_findVariant(HttpCache::_makeKey(method, url), customHeaders);
+		if (entry == NULL)
+		{
+			return false;
+		}
+		entry->lastUse = ++this->useCounter;
+		bool noCache = (customHeaders.tryGet(SAKIT_HTTP_REQUEST_HEADER_CACHE_CONTROL, "").lowered().contains("no-cache") ||
+			customHeaders.tryGet(SAKIT_HTTP_REQUEST_HEADER_PRAGMA, "").lowered().contains("no-cache"));
+		if (!noCache && htime() - entry->storeTime < entry->lifetime)
+		{
+			HttpCache::_copyEntry(entry, response);
+			++this->hits;
+			return true;
+		}
+		hstr eTag = entry->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_E_TAG, "");
+		if (eTag != "" && !customHeaders.hasKey(SAKIT_HTTP_REQUEST_HEADER_IF_NONE_MATCH))
+		{
+			customHeaders[SAKIT_HTTP_REQUEST_HEADER_IF_NONE_MATCH] = eTag;
+		}
+		hstr lastModified = entry->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_LAST_MODIFIED, "");
+		if (lastModified != "" && !customHeaders.hasKey(SAKIT_HTTP_REQUEST_HEADER_IF_MODIFIED_SINCE))
+		{
+			customHeaders[SAKIT_HTTP_REQUEST_HEADER_IF_MODIFIED_SINCE] = lastModified;
+		}
+		return false;
+	}
+
+	void HttpCache::_update(chstr method, Url& url, hmap<hstr, hstr>& customHeaders, HttpResponse* response)
+	{
+		if (method == REQUEST_POST || method == REQUEST_PUT || method == REQUEST_DELETE)
+		{
+			// modifying a resource makes the cached representation obsolete
+			hmutex::ScopeLock lock(&this->mutex);
+			this->_remove(HttpCache::_makeKey(REQUEST_GET, url));
+			return;
+		}
+		if (!HttpCache::_isCacheable(method, customHeaders))
+		{
+			return;
+		}
+		hstr key = HttpCache::_makeKey(method, url);
+		int64_t now = htime();
+		hmutex::ScopeLock lock(&this->mutex);
+		if (response->statusCode == HttpResponse::Code::NotModified)
+		{
+			// a conditional request made by the user gets the 304 Not Modified itself
+			if (customHeaders.hasKey(SAKIT_HTTP_REQUEST_HEADER_IF_NONE_MATCH) || customHeaders.hasKey(SAKIT_HTTP_REQUEST_HEADER_IF_MODIFIED_SINCE))
+			{
+				return;
+			}
+			Entry* entry = this->_findVariant(key, customHeaders);
+			if (entry == NULL)
+			{
+				++this->misses;
+				return;
+			}
+			HttpCache::_updateHeaders(response->headers, entry->headers);
+			entry->storeTime = now;
+			entry->lifetime = HttpCache::_calculateLifetime(entry->headers, now);
+			entry->lastUse = ++this->useCounter;
+			HttpCache::_copyEntry(entry, response);
+			++this->revalidations;
+			if (entry->lifetime < 0LL)
+			{
+				this->_remove(entry->key);
+			}
+			else if (this->path != "")
+			{
+				this->_writeEntry(entry);
+			}
+			return;
+		}
+		++this->misses;
+		if (response->statusCode != HttpResponse::Code::Ok || !response->bodyComplete)
+		{
+			return;
+		}
+		int64_t lifetime = HttpCache::_calculateLifetime(response->headers, now);
+		hstr vary = response->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_VARY, "");
+		bool validators = (response->headers.hasKey(SAKIT_HTTP_RESPONSE_HEADER_E_TAG) || response->headers.hasKey(SAKIT_HTTP_RESPONSE_HEADER_LAST_MODIFIED));
+		if (lifetime < 0LL || (lifetime == 0LL && !validators) || vary.trimmed() == "*")
+		{
+			this->_remove(key);
+			return;
+		}
+		Entry* entry = new Entry();
+		entry->key = key;
+		if (vary.trimmed() != "")
+		{
+			entry->key = HttpCache::_makeVariantKey(key, vary, customHeaders);
+			this->_addVariant(key, vary, entry->key);
+		}
+		else
+		{
+			// the resource doesn't vary anymore so its variants are obsolete
+			Entry* old = this->_find(key);
+			if (old != NULL && old->variants.size() > 0)
+			{
+				this->_remove(key);
+			}
+		}
+		entry->statusCode = response->statusCode;
+		entry->statusMessage = response->statusMessage;
+		HttpCache::_copyHeaders(response->headers, entry->headers);
+		if (response->body.size() > 0)
+		{
+			entry->body.writeRaw(&response->body[0], (int)response->body.size());
+			entry->body.rewind();
+		}
+		entry->storeTime = now;
+		entry->lifetime = lifetime;
+		this->_store(entry);
+	}
+
+	HttpCache::Entry* HttpCache::_find(chstr key)
+	{
+		Entry* entry = this->entries.tryGet(key, NULL);
+		if (entry != NULL || this->path == "")
+		{
+			return entry;
+		}
+		hstr filename = HttpCache::_makeFilename(key);
+		if (!this->diskFiles.hasKey(filename))
+		{
+			return NULL;
+		}
+		entry = this->_readEntry(filename, key);
+		if (entry != NULL)
+		{
+			entry->lastUse = ++this->useCounter;
+			this->entries[key] = entry;
+			this->memorySize += entry->getSize();
+			this->_trimMemory();
+		}
+		return entry;
+	}
+
+	HttpCache::Entry* HttpCache::_findVariant(chstr key, hmap<hstr, hstr>& customHeaders)
+	{
+		Entry* entry = this->_find(key);
+		if (entry == NULL || entry->variants.size() == 0)
+		{
+			return entry;
+		}
+		entry->lastUse = ++this->useCounter;
+		return this->_find(HttpCache::_makeVariantKey(key, entry->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_VARY, ""), customHeaders));
+	}
+
+	void HttpCache::_addVariant(chstr key, chstr vary, chstr variantKey)
+	{
+		Entry* entry = new Entry();
+		entry->key = key;
+		entry->headers[SAKIT_HTTP_RESPONSE_HEADER_VARY] = vary;
+		Entry* old = this->_find(key);
+		if (old != NULL)
+		{
+			if (old->variants.size() > 0 && old->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_VARY, "") == vary)
+			{
+				entry->variants = old->variants;
+			}
+			else
+			{
+				this->_remove(key);
+			}
+		}
+		if (!entry->variants.has(variantKey))
+		{
+			entry->variants += variantKey;
+		}
+		this->_store(entry);
+	}
+
+	void HttpCache::_store(Entry* entry)
+	{
+		Entry* old = this->entries.tryGet(entry->key, NULL);
+		if (old != NULL)
+		{
+			this->memorySize -= old->getSize();
+			delete old;
+		}
+		entry->lastUse = ++this->useCounter;
+		this->entries[entry->key] = entry;
+		this->memorySize += entry->getSize();
+		if (this->path != "")
+		{
+			this->_writeEntry(entry);
+			this->_trimDisk();
+		}
+		this->_trimMemory();
+	}
+
+	void HttpCache::_remove(chstr key)
+	{
+		// the entry might only be on disk, but its variants have to be known
+		Entry* entry = this->_find(key);
+		harray<hstr> variants;
+		if (entry != NULL)
+		{
+			variants = entry->variants;
+			this->memorySize -= entry->getSize();
+			this->entries.removeKey(key);
+			delete entry;
+		}
+		foreach (hstr, it, variants)
+		{
+			this->_remove(*it);
+		}
+		if (this->path != "")
+		{
+			this->_removeFile(HttpCache::_makeFilename(key));
+		}
+	}
+
+	void HttpCache::_trimMemory()
+	{
+		Entry* oldest = NULL;
+		while (this->memorySize > this->maxMemorySize)
+		{
+			oldest = NULL;
+			foreach_map (hstr, Entry*, it, this->entries)
+			{
+				if (oldest == NULL || it->second->lastUse < oldest->lastUse)
+				{
+					oldest = it->second;
+				}
+			}
+			// the entry that was just used stays, even if it exceeds the limit on its own
+			if (oldest == NULL || oldest->lastUse == this->useCounter)
+			{
+				break;
+			}
+			// it's still available on disk if the on-disk cache is used
+			this->memorySize -= oldest->getSize();
+			this->entries.removeKey(oldest->key);
+			delete oldest;
+		}
+	}
+
+	void HttpCache::_trimDisk()
+	{
+		while (this->diskSize > this->maxDiskSize && this->diskOrder.size() > 0)
+		{
+			this->_removeFile(this->diskOrder.first());
+		}
+	}
+
+	HttpCache::Entry* HttpCache::_readEntry(chstr filename, chstr key)
+	{
+		hstr fullFilename = hdir::joinPath(this->path, filename);
+		if (!hfile::exists(fullFilename))
+		{
+			this->_removeFile(filename);
+			return NULL;
+		}
+		hfile file;
+		file.open(fullFilename);
+		// a different key means a hash collision, the entry is simply not available
+		if (file.readLine() != FILE_HEADER || file.readLine() != key)
+		{
+			return NULL;
+		}
+		Entry* entry = new Entry();
+		entry->key = key;
+		entry->statusCode = HttpResponse::Code::fromInt((int)file.readLine());
+		entry->statusMessage = file.readLine();
+		entry->storeTime = (int64_t)(long long)file.readLine();
+		entry->lifetime = (int64_t)(long long)file.readLine();
+		int count = (int)file.readLine();
+		for_iter (i, 0, count)
+		{
+			entry->variants += file.readLine();
+		}
+		harray<hstr> data;
+		count = (int)file.readLine();
+		for_iter (i, 0, count)
+		{
+			data = file.readLine().split(": ", 1);
+			if (data.size() == 2)
+			{
+				entry->headers[data[0]] = data[1];
+			}
+		}
+		int size = (int)file.readLine();
+		if (size > 0)
+		{
+			unsigned char* buffer = new unsigned char[size];
+			int read = file.readRaw(buffer, size);
+			entry->body.writeRaw(buffer, read);
+			entry->body.rewind();
+			delete[] buffer;
+			if (read < size)
+			{
+				hlog::warn(logTag, "Cached response is incomplete: " + fullFilename);
+				delete entry;
+				return NULL;
+			}
+		}
+		return entry;
+	}
+
+	bool HttpCache::_writeEntry(Entry* entry)
+	{
+		hstr filename = HttpCache::_makeFilename(entry->key);
+		hfile file;
+		file.open(hdir::joinPath(this->path, filename), hfaccess::Write);
+		file.writeLine(FILE_HEADER);
+		file.writeLine(entry->key);
+		file.writeLine(hstr((int)entry->statusCode.value));
+		file.writeLine(entry->statusMessage);
+		file.writeLine(hstr((long long)entry->storeTime));
+		file.writeLine(hstr((long long)entry->lifetime));
+		file.writeLine(hstr(entry->variants.size()));
+		foreach (hstr, it, entry->variants)
+		{
+			file.writeLine(*it);
+		}
+		file.writeLine(hstr(entry->headers.size()));
+		foreach_map (hstr, hstr, it, entry->headers)
+		{
+			file.writeLine(it->first + ": " + it->second);
+		}
+		file.writeLine(hstr((int)entry->body.size()));
+		if (entry->body.size() > 0)
+		{
+			file.writeRaw(&entry->body[0], (int)entry->body.size());
+		}
+		int64_t size = file.size();
+		file.close();
+		if (this->diskFiles.hasKey(filename))
+		{
+			this->diskSize -= this->diskFiles[filename];
+			this->diskOrder.remove(filename);
+		}
+		this->diskFiles[filename] = size;
+		this->diskSize += size;
+		this->diskOrder += filename;
+		return true;
+	}
+
+	void HttpCache::_removeFile(chstr filename)
+	{
+		if (this->diskFiles.hasKey(filename))
+		{
+			this->diskSize -= this->diskFiles[filename];
+			this->diskFiles.removeKey(filename);
+			this->diskOrder.remove(filename);
+		}
+		hfile::remove(hdir::joinPath(this->path, filename));
+	}
+
+	hstr HttpCache::_makeKey(chstr method, Url& url)
+	{
+		return method + " " + url.toString();
+	}
+
+	hstr HttpCache::_makeFilename(chstr key)
+	{
+		// FNV-1a
+		uint64_t hash = 14695981039346656037ULL;
+		for_iter (i, 0, key.size())
+		{
+			hash = (hash ^ (unsigned char)key[i]) * 1099511628211ULL;
+		}
+		return hsprintf("%016llx", (unsigned long long)hash) + FILE_EXTENSION;
+	}
+
+	bool HttpCache::_isCacheable(chstr method, hmap<hstr, hstr>& customHeaders)
+	{
+		return (method == REQUEST_GET && !customHeaders.hasKey(SAKIT_HTTP_REQUEST_HEADER_RANGE) &&
+			!customHeaders.hasKey(SAKIT_HTTP_REQUEST_HEADER_AUTHORIZATION) &&
+			!customHeaders.tryGet(SAKIT_HTTP_REQUEST_HEADER_CACHE_CONTROL, "").lowered().contains("no-store"));
+	}
+
+	hstr HttpCache::_makeVariantKey(chstr key, chstr vary, hmap<hstr, hstr>& customHeaders)
+	{
+		hstr result = key;
+		harray<hstr> names = vary.split(',', -1, true);
+		hstr name;
+		hstr value;
+		foreach (hstr, it, names)
+		{
+			// header names are case-insensitive, so they can't be used as map keys directly
+			name = (*it).trimmed().lowered();
+			value = "";
+			HttpCache::_tryGetHeader(customHeaders, name, value);
+			result += "; " + name + "=" + value;
+		}
+		return result;
+	}
+
+	int64_t HttpCache::_calculateLifetime(hmap<hstr, hstr>& headers, int64_t now)
+	{
+		hstr age = headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_AGE, "").trimmed();
+		int64_t ageValue = (age.isNumber() ? (int64_t)(long long)age : 0LL);
+		int64_t maxAge = -1LL;
+		harray<hstr> directives = headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_CACHE_CONTROLE, "").lowered().split(',', -1, true);
+		hstr directive;
+		foreach (hstr, it, directives)
+		{
+			directive = (*it).trimmed();
+			if (directive == "no-store")
+			{
+				return -1LL;
+			}
+			if (directive == "no-cache")
+			{
+				return 0LL;
+			}
+			if (directive.startsWith("max-age=") && directive(8, -1).isNumber())
+			{
+				maxAge = (int64_t)(long long)directive(8, -1);
+			}
+		}
+		if (maxAge >= 0LL)
+		{
+			return hmax(maxAge - ageValue, (int64_t)0);
+		}
+		if (headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_PRAGMA, "").lowered().contains("no-cache") || !headers.hasKey(SAKIT_HTTP_RESPONSE_HEADER_EXPIRES))
+		{
+			return 0LL;
+		}
+		int64_t expires = HttpCache::_parseHttpDate(headers[SAKIT_HTTP_RESPONSE_HEADER_EXPIRES]);
+		if (expires < 0LL)
+		{
+			return 0LL;
+		}
+		// relative to the server's clock to avoid problems with clock differences
+		int64_t date = HttpCache::_parseHttpDate(headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_DATE, ""));
+		return hmax(expires - (date >= 0LL ? date : now) - ageValue, (int64_t)0);
+	}
+
+	int64_t HttpCache::_parseHttpDate(chstr value)
+	{
+		// e.g. "Sun, 06 Nov 1994 08:49:37 GMT", the obsolete formats are treated as invalid which means expired
+		harray<hstr> parts = value.split(' ', -1, true);
+		if (parts.size() != 6 || parts[5] != "GMT" || !parts[1].isNumber() || !parts[3].isNumber())
+		{
+			return -1LL;
+		}
+		int month = -1;
+		for_iter (i, 0, 12)
+		{
+			if (parts[2] == months[i])
+			{
+				month = i + 1;
+				break;
+			}
+		}
+		harray<hstr> time = parts[4].split(':');
+		if (month < 0 || time.size() != 3 || !time[0].isNumber() || !time[1].isNumber() || !time[2].isNumber())
+		{
+			return -1LL;
+		}
+		// days since the epoch of the proleptic Gregorian calendar
+		int64_t year = (int64_t)(int)parts[3] - (month <= 2 ? 1 : 0);
+		int64_t era = year / 400;
+		int64_t yearOfEra = year - era * 400;
+		int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + (int)parts[1] - 1;
+		int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+		int64_t days = era * 146097 + dayOfEra - 719468;
+		return days * 86400 + (int)time[0] * 3600 + (int)time[1] * 60 + (int)time[2];
+	}
+
+	void HttpCache::_copyHeaders(hmap<hstr, hstr>& source, hmap<hstr, hstr>& destination)
+	{
+		foreach_map (hstr, hstr, it, source)
+		{
+			destination[it->first] = it->second;
+		}
+		for_iter (i, 0, 3)
+		{
+			destination.removeKey(hopByHopHeaders[i]);
+		}
+	}
+
+	void HttpCache::_updateHeaders(hmap<hstr, hstr>& source, hmap<hstr, hstr>& destination)
+	{
+		hstr value;
+		harray<hstr> names;
+		hstr lowered;
+		for_iter (i, 0, 7)
+		{
+			if (!HttpCache::_tryGetHeader(source, updatedHeaders[i], value))
+			{
+				continue;
+			}
+			// the stored spelling of the name might differ
+			lowered = hstr(updatedHeaders[i]).lowered();
+			names = destination.keys();
+			foreach (hstr, it, names)
+			{
+				if ((*it).lowered() == lowered)
+				{
+					destination.removeKey(*it);
+				}
+			}
+			destination[updatedHeaders[i]] = value;
+		}
+	}
+
+	bool HttpCache::_tryGetHeader(hmap<hstr, hstr>& headers, chstr name, hstr& value)
+	{
+		hstr lowered = name.lowered();
+		foreach_map (hstr, hstr, it, headers)
+		{
+			if (it->first.lowered() == lowered)
+			{
+				value = it->second;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void HttpCache::_copyEntry(Entry* entry, HttpResponse* response)
+	{
+		response->clear();
+		response->protocol = "HTTP/1.1";
+		response->statusCode = entry->statusCode;
+		response->statusMessage = entry->statusMessage;
+		response->headers = entry->headers;
+		if (entry->body.size() > 0)
+		{
+			response->body.writeRaw(&entry->body[0], (int)entry->body.size());
+			response->body.rewind();
+		}
+		response->headersComplete = true;
+		response->bodyComplete = true;
+	}
+
+}
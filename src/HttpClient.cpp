@@ -0,0 +1,228 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/harray.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hstring.h>
+
+#include "HttpClient.h"
+#include "HttpClientDelegate.h"
+#include "HttpClientRequest.h"
+#include "HttpClientThread.h"
+#include "HttpResponse.h"
+#include "sakit.h"
+#include "State.h"
+
+#define REQUEST_OPTIONS "OPTIONS"
+#define REQUEST_GET "GET"
+#define REQUEST_HEAD "HEAD"
+#define REQUEST_POST "POST"
+#define REQUEST_PUT "PUT"
+#define REQUEST_DELETE "DELETE"
+
+#define CLIENT_EXECUTE(name, constant) \
+	HttpClientRequest* HttpClient::execute ## name(Url url, chstr customBody, hmap<hstr, hstr> customHeaders, float deadline) \
+	{ \
+		return this->execute(REQUEST_ ## constant, url, customBody, customHeaders, deadline); \
+	}
+
+namespace sakit
+{
+	HttpClient::HttpClient(HttpClientDelegate* clientDelegate, int maxConcurrentRequests, int threadCount) :
+		Base(),
+		nextId(0),
+		activeCount(0)
+	{
+		this->clientDelegate = clientDelegate;
+		this->maxConcurrentRequests = hmax(maxConcurrentRequests, 1);
+		this->threadCount = hclamp(threadCount, 1, this->maxConcurrentRequests);
+		// the concurrency limit is spread evenly so one thread can't take all requests
+		int maxTransfers = (this->maxConcurrentRequests + this->threadCount - 1) / this->threadCount;
+		for_iter (i, 0, this->threadCount)
+		{
+			this->threads += new HttpClientThread(this, maxTransfers);
+		}
+		this->__register();
+	}
+
+	HttpClient::~HttpClient()
+	{
+		this->__unregister();
+		foreach (HttpClientThread*, it, this->threads)
+		{
+			(*it)->join();
+			delete (*it);
+		}
+		foreach (HttpClientRequest*, it, this->requests)
+		{
+			delete (*it);
+		}
+	}
+
+	int HttpClient::getPendingRequestCount()
+	{
+		hmutex::ScopeLock lock(&this->requestsMutex);
+		return this->pendingRequests.size();
+	}
+
+	int HttpClient::getActiveRequestCount()
+	{
+		hmutex::ScopeLock lock(&this->requestsMutex);
+		return this->activeCount;
+	}
+
+	void HttpClient::update(float timeDelta)
+	{
+		hmutex::ScopeLock lock;
+		HttpClientRequest* request = NULL;
+		// one at a time since the delegate might release other requests
+		while (true)
+		{
+			lock.acquire(&this->requestsMutex);
+			if (this->doneRequests.size() == 0)
+			{
+				break;
+			}
+			request = this->doneRequests.removeFirst();
+			lock.release();
+			if (this->clientDelegate != NULL)
+			{
+				if (request->getState() == State::Finished)
+				{
+					this->clientDelegate->onRequestCompleted(this, request);
+				}
+				else
+				{
+					this->clientDelegate->onRequestFailed(this, request);
+				}
+			}
+		}
+	}
+
+	CLIENT_EXECUTE(Options, OPTIONS);
+	CLIENT_EXECUTE(Get, GET);
+	CLIENT_EXECUTE(Head, HEAD);
+	CLIENT_EXECUTE(Post, POST);
+	CLIENT_EXECUTE(Put, PUT);
+	CLIENT_EXECUTE(Delete, DELETE);
+
+	HttpClientRequest* HttpClient::execute(chstr method, Url url, chstr customBody, hmap<hstr, hstr> customHeaders, float deadline)
+	{
+		if (!url.isValid())
+		{
+			hlog::warn(logTag, "Cannot execute, URL is not valid!");
+			return NULL;
+		}
+		if (deadline <= 0.0f)
+		{
+			deadline = this->timeout;
+		}
+		hmutex::ScopeLock lock(&this->requestsMutex);
+		HttpClientRequest* request = new HttpClientRequest(this->nextId, method, url, customBody, customHeaders, (int64_t)htickCount() + (int64_t)(deadline * 1000.0f));
+		++this->nextId;
+		this->requests += request;
+		this->pendingRequests += request;
+		// threads are only started when there's something to do
+		foreach (HttpClientThread*, it, this->threads)
+		{
+			if (!(*it)->isRunning())
+			{
+				(*it)->start();
+			}
+		}
+		return request;
+	}
+
+	void HttpClient::release(HttpClientRequest* request)
+	{
+		hmutex::ScopeLock lock(&this->requestsMutex);
+		int index = this->requests.indexOf(request);
+		if (index < 0)
+		{
+			hlog::warn(logTag, "Cannot release, request does not belong to this client!");
+			return;
+		}
+		this->requests.removeAt(index);
+		index = this->doneRequests.indexOf(request);
+		if (index >= 0)
+		{
+			this->doneRequests.removeAt(index);
+		}
+		index = this->pendingRequests.indexOf(request);
+		if (index >= 0)
+		{
+			this->pendingRequests.removeAt(index);
+		}
+		if (request->getState() == State::Running)
+		{
+			request->released = true; // the thread executing it deletes it
+			return;
+		}
+		lock.release();
+		delete request;
+	}
+
+	HttpClientRequest* HttpClient::_takePendingRequest()
+	{
+		hmutex::ScopeLock lock(&this->requestsMutex);
+		if (this->activeCount >= this->maxConcurrentRequests || this->pendingRequests.size() == 0)
+		{
+			return NULL;
+		}
+		HttpClientRequest* request = this->pendingRequests.removeFirst();
+		++this->activeCount;
+		hmutex::ScopeLock lockRequest(&request->mutex);
+		request->state = State::Running;
+		return request;
+	}
+
+	void HttpClient::_finishRequest(HttpClientRequest* request, State state, bool timedOut)
+	{
+		hmutex::ScopeLock lock(&this->requestsMutex);
+		--this->activeCount;
+		if (request->released)
+		{
+			lock.release();
+			delete request;
+			return;
+		}
+		// only a response with complete headers and a complete body is considered
+		if (state != State::Finished)
+		{
+			request->response->clear();
+		}
+		request->response->raw.rewind();
+		request->response->body.rewind();
+		request->_setDone(state, timedOut);
+		this->doneRequests += request;
+	}
+
+	void HttpClient::_expirePendingRequests()
+	{
+		hmutex::ScopeLock lock(&this->requestsMutex);
+		int64_t time = (int64_t)htickCount();
+		HttpClientRequest* request = NULL;
+		int i = 0;
+		while (i < this->pendingRequests.size())
+		{
+			if (time >= this->pendingRequests[i]->deadline)
+			{
+				request = this->pendingRequests.removeAt(i);
+				request->_setDone(State::Failed, true);
+				this->doneRequests += request;
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+
+}
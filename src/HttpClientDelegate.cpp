@@ -0,0 +1,29 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include "HttpClientDelegate.h"
+
+namespace sakit
+{
+	HttpClientDelegate::HttpClientDelegate()
+	{
+	}
+
+	HttpClientDelegate::~HttpClientDelegate()
+	{
+	}
+
+	void HttpClientDelegate::onRequestCompleted(HttpClient* client, HttpClientRequest* request)
+	{
+	}
+
+	void HttpClientDelegate::onRequestFailed(HttpClient* client, HttpClientRequest* request)
+	{
+	}
+
+}
@@ -0,0 +1,389 @@
+/// @file
+/// @version 1.2
+///
+/// @section LICENSE
+///
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/harray.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hstring.h>
+
+#include "HttpClientPool.h"
+#include "HttpResponse.h"
+#include "HttpSocket.h"
+#include "sakit.h"
+
+#define REQUEST_OPTIONS "OPTIONS"
+#define REQUEST_GET "GET"
+#define REQUEST_HEAD "HEAD"
+#define REQUEST_POST "POST"
+#define REQUEST_PUT "PUT"
+#define REQUEST_DELETE "DELETE"
+
+#define POOL_EXECUTE(name, constant) \
+	bool HttpClientPool::execute ## name(HttpResponse* response, Url url, chstr customBody, hmap<hstr, hstr> customHeaders) \
+	{ \
+		return this->execute(response, REQUEST_ ## constant, url, customBody, customHeaders); \
+	}
+#define POOL_EXECUTE_ASYNC(name, constant) \
+	bool HttpClientPool::execute ## name ## Async(Url url, chstr customBody, hmap<hstr, hstr> customHeaders) \
+	{ \
+		return this->executeAsync(REQUEST_ ## constant, url, customBody, customHeaders); \
+	}
+
+namespace sakit
+{
+	HttpClientPool::Request::Request(chstr method, Url url, chstr customBody, hmap<hstr, hstr> customHeaders) :
+		reused(false),
+		retried(false)
+	{
+		this->method = method;
+		this->url = url;
+		this->customBody = customBody;
+		this->customHeaders = customHeaders;
+	}
+
+	HttpClientPool::HttpClientPool(HttpSocketDelegate* socketDelegate, int maxConnectionsPerHost, float idleTimeout) :
+		HttpSocketDelegate(),
+		reportProgress(false),
+		hits(0LL),
+		misses(0LL),
+		expired(0LL),
+		queued(0LL)
+	{
+		this->socketDelegate = socketDelegate;
+		this->maxConnectionsPerHost = hmax(maxConnectionsPerHost, 1);
+		this->idleTimeout = idleTimeout;
+	}
+
+	HttpClientPool::~HttpClientPool()
+	{
+		foreach (HttpSocket*, it, this->sockets)
+		{
+			delete (*it);
+		}
+		foreach_map (HttpSocket*, Request*, it, this->activeRequests)
+		{
+			delete it->second;
+		}
+		foreach (Request*, it, this->pendingRequests)
+		{
+			delete (*it);
+		}
+	}
+
+	int64_t HttpClientPool::getHits()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->hits;
+	}
+
+	int64_t HttpClientPool::getMisses()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->misses;
+	}
+
+	int64_t HttpClientPool::getExpired()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->expired;
+	}
+
+	int64_t HttpClientPool::getQueued()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->queued;
+	}
+
+	int HttpClientPool::getConnectionCount()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->socketKeys.size();
+	}
+
+	int HttpClientPool::getIdleConnectionCount()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->idleTimes.size();
+	}
+
+	int HttpClientPool::getPendingRequestCount()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->pendingRequests.size();
+	}
+
+	POOL_EXECUTE(Options, OPTIONS);
+	POOL_EXECUTE(Get, GET);
+	POOL_EXECUTE(Head, HEAD);
+	POOL_EXECUTE(Post, POST);
+	POOL_EXECUTE(Put, PUT);
+	POOL_EXECUTE(Delete, DELETE);
+
+	POOL_EXECUTE_ASYNC(Options, OPTIONS);
+	POOL_EXECUTE_ASYNC(Get, GET);
+	POOL_EXECUTE_ASYNC(Head, HEAD);
+	POOL_EXECUTE_ASYNC(Post, POST);
+	POOL_EXECUTE_ASYNC(Put, PUT);
+	POOL_EXECUTE_ASYNC(Delete, DELETE);
+
+	bool HttpClientPool::execute(HttpResponse* response, chstr method, Url url, chstr customBody, hmap<hstr, hstr> customHeaders)
+	{
+		if (!url.isValid())
+		{
+			hlog::warn(logTag, "Cannot execute, URL is not valid!");
+			return false;
+		}
+		hstr key = HttpClientPool::_makeKey(url);
+		bool reused = false;
+		hmutex::ScopeLock lock(&this->mutex);
+		HttpSocket* socket = this->_acquire(key, reused);
+		lock.release();
+		if (socket == NULL)
+		{
+			hlog::warn(logTag, "Cannot execute, all connections are busy: " + key);
+			return false;
+		}
+		bool result = socket->_executeMethod(response, method, url, customBody, customHeaders);
+		// the server might have closed the idle connection in the meantime
+		if (!result && reused && HttpSocket::_isIdempotent(method) && response != NULL && response->raw.size() == 0)
+		{
+			result = socket->_executeMethod(response, method, url, customBody, customHeaders);
+		}
+		lock.acquire(&this->mutex);
+		this->_release(socket);
+		lock.release();
+		this->_startPendingRequests();
+		return result;
+	}
+
+	bool HttpClientPool::executeAsync(chstr method, Url url, chstr customBody, hmap<hstr, hstr> customHeaders)
+	{
+		if (!url.isValid())
+		{
+			hlog::warn(logTag, "Cannot execute, URL is not valid!");
+			return false;
+		}
+		Request* request = new Request(method, url, customBody, customHeaders);
+		hmutex::ScopeLock lock(&this->mutex);
+		HttpSocket* socket = this->_acquire(HttpClientPool::_makeKey(url), request->reused);
+		if (socket == NULL)
+		{
+			this->pendingRequests += request;
+			++this->queued;
+			return true;
+		}
+		lock.release();
+		return this->_startRequest(socket, request);
+	}
+
+	void HttpClientPool::update(float timeDelta)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		this->_expireIdleSockets();
+	}
+
+	void HttpClientPool::closeIdleConnections()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		harray<HttpSocket*> idleSockets = this->idleTimes.keys();
+		foreach (HttpSocket*, it, idleSockets)
+		{
+			(*it)->_closeConnection();
+			this->idleTimes.removeKey(*it);
+			this->socketKeys.removeKey(*it);
+			this->freeSockets += (*it);
+		}
+	}
+
+	void HttpClientPool::onExecuteProgress(HttpSocket* socket, HttpResponse* response, Url url)
+	{
+		this->socketDelegate->onExecuteProgress(socket, response, url);
+	}
+
+	void HttpClientPool::onExecuteCompleted(HttpSocket* socket, HttpResponse* response, Url url)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		Request* request = this->activeRequests.tryGet(socket, NULL);
+		this->activeRequests.removeKey(socket);
+		this->_release(socket);
+		lock.release();
+		if (request != NULL)
+		{
+			delete request;
+		}
+		this->_startPendingRequests();
+		this->socketDelegate->onExecuteCompleted(socket, response, url);
+	}
+
+	void HttpClientPool::onExecuteFailed(HttpSocket* socket, HttpResponse* response, Url url)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		Request* request = this->activeRequests.tryGet(socket, NULL);
+		// the server might have closed the idle connection in the meantime, but a request with a partial response may have
+		// been processed already so it is only repeated when nothing was received
+		if (request != NULL && request->reused && !request->retried && HttpSocket::_isIdempotent(request->method) && response != NULL && response->raw.size() == 0)
+		{
+			request->retried = true;
+			lock.release();
+			if (socket->_executeMethodAsync(request->method, request->url, request->customBody, request->customHeaders))
+			{
+				return;
+			}
+			lock.acquire(&this->mutex);
+		}
+		this->activeRequests.removeKey(socket);
+		this->_release(socket);
+		lock.release();
+		if (request != NULL)
+		{
+			delete request;
+		}
+		this->_startPendingRequests();
+		this->socketDelegate->onExecuteFailed(socket, response, url);
+	}
+
+	HttpSocket* HttpClientPool::_acquire(chstr key, bool& reused)
+	{
+		this->_expireIdleSockets();
+		reused = false;
+		HttpSocket* socket = NULL;
+		int64_t latestTime = -1LL;
+		int count = 0;
+		// the most recently used connection is the least likely to have been closed by the server
+		foreach_map (HttpSocket*, hstr, it, this->socketKeys)
+		{
+			if (it->second == key)
+			{
+				++count;
+				if (this->idleTimes.hasKey(it->first) && this->idleTimes[it->first] > latestTime)
+				{
+					socket = it->first;
+					latestTime = this->idleTimes[it->first];
+				}
+			}
+		}
+		if (socket != NULL)
+		{
+			this->idleTimes.removeKey(socket);
+			++this->hits;
+			reused = true;
+			return socket;
+		}
+		if (count >= this->maxConnectionsPerHost)
+		{
+			return NULL;
+		}
+		++this->misses;
+		if (this->freeSockets.size() > 0)
+		{
+			socket = this->freeSockets.removeLast();
+		}
+		else
+		{
+			socket = new HttpSocket(this);
+			socket->setKeepAlive(true);
+			this->sockets += socket;
+		}
+		socket->setReportProgress(this->reportProgress);
+		this->socketKeys[socket] = key;
+		return socket;
+	}
+
+	void HttpClientPool::_release(HttpSocket* socket)
+	{
+		if (socket->isConnected())
+		{
+			this->idleTimes[socket] = (int64_t)htickCount();
+		}
+		else
+		{
+			this->socketKeys.removeKey(socket);
+			this->freeSockets += socket;
+		}
+	}
+
+	void HttpClientPool::_expireIdleSockets()
+	{
+		int64_t time = (int64_t)htickCount();
+		int64_t maxIdleTime = (int64_t)(this->idleTimeout * 1000.0f);
+		harray<HttpSocket*> expiredSockets;
+		foreach_map (HttpSocket*, int64_t, it, this->idleTimes)
+		{
+			if (time - it->second >= maxIdleTime)
+			{
+				expiredSockets += it->first;
+			}
+		}
+		foreach (HttpSocket*, it, expiredSockets)
+		{
+			(*it)->_closeConnection();
+			this->idleTimes.removeKey(*it);
+			this->socketKeys.removeKey(*it);
+			this->freeSockets += (*it);
+			++this->expired;
+		}
+	}
+
+	bool HttpClientPool::_startRequest(HttpSocket* socket, Request* request)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		this->activeRequests[socket] = request;
+		lock.release();
+		if (!socket->_executeMethodAsync(request->method, request->url, request->customBody, request->customHeaders))
+		{
+			lock.acquire(&this->mutex);
+			this->activeRequests.removeKey(socket);
+			this->_release(socket);
+			lock.release();
+			delete request;
+			return false;
+		}
+		return true;
+	}
+
+	void HttpClientPool::_startPendingRequests()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		harray<HttpSocket*> startedSockets;
+		harray<Request*> startedRequests;
+		HttpSocket* socket = NULL;
+		int i = 0;
+		while (i < this->pendingRequests.size())
+		{
+			socket = this->_acquire(HttpClientPool::_makeKey(this->pendingRequests[i]->url), this->pendingRequests[i]->reused);
+			if (socket != NULL)
+			{
+				startedSockets += socket;
+				startedRequests += this->pendingRequests.removeAt(i);
+			}
+			else
+			{
+				++i;
+			}
+		}
+		lock.release();
+		Url url;
+		for_iter (j, 0, startedSockets.size())
+		{
+			url = startedRequests[j]->url;
+			if (!this->_startRequest(startedSockets[j], startedRequests[j]))
+			{
+				HttpResponse response;
+				this->socketDelegate->onExecuteFailed(startedSockets[j], &response, url);
+			}
+		}
+	}
+
+	hstr HttpClientPool::_makeKey(Url& url)
+	{
+		unsigned short port = (url.getPort() == 0 ? HttpSocket::DefaultPort : url.getPort());
+		return url.getHost() + ":" + hstr((int)port);
+	}
+
+}
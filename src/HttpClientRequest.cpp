@@ -0,0 +1,85 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hthread.h>
+
+#include "HttpClientRequest.h"
+#include "HttpResponse.h"
+#include "sakit.h"
+
+namespace sakit
+{
+	HttpClientRequest::HttpClientRequest(int id, chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders, int64_t deadline) :
+		state(State::Idle),
+		timedOut(false),
+		released(false)
+	{
+		this->id = id;
+		this->method = method;
+		this->url = url;
+		this->customBody = customBody;
+		this->customHeaders = customHeaders;
+		this->deadline = deadline;
+		this->response = new HttpResponse();
+	}
+
+	HttpClientRequest::~HttpClientRequest()
+	{
+		delete this->response;
+	}
+
+	State HttpClientRequest::getState()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->state;
+	}
+
+	bool HttpClientRequest::isDone()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return (this->state == State::Finished || this->state == State::Failed);
+	}
+
+	bool HttpClientRequest::isTimedOut()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->timedOut;
+	}
+
+	bool HttpClientRequest::wait(float timeout)
+	{
+		float retryFrequency = sakit::getGlobalRetryFrequency();
+		int64_t end = 0;
+		if (timeout > 0.0f)
+		{
+			end = (int64_t)htickCount() + (int64_t)(timeout * 1000.0f);
+		}
+		else // the executing thread needs a moment to notice that the deadline has passed
+		{
+			end = this->deadline + (int64_t)(retryFrequency * 2000.0f);
+		}
+		while (!this->isDone())
+		{
+			if ((int64_t)htickCount() >= end)
+			{
+				return false;
+			}
+			hthread::sleep(retryFrequency * 1000.0f);
+		}
+		return true;
+	}
+
+	void HttpClientRequest::_setDone(State state, bool timedOut)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		this->state = state;
+		this->timedOut = timedOut;
+	}
+
+}
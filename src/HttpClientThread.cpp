@@ -0,0 +1,350 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/hlog.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hthread.h>
+
+#include "HttpClient.h"
+#include "HttpClientRequest.h"
+#include "HttpClientThread.h"
+#include "HttpResponse.h"
+#include "HttpSocket.h"
+#include "PlatformSocket.h"
+#include "sakit.h"
+#include "State.h"
+
+namespace sakit
+{
+	HttpClientThread::Resolver::Resolver(PlatformSocket* socket, Host host, unsigned short port) :
+		WorkerThread(socket)
+	{
+		this->name = "SAKit HTTP resolver";
+		this->result = State::Running;
+		this->host = host;
+		this->port = port;
+	}
+
+	State HttpClientThread::Resolver::getResult()
+	{
+		hmutex::ScopeLock lock(&this->resultMutex);
+		return this->result;
+	}
+
+	void HttpClientThread::Resolver::_updateProcess()
+	{
+		bool result = this->socket->setRemoteAddress(this->host, this->port);
+		hmutex::ScopeLock lock(&this->resultMutex);
+		this->result = (result ? State::Finished : State::Failed);
+	}
+
+	HttpClientThread::Transfer::Transfer(HttpClientRequest* request) :
+		state(State::Idle),
+		remaining(0),
+		resolver(NULL)
+	{
+		this->request = request;
+		this->socket = new PlatformSocket();
+		this->socket->setConnectionLess(false);
+	}
+
+	HttpClientThread::Transfer::~Transfer()
+	{
+		if (this->resolver != NULL)
+		{
+			this->resolver->join();
+			delete this->resolver;
+		}
+		this->socket->disconnect();
+		delete this->socket;
+	}
+
+	HttpClientThread::HttpClientThread(HttpClient* client, int maxTransfers) :
+		hthread(&process, "SAKit HTTP client"),
+		polling(false)
+	{
+		this->client = client;
+		this->maxTransfers = maxTransfers;
+	}
+
+	HttpClientThread::~HttpClientThread()
+	{
+		foreach (Transfer*, it, this->transfers)
+		{
+			// requests that weren't released are deleted by the client
+			if ((*it)->request->released)
+			{
+				delete (*it)->request;
+			}
+			delete (*it);
+		}
+		// waits for the remaining address lookups
+		foreach (Transfer*, it, this->abandonedTransfers)
+		{
+			delete (*it);
+		}
+	}
+
+	bool HttpClientThread::_isCloseDelimited(HttpResponse* response)
+	{
+		return (response->headersComplete && !response->invalid && !response->headers.hasKey(SAKIT_HTTP_REQUEST_HEADER_CONTENT_LENGTH) &&
+			response->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_TRANSFER_ENCODING, "") != "chunked");
+	}
+
+	State HttpClientThread::_updateTransfer(Transfer* transfer, bool& progress)
+	{
+		HttpClientRequest* request = transfer->request;
+		if ((int64_t)htickCount() >= request->deadline)
+		{
+			HttpResponse* response = request->response;
+			// if there is no predefined length, all headers were received and there is a body
+			if (transfer->state == State::Receiving && response->body.size() > 0 && HttpClientThread::_isCloseDelimited(response))
+			{
+				// let's say it's complete, we don't know its supposed length anyway
+				hlog::warn(logTag, "HttpClient did not receive header '" SAKIT_HTTP_REQUEST_HEADER_CONTENT_LENGTH "'! Body might be incomplete, but will be considered complete.");
+				response->bodyComplete = true;
+				return State::Finished;
+			}
+			hlog::warn(logTag, "HttpClient request timed out: " + request->url.toString());
+			return State::Failed;
+		}
+		if (transfer->state == State::Idle || transfer->state == State::Connecting)
+		{
+			return this->_updateConnect(transfer, progress);
+		}
+		if (transfer->state == State::Sending)
+		{
+			return this->_updateSend(transfer, progress);
+		}
+		return this->_updateReceive(transfer, progress);
+	}
+
+	State HttpClientThread::_updateConnect(Transfer* transfer, bool& progress)
+	{
+		bool done = false;
+		Url& url = transfer->request->url;
+		unsigned short port = (url.getPort() == 0 ? HttpSocket::DefaultPort : url.getPort());
+		if (transfer->state == State::Idle)
+		{
+			transfer->socket->setOptions(this->client->getOptions());
+			// getaddrinfo() blocks, so it runs on its own thread while this one keeps driving the other transfers
+			transfer->resolver = new Resolver(transfer->socket, Host(url.getHost()), port);
+			transfer->resolver->start();
+			hstr request = HttpSocket::_makeRequest(transfer->request->method, url, transfer->request->customBody, transfer->request->customHeaders, false, "HTTP/1.1");
+			transfer->stream.writeRaw((void*)request.cStr(), request.size());
+			transfer->stream.rewind();
+			transfer->remaining = request.size();
+			transfer->state = State::Connecting;
+			progress = true;
+			return State::Running;
+		}
+		if (transfer->resolver != NULL)
+		{
+			State result = transfer->resolver->getResult();
+			if (result == State::Running)
+			{
+				return State::Running;
+			}
+			transfer->resolver->join();
+			delete transfer->resolver;
+			transfer->resolver = NULL;
+			if (result == State::Failed || !transfer->socket->startConnect(Host(url.getHost()), port, done, true))
+			{
+				return State::Failed;
+			}
+			// sending and receiving never block the other transfers, pollConnect() doesn't switch back to blocking mode either
+			transfer->socket->setNonBlocking(true);
+			progress = true;
+		}
+		else if (!transfer->socket->pollConnect(done))
+		{
+			return State::Failed;
+		}
+		if (done)
+		{
+			transfer->state = State::Sending;
+			progress = true;
+		}
+		return State::Running;
+	}
+
+	State HttpClientThread::_updateSend(Transfer* transfer, bool& progress)
+	{
+		int sent = 0;
+		if (!transfer->socket->send(&transfer->stream, transfer->remaining, sent))
+		{
+			return State::Failed;
+		}
+		if (sent > 0)
+		{
+			progress = true;
+		}
+		if (transfer->stream.eof())
+		{
+			transfer->stream.clear();
+			transfer->state = State::Receiving;
+		}
+		return State::Running;
+	}
+
+	State HttpClientThread::_updateReceive(Transfer* transfer, bool& progress)
+	{
+		// only sockets that were reported as readable are read from
+		if (!this->polling && !this->readySockets.has(transfer->socket))
+		{
+			return State::Running;
+		}
+		HttpResponse* response = transfer->request->response;
+		int maxCount = HTTP_CLIENT_THREAD_BUFFER_SIZE;
+		this->stream.clear(maxCount);
+		bool received = transfer->socket->receive(&this->stream, maxCount);
+		if (this->stream.size() > 0)
+		{
+			this->stream.rewind();
+			response->raw.seek(0, hseek::End);
+			int64_t position = response->raw.position();
+			response->raw.writeRaw(this->stream);
+			response->raw.seek(position, hseek::Start);
+			response->parseFromRaw();
+			progress = true;
+		}
+		else if (received && !this->polling)
+		{
+			// a socket that is readable without any data means that the server closed the connection
+			if (!HttpClientThread::_isCloseDelimited(response))
+			{
+				return State::Failed;
+			}
+			response->bodyComplete = true;
+		}
+		if (response->headersComplete && response->bodyComplete)
+		{
+			return State::Finished;
+		}
+		return (received && !response->invalid ? State::Running : State::Failed);
+	}
+
+	void HttpClientThread::_removeReleasedTransfers()
+	{
+		hmutex::ScopeLock lock(&this->client->requestsMutex);
+		harray<Transfer*> releasedTransfers;
+		foreach (Transfer*, it, this->transfers)
+		{
+			if ((*it)->request->released)
+			{
+				releasedTransfers += (*it);
+			}
+		}
+		lock.release();
+		foreach (Transfer*, it, releasedTransfers)
+		{
+			this->transfers.remove(*it);
+			this->client->_finishRequest((*it)->request, State::Failed, false);
+			this->_deleteTransfer(*it);
+		}
+	}
+
+	void HttpClientThread::_deleteTransfer(Transfer* transfer)
+	{
+		// the socket is still used by a running address lookup
+		if (transfer->resolver != NULL && transfer->resolver->getResult() == State::Running)
+		{
+			this->abandonedTransfers += transfer;
+			return;
+		}
+		delete transfer;
+	}
+
+	void HttpClientThread::_deleteAbandonedTransfers()
+	{
+		int i = 0;
+		while (i < this->abandonedTransfers.size())
+		{
+			if (this->abandonedTransfers[i]->resolver->getResult() == State::Running)
+			{
+				++i;
+				continue;
+			}
+			delete this->abandonedTransfers.removeAt(i);
+		}
+	}
+
+	void HttpClientThread::_waitForData(bool progress)
+	{
+		harray<PlatformSocket*> sockets;
+		harray<PlatformSocket*> sendingSockets;
+		foreach (Transfer*, it, this->transfers)
+		{
+			if ((*it)->state == State::Receiving)
+			{
+				sockets += (*it)->socket;
+			}
+			// a socket that finished connecting becomes writable as well
+			else if ((*it)->state == State::Sending || ((*it)->state == State::Connecting && (*it)->resolver == NULL))
+			{
+				sendingSockets += (*it)->socket;
+			}
+		}
+		// new requests and finished address lookups don't wake up the thread, so waiting still ends after retryFrequency at the latest
+		float timeout = (progress ? 0.0f : this->client->retryFrequency);
+		this->polling = !PlatformSocket::waitForReceive(sockets, timeout, this->readySockets, sendingSockets);
+		// as long as data is flowing, there's no waiting
+		if (this->polling && !progress)
+		{
+			hthread::sleep(this->client->retryFrequency * 1000.0f);
+		}
+	}
+
+	void HttpClientThread::_updateProcess()
+	{
+		HttpClientRequest* request = NULL;
+		Transfer* transfer = NULL;
+		State result = State::Running;
+		bool progress = false;
+		int i = 0;
+		while (this->isRunning())
+		{
+			this->client->_expirePendingRequests();
+			this->_removeReleasedTransfers();
+			this->_deleteAbandonedTransfers();
+			while (this->transfers.size() < this->maxTransfers)
+			{
+				request = this->client->_takePendingRequest();
+				if (request == NULL)
+				{
+					break;
+				}
+				this->transfers += new Transfer(request);
+			}
+			progress = false;
+			i = 0;
+			while (i < this->transfers.size())
+			{
+				transfer = this->transfers[i];
+				result = this->_updateTransfer(transfer, progress);
+				if (result == State::Running)
+				{
+					++i;
+					continue;
+				}
+				this->transfers.removeAt(i);
+				this->client->_finishRequest(transfer->request, result, (result == State::Failed && (int64_t)htickCount() >= transfer->request->deadline));
+				this->_deleteTransfer(transfer);
+				progress = true;
+			}
+			this->_waitForData(progress);
+		}
+	}
+
+	void HttpClientThread::process(hthread* thread)
+	{
+		((HttpClientThread*)thread)->_updateProcess();
+	}
+
+}
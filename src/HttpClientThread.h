@@ -0,0 +1,105 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a thread that drives many HTTP requests of a HttpClient at the same time.
+
+#ifndef SAKIT_HTTP_CLIENT_THREAD_H
+#define SAKIT_HTTP_CLIENT_THREAD_H
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hthread.h>
+
+#include "Host.h"
+#include "State.h"
+#include "WorkerThread.h"
+
+#define HTTP_CLIENT_THREAD_BUFFER_SIZE 4096
+
+namespace sakit
+{
+	class HttpClient;
+	class HttpClientRequest;
+	class HttpResponse;
+	class PlatformSocket;
+
+	class HttpClientThread : public hthread
+	{
+	public:
+		friend class HttpClient;
+
+		HttpClientThread(HttpClient* client, int maxTransfers);
+		~HttpClientThread();
+
+	protected:
+		/// @brief Looks up the remote address of a transfer so a slow DNS query doesn't hold up the other transfers.
+		class Resolver : public WorkerThread
+		{
+		public:
+			Resolver(PlatformSocket* socket, Host host, unsigned short port);
+
+			/// @return Running while the lookup isn't done, otherwise Finished or Failed.
+			State getResult();
+
+		protected:
+			void _updateProcess() override;
+
+		};
+
+		/// @brief Progress of one request on its own connection.
+		class Transfer
+		{
+		public:
+			HttpClientRequest* request;
+			PlatformSocket* socket;
+			/// @brief Idle before connecting, then Connecting, Sending and Receiving.
+			State state;
+			hstream stream;
+			int remaining;
+			/// @brief Not NULL while the remote address is being looked up.
+			Resolver* resolver;
+
+			Transfer(HttpClientRequest* request);
+			~Transfer();
+
+		};
+
+		HttpClient* client;
+		int maxTransfers;
+		harray<Transfer*> transfers;
+		/// @brief Finished transfers that are only deleted once their address lookup is done.
+		harray<Transfer*> abandonedTransfers;
+		/// @brief Reused for receiving.
+		hstream stream;
+		harray<PlatformSocket*> readySockets;
+		/// @brief True if waiting on the sockets wasn't possible and all receiving transfers are checked for data instead.
+		bool polling;
+
+		/// @return Running while the request isn't done, otherwise Finished or Failed.
+		State _updateTransfer(Transfer* transfer, bool& progress);
+		State _updateConnect(Transfer* transfer, bool& progress);
+		State _updateSend(Transfer* transfer, bool& progress);
+		State _updateReceive(Transfer* transfer, bool& progress);
+		void _removeReleasedTransfers();
+		void _deleteTransfer(Transfer* transfer);
+		void _deleteAbandonedTransfers();
+		void _waitForData(bool progress);
+		void _updateProcess();
+
+		/// @return True if the response has neither Content-Length nor chunked encoding so only closing the connection ends it.
+		static bool _isCloseDelimited(HttpResponse* response);
+
+		static void process(hthread* thread);
+
+	};
+
+}
+#endif
@@ -0,0 +1,454 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/harray.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
+#include "HttpDownloader.h"
+#include "HttpDownloaderDelegate.h"
+#include "HttpResponse.h"
+#include "HttpSocket.h"
+#include "sakit.h"
+
+namespace sakit
+{
+	HttpDownloader::Piece::Piece() :
+		start(0LL),
+		end(-1LL),
+		retries(0)
+	{
+	}
+
+	HttpDownloader::Piece::Piece(int64_t start, int64_t end) :
+		retries(0)
+	{
+		this->start = start;
+		this->end = end;
+	}
+
+	HttpDownloader::HttpDownloader(HttpDownloaderDelegate* downloaderDelegate, int maxConnections, int pieceSize) :
+		HttpSocketDelegate(),
+		maxRetries(3),
+		sink(NULL),
+		state(State::Idle),
+		size(-1LL),
+		received(0LL),
+		rangesSupported(false)
+	{
+		this->downloaderDelegate = downloaderDelegate;
+		this->maxConnections = hmax(maxConnections, 1);
+		this->pieceSize = hmax(pieceSize, 1);
+	}
+
+	HttpDownloader::~HttpDownloader()
+	{
+		foreach (HttpSocket*, it, this->sockets)
+		{
+			delete (*it);
+		}
+	}
+
+	Url HttpDownloader::getUrl()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->url;
+	}
+
+	int64_t HttpDownloader::getSize()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->size;
+	}
+
+	int64_t HttpDownloader::getReceived()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->received;
+	}
+
+	State HttpDownloader::getState()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->state;
+	}
+
+	bool HttpDownloader::start(Url url, hsbase* sink, hmap<hstr, hstr> customHeaders)
+	{
+		if (!url.isValid())
+		{
+			hlog::warn(logTag, "Cannot start download, URL is not valid!");
+			return false;
+		}
+		if (sink == NULL)
+		{
+			hlog::warn(logTag, "Cannot start download, no sink given!");
+			return false;
+		}
+		hmutex::ScopeLock lock(&this->mutex);
+		if (this->state == State::Running)
+		{
+			hlog::warn(logTag, "Cannot start download, already running: " + this->url.toString());
+			return false;
+		}
+		this->url = url;
+		this->sink = sink;
+		this->customHeaders = customHeaders;
+		this->customHeaders.removeKey(SAKIT_HTTP_REQUEST_HEADER_RANGE);
+		this->customHeaders.removeKey(SAKIT_HTTP_REQUEST_HEADER_IF_RANGE);
+		this->size = -1LL;
+		this->received = 0LL;
+		this->validator = "";
+		this->rangesSupported = false;
+		// the first piece tells whether the server supports ranges at all
+		this->pendingPieces.clear();
+		this->pendingPieces += Piece(0LL, (int64_t)this->pieceSize - 1);
+		this->state = State::Running;
+		lock.release();
+		State result = this->_startPendingPieces();
+		if (result != State::Running)
+		{
+			lock.acquire(&this->mutex);
+			this->_stopSockets();
+			this->state = State::Idle;
+			return false;
+		}
+		return true;
+	}
+
+	bool HttpDownloader::abort()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		if (this->state != State::Running)
+		{
+			return false;
+		}
+		this->_stopSockets();
+		this->state = State::Idle;
+		return true;
+	}
+
+	void HttpDownloader::onExecuteCompleted(HttpSocket* socket, HttpResponse* response, Url url)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		if (this->state != State::Running || !this->activePieces.hasKey(socket))
+		{
+			return;
+		}
+		Piece piece = this->activePieces[socket];
+		this->activePieces.removeKey(socket);
+		int64_t received = this->received;
+		State result = this->_processResponse(piece, response, true);
+		bool progress = (this->received != received);
+		lock.release();
+		if (result == State::Running)
+		{
+			result = this->_startPendingPieces();
+		}
+		this->_reportResult(result, progress);
+	}
+
+	void HttpDownloader::onExecuteFailed(HttpSocket* socket, HttpResponse* response, Url url)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		if (this->state != State::Running || !this->activePieces.hasKey(socket))
+		{
+			return;
+		}
+		Piece piece = this->activePieces[socket];
+		this->activePieces.removeKey(socket);
+		int64_t received = this->received;
+		// whatever arrived before the failure is kept so only the missing part is requested again
+		State result = this->_processResponse(piece, response, false);
+		bool progress = (this->received != received);
+		lock.release();
+		if (result == State::Running)
+		{
+			result = this->_startPendingPieces();
+		}
+		this->_reportResult(result, progress);
+	}
+
+	State HttpDownloader::_processResponse(Piece& piece, HttpResponse* response, bool completed)
+	{
+		int64_t written = 0LL;
+		if (response->statusCode == HttpResponse::Code::PartialContent)
+		{
+			int64_t start = 0LL;
+			int64_t end = 0LL;
+			int64_t total = 0LL;
+			if (!HttpDownloader::_parseContentRange(response->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_CONTENT_RANGE, ""), start, end, total) ||
+				start != piece.start || end > piece.end || (this->rangesSupported && total != this->size))
+			{
+				if (!completed)
+				{
+					return this->_retryPiece(piece, 0LL);
+				}
+				hlog::warn(logTag, "Cannot download, unexpected Content-Range: " + response->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_CONTENT_RANGE, ""));
+				return State::Failed;
+			}
+			int64_t requestedEnd = piece.end;
+			piece.end = end;
+			if (!this->rangesSupported)
+			{
+				this->rangesSupported = true;
+				this->size = total;
+				hstr eTag = response->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_E_TAG, "");
+				// weak validators must not be used with If-Range
+				this->validator = (eTag != "" && !eTag.startsWith("W/") ? eTag : response->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_LAST_MODIFIED, ""));
+				if (this->size >= 0LL)
+				{
+					this->_queuePieces(piece.end + 1);
+				}
+			}
+			written = this->_writePiece(piece, response);
+			if (written < 0LL)
+			{
+				return State::Failed;
+			}
+			if (piece.start <= piece.end)
+			{
+				return this->_retryPiece(piece, written);
+			}
+			// without a known size the resource is downloaded piece by piece until the server sends less than requested
+			if (this->size < 0LL)
+			{
+				if (end < requestedEnd)
+				{
+					this->size = end + 1;
+				}
+				else
+				{
+					this->_queuePieces(end + 1);
+				}
+			}
+			return State::Running;
+		}
+		if (response->statusCode == HttpResponse::Code::Ok)
+		{
+			// a full response after ranges were confirmed means that If-Range didn't match anymore
+			if (this->rangesSupported || piece.start != 0LL)
+			{
+				hlog::warn(logTag, "Cannot download, resource has changed: " + this->url.toString());
+				return State::Failed;
+			}
+			if (!completed)
+			{
+				// without range support there is no way to resume
+				return this->_retryPiece(piece, 0LL);
+			}
+			piece.end = response->body.size() - 1;
+			written = this->_writePiece(piece, response);
+			if (written < 0LL)
+			{
+				return State::Failed;
+			}
+			this->size = written;
+			return State::Running;
+		}
+		if (response->statusCode == HttpResponse::Code::RequestedRangeNotSatisfiable && completed)
+		{
+			// the requested piece starts exactly at the end of the resource
+			if (piece.start == 0LL && !this->rangesSupported)
+			{
+				this->size = 0LL;
+				return State::Running;
+			}
+			if (this->rangesSupported && this->size < 0LL)
+			{
+				this->size = piece.start;
+				return State::Running;
+			}
+		}
+		if (!completed)
+		{
+			return this->_retryPiece(piece, 0LL);
+		}
+		hlog::warn(logTag, hsprintf("Cannot download, unexpected status %d: ", response->statusCode.value) + this->url.toString());
+		return State::Failed;
+	}
+
+	int64_t HttpDownloader::_writePiece(Piece& piece, HttpResponse* response)
+	{
+		int64_t count = hmin(response->body.size(), piece.end - piece.start + 1);
+		if (count <= 0LL)
+		{
+			return 0LL;
+		}
+		if (!this->sink->seek(piece.start, hseek::Start) || this->sink->writeRaw(&response->body[0], (int)count) != (int)count)
+		{
+			hlog::warn(logTag, "Cannot download, writing to sink failed: " + this->url.toString());
+			return -1LL;
+		}
+		piece.start += count;
+		this->received += count;
+		return count;
+	}
+
+	State HttpDownloader::_retryPiece(Piece& piece, int64_t written)
+	{
+		// only attempts that didn't get any data count as retries
+		piece.retries = (written > 0LL ? 0 : piece.retries + 1);
+		if (piece.retries > this->maxRetries)
+		{
+			hlog::warn(logTag, hsprintf("Cannot download, bytes %lld-%lld failed too often: ", (long long)piece.start, (long long)piece.end) + this->url.toString());
+			return State::Failed;
+		}
+		this->pendingPieces.insertAt(0, piece);
+		return State::Running;
+	}
+
+	void HttpDownloader::_queuePieces(int64_t start)
+	{
+		if (this->size < 0LL)
+		{
+			this->pendingPieces += Piece(start, start + this->pieceSize - 1);
+			return;
+		}
+		for (int64_t i = start; i < this->size; i += this->pieceSize)
+		{
+			this->pendingPieces += Piece(i, hmin(i + (int64_t)this->pieceSize, this->size) - 1);
+		}
+	}
+
+	State HttpDownloader::_startPendingPieces()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		if (this->state != State::Running)
+		{
+			return this->state;
+		}
+		// until ranges are confirmed there is only the first piece
+		int maxConnections = (this->rangesSupported ? this->maxConnections : 1);
+		harray<HttpSocket*> startedSockets;
+		harray<Piece> startedPieces;
+		HttpSocket* socket = NULL;
+		while (this->pendingPieces.size() > 0 && this->activePieces.size() < maxConnections)
+		{
+			socket = NULL;
+			foreach (HttpSocket*, it, this->sockets)
+			{
+				if (!this->activePieces.hasKey(*it) && !this->retiredSockets.has(*it))
+				{
+					socket = (*it);
+					break;
+				}
+			}
+			if (socket == NULL)
+			{
+				socket = new HttpSocket(this);
+				socket->setKeepAlive(true);
+				this->sockets += socket;
+			}
+			this->activePieces[socket] = this->pendingPieces.removeFirst();
+			startedSockets += socket;
+			startedPieces += this->activePieces[socket];
+		}
+		if (this->activePieces.size() == 0)
+		{
+			return State::Finished;
+		}
+		Url url = this->url;
+		hstr validator = this->validator;
+		hmap<hstr, hstr> customHeaders = this->customHeaders;
+		lock.release();
+		for_iter (i, 0, startedSockets.size())
+		{
+			customHeaders[SAKIT_HTTP_REQUEST_HEADER_RANGE] = hsprintf("bytes=%lld-%lld", (long long)startedPieces[i].start, (long long)startedPieces[i].end);
+			if (validator != "")
+			{
+				customHeaders[SAKIT_HTTP_REQUEST_HEADER_IF_RANGE] = validator;
+			}
+			if (!startedSockets[i]->executeGetAsync(url, "", customHeaders))
+			{
+				hlog::warn(logTag, "Cannot download, request could not be started: " + url.toString());
+				return State::Failed;
+			}
+		}
+		return State::Running;
+	}
+
+	void HttpDownloader::_stopSockets()
+	{
+		foreach_map (HttpSocket*, Piece, it, this->activePieces)
+		{
+			it->first->abort();
+			this->retiredSockets += it->first;
+		}
+		this->activePieces.clear();
+		this->pendingPieces.clear();
+	}
+
+	void HttpDownloader::_reportResult(State result, bool progress)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		if (this->state != State::Running)
+		{
+			return;
+		}
+		if (result == State::Failed)
+		{
+			this->_stopSockets();
+		}
+		this->state = result;
+		int64_t received = this->received;
+		int64_t size = this->size;
+		lock.release();
+		if (progress)
+		{
+			this->downloaderDelegate->onDownloadProgress(this, received, size);
+		}
+		if (result == State::Finished)
+		{
+			this->downloaderDelegate->onDownloadCompleted(this);
+		}
+		else if (result == State::Failed)
+		{
+			this->downloaderDelegate->onDownloadFailed(this);
+		}
+	}
+
+	bool HttpDownloader::_parseContentRange(chstr value, int64_t& start, int64_t& end, int64_t& size)
+	{
+		// e.g. "bytes 0-1023/4096" or "bytes 0-1023/*" if the total size isn't known
+		if (!value.startsWith("bytes "))
+		{
+			return false;
+		}
+		harray<hstr> parts = value(6, -1).split('/');
+		if (parts.size() != 2)
+		{
+			return false;
+		}
+		harray<hstr> range = parts[0].trimmed().split('-');
+		if (range.size() != 2 || !range[0].isNumber() || !range[1].isNumber())
+		{
+			return false;
+		}
+		start = (int64_t)(long long)range[0];
+		end = (int64_t)(long long)range[1];
+		hstr total = parts[1].trimmed();
+		if (total == "*")
+		{
+			size = -1LL;
+		}
+		else if (total.isNumber())
+		{
+			size = (int64_t)(long long)total;
+		}
+		else
+		{
+			return false;
+		}
+		return (start >= 0LL && start <= end && (size < 0LL || end < size));
+	}
+
+}
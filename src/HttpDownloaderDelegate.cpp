@@ -0,0 +1,33 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include "HttpDownloaderDelegate.h"
+
+namespace sakit
+{
+	HttpDownloaderDelegate::HttpDownloaderDelegate()
+	{
+	}
+
+	HttpDownloaderDelegate::~HttpDownloaderDelegate()
+	{
+	}
+
+	void HttpDownloaderDelegate::onDownloadProgress(HttpDownloader* downloader, int64_t received, int64_t size)
+	{
+	}
+
+	void HttpDownloaderDelegate::onDownloadCompleted(HttpDownloader* downloader)
+	{
+	}
+
+	void HttpDownloaderDelegate::onDownloadFailed(HttpDownloader* downloader)
+	{
+	}
+
+}
@@ -0,0 +1,71 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/hfile.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
+#include "HttpRequestBody.h"
+#include "sakit.h"
+
+namespace sakit
+{
+	HttpRequestBody::HttpRequestBody() :
+		stream(NULL),
+		streamOwned(false)
+	{
+	}
+
+	HttpRequestBody::HttpRequestBody(hsbase* stream) :
+		streamOwned(false)
+	{
+		this->stream = stream;
+	}
+
+	HttpRequestBody::HttpRequestBody(chstr filename) :
+		stream(NULL),
+		streamOwned(true)
+	{
+		if (!hfile::exists(filename))
+		{
+			hlog::warn(logTag, "Cannot upload, file does not exist: " + filename);
+			return;
+		}
+		hfile* file = new hfile();
+		file->open(filename);
+		this->stream = file;
+	}
+
+	HttpRequestBody::~HttpRequestBody()
+	{
+		if (this->streamOwned && this->stream != NULL)
+		{
+			delete this->stream;
+		}
+	}
+
+	int64_t HttpRequestBody::getSize()
+	{
+		if (this->stream == NULL)
+		{
+			return -1LL;
+		}
+		return (this->stream->size() - this->stream->position());
+	}
+
+	int HttpRequestBody::read(unsigned char* data, int size)
+	{
+		if (this->stream == NULL)
+		{
+			return -1;
+		}
+		return this->stream->readRaw(data, size);
+	}
+
+}
@@ -6,43 +6,41 @@
 /// This program is free software; you can redistribute it and/or modify it under
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
+#ifdef _SAKIT_ZLIB
+#include <string.h>
+#include <zlib.h>
+#endif
+
 #include <hltypes/hlog.h>
 #include <hltypes/hmap.h>
 #include <hltypes/hstream.h>
 #include <hltypes/hstring.h>
 
+#include "DelimiterScanner.h"
 #include "HttpResponse.h"
 #include "sakit.h"
 
-#define HTTP_DELIMITER "\r\n"
+#define DECODE_BUFFER_SIZE 16384
 
 namespace sakit
 {
-	static int _findSequence(hstream& stream, unsigned char* sequence, int sequenceLength)
+#ifdef _SAKIT_ZLIB
+	class ContentDecoder
 	{
-		if (sequence != NULL && sequenceLength > 0)
+	public:
+		z_stream stream;
+		/// @brief Data after the end of the compressed stream is ignored.
+		bool finished;
+		/// @brief Some servers send deflate data without the zlib header.
+		bool rawRetried;
+
+		ContentDecoder() : finished(false), rawRetried(false)
 		{
-			int position = (int)stream.position();
-			int size = (int)stream.size();
-			int j = 0;
-			for_iter (i, position, size)
-			{
-				if (stream[i] == sequence[j])
-				{
-					++j;
-				}
-				else
-				{
-					j = 0;
-				}
-				if (j == sequenceLength)
-				{
-					return i - position - 1;
-				}
-			}
+			memset(&this->stream, 0, sizeof(z_stream));
 		}
-		return -1;
-	}
+
+	};
+#endif
 
 	HL_ENUM_CLASS_DEFINE(HttpResponse::Code,
 	(
@@ -93,13 +91,25 @@ namespace sakit
 		statusCode(Code::Undefined),
 		headersComplete(false),
 		bodyComplete(false),
+		invalid(false),
+		contentDecoding(false),
 		chunkSize(0),
 		chunkRead(0),
-		newDataSize(0)
+		chunkDelimiterRemaining(0),
+		readingTrailers(false),
+		newDataSize(0),
+		parsePosition(0),
+		lineStart(0),
+		decoder(NULL)
 	{
 		this->clear();
 	}
 
+	HttpResponse::~HttpResponse()
+	{
+		this->_destroyDecoder();
+	}
+
 	void HttpResponse::clear()
 	{
 		this->protocol = "";
@@ -110,21 +120,42 @@ namespace sakit
 		this->raw.clear();
 		this->headersComplete = false;
 		this->bodyComplete = false;
+		this->invalid = false;
 		this->chunkSize = 0;
 		this->chunkRead = 0;
+		this->chunkDelimiterRemaining = 0;
+		this->readingTrailers = false;
 		this->newDataSize = 0;
+		this->parsePosition = 0;
+		this->lineStart = 0;
+		this->headerSpans.clear();
+		this->_destroyDecoder();
 	}
 
 	void HttpResponse::parseFromRaw()
 	{
+		if (this->invalid)
+		{
+			return;
+		}
+		// callers append new data at the end, parsing always continues where it stopped the last time
+		this->raw.seek(this->parsePosition, hseek::Start);
 		if (!this->headersComplete)
 		{
 			this->_readHeaders();
 		}
 		if (this->headersComplete && !this->bodyComplete)
 		{
-			this->_readBody();
+			if (this->statusCode == Code::NoContent || this->statusCode == Code::NotModified)
+			{
+				this->bodyComplete = true; // these never have a body
+			}
+			else
+			{
+				this->_readBody();
+			}
 		}
+		this->parsePosition = (int)this->raw.position();
 	}
 
 	bool HttpResponse::hasNewData()
@@ -145,77 +176,129 @@ namespace sakit
 
 	void HttpResponse::_readHeaders()
 	{
-		hstr data;
-		int size = 0;
-		this->_getRawData(data, size);
+		int size = (int)this->raw.size();
+		int position = (int)this->raw.position();
+		if (position >= size)
+		{
+			return;
+		}
+		// only new data is scanned and lines are processed directly in the raw data so fragmented headers don't get parsed again
+		const char* data = (const char*)&this->raw[0];
 		int index = 0;
-		int read = 0;
-		hstr line;
-		harray<hstr> lineData;
-		while (true)
+		int lineSize = 0;
+		while (position < size)
 		{
-			index = data.indexOf(HTTP_DELIMITER);
+			// the CR can be at the end of previous data so only LF is searched for
+			index = DelimiterScanner::findByte((const unsigned char*)&data[position], size - position, '\n');
 			if (index < 0)
 			{
-				this->raw.seek(read - size, hseek::End);
 				break;
 			}
-			line = (index > 0 ? data(0, index) : "");
-			data = data(index + 2, -1); // +2 is HTTP_DELIMITER's size
-			read += index + 2;
-			if (line == "")
+			index += position;
+			position = index + 1;
+			if (index - 1 < this->lineStart || data[index - 1] != '\r')
+			{
+				continue;
+			}
+			lineSize = index - 1 - this->lineStart;
+			if (lineSize == 0)
 			{
-				this->raw.seek(read - size, hseek::End);
+				this->lineStart = index + 1;
+				this->raw.seek(this->lineStart, hseek::Start);
+				this->_materializeHeaders();
 				this->headersComplete = true;
-				break;
+				return;
 			}
-			if (this->statusCode == HttpResponse::Code::Undefined)
+			if (this->lineStart == 0)
 			{
-				index = line.indexOf(' ');
-				if (index >= 0)
-				{
-					this->protocol = line(0, index);
-					line = line(index + 1, -1);
-					index = line.indexOf(' ');
-					if (index >= 0)
-					{
-						this->statusCode = HttpResponse::Code::fromInt((int)line(0, index));
-						this->statusMessage = line(index + 1, -1);
-					}
-					else
-					{
-						this->statusMessage = line;
-					}
-				}
+				this->_readStatusLine(data, lineSize);
 			}
 			else
 			{
-				lineData = line.split(':', 1, true);
-				if (lineData.size() > 1)
-				{
-					this->headers[lineData[0]] = lineData[1](1, -1); // because there's that space character
-				}
-				else
-				{
-					this->headers[lineData[0]] = "";
-				}
+				this->_addHeaderSpan(data, this->lineStart, lineSize);
+			}
+			this->lineStart = index + 1;
+		}
+		this->raw.seek(size, hseek::Start);
+	}
+
+	void HttpResponse::_readStatusLine(const char* data, int size)
+	{
+		hstr line(data, size);
+		int index = line.indexOf(' ');
+		if (index >= 0)
+		{
+			this->protocol = line(0, index);
+			line = line(index + 1, -1);
+			index = line.indexOf(' ');
+			if (index >= 0)
+			{
+				this->statusCode = HttpResponse::Code::fromInt((int)line(0, index));
+				this->statusMessage = line(index + 1, -1);
+			}
+			else
+			{
+				this->statusMessage = line;
 			}
 		}
 	}
 
+	void HttpResponse::_addHeaderSpan(const char* data, int start, int size)
+	{
+		int nameSize = DelimiterScanner::findByte((const unsigned char*)&data[start], size, ':');
+		if (nameSize < 0)
+		{
+			nameSize = size;
+		}
+		if (nameSize == 0)
+		{
+			return;
+		}
+		int valueStart = hmin(start + nameSize + 1, start + size);
+		int valueSize = start + size - valueStart;
+		if (valueSize > 0 && data[valueStart] == ' ') // because there's that space character
+		{
+			++valueStart;
+			--valueSize;
+		}
+		this->headerSpans += start;
+		this->headerSpans += nameSize;
+		this->headerSpans += valueStart;
+		this->headerSpans += valueSize;
+	}
+
+	void HttpResponse::_materializeHeaders()
+	{
+		if (this->headerSpans.size() == 0)
+		{
+			return;
+		}
+		const char* data = (const char*)&this->raw[0];
+		for (int i = 0; i < this->headerSpans.size(); i += 4)
+		{
+			this->headers[hstr(&data[this->headerSpans[i]], this->headerSpans[i + 1])] = hstr(&data[this->headerSpans[i + 2]], this->headerSpans[i + 3]);
+		}
+	}
+
 	void HttpResponse::_readBody()
 	{
 		if (this->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_TRANSFER_ENCODING, "identity") != "chunked")
 		{
-			this->chunkSize = (int)this->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_CONTENT_LENGTH, "0");
-			int written = this->body.writeRaw(this->raw);
-			this->raw.seek(written);
-			this->chunkRead += written;
-			if (written > 0)
+			// without Content-Length the body ends when the connection is closed
+			bool hasLength = this->headers.hasKey(SAKIT_HTTP_RESPONSE_HEADER_CONTENT_LENGTH);
+			int written = 0;
+			if (hasLength)
 			{
-				this->newDataSize += written;
+				// data after the body already belongs to the next response when pipelining
+				this->chunkSize = (int)this->headers[SAKIT_HTTP_RESPONSE_HEADER_CONTENT_LENGTH];
+				written = this->_writeBody(this->chunkSize - this->chunkRead);
 			}
-			if (this->chunkSize > 0 && this->chunkSize == this->chunkRead)
+			else
+			{
+				written = this->_writeBody((int)(this->raw.size() - this->raw.position()));
+			}
+			this->chunkRead += written;
+			if (hasLength && this->chunkRead >= this->chunkSize)
 			{
 				this->bodyComplete = true;
 			}
@@ -224,55 +307,210 @@ namespace sakit
 		{
 			int offset = 0;
 			int read = 0;
-			while (true)
+			hstr line;
+			while (!this->raw.eof())
 			{
-				if (this->chunkSize == 0)
+				if (this->readingTrailers)
 				{
-					offset = _findSequence(this->raw, (unsigned char*)HTTP_DELIMITER, strlen(HTTP_DELIMITER));
+					offset = (int)this->raw.position();
+					offset = DelimiterScanner::findLineEnd(&this->raw[offset], (int)this->raw.size() - offset);
 					if (offset < 0)
 					{
 						break; // not enough bytes to read
 					}
-					this->chunkSize = (int)hstr(this->raw.read(offset)).unhex();
-					this->raw.seek(2);
-					if (this->chunkSize == 0)
+					this->raw.seek(offset + 2);
+					// trailers are not part of the body and end with an empty line
+					if (offset == 0)
 					{
-						this->body.writeRaw(this->raw);
-						this->raw.seek(0, hseek::End);
+						this->readingTrailers = false;
 						this->bodyComplete = true;
 						break;
 					}
+					continue;
 				}
-				if (this->chunkSize > 0)
+				if (this->chunkDelimiterRemaining > 0) // the delimiter after the chunk data can be fragmented as well
 				{
-					read = this->chunkSize - this->chunkRead;
-					read = this->body.writeRaw(this->raw, read);
+					read = hmin(this->chunkDelimiterRemaining, (int)(this->raw.size() - this->raw.position()));
 					this->raw.seek(read);
-					this->chunkRead += read;
-					this->newDataSize += read;
-					if (this->chunkRead == this->chunkSize)
+					this->chunkDelimiterRemaining -= read;
+					continue;
+				}
+				if (this->chunkSize == 0)
+				{
+					offset = (int)this->raw.position();
+					offset = DelimiterScanner::findLineEnd(&this->raw[offset], (int)this->raw.size() - offset);
+					if (offset < 0)
 					{
-						this->chunkSize = 0;
-						this->chunkRead = 0;
-						this->raw.seek(2);
+						break; // not enough bytes to read
+					}
+					line = this->raw.read(offset);
+					offset = line.indexOf(';'); // chunk extensions are ignored
+					if (offset >= 0)
+					{
+						line = line(0, offset);
 					}
-					if (this->raw.eof())
+					line = line.trimmed();
+					// at most 7 significant hex digits so the size always fits into a positive int
+					if (line == "" || !line.isHex() || line.trimmedLeft('0').size() > 7)
 					{
+						hlog::error(logTag, "Cannot parse response, invalid chunk size: " + line);
+						this->invalid = true;
 						break;
 					}
+					line = line.trimmedLeft('0');
+					this->chunkSize = (line != "" ? (int)line.unhex() : 0);
+					if (this->chunkSize < 0)
+					{
+						hlog::error(logTag, "Cannot parse response, invalid chunk size: " + line);
+						this->chunkSize = 0;
+						this->invalid = true;
+						break;
+					}
+					this->raw.seek(2);
+					if (this->chunkSize == 0)
+					{
+						this->readingTrailers = true;
+						continue;
+					}
+				}
+				read = this->_writeBody(this->chunkSize - this->chunkRead);
+				if (read == 0)
+				{
+					break;
+				}
+				this->chunkRead += read;
+				if (this->chunkRead == this->chunkSize)
+				{
+					this->chunkSize = 0;
+					this->chunkRead = 0;
+					this->chunkDelimiterRemaining = 2;
+				}
+			}
+		}
+	}
+
+	int HttpResponse::_writeBody(int count)
+	{
+		int position = (int)this->raw.position();
+		count = hclamp(count, 0, (int)this->raw.size() - position);
+		if (count == 0)
+		{
+			return 0;
+		}
+		if (!this->contentDecoding || !this->_decodeBody(&this->raw[position], count))
+		{
+			this->body.writeRaw(&this->raw[position], count);
+			this->newDataSize += count;
+		}
+		this->raw.seek(count);
+		return count;
+	}
+
+	bool HttpResponse::_decodeBody(const unsigned char* data, int size)
+	{
+#ifdef _SAKIT_ZLIB
+		ContentDecoder* decoder = (ContentDecoder*)this->decoder;
+		if (decoder == NULL)
+		{
+			hstr encoding = this->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_CONTENT_ENCODING, "identity").trimmed().lowered();
+			if (encoding != "gzip" && encoding != "x-gzip" && encoding != "deflate")
+			{
+				return false;
+			}
+			decoder = new ContentDecoder();
+			// adding 32 enables automatic detection of the gzip and zlib headers
+			int windowBits = MAX_WBITS + 32;
+			// a zlib header always starts with the deflate method and a window size of at most 32K
+			if (encoding == "deflate" && ((data[0] & 0x0F) != Z_DEFLATED || (data[0] >> 4) > 7))
+			{
+				windowBits = -MAX_WBITS;
+				decoder->rawRetried = true;
+			}
+			if (inflateInit2(&decoder->stream, windowBits) != Z_OK)
+			{
+				hlog::error(logTag, "Could not initialize decoding of body!");
+				delete decoder;
+				return false;
+			}
+			this->decoder = decoder;
+		}
+		if (decoder->finished)
+		{
+			return true;
+		}
+		unsigned char buffer[DECODE_BUFFER_SIZE];
+		int result = Z_OK;
+		int written = 0;
+		decoder->stream.next_in = (Bytef*)data;
+		decoder->stream.avail_in = (uInt)size;
+		do
+		{
+			decoder->stream.next_out = (Bytef*)buffer;
+			decoder->stream.avail_out = (uInt)DECODE_BUFFER_SIZE;
+			result = inflate(&decoder->stream, Z_NO_FLUSH);
+			if (result == Z_DATA_ERROR && !decoder->rawRetried && decoder->stream.total_out == 0 && decoder->stream.total_in <= (uLong)size)
+			{
+				decoder->rawRetried = true;
+				if (inflateReset2(&decoder->stream, -MAX_WBITS) == Z_OK)
+				{
+					decoder->stream.next_in = (Bytef*)data;
+					decoder->stream.avail_in = (uInt)size;
+					continue;
 				}
 			}
+			if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+			{
+				hlog::error(logTag, "Could not decode body: " + hstr(decoder->stream.msg != NULL ? decoder->stream.msg : "unknown error"));
+				decoder->finished = true;
+				break;
+			}
+			written = DECODE_BUFFER_SIZE - (int)decoder->stream.avail_out;
+			if (written > 0)
+			{
+				this->body.writeRaw(buffer, written);
+				this->newDataSize += written;
+			}
+			if (result == Z_STREAM_END)
+			{
+				decoder->finished = true;
+				break;
+			}
+		} while (result != Z_BUF_ERROR && (decoder->stream.avail_in > 0 || decoder->stream.avail_out == 0));
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void HttpResponse::_destroyDecoder()
+	{
+#ifdef _SAKIT_ZLIB
+		if (this->decoder != NULL)
+		{
+			inflateEnd(&((ContentDecoder*)this->decoder)->stream);
+			delete (ContentDecoder*)this->decoder;
 		}
+#endif
+		this->decoder = NULL;
 	}
 
-	void HttpResponse::_getRawData(hstr& data, int& size)
+	void HttpResponse::moveExcessData(HttpResponse* other)
 	{
-		size = (int)(this->raw.size() - this->raw.position());
-		char* buffer = new char[size + 1];
-		this->raw.readRaw(buffer, size);
-		buffer[size] = '\0'; // classic string terminating 0-character
-		data = hstr(buffer);
-		delete[] buffer;
+		other->clear();
+		other->contentDecoding = this->contentDecoding;
+		int size = (int)this->raw.size();
+		if (this->parsePosition < size)
+		{
+			other->raw.writeRaw(&this->raw[this->parsePosition], size - this->parsePosition);
+			other->raw.rewind();
+			hstream data;
+			if (this->parsePosition > 0)
+			{
+				data.writeRaw(&this->raw[0], this->parsePosition);
+			}
+			this->raw = data;
+			this->raw.seek(0, hseek::End);
+		}
 	}
 
 	HttpResponse* HttpResponse::clone() const
@@ -288,9 +526,33 @@ namespace sakit
 		result->raw.rewind();
 		result->headersComplete = this->headersComplete;
 		result->bodyComplete = this->bodyComplete;
+		result->invalid = this->invalid;
 		result->chunkSize = this->chunkSize;
 		result->chunkRead = this->chunkRead;
+		result->chunkDelimiterRemaining = this->chunkDelimiterRemaining;
+		result->readingTrailers = this->readingTrailers;
 		result->newDataSize = this->newDataSize;
+		result->parsePosition = this->parsePosition;
+		result->lineStart = this->lineStart;
+		result->headerSpans = this->headerSpans;
+		result->contentDecoding = this->contentDecoding;
+#ifdef _SAKIT_ZLIB
+		if (this->decoder != NULL)
+		{
+			ContentDecoder* decoder = new ContentDecoder();
+			ContentDecoder* source = (ContentDecoder*)this->decoder;
+			if (inflateCopy(&decoder->stream, &source->stream) == Z_OK)
+			{
+				decoder->finished = source->finished;
+				decoder->rawRetried = source->rawRetried;
+				result->decoder = decoder;
+			}
+			else
+			{
+				delete decoder;
+			}
+		}
+#endif
 		return result;
 	}
 
@@ -0,0 +1,175 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstring.h>
+
+#include "HttpServer.h"
+#include "HttpServerThread.h"
+#include "sakit.h"
+#include "TcpServerDelegate.h"
+#include "TcpServerThread.h"
+#include "TcpSocket.h"
+
+#define REQUEST_GET "GET"
+#define REQUEST_HEAD "HEAD"
+
+namespace sakit
+{
+	HttpServer::Route::Route() :
+		handler(NULL)
+	{
+	}
+
+	HttpServer::Route::Route(chstr method, chstr path, HttpServerHandler* handler)
+	{
+		this->method = method;
+		this->path = path;
+		this->handler = handler;
+	}
+
+	HttpServer::HttpServer(TcpServerDelegate* serverDelegate, int threadCount) :
+		TcpServer(serverDelegate, NULL),
+		nextThread(0),
+		keepAliveTimeout(5.0f),
+		maxHeaderSize(65536),
+		maxBodySize(8388608),
+		connectionCount(0),
+		requestCount(0LL)
+	{
+		threadCount = hmax(threadCount, 1);
+		for_iter (i, 0, threadCount)
+		{
+			this->threads += new HttpServerThread(this);
+		}
+		foreach (HttpServerThread*, it, this->threads)
+		{
+			(*it)->start();
+		}
+	}
+
+	HttpServer::~HttpServer()
+	{
+		foreach (HttpServerThread*, it, this->threads)
+		{
+			(*it)->join();
+			delete (*it);
+		}
+	}
+
+	int HttpServer::getConnectionCount()
+	{
+		hmutex::ScopeLock lock(&this->statsMutex);
+		return this->connectionCount;
+	}
+
+	int64_t HttpServer::getRequestCount()
+	{
+		hmutex::ScopeLock lock(&this->statsMutex);
+		return this->requestCount;
+	}
+
+	void HttpServer::addRoute(chstr method, chstr path, HttpServerHandler* handler)
+	{
+		hmutex::ScopeLock lock(&this->routesMutex);
+		for_iter (i, 0, this->routes.size())
+		{
+			if (this->routes[i].method == method && this->routes[i].path == path)
+			{
+				this->routes[i].handler = handler;
+				return;
+			}
+		}
+		this->routes += Route(method, path, handler);
+	}
+
+	bool HttpServer::removeRoute(chstr method, chstr path)
+	{
+		hmutex::ScopeLock lock(&this->routesMutex);
+		for_iter (i, 0, this->routes.size())
+		{
+			if (this->routes[i].method == method && this->routes[i].path == path)
+			{
+				this->routes.removeAt(i);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void HttpServer::update(float timeDelta)
+	{
+		// accepted connections are taken over by the I/O threads directly, TcpServer::update() would hand them to the delegate
+		Server::update(timeDelta);
+	}
+
+	TcpSocket* HttpServer::_takeAcceptedSocket(HttpServerThread* thread)
+	{
+		hmutex::ScopeLock lock(&this->acceptMutex);
+		if (this->threads[this->nextThread] != thread)
+		{
+			return NULL;
+		}
+		hmutex::ScopeLock lockThreadSockets(&this->tcpServerThread->socketsMutex);
+		if (this->tcpServerThread->sockets.size() == 0)
+		{
+			return NULL;
+		}
+		TcpSocket* socket = this->tcpServerThread->sockets.removeFirst();
+		lockThreadSockets.release();
+		// round-robin keeps the connections evenly distributed
+		this->nextThread = (this->nextThread + 1) % this->threads.size();
+		return socket;
+	}
+
+	HttpServerHandler* HttpServer::_findHandler(chstr method, chstr path, bool& pathFound)
+	{
+		pathFound = false;
+		HttpServerHandler* result = NULL;
+		int prefixSize = -1;
+		bool methodMatches = false;
+		hstr prefix;
+		hmutex::ScopeLock lock(&this->routesMutex);
+		foreach (Route, it, this->routes)
+		{
+			methodMatches = ((*it).method == "" || (*it).method == method || (method == REQUEST_HEAD && (*it).method == REQUEST_GET));
+			if ((*it).path == path)
+			{
+				pathFound = true;
+				if (methodMatches)
+				{
+					return (*it).handler;
+				}
+			}
+			else if ((*it).path.endsWith("*"))
+			{
+				prefix = (*it).path(0, (*it).path.size() - 1);
+				if (path.startsWith(prefix))
+				{
+					pathFound = true;
+					if (methodMatches && prefix.size() > prefixSize)
+					{
+						result = (*it).handler;
+						prefixSize = prefix.size();
+					}
+				}
+			}
+		}
+		return result;
+	}
+
+	void HttpServer::_updateStats(int connectionChange, int requestChange)
+	{
+		hmutex::ScopeLock lock(&this->statsMutex);
+		this->connectionCount += connectionChange;
+		this->requestCount += requestChange;
+	}
+
+}
@@ -0,0 +1,292 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
+#include "DelimiterScanner.h"
+#include "HttpResponse.h"
+#include "HttpServerRequest.h"
+#include "HttpSocket.h"
+
+#define MAX_CHUNK_SIZE_LINE 32
+
+namespace sakit
+{
+	HttpServerRequest::HttpServerRequest() :
+		remotePort(0),
+		headersComplete(false),
+		bodyComplete(false),
+		lineStart(0),
+		parsePosition(0),
+		chunked(false),
+		contentLength(0),
+		readingTrailers(false),
+		error(HttpResponse::Code::Undefined)
+	{
+	}
+
+	HttpServerRequest::~HttpServerRequest()
+	{
+	}
+
+	hstr HttpServerRequest::getHeader(chstr name, chstr defaultValue) const
+	{
+		hstr lowered = name.lowered();
+		for (hmap<hstr, hstr>::const_iterator it = this->headers.begin(); it != this->headers.end(); ++it)
+		{
+			if (it->first.lowered() == lowered)
+			{
+				return it->second;
+			}
+		}
+		return defaultValue;
+	}
+
+	bool HttpServerRequest::isKeepAlive() const
+	{
+		hstr connection = this->getHeader(SAKIT_HTTP_REQUEST_HEADER_CONNECTION).lowered();
+		if (this->protocol == "HTTP/1.0")
+		{
+			return connection.contains("keep-alive");
+		}
+		return !connection.contains("close");
+	}
+
+	void HttpServerRequest::clear()
+	{
+		this->method = "";
+		this->path = "";
+		this->query = "";
+		this->protocol = "";
+		this->headers.clear();
+		this->body.clear();
+		this->headersComplete = false;
+		this->bodyComplete = false;
+		this->lineStart = 0;
+		this->parsePosition = 0;
+		this->chunked = false;
+		this->contentLength = 0;
+		this->readingTrailers = false;
+		this->error = HttpResponse::Code::Undefined;
+	}
+
+	int HttpServerRequest::_parse(const unsigned char* data, int size, int maxHeaderSize, int maxBodySize)
+	{
+		int index = 0;
+		int lineSize = 0;
+		hstr line;
+		while (!this->headersComplete && this->parsePosition < size)
+		{
+			// only new data is scanned so fragmented headers don't get scanned again
+			index = DelimiterScanner::findByte(&data[this->parsePosition], size - this->parsePosition, '\n');
+			if (index < 0)
+			{
+				this->parsePosition = size;
+				break;
+			}
+			index += this->parsePosition;
+			this->parsePosition = index + 1;
+			lineSize = index - this->lineStart;
+			if (lineSize > 0 && data[index - 1] == '\r')
+			{
+				--lineSize;
+			}
+			line = hstr((const char*)&data[this->lineStart], lineSize);
+			this->lineStart = this->parsePosition;
+			if (this->method == "")
+			{
+				// empty lines before the request line have to be ignored
+				if (lineSize > 0 && !this->_readRequestLine(line))
+				{
+					return -1;
+				}
+				continue;
+			}
+			if (lineSize == 0)
+			{
+				this->headersComplete = true;
+				if (!this->_prepareBody(maxBodySize))
+				{
+					return -1;
+				}
+				break;
+			}
+			index = line.indexOf(':');
+			if (index <= 0)
+			{
+				this->error = HttpResponse::Code::BadRequest;
+				return -1;
+			}
+			this->headers[line(0, index)] = line(index + 1, -1).trimmed();
+		}
+		if (!this->headersComplete)
+		{
+			if (size > maxHeaderSize)
+			{
+				this->error = HttpResponse::Code::RequestEntityTooLarge;
+				return -1;
+			}
+			return 0;
+		}
+		return (this->chunked ? this->_readChunkedBody(data, size, maxBodySize) : this->_readBody(data, size));
+	}
+
+	bool HttpServerRequest::_readRequestLine(chstr line)
+	{
+		harray<hstr> parts = line.split(' ', -1, true);
+		if (parts.size() != 3)
+		{
+			this->error = HttpResponse::Code::BadRequest;
+			return false;
+		}
+		if (!parts[2].startsWith("HTTP/1."))
+		{
+			this->error = HttpResponse::Code::HttpVersionNotSupported;
+			return false;
+		}
+		this->method = parts[0];
+		this->protocol = parts[2];
+		hstr target = parts[1];
+		// absolute form as sent to proxies
+		if (target.startsWith("http://") || target.startsWith("https://"))
+		{
+			int index = target.indexOf('/', target.indexOf("//") + 2);
+			target = (index >= 0 ? target(index, -1) : hstr("/"));
+		}
+		int index = target.indexOf('?');
+		if (index >= 0)
+		{
+			this->path = target(0, index);
+			this->query = target(index + 1, -1);
+		}
+		else
+		{
+			this->path = target;
+		}
+		return true;
+	}
+
+	bool HttpServerRequest::_prepareBody(int maxBodySize)
+	{
+		if (this->getHeader(SAKIT_HTTP_RESPONSE_HEADER_TRANSFER_ENCODING).lowered().contains("chunked"))
+		{
+			this->chunked = true;
+			return true;
+		}
+		hstr contentLength = this->getHeader(SAKIT_HTTP_REQUEST_HEADER_CONTENT_LENGTH, "0").trimmed();
+		if (!contentLength.isNumber() || (int64_t)(long long)contentLength < 0LL)
+		{
+			this->error = HttpResponse::Code::BadRequest;
+			return false;
+		}
+		if ((int64_t)(long long)contentLength > (int64_t)maxBodySize)
+		{
+			this->error = HttpResponse::Code::RequestEntityTooLarge;
+			return false;
+		}
+		this->contentLength = (int)contentLength;
+		return true;
+	}
+
+	int HttpServerRequest::_readBody(const unsigned char* data, int size)
+	{
+		if (size - this->parsePosition < this->contentLength)
+		{
+			return 0;
+		}
+		if (this->contentLength > 0)
+		{
+			this->body.writeRaw(&data[this->parsePosition], this->contentLength);
+			this->body.rewind();
+		}
+		this->bodyComplete = true;
+		return (this->parsePosition + this->contentLength);
+	}
+
+	int HttpServerRequest::_readChunkedBody(const unsigned char* data, int size, int maxBodySize)
+	{
+		int index = 0;
+		int chunkSize = 0;
+		hstr line;
+		// parsePosition only advances over complete chunks so an incomplete chunk is parsed again with more data
+		while (this->parsePosition < size)
+		{
+			index = DelimiterScanner::findLineEnd(&data[this->parsePosition], size - this->parsePosition);
+			if (index < 0)
+			{
+				if (!this->readingTrailers && size - this->parsePosition > MAX_CHUNK_SIZE_LINE)
+				{
+					this->error = HttpResponse::Code::BadRequest;
+					return -1;
+				}
+				return 0;
+			}
+			if (this->readingTrailers)
+			{
+				this->parsePosition += index + 2;
+				// trailers are ignored and end with an empty line
+				if (index == 0)
+				{
+					this->body.rewind();
+					this->bodyComplete = true;
+					return this->parsePosition;
+				}
+				continue;
+			}
+			line = hstr((const char*)&data[this->parsePosition], index);
+			// chunk extensions are ignored
+			int extension = line.indexOf(';');
+			if (extension >= 0)
+			{
+				line = line(0, extension);
+			}
+			line = line.trimmed();
+			if (line == "" || !line.isHex())
+			{
+				this->error = HttpResponse::Code::BadRequest;
+				return -1;
+			}
+			line = line.trimmedLeft('0');
+			// at most 7 hex digits so the size always fits into a positive int
+			if (line.size() > 7)
+			{
+				this->error = HttpResponse::Code::RequestEntityTooLarge;
+				return -1;
+			}
+			chunkSize = (line != "" ? (int)line.unhex() : 0);
+			if (chunkSize < 0)
+			{
+				this->error = HttpResponse::Code::BadRequest;
+				return -1;
+			}
+			if (chunkSize == 0)
+			{
+				this->parsePosition += index + 2;
+				this->readingTrailers = true;
+				continue;
+			}
+			if ((int64_t)chunkSize > (int64_t)maxBodySize - this->body.size())
+			{
+				this->error = HttpResponse::Code::RequestEntityTooLarge;
+				return -1;
+			}
+			if (size - this->parsePosition < index + 2 + chunkSize + 2)
+			{
+				return 0;
+			}
+			this->body.writeRaw(&data[this->parsePosition + index + 2], chunkSize);
+			this->parsePosition += index + 2 + chunkSize + 2;
+		}
+		return 0;
+	}
+
+}
@@ -0,0 +1,148 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
+#include "HttpRequestBody.h"
+#include "HttpResponse.h"
+#include "HttpServerResponse.h"
+#include "HttpSocket.h"
+
+#define HTTP_DELIMITER "\r\n"
+
+namespace sakit
+{
+	struct StatusMessage
+	{
+		unsigned int code;
+		const char* message;
+	};
+
+	static const StatusMessage statusMessages[] =
+	{
+		{ 100, "Continue" },
+		{ 101, "Switching Protocols" },
+		{ 200, "OK" },
+		{ 201, "Created" },
+		{ 202, "Accepted" },
+		{ 203, "Non-Authoritative Information" },
+		{ 204, "No Content" },
+		{ 205, "Reset Content" },
+		{ 206, "Partial Content" },
+		{ 300, "Multiple Choices" },
+		{ 301, "Moved Permanently" },
+		{ 302, "Found" },
+		{ 303, "See Other" },
+		{ 304, "Not Modified" },
+		{ 305, "Use Proxy" },
+		{ 307, "Temporary Redirect" },
+		{ 400, "Bad Request" },
+		{ 401, "Unauthorized" },
+		{ 402, "Payment Required" },
+		{ 403, "Forbidden" },
+		{ 404, "Not Found" },
+		{ 405, "Method Not Allowed" },
+		{ 406, "Not Acceptable" },
+		{ 407, "Proxy Authentication Required" },
+		{ 408, "Request Timeout" },
+		{ 409, "Conflict" },
+		{ 410, "Gone" },
+		{ 411, "Length Required" },
+		{ 412, "Precondition Failed" },
+		{ 413, "Payload Too Large" },
+		{ 414, "URI Too Long" },
+		{ 415, "Unsupported Media Type" },
+		{ 416, "Range Not Satisfiable" },
+		{ 417, "Expectation Failed" },
+		{ 500, "Internal Server Error" },
+		{ 501, "Not Implemented" },
+		{ 502, "Bad Gateway" },
+		{ 503, "Service Unavailable" },
+		{ 504, "Gateway Timeout" },
+		{ 505, "HTTP Version Not Supported" },
+	};
+
+	HttpServerResponse::HttpServerResponse() :
+		statusCode(HttpResponse::Code::Ok),
+		chunked(false),
+		bodyStream(NULL)
+	{
+	}
+
+	HttpServerResponse::~HttpServerResponse()
+	{
+		if (this->bodyStream != NULL)
+		{
+			delete this->bodyStream;
+		}
+	}
+
+	void HttpServerResponse::setBodyStream(HttpRequestBody* value)
+	{
+		if (this->bodyStream != NULL && this->bodyStream != value)
+		{
+			delete this->bodyStream;
+		}
+		this->bodyStream = value;
+	}
+
+	void HttpServerResponse::setBody(chstr value)
+	{
+		this->body.clear();
+		if (value.size() > 0)
+		{
+			this->body.writeRaw((void*)value.cStr(), value.size());
+			this->body.rewind();
+		}
+	}
+
+	hstr HttpServerResponse::_makeHeader(chstr protocol, bool keepAlive, int64_t bodySize)
+	{
+		hstr result = hsprintf("%s %d %s" HTTP_DELIMITER, protocol.cStr(), (int)this->statusCode.value, HttpServerResponse::_getStatusMessage(this->statusCode).cStr());
+		foreach_map (hstr, hstr, it, this->headers)
+		{
+			if (it->first != SAKIT_HTTP_RESPONSE_HEADER_CONTENT_LENGTH && it->first != SAKIT_HTTP_RESPONSE_HEADER_TRANSFER_ENCODING &&
+				it->first != SAKIT_HTTP_RESPONSE_HEADER_CONNECTION)
+			{
+				result += it->first + ": " + it->second + HTTP_DELIMITER;
+			}
+		}
+		// these never have a body
+		if (this->statusCode != HttpResponse::Code::NoContent && this->statusCode != HttpResponse::Code::NotModified && this->statusCode.value >= 200)
+		{
+			if (bodySize >= 0LL)
+			{
+				result += hsprintf(SAKIT_HTTP_RESPONSE_HEADER_CONTENT_LENGTH ": %lld" HTTP_DELIMITER, (long long)bodySize);
+			}
+			else
+			{
+				result += SAKIT_HTTP_RESPONSE_HEADER_TRANSFER_ENCODING ": chunked" HTTP_DELIMITER;
+			}
+		}
+		result += SAKIT_HTTP_RESPONSE_HEADER_CONNECTION;
+		result += (keepAlive ? ": keep-alive" HTTP_DELIMITER : ": close" HTTP_DELIMITER);
+		result += HTTP_DELIMITER;
+		return result;
+	}
+
+	hstr HttpServerResponse::_getStatusMessage(HttpResponse::Code code)
+	{
+		for_iter (i, 0, (int)(sizeof(statusMessages) / sizeof(StatusMessage)))
+		{
+			if (statusMessages[i].code == code.value)
+			{
+				return statusMessages[i].message;
+			}
+		}
+		return "Unknown";
+	}
+
+}
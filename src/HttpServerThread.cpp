@@ -0,0 +1,362 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/harray.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+#include <hltypes/hthread.h>
+
+#include "HttpRequestBody.h"
+#include "HttpResponse.h"
+#include "HttpServer.h"
+#include "HttpServerHandler.h"
+#include "HttpServerRequest.h"
+#include "HttpServerResponse.h"
+#include "HttpServerThread.h"
+#include "HttpSocketThread.h"
+#include "PlatformSocket.h"
+#include "sakit.h"
+#include "TcpSocket.h"
+
+#define REQUEST_HEAD "HEAD"
+#define PROTOCOL_HTTP_1_0 "HTTP/1.0"
+#define PROTOCOL_HTTP_1_1 "HTTP/1.1"
+
+namespace sakit
+{
+	HttpServerThread::Connection::Connection(TcpSocket* socket) :
+		consumed(0),
+		streamedResponse(NULL),
+		streamSize(0LL),
+		streamSent(0LL),
+		keepAlive(true)
+	{
+		this->socket = socket;
+		this->platformSocket = socket->socket;
+		// a client that doesn't read its responses mustn't block the other connections of the thread
+		this->platformSocket->setNonBlocking(true);
+		this->lastActivityTime = (int64_t)htickCount();
+	}
+
+	HttpServerThread::Connection::~Connection()
+	{
+		if (this->streamedResponse != NULL)
+		{
+			delete this->streamedResponse;
+		}
+		this->platformSocket->disconnect();
+		delete this->socket;
+	}
+
+	HttpServerThread::HttpServerThread(HttpServer* server) :
+		hthread(&process, "SAKit HTTP server")
+	{
+		this->server = server;
+		this->buffer = new unsigned char[HTTP_SOCKET_THREAD_UPLOAD_PIECE_SIZE];
+	}
+
+	HttpServerThread::~HttpServerThread()
+	{
+		foreach (Connection*, it, this->connections)
+		{
+			delete (*it);
+		}
+		delete[] this->buffer;
+	}
+
+	bool HttpServerThread::_updateConnection(Connection* connection, bool& progress)
+	{
+		if (!this->_updateSend(connection, progress) || !this->_updateReceive(connection, progress))
+		{
+			return false;
+		}
+		bool pending = (connection->output.size() > 0 || connection->streamedResponse != NULL);
+		if (!connection->keepAlive && !pending)
+		{
+			return false;
+		}
+		if ((int64_t)htickCount() - connection->lastActivityTime >= (int64_t)(this->server->keepAliveTimeout * 1000.0f))
+		{
+			if (pending)
+			{
+				hlog::warn(logTag, "HttpServer connection timed out while sending: " + connection->socket->getRemoteHost().toString());
+			}
+			return false;
+		}
+		return true;
+	}
+
+	bool HttpServerThread::_updateSend(Connection* connection, bool& progress)
+	{
+		if (connection->output.size() > 0)
+		{
+			int count = (int)(connection->output.size() - connection->output.position());
+			int sent = 0;
+			if (!connection->platformSocket->send(&connection->output, count, sent))
+			{
+				return false;
+			}
+			if (sent > 0)
+			{
+				connection->lastActivityTime = (int64_t)htickCount();
+				progress = true;
+			}
+			if (!connection->output.eof())
+			{
+				return true;
+			}
+			connection->output.clear();
+		}
+		// body streams are read piece by piece only as fast as the client takes them
+		if (connection->streamedResponse != NULL)
+		{
+			int count = HttpSocketThread::_readUploadPiece(connection->streamedResponse->bodyStream, connection->streamSize,
+				connection->streamSent, this->buffer, &this->piece);
+			if (count < 0)
+			{
+				return false;
+			}
+			if (this->piece.size() > 0)
+			{
+				this->_queueOutput(connection, &this->piece[0], (int)this->piece.size());
+			}
+			connection->streamSent += count;
+			if (count == 0 || (connection->streamSize >= 0 && connection->streamSent >= connection->streamSize))
+			{
+				delete connection->streamedResponse;
+				connection->streamedResponse = NULL;
+				// pipelined requests that arrived in the meantime can be handled now
+				this->_processRequests(connection);
+			}
+			progress = true;
+		}
+		return true;
+	}
+
+	bool HttpServerThread::_updateReceive(Connection* connection, bool& progress)
+	{
+		// no more requests are read while a response is being streamed or once the connection is going to be closed
+		if (!connection->keepAlive || connection->streamedResponse != NULL)
+		{
+			return true;
+		}
+		int maxCount = HTTP_SERVER_THREAD_BUFFER_SIZE;
+		connection->raw.seek(0, hseek::End);
+		int64_t size = connection->raw.size();
+		if (!connection->platformSocket->receive(&connection->raw, maxCount))
+		{
+			return false;
+		}
+		if (connection->raw.size() == size)
+		{
+			// a socket that is readable without any data means that the client closed the connection
+			return !this->readySockets.has(connection->platformSocket);
+		}
+		connection->lastActivityTime = (int64_t)htickCount();
+		progress = true;
+		this->_processRequests(connection);
+		return true;
+	}
+
+	void HttpServerThread::_processRequests(Connection* connection)
+	{
+		int size = (int)connection->raw.size();
+		int result = 0;
+		while (connection->keepAlive && connection->streamedResponse == NULL && connection->consumed < size)
+		{
+			result = connection->request._parse(&connection->raw[connection->consumed], size - connection->consumed,
+				this->server->maxHeaderSize, this->server->maxBodySize);
+			if (result == 0)
+			{
+				break;
+			}
+			if (result < 0)
+			{
+				this->_queueError(connection, connection->request.error);
+				connection->keepAlive = false;
+				break;
+			}
+			connection->consumed += result;
+			this->_handleRequest(connection);
+			connection->request.clear();
+		}
+		// the incomplete request that follows is moved to the front, the parser expects the data to start with the request
+		if (connection->consumed > 0)
+		{
+			int remaining = size - connection->consumed;
+			if (remaining > 0)
+			{
+				hstream rest;
+				rest.writeRaw(&connection->raw[connection->consumed], remaining);
+				connection->raw.clear();
+				connection->raw.writeRaw(&rest[0], remaining);
+			}
+			else
+			{
+				connection->raw.clear();
+			}
+			connection->consumed = 0;
+		}
+	}
+
+	void HttpServerThread::_handleRequest(Connection* connection)
+	{
+		HttpServerRequest* request = &connection->request;
+		request->remoteHost = connection->socket->getRemoteHost();
+		request->remotePort = connection->socket->getRemotePort();
+		HttpServerResponse* response = new HttpServerResponse();
+		bool pathFound = false;
+		HttpServerHandler* handler = this->server->_findHandler(request->method, request->path, pathFound);
+		if (handler != NULL)
+		{
+			handler->onRequest(this->server, request, response);
+		}
+		else
+		{
+			response->statusCode = (pathFound ? HttpResponse::Code::MethodNotAllowed : HttpResponse::Code::NotFound);
+		}
+		this->server->_updateStats(0, 1);
+		connection->keepAlive = request->isKeepAlive();
+		bool http10 = (request->protocol == PROTOCOL_HTTP_1_0);
+		int64_t bodySize = response->body.size();
+		if (response->bodyStream != NULL)
+		{
+			bodySize = response->bodyStream->getSize();
+			// HTTP/1.0 has no chunked transfer encoding so the body has to be read completely to get its size
+			if (bodySize < 0 && http10)
+			{
+				int count = 0;
+				response->body.clear();
+				while ((count = response->bodyStream->read(this->buffer, HTTP_SOCKET_THREAD_UPLOAD_PIECE_SIZE)) > 0)
+				{
+					response->body.writeRaw(this->buffer, count);
+				}
+				response->setBodyStream(NULL);
+				bodySize = response->body.size();
+			}
+		}
+		else if (response->chunked && !http10)
+		{
+			bodySize = -1LL;
+		}
+		hstr header = response->_makeHeader(PROTOCOL_HTTP_1_1, connection->keepAlive, bodySize);
+		this->_queueOutput(connection, header.cStr(), header.size());
+		// responses to HEAD and these codes never have a body
+		if (request->method == REQUEST_HEAD || response->statusCode == HttpResponse::Code::NoContent ||
+			response->statusCode == HttpResponse::Code::NotModified || response->statusCode.value < 200)
+		{
+			delete response;
+			return;
+		}
+		if (response->bodyStream != NULL)
+		{
+			connection->streamedResponse = response;
+			connection->streamSize = bodySize;
+			connection->streamSent = 0LL;
+			return;
+		}
+		int size = (int)response->body.size();
+		if (bodySize < 0LL)
+		{
+			hstr chunkHeader = hsprintf("%x\r\n", size);
+			if (size > 0)
+			{
+				this->_queueOutput(connection, chunkHeader.cStr(), chunkHeader.size());
+				this->_queueOutput(connection, &response->body[0], size);
+				this->_queueOutput(connection, "\r\n", 2);
+			}
+			this->_queueOutput(connection, "0\r\n\r\n", 5);
+		}
+		else if (size > 0)
+		{
+			this->_queueOutput(connection, &response->body[0], size);
+		}
+		delete response;
+	}
+
+	void HttpServerThread::_queueError(Connection* connection, HttpResponse::Code code)
+	{
+		HttpServerResponse response;
+		response.statusCode = code;
+		hstr header = response._makeHeader(PROTOCOL_HTTP_1_1, false, 0LL);
+		this->_queueOutput(connection, header.cStr(), header.size());
+	}
+
+	void HttpServerThread::_queueOutput(Connection* connection, const void* data, int size)
+	{
+		int64_t position = connection->output.position();
+		connection->output.seek(0, hseek::End);
+		connection->output.writeRaw(data, size);
+		connection->output.seek(position, hseek::Start);
+	}
+
+	void HttpServerThread::_waitForData()
+	{
+		harray<PlatformSocket*> sockets;
+		harray<PlatformSocket*> sendingSockets;
+		foreach (Connection*, it, this->connections)
+		{
+			sockets += (*it)->platformSocket;
+			if ((*it)->output.size() > 0)
+			{
+				sendingSockets += (*it)->platformSocket;
+			}
+		}
+		// waiting on the sockets directly wakes the thread up as soon as a request arrives or pending output can be sent
+		if (sockets.size() == 0 || !PlatformSocket::waitForReceive(sockets, this->server->retryFrequency, this->readySockets, sendingSockets))
+		{
+			hthread::sleep(this->server->retryFrequency * 1000.0f);
+		}
+	}
+
+	void HttpServerThread::_updateProcess()
+	{
+		TcpSocket* socket = NULL;
+		Connection* connection = NULL;
+		bool progress = false;
+		int i = 0;
+		while (this->isRunning())
+		{
+			progress = false;
+			socket = this->server->_takeAcceptedSocket(this);
+			if (socket != NULL)
+			{
+				this->connections += new Connection(socket);
+				this->server->_updateStats(1, 0);
+				progress = true;
+			}
+			i = 0;
+			while (i < this->connections.size())
+			{
+				connection = this->connections[i];
+				if (this->_updateConnection(connection, progress))
+				{
+					++i;
+					continue;
+				}
+				this->connections.removeAt(i);
+				delete connection;
+				this->server->_updateStats(-1, 0);
+				progress = true;
+			}
+			this->readySockets.clear();
+			// as long as data is flowing, there's no waiting
+			if (!progress)
+			{
+				this->_waitForData();
+			}
+		}
+	}
+
+	void HttpServerThread::process(hthread* thread)
+	{
+		((HttpServerThread*)thread)->_updateProcess();
+	}
+
+}
@@ -0,0 +1,91 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a thread that handles many HTTP server connections.
+
+#ifndef SAKIT_HTTP_SERVER_THREAD_H
+#define SAKIT_HTTP_SERVER_THREAD_H
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hthread.h>
+
+#include "HttpResponse.h"
+#include "HttpServerRequest.h"
+
+#define HTTP_SERVER_THREAD_BUFFER_SIZE 16384
+
+namespace sakit
+{
+	class HttpServer;
+	class HttpServerResponse;
+	class PlatformSocket;
+	class TcpSocket;
+
+	class HttpServerThread : public hthread
+	{
+	public:
+		friend class HttpServer;
+
+		HttpServerThread(HttpServer* server);
+		~HttpServerThread();
+
+	protected:
+		class Connection
+		{
+		public:
+			TcpSocket* socket;
+			PlatformSocket* platformSocket;
+			/// @brief Received data, pipelined requests can follow the current one.
+			hstream raw;
+			/// @brief Offset in raw where the current request starts.
+			int consumed;
+			HttpServerRequest request;
+			/// @brief Responses that still have to be sent, the position is where sending continues.
+			hstream output;
+			/// @brief Response whose body stream is being sent, no further requests are processed meanwhile to keep the order.
+			HttpServerResponse* streamedResponse;
+			int64_t streamSize;
+			int64_t streamSent;
+			/// @brief False once the connection is closed after the pending responses were sent.
+			bool keepAlive;
+			int64_t lastActivityTime;
+
+			Connection(TcpSocket* socket);
+			~Connection();
+
+		};
+
+		HttpServer* server;
+		harray<Connection*> connections;
+		/// @brief Sockets that had data or were closed by the peer after the last wait.
+		harray<PlatformSocket*> readySockets;
+		/// @brief Reused for streamed response bodies.
+		unsigned char* buffer;
+		hstream piece;
+
+		/// @return False if the connection has to be closed.
+		bool _updateConnection(Connection* connection, bool& progress);
+		bool _updateSend(Connection* connection, bool& progress);
+		bool _updateReceive(Connection* connection, bool& progress);
+		void _processRequests(Connection* connection);
+		void _handleRequest(Connection* connection);
+		void _queueError(Connection* connection, HttpResponse::Code code);
+		void _queueOutput(Connection* connection, const void* data, int size);
+		void _waitForData();
+		void _updateProcess();
+
+		static void process(hthread* thread);
+
+	};
+
+}
+#endif
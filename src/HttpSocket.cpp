@@ -10,6 +10,8 @@
 #include <hltypes/hmap.h>
 #include <hltypes/hstring.h>
 
+#include "HttpCache.h"
+#include "HttpRequestBody.h"
 #include "HttpResponse.h"
 #include "HttpSocket.h"
 #include "HttpSocketDelegate.h"
@@ -20,6 +22,7 @@
 #include "State.h"
 
 #define HTTP_DELIMITER "\r\n"
+#define COMPRESSED_ENCODINGS "gzip, deflate"
 #define REQUEST_OPTIONS "OPTIONS"
 #define REQUEST_GET "GET"
 #define REQUEST_HEAD "HEAD"
@@ -62,7 +65,10 @@ namespace sakit
 	HttpSocket::HttpSocket(HttpSocketDelegate* socketDelegate, Protocol protocol) :
 		SocketBase(),
 		keepAlive(false),
-		reportProgress(false)
+		reportProgress(false),
+		compressionEnabled(false),
+		cache(NULL),
+		uploadReported(0LL)
 	{
 		this->socketDelegate = socketDelegate;
 		this->protocol = protocol;
@@ -81,19 +87,37 @@ namespace sakit
 
 	bool HttpSocket::isConnected()
 	{
-		hmutex::ScopeLock lock(&this->mutexState);
-		return (this->state == State::Running || this->state == State::Connected);
+		return ((this->state.getMask() & (State::MaskRunning | State::MaskConnected)) != 0);
+	}
+
+	bool HttpSocket::setCompressionEnabled(bool value)
+	{
+#ifndef _SAKIT_ZLIB
+		if (value)
+		{
+			hlog::warn(logTag, "Cannot enable compression, sakit was built without zlib support!");
+			return false;
+		}
+#endif
+		this->compressionEnabled = value;
+		return true;
 	}
 
 	bool HttpSocket::isExecuting()
 	{
-		hmutex::ScopeLock lock(&this->mutexState);
 		return (this->state == State::Running);
 	}
 
 	void HttpSocket::update(float timeDelta)
 	{
+		this->_updateUploadProgress();
 		hmutex::ScopeLock lock(&this->mutexState);
+		if (this->thread->pipelined)
+		{
+			lock.release();
+			this->_updatePipeline();
+			return;
+		}
 		hmutex::ScopeLock lockThreadResult(&this->thread->resultMutex);
 		hmutex::ScopeLock lockThreadResponse;
 		State result = this->thread->result;
@@ -122,6 +146,10 @@ namespace sakit
 		response = this->thread->response->clone();
 		this->thread->response->clear();
 		lockThreadResponse.release();
+		hstr cacheMethod = this->cacheMethod;
+		hmap<hstr, hstr> cacheHeaders = this->cacheHeaders;
+		this->cacheMethod = "";
+		this->cacheHeaders.clear();
 		Url url = this->url; // _terminateConnection() deletes this, but it's needed for the delegate call ahead
 		if (!this->keepAlive || response->headers.tryGet(SAKIT_HTTP_REQUEST_HEADER_CONNECTION, "") == "close" || !this->socket->isConnected())
 		{
@@ -144,6 +172,10 @@ namespace sakit
 		response->body.rewind();
 		if (result == State::Finished)
 		{
+			if (cacheMethod != "" && this->cache != NULL)
+			{
+				this->cache->_update(cacheMethod, url, cacheHeaders, response);
+			}
 			this->socketDelegate->onExecuteCompleted(this, response, url);
 		}
 		else if (result == State::Failed)
@@ -189,7 +221,7 @@ namespace sakit
 	CONNECTED_EXECUTE_ASYNC(Trace, TRACE);
 	CONNECTED_EXECUTE_ASYNC(Connect, CONNECT);
 
-	bool HttpSocket::_executeMethodInternal(HttpResponse* response, chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders)
+	bool HttpSocket::_executeMethodInternal(HttpResponse* response, chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders, HttpRequestBody* body)
 	{
 		if (response == NULL)
 		{
@@ -206,11 +238,19 @@ namespace sakit
 		{
 			return false;
 		}
+		bool cached = (this->cache != NULL && body == NULL);
+		hmap<hstr, hstr> requestHeaders = customHeaders;
+		if (cached && this->cache->_prepare(method, url, requestHeaders, response))
+		{
+			return true;
+		}
 		this->state = State::Running;
 		lock.release();
-		hstr request = this->_processRequest(method, url, customBody, customHeaders);
+		int64_t bodySize = (body != NULL ? body->getSize() : -1LL);
+		hstr request = (body == NULL ? this->_processRequest(method, url, customBody, requestHeaders) : this->_processUploadRequest(method, url, bodySize, requestHeaders));
 		unsigned short port = (this->url.getPort() == 0 ? this->remotePort : this->url.getPort());
-		bool result = this->socket->connect(this->remoteHost, port, this->localHost, this->localPort, this->timeout, this->retryFrequency);
+		// persistent connections are reused
+		bool result = (this->socket->isConnected() || this->socket->connect(this->remoteHost, port, this->localHost, this->localPort, this->timeout, this->retryFrequency));
 		if (!result)
 		{
 			this->_terminateConnection();
@@ -218,7 +258,7 @@ namespace sakit
 			this->state = State::Idle;
 			return false;
 		}
-		if (SocketBase::_send(request) == 0)
+		if (SocketBase::_send(request) == 0 || (body != NULL && !this->_sendBodyDirect(body, bodySize)))
 		{
 			this->_terminateConnection();
 			lock.acquire(&this->mutexState);
@@ -226,6 +266,7 @@ namespace sakit
 			return false;
 		}
 		response->clear();
+		response->contentDecoding = this->compressionEnabled;
 		if (this->_receiveHttpDirect(response) == 0)
 		{
 			this->_terminateConnection();
@@ -246,12 +287,18 @@ namespace sakit
 			lock.acquire(&this->mutexState);
 			this->state = State::Connected;
 		}
-		return (response->headersComplete && response->bodyComplete);
+		lock.release();
+		bool complete = (response->headersComplete && response->bodyComplete);
+		if (complete && cached)
+		{
+			this->cache->_update(method, url, customHeaders, response);
+		}
+		return complete;
 	}
 
 	bool HttpSocket::_executeMethod(HttpResponse* response, chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders)
 	{
-		if (this->isConnected())
+		if (this->isConnected() && !this->_isConnectedTo(url))
 		{
 			hlog::warn(logTag, "Already existing connection will be closed!");
 			this->_terminateConnection();
@@ -269,7 +316,7 @@ namespace sakit
 		return this->_executeMethodInternal(response, method, this->url, customBody, customHeaders);
 	}
 
-	bool HttpSocket::_executeMethodInternalAsync(chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders)
+	bool HttpSocket::_executeMethodInternalAsync(chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders, HttpRequestBody* body)
 	{
 		if (!url.isValid())
 		{
@@ -282,8 +329,33 @@ namespace sakit
 		{
 			return false;
 		}
-		hstr request = this->_processRequest(method, url, customBody, customHeaders);
+		hmap<hstr, hstr> requestHeaders = customHeaders;
+		this->cacheMethod = "";
+		this->cacheHeaders.clear();
+		if (this->cache != NULL && body == NULL)
+		{
+			hmutex::ScopeLock lockThreadResponse(&this->thread->responseMutex);
+			if (this->cache->_prepare(method, url, requestHeaders, this->thread->response))
+			{
+				// update() reports the cached response like a received one
+				this->url = url;
+				this->thread->result = State::Finished;
+				this->state = State::Running;
+				return true;
+			}
+			this->cacheMethod = method;
+			this->cacheHeaders = customHeaders;
+		}
+		int64_t bodySize = (body != NULL ? body->getSize() : -1LL);
+		hstr request = (body == NULL ? this->_processRequest(method, url, customBody, requestHeaders) : this->_processUploadRequest(method, url, bodySize, requestHeaders));
+		hmutex::ScopeLock lockThreadResponse(&this->thread->responseMutex);
 		this->thread->response->clear();
+		this->thread->response->contentDecoding = this->compressionEnabled;
+		this->thread->uploadBody = body;
+		this->thread->uploadSize = bodySize;
+		this->thread->uploadSent = 0LL;
+		this->uploadReported = 0LL;
+		lockThreadResponse.release();
 		this->thread->stream->clear();
 		this->thread->stream->writeRaw((void*)request.cStr(), request.size());
 		this->thread->stream->rewind();
@@ -296,7 +368,7 @@ namespace sakit
 
 	bool HttpSocket::_executeMethodAsync(chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders)
 	{
-		if (this->isConnected())
+		if (this->isConnected() && !this->_isConnectedTo(url))
 		{
 			hlog::warn(logTag, "Already existing connection will be closed!");
 			this->_terminateConnection();
@@ -314,6 +386,145 @@ namespace sakit
 		return this->_executeMethodInternalAsync(method, this->url, customBody, customHeaders);
 	}
 
+	bool HttpSocket::executeUpload(HttpResponse* response, chstr method, Url url, HttpRequestBody* body, hmap<hstr, hstr> customHeaders)
+	{
+		if (body == NULL)
+		{
+			hlog::warn(logTag, "Cannot execute, body is NULL!");
+			return false;
+		}
+		if (this->isConnected() && !this->_isConnectedTo(url))
+		{
+			hlog::warn(logTag, "Already existing connection will be closed!");
+			this->_terminateConnection();
+		}
+		return this->_executeMethodInternal(response, method, url, "", customHeaders, body);
+	}
+
+	bool HttpSocket::executeUploadAsync(chstr method, Url url, HttpRequestBody* body, hmap<hstr, hstr> customHeaders)
+	{
+		if (body == NULL)
+		{
+			hlog::warn(logTag, "Cannot execute, body is NULL!");
+			return false;
+		}
+		if (this->isConnected() && !this->_isConnectedTo(url))
+		{
+			hlog::warn(logTag, "Already existing connection will be closed!");
+			this->_terminateConnection();
+		}
+		return this->_executeMethodInternalAsync(method, url, "", customHeaders, body);
+	}
+
+	bool HttpSocket::executePipelinedAsync(chstr method, harray<Url> urls, hmap<hstr, hstr> customHeaders)
+	{
+		if (urls.size() == 0)
+		{
+			hlog::warn(logTag, "Cannot execute, no URLs given!");
+			return false;
+		}
+		if (!this->keepAlive)
+		{
+			hlog::warn(logTag, "Cannot execute, pipelining requires keep-alive!");
+			return false;
+		}
+		// the response to HEAD has no body, but can have a Content-Length so the end of the response can't be detected
+		if (method == REQUEST_HEAD || method == REQUEST_CONNECT)
+		{
+			hlog::warn(logTag, "Cannot execute, pipelining is not supported for: " + method);
+			return false;
+		}
+		Url first = urls.first();
+		foreach (Url, it, urls)
+		{
+			if (!(*it).isValid())
+			{
+				hlog::warn(logTag, "Cannot execute, URL is not valid!");
+				return false;
+			}
+			if ((*it).getHost() != first.getHost() || (*it).getPort() != first.getPort())
+			{
+				hlog::warn(logTag, "Cannot execute, pipelined URLs have to use the same host and port!");
+				return false;
+			}
+		}
+		if (this->isConnected() && !this->_isConnectedTo(first))
+		{
+			hlog::warn(logTag, "Already existing connection will be closed!");
+			this->_terminateConnection();
+		}
+		hmutex::ScopeLock lock(&this->mutexState);
+		hmutex::ScopeLock lockThreadResult(&this->thread->resultMutex);
+		if (!this->_canExecute(this->state))
+		{
+			return false;
+		}
+		harray<hstr> requests;
+		foreach (Url, it, urls)
+		{
+			requests += this->_processRequest(method, (*it), "", customHeaders);
+		}
+		this->thread->response->clear();
+		this->thread->response->contentDecoding = this->compressionEnabled;
+		this->thread->pipelineRequests = requests;
+		this->thread->pipelineUrls = urls;
+		this->thread->pipelineIdempotent = HttpSocket::_isIdempotent(method);
+		this->thread->pipelined = true;
+		this->thread->host = this->remoteHost;
+		this->thread->port = (this->url.getPort() == 0 ? this->remotePort : this->url.getPort());
+		this->state = State::Running;
+		this->thread->start();
+		return true;
+	}
+
+	void HttpSocket::_updatePipeline()
+	{
+		hmutex::ScopeLock lock(&this->mutexState);
+		hmutex::ScopeLock lockThreadResult(&this->thread->resultMutex);
+		hmutex::ScopeLock lockThreadResponse(&this->thread->responseMutex);
+		State result = this->thread->result;
+		harray<HttpResponse*> responses = this->thread->completedResponses;
+		harray<Url> urls = this->thread->completedUrls;
+		this->thread->completedResponses.clear();
+		this->thread->completedUrls.clear();
+		harray<Url> failedUrls;
+		bool finished = (result != State::Running && result != State::Idle);
+		if (finished)
+		{
+			failedUrls = this->thread->pipelineUrls;
+			this->thread->pipelineUrls.clear();
+			this->thread->pipelineRequests.clear();
+			this->thread->pipelined = false;
+			this->thread->response->clear();
+			this->thread->result = State::Idle;
+			bool closed = (responses.size() > 0 && responses.last()->headers.tryGet(SAKIT_HTTP_REQUEST_HEADER_CONNECTION, "") == "close");
+			if (result == State::Failed || closed || !this->socket->isConnected())
+			{
+				this->_terminateConnection();
+				this->state = State::Idle;
+			}
+			else
+			{
+				this->state = State::Connected;
+			}
+		}
+		lockThreadResponse.release();
+		lockThreadResult.release();
+		lock.release();
+		for_iter (i, 0, responses.size())
+		{
+			responses[i]->raw.rewind();
+			responses[i]->body.rewind();
+			this->socketDelegate->onExecuteCompleted(this, responses[i], urls[i]);
+			delete responses[i];
+		}
+		foreach (Url, it, failedUrls)
+		{
+			HttpResponse response;
+			this->socketDelegate->onExecuteFailed(this, &response, (*it));
+		}
+	}
+
 	int HttpSocket::_receiveHttpDirect(HttpResponse* response)
 	{
 		int maxCount = 0;
@@ -336,7 +547,7 @@ namespace sakit
 				response->raw.seek(position, hseek::Start);
 				response->parseFromRaw();
 			}
-			if (!hasMoreData || (response->headersComplete && response->bodyComplete))
+			if (!hasMoreData || (response->headersComplete && response->bodyComplete) || response->invalid)
 			{
 				break;
 			}
@@ -357,7 +568,7 @@ namespace sakit
 			hthread::sleep(this->retryFrequency * 1000.0f);
 		}
 		// if timed out, has no predefined length, all headers were received and there is a body
-		if (time >= this->timeout && response->headersComplete)
+		if (time >= this->timeout && response->headersComplete && !response->invalid)
 		{
 			if (!response->headers.hasKey(SAKIT_HTTP_REQUEST_HEADER_CONTENT_LENGTH) && response->body.size() > 0)
 			{
@@ -373,6 +584,49 @@ namespace sakit
 		return (int)response->raw.size();
 	}
 
+	bool HttpSocket::_sendBodyDirect(HttpRequestBody* body, int64_t size)
+	{
+		unsigned char* buffer = new unsigned char[HTTP_SOCKET_THREAD_UPLOAD_PIECE_SIZE];
+		hstream stream;
+		int64_t sent = 0LL;
+		int count = 0;
+		bool result = true;
+		while (true)
+		{
+			count = HttpSocketThread::_readUploadPiece(body, size, sent, buffer, &stream);
+			if (count < 0 || (stream.size() > 0 && this->_sendDirect(&stream, (int)stream.size()) < (int)stream.size()))
+			{
+				result = false;
+				break;
+			}
+			if (count == 0)
+			{
+				break;
+			}
+			sent += count;
+			this->socketDelegate->onUploadProgress(this, sent, size);
+			if (size >= 0 && sent >= size)
+			{
+				break;
+			}
+		}
+		delete[] buffer;
+		return result;
+	}
+
+	void HttpSocket::_updateUploadProgress()
+	{
+		hmutex::ScopeLock lock(&this->thread->responseMutex);
+		if (this->thread->uploadSent == this->uploadReported)
+		{
+			return;
+		}
+		this->uploadReported = this->thread->uploadSent;
+		int64_t size = this->thread->uploadSize;
+		lock.release();
+		this->socketDelegate->onUploadProgress(this, this->uploadReported, size);
+	}
+
 	int HttpSocket::_send(hstream* stream, int count)
 	{
 		return this->_sendDirect(stream, count);
@@ -387,7 +641,8 @@ namespace sakit
 	bool HttpSocket::abort()
 	{
 		hmutex::ScopeLock lock(&this->mutexState);
-		if (!this->_canAbort(this->state))
+		State state = this->state;
+		if (!this->_canAbort(state))
 		{
 			return false;
 		}
@@ -417,6 +672,26 @@ namespace sakit
 		this->url = Url();
 	}
 
+	void HttpSocket::_closeConnection()
+	{
+		hmutex::ScopeLock lock(&this->mutexState);
+		if (this->state == State::Connected)
+		{
+			this->_terminateConnection();
+			this->state = State::Idle;
+		}
+	}
+
+	bool HttpSocket::_isConnectedTo(Url& url)
+	{
+		if (!this->keepAlive || !this->url.isValid() || this->url.getHost() != url.getHost())
+		{
+			return false;
+		}
+		unsigned short port = (this->url.getPort() == 0 ? this->remotePort : this->url.getPort());
+		return ((url.getPort() == 0 ? this->remotePort : url.getPort()) == port);
+	}
+
 	bool HttpSocket::_canExecute(State state)
 	{
 		return _checkState(state, State::allowedHttpExecuteStates, "execute");
@@ -431,8 +706,28 @@ namespace sakit
 	{
 		this->url = url;
 		this->remoteHost = Host(this->url.getHost());
-		customHeaders[SAKIT_HTTP_REQUEST_HEADER_HOST] = this->remoteHost.toString();
-		customHeaders[SAKIT_HTTP_REQUEST_HEADER_CONNECTION] = (this->keepAlive ? "keep-alive" : "close");
+		if (this->compressionEnabled && !customHeaders.hasKey(SAKIT_HTTP_REQUEST_HEADER_ACCEPT_ENCODING))
+		{
+			customHeaders[SAKIT_HTTP_REQUEST_HEADER_ACCEPT_ENCODING] = COMPRESSED_ENCODINGS;
+		}
+		return HttpSocket::_makeRequest(method, this->url, customBody, customHeaders, this->keepAlive, this->_makeProtocol());
+	}
+
+	hstr HttpSocket::_processUploadRequest(chstr method, Url url, int64_t bodySize, hmap<hstr, hstr> customHeaders)
+	{
+		this->url = url;
+		this->remoteHost = Host(this->url.getHost());
+		if (this->compressionEnabled && !customHeaders.hasKey(SAKIT_HTTP_REQUEST_HEADER_ACCEPT_ENCODING))
+		{
+			customHeaders[SAKIT_HTTP_REQUEST_HEADER_ACCEPT_ENCODING] = COMPRESSED_ENCODINGS;
+		}
+		return HttpSocket::_makeUploadRequest(method, this->url, bodySize, customHeaders, this->keepAlive, this->_makeProtocol());
+	}
+
+	void HttpSocket::_applyDefaultHeaders(Url& url, hmap<hstr, hstr>& customHeaders, bool keepAlive)
+	{
+		customHeaders[SAKIT_HTTP_REQUEST_HEADER_HOST] = Host(url.getHost()).toString();
+		customHeaders[SAKIT_HTTP_REQUEST_HEADER_CONNECTION] = (keepAlive ? "keep-alive" : "close");
 		if (!customHeaders.hasKey(SAKIT_HTTP_REQUEST_HEADER_ACCEPT_ENCODING))
 		{
 			customHeaders[SAKIT_HTTP_REQUEST_HEADER_ACCEPT_ENCODING] = "identity";
@@ -445,15 +740,27 @@ namespace sakit
 		{
 			customHeaders[SAKIT_HTTP_REQUEST_HEADER_ACCEPT] = "*/*";
 		}
+	}
+
+	bool HttpSocket::_isIdempotent(chstr method)
+	{
+		// unknown methods like PATCH and CONNECT are never repeated
+		return (method == REQUEST_GET || method == REQUEST_HEAD || method == REQUEST_OPTIONS || method == REQUEST_PUT ||
+			method == REQUEST_DELETE || method == REQUEST_TRACE);
+	}
+
+	hstr HttpSocket::_makeRequest(chstr method, Url& url, chstr customBody, hmap<hstr, hstr> customHeaders, bool keepAlive, chstr protocol)
+	{
+		HttpSocket::_applyDefaultHeaders(url, customHeaders, keepAlive);
 		bool urlEncoded = (customBody == "" && (method == REQUEST_GET || method == REQUEST_HEAD || method == REQUEST_OPTIONS));
 		hstr absolutePath;
 		hstr body = customBody;
 		if (!urlEncoded)
 		{
-			absolutePath = this->url.getRelativePath();
+			absolutePath = url.getRelativePath();
 			if (customBody == "")
 			{
-				body = this->url.getBody();
+				body = url.getBody();
 			}
 			if (body != "")
 			{
@@ -462,10 +769,10 @@ namespace sakit
 		}
 		else
 		{
-			absolutePath = this->url.toString(false, true);
+			absolutePath = url.toString(false, true);
 		}
 		hstr request;
-		request += method + " " + absolutePath + " " + this->_makeProtocol() + HTTP_DELIMITER;
+		request += method + " " + absolutePath + " " + protocol + HTTP_DELIMITER;
 		foreach_m (hstr, it, customHeaders)
 		{
 			request += it->first + ": " + it->second + HTTP_DELIMITER;
@@ -479,6 +786,34 @@ namespace sakit
 		return request;
 	}
 
+	hstr HttpSocket::_makeUploadRequest(chstr method, Url& url, int64_t bodySize, hmap<hstr, hstr> customHeaders, bool keepAlive, chstr protocol)
+	{
+		if (!customHeaders.hasKey(SAKIT_HTTP_REQUEST_HEADER_CONTENT_TYPE))
+		{
+			customHeaders[SAKIT_HTTP_REQUEST_HEADER_CONTENT_TYPE] = "application/octet-stream";
+		}
+		HttpSocket::_applyDefaultHeaders(url, customHeaders, keepAlive);
+		if (bodySize >= 0)
+		{
+			customHeaders[SAKIT_HTTP_REQUEST_HEADER_CONTENT_LENGTH] = hstr(bodySize);
+		}
+		else
+		{
+			customHeaders.removeKey(SAKIT_HTTP_REQUEST_HEADER_CONTENT_LENGTH);
+			customHeaders[SAKIT_HTTP_RESPONSE_HEADER_TRANSFER_ENCODING] = "chunked";
+		}
+		// the query stays in the path since the body is the uploaded data
+		hstr request;
+		request += method + " " + url.toString(false, true) + " " + protocol + HTTP_DELIMITER;
+		foreach_m (hstr, it, customHeaders)
+		{
+			request += it->first + ": " + it->second + HTTP_DELIMITER;
+		}
+		request += HTTP_DELIMITER;
+		hlog::debug(logTag, "Processed upload request generated:\n" + request);
+		return request;
+	}
+
 	hstr HttpSocket::_makeProtocol()
 	{
 		/*
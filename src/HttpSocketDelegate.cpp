@@ -30,4 +30,8 @@ namespace sakit
 	{
 	}
 
+	void HttpSocketDelegate::onUploadProgress(HttpSocket* socket, int64_t sent, int64_t size)
+	{
+	}
+
 }
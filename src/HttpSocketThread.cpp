@@ -12,6 +12,7 @@
 #include <hltypes/hstream.h>
 #include <hltypes/hthread.h>
 
+#include "HttpRequestBody.h"
 #include "HttpResponse.h"
 #include "HttpSocket.h"
 #include "HttpSocketThread.h"
@@ -23,7 +24,12 @@
 namespace sakit
 {
 	HttpSocketThread::HttpSocketThread(PlatformSocket* socket, float* timeout, float* retryFrequency) :
-		TimedThread(socket, timeout, retryFrequency)
+		TimedThread(socket, timeout, retryFrequency),
+		uploadBody(NULL),
+		uploadSize(-1LL),
+		uploadSent(0LL),
+		pipelined(false),
+		pipelineIdempotent(false)
 	{
 		this->name = "SAKit HTTP Socket";
 		this->stream = new hstream();
@@ -34,6 +40,10 @@ namespace sakit
 	{
 		delete this->stream;
 		delete this->response;
+		foreach (HttpResponse*, it, this->completedResponses)
+		{
+			delete (*it);
+		}
 	}
 
 	void HttpSocketThread::_updateConnect()
@@ -50,27 +60,74 @@ namespace sakit
 	}
 
 	void HttpSocketThread::_updateSend()
+	{
+		bool result = this->_sendStream(this->stream);
+		this->stream->clear();
+		if (result && this->uploadBody != NULL)
+		{
+			result = this->_sendUploadBody();
+		}
+		if (!result)
+		{
+			hmutex::ScopeLock lock(&this->resultMutex);
+			this->result = State::Failed;
+			lock.release();
+			this->executing = false;
+			this->socket->disconnect();
+		}
+	}
+
+	bool HttpSocketThread::_sendStream(hstream* stream)
 	{
 		int sentCount = 0;
-		int count = (int)this->stream->size();
+		int count = (int)stream->size();
 		while (this->isRunning() && this->executing)
 		{
-			if (!this->socket->send(this->stream, count, sentCount))
+			if (!this->socket->send(stream, count, sentCount))
 			{
-				hmutex::ScopeLock lock(&this->resultMutex);
-				this->result = State::Failed;
-				lock.release();
-				this->executing = false;
-				this->socket->disconnect();
-				break;
+				return false;
 			}
-			if (this->stream->eof())
+			if (stream->eof())
 			{
 				break;
 			}
 			hthread::sleep(*this->retryFrequency * 1000.0f);
 		}
-		this->stream->clear();
+		return true;
+	}
+
+	bool HttpSocketThread::_sendUploadBody()
+	{
+		// only one piece is kept in memory at a time
+		unsigned char* buffer = new unsigned char[HTTP_SOCKET_THREAD_UPLOAD_PIECE_SIZE];
+		hstream piece;
+		hmutex::ScopeLock lock;
+		int64_t sent = 0LL;
+		int count = 0;
+		bool result = true;
+		while (this->isRunning() && this->executing)
+		{
+			count = HttpSocketThread::_readUploadPiece(this->uploadBody, this->uploadSize, sent, buffer, &piece);
+			if (count < 0 || !this->_sendStream(&piece))
+			{
+				result = false;
+				break;
+			}
+			if (count == 0)
+			{
+				break;
+			}
+			sent += count;
+			lock.acquire(&this->responseMutex);
+			this->uploadSent = sent;
+			lock.release();
+			if (this->uploadSize >= 0 && sent >= this->uploadSize)
+			{
+				break;
+			}
+		}
+		delete[] buffer;
+		return result;
 	}
 
 	void HttpSocketThread::_updateReceive()
@@ -109,7 +166,7 @@ namespace sakit
 			this->response->raw.seek(position, hseek::Start);
 			this->response->parseFromRaw();
 			size = this->response->raw.size();
-			if (this->response->headersComplete && this->response->bodyComplete)
+			if ((this->response->headersComplete && this->response->bodyComplete) || this->response->invalid)
 			{
 				lock.release();
 				break;
@@ -132,7 +189,7 @@ namespace sakit
 		}
 		lock.acquire(&this->responseMutex);
 		// if timed out, has no predefined length, all headers were received and there is a body
-		if (time >= *this->timeout && !this->response->headers.hasKey(SAKIT_HTTP_REQUEST_HEADER_CONTENT_LENGTH) && this->response->headersComplete && this->response->body.size() > 0)
+		if (time >= *this->timeout && !this->response->headers.hasKey(SAKIT_HTTP_REQUEST_HEADER_CONTENT_LENGTH) && this->response->headersComplete && this->response->body.size() > 0 && !this->response->invalid)
 		{
 			if (!this->response->headers.hasKey(SAKIT_HTTP_REQUEST_HEADER_CONTENT_LENGTH) && this->response->body.size() > 0)
 			{
@@ -145,11 +202,8 @@ namespace sakit
 				this->response->bodyComplete = true;
 			}
 		}
+		// an incomplete response is kept so the data received so far can be used to resume
 		bool completeHeaders = (this->response->headersComplete && this->response->bodyComplete);
-		if (!completeHeaders)
-		{
-			this->response->clear();
-		}
 		lock.release();
 		lock.acquire(&this->resultMutex);
 		// only a response with complete headers and a complete body is considered
@@ -164,8 +218,210 @@ namespace sakit
 		}
 	}
 
+	void HttpSocketThread::_updatePipeline()
+	{
+		Host localHost;
+		unsigned short localPort = 0;
+		bool retry = true;
+		int answered = 0;
+		while (this->isRunning() && this->executing && this->pipelineRequests.size() > 0)
+		{
+			if (!this->socket->isConnected() && !this->socket->connect(this->host, this->port, localHost, localPort, *this->timeout, *this->retryFrequency))
+			{
+				break;
+			}
+			answered = 0;
+			if (this->_sendPipeline())
+			{
+				answered = this->_receivePipeline();
+			}
+			if (this->pipelineRequests.size() == 0)
+			{
+				break;
+			}
+			// head-of-line failure, everything after the last complete response has to be sent again on a new connection
+			this->socket->disconnect();
+			if (!this->pipelineIdempotent)
+			{
+				break;
+			}
+			// only one attempt that doesn't make any progress is allowed
+			if (answered == 0)
+			{
+				if (!retry)
+				{
+					break;
+				}
+				retry = false;
+			}
+			hlog::debugf(logTag, "Pipelined connection failed, sending %d requests again.", this->pipelineRequests.size());
+		}
+		hmutex::ScopeLock lock(&this->resultMutex);
+		if (this->pipelineRequests.size() == 0)
+		{
+			this->result = State::Finished;
+		}
+		else
+		{
+			this->result = State::Failed;
+			this->socket->disconnect();
+		}
+	}
+
+	bool HttpSocketThread::_sendPipeline()
+	{
+		// all remaining requests are written back-to-back
+		this->stream->clear();
+		foreach (hstr, it, this->pipelineRequests)
+		{
+			this->stream->writeRaw((void*)(*it).cStr(), (*it).size());
+		}
+		this->stream->rewind();
+		hmutex::ScopeLock lock(&this->responseMutex);
+		this->response->clear();
+		lock.release();
+		int sentCount = 0;
+		int count = (int)this->stream->size();
+		bool result = true;
+		while (this->isRunning() && this->executing)
+		{
+			if (!this->socket->send(this->stream, count, sentCount))
+			{
+				result = false;
+				break;
+			}
+			if (this->stream->eof())
+			{
+				break;
+			}
+			hthread::sleep(*this->retryFrequency * 1000.0f);
+		}
+		this->stream->clear();
+		return result;
+	}
+
+	int HttpSocketThread::_receivePipeline()
+	{
+		hmutex::ScopeLock lock;
+		int maxCount = 0;
+		hstream stream(maxCount);
+		float time = 0.0f;
+		int64_t position = 0LL;
+		int answered = 0;
+		int newAnswered = 0;
+		bool hasMoreData = true;
+		bool closed = false;
+		bool invalid = false;
+		while (this->isRunning() && this->executing && this->pipelineRequests.size() > 0)
+		{
+			maxCount = HTTP_SOCKET_THREAD_BUFFER_SIZE;
+			hasMoreData = this->socket->receive(&stream, maxCount);
+			if (stream.size() > 0)
+			{
+				stream.rewind();
+				lock.acquire(&this->responseMutex);
+				this->response->raw.seek(0, hseek::End);
+				position = this->response->raw.position();
+				this->response->raw.writeRaw(stream);
+				this->response->raw.seek(position, hseek::Start);
+				this->response->parseFromRaw();
+				newAnswered = this->_takeCompletedResponses();
+				// the server announced that it won't answer any further requests on this connection
+				closed = (newAnswered > 0 && this->completedResponses.last()->headers.tryGet(SAKIT_HTTP_REQUEST_HEADER_CONNECTION, "") == "close");
+				// nothing after unparsable data can be trusted
+				invalid = this->response->invalid;
+				lock.release();
+				stream.clear(maxCount);
+				answered += newAnswered;
+				if (closed || invalid)
+				{
+					break;
+				}
+				// retry attempts are reset after a successful read
+				time = 0.0f;
+				continue;
+			}
+			time += *this->retryFrequency;
+			if (!hasMoreData || time >= *this->timeout)
+			{
+				// without Content-Length and chunked encoding only the end of the connection ends a response, the requests after
+				// it can't be answered on this connection anymore and are sent again on a new one
+				lock.acquire(&this->responseMutex);
+				if (this->response->headersComplete && !this->response->bodyComplete && !this->response->invalid &&
+					!this->response->headers.hasKey(SAKIT_HTTP_RESPONSE_HEADER_CONTENT_LENGTH) &&
+					this->response->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_TRANSFER_ENCODING, "") != "chunked")
+				{
+					this->response->bodyComplete = true;
+					answered += this->_takeCompletedResponses();
+				}
+				lock.release();
+				break;
+			}
+			hthread::sleep(*this->retryFrequency * 1000.0f);
+		}
+		return answered;
+	}
+
+	int HttpSocketThread::_takeCompletedResponses()
+	{
+		int result = 0;
+		HttpResponse* next = NULL;
+		while (this->pipelineRequests.size() > 0 && this->response->headersComplete && this->response->bodyComplete)
+		{
+			next = new HttpResponse();
+			this->response->moveExcessData(next);
+			this->completedResponses += this->response;
+			this->completedUrls += this->pipelineUrls.removeFirst();
+			this->pipelineRequests.removeFirst();
+			this->response = next;
+			this->response->parseFromRaw();
+			++result;
+		}
+		return result;
+	}
+
+	int HttpSocketThread::_readUploadPiece(HttpRequestBody* body, int64_t size, int64_t sent, unsigned char* buffer, hstream* stream)
+	{
+		int maxCount = HTTP_SOCKET_THREAD_UPLOAD_PIECE_SIZE;
+		if (size >= 0)
+		{
+			maxCount = (int)hmin(size - sent, (int64_t)maxCount);
+		}
+		int count = (maxCount > 0 ? body->read(buffer, maxCount) : 0);
+		stream->clear();
+		if (count < 0)
+		{
+			hlog::warn(logTag, "Cannot upload, body could not be read!");
+			return -1;
+		}
+		if (size >= 0 && count == 0 && sent < size)
+		{
+			hlog::warn(logTag, "Cannot upload, body ended before its announced size!");
+			return -1;
+		}
+		if (size < 0) // the last chunk has a size of 0
+		{
+			stream->write(hsprintf("%x\r\n", count));
+		}
+		if (count > 0)
+		{
+			stream->writeRaw(buffer, count);
+		}
+		if (size < 0)
+		{
+			stream->write("\r\n");
+		}
+		stream->rewind();
+		return count;
+	}
+
 	void HttpSocketThread::_updateProcess()
 	{
+		if (this->pipelined)
+		{
+			this->_updatePipeline();
+			return;
+		}
 		this->_updateConnect();
 		if (this->isRunning() && this->executing)
 		{
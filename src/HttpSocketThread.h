@@ -13,23 +13,29 @@
 #ifndef SAKIT_HTTP_SOCKET_THREAD_H
 #define SAKIT_HTTP_SOCKET_THREAD_H
 
+#include <hltypes/harray.h>
 #include <hltypes/hltypesUtil.h>
 #include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
 
 #include "Socket.h"
 #include "TimedThread.h"
+#include "Url.h"
 
 #define HTTP_SOCKET_THREAD_BUFFER_SIZE 4096
+#define HTTP_SOCKET_THREAD_UPLOAD_PIECE_SIZE 65536
 
 namespace sakit
 {
 	class PlatformSocket;
+	class HttpRequestBody;
 	class HttpResponse;
 	class HttpSocket;
 
 	class HttpSocketThread : public TimedThread
 	{
 	public:
+		friend class HttpServerThread;
 		friend class HttpSocket;
 
 		HttpSocketThread(PlatformSocket* socket, float* timeout, float* retryFrequency);
@@ -39,12 +45,36 @@ namespace sakit
 		hstream* stream;
 		HttpResponse* response;
 		hmutex responseMutex;
+		/// @brief Body that is streamed after the request headers, NULL if the body is part of the request already.
+		HttpRequestBody* uploadBody;
+		int64_t uploadSize;
+		/// @note Protected by responseMutex.
+		int64_t uploadSent;
+		bool pipelined;
+		/// @brief Unanswered requests are only sent again on a new connection if they are idempotent.
+		bool pipelineIdempotent;
+		/// @brief Requests without a complete response yet, in the order they were sent.
+		harray<hstr> pipelineRequests;
+		harray<Url> pipelineUrls;
+		/// @brief Complete responses that weren't reported yet.
+		harray<HttpResponse*> completedResponses;
+		harray<Url> completedUrls;
 
 		void _updateConnect();
 		void _updateSend();
+		bool _sendStream(hstream* stream);
+		bool _sendUploadBody();
 		void _updateReceive();
+		void _updatePipeline();
+		bool _sendPipeline();
+		int _receivePipeline();
+		int _takeCompletedResponses();
 		void _updateProcess() override;
 
+		/// @brief Reads the next piece of an upload body into stream, framed as a chunk if the size is unknown.
+		/// @return Number of body bytes in the piece, 0 after the end was reached or -1 on error.
+		static int _readUploadPiece(HttpRequestBody* body, int64_t size, int64_t sent, unsigned char* buffer, hstream* stream);
+
 	};
 
 }
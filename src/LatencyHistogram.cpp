@@ -0,0 +1,158 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstring.h>
+
+#include "LatencyHistogram.h"
+
+#define SUB_BUCKET_BITS 4
+#define SUB_BUCKET_COUNT (1 << SUB_BUCKET_BITS)
+#define MAX_VALUE_BITS 32
+
+namespace sakit
+{
+	const int LatencyHistogram::SubBucketBits = SUB_BUCKET_BITS;
+	const int LatencyHistogram::BucketCount = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+	const int64_t LatencyHistogram::MaxValue = (1LL << MAX_VALUE_BITS) - 1;
+
+	static inline int _highestBit(uint64_t value)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return 63 - __builtin_clzll(value);
+#elif defined(_MSC_VER) && defined(_WIN64)
+		unsigned long index = 0;
+		_BitScanReverse64(&index, value);
+		return (int)index;
+#else
+		int result = 0;
+		while (value >>= 1)
+		{
+			++result;
+		}
+		return result;
+#endif
+	}
+
+	LatencyHistogram::LatencyHistogram() :
+		count(0LL),
+		min(0LL),
+		max(0LL),
+		sum(0LL)
+	{
+		for_iter (i, 0, BucketCount)
+		{
+			this->buckets += (int64_t)0;
+		}
+	}
+
+	LatencyHistogram::~LatencyHistogram()
+	{
+	}
+
+	int LatencyHistogram::getBucketIndex(int64_t value)
+	{
+		value = hclamp(value, (int64_t)0, MaxValue);
+		if (value < SUB_BUCKET_COUNT * 2)
+		{
+			return (int)value;
+		}
+		int shift = _highestBit((uint64_t)value) - SUB_BUCKET_BITS;
+		// the sub-bucket always has the top bit set so it lies in [SUB_BUCKET_COUNT, SUB_BUCKET_COUNT * 2)
+		return (shift * SUB_BUCKET_COUNT + (int)(value >> shift));
+	}
+
+	int64_t LatencyHistogram::getBucketValue(int index)
+	{
+		if (index < SUB_BUCKET_COUNT * 2)
+		{
+			return (int64_t)index;
+		}
+		int shift = index / SUB_BUCKET_COUNT - 1;
+		return ((int64_t)(index % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT) << shift);
+	}
+
+	double LatencyHistogram::getMean() const
+	{
+		return (this->count > 0 ? (double)this->sum / this->count : 0.0);
+	}
+
+	int64_t LatencyHistogram::getPercentile(double percentile) const
+	{
+		if (this->count == 0)
+		{
+			return 0LL;
+		}
+		int64_t target = hmax((int64_t)(this->count * hclamp(percentile, 0.0, 100.0) / 100.0 + 0.5), (int64_t)1);
+		int64_t current = 0LL;
+		for_iter (i, 0, this->buckets.size())
+		{
+			current += this->buckets[i];
+			if (current >= target)
+			{
+				return hclamp(LatencyHistogram::getBucketValue(i), this->min, this->max);
+			}
+		}
+		return this->max;
+	}
+
+	void LatencyHistogram::add(int64_t value, int64_t count)
+	{
+		if (count <= 0)
+		{
+			return;
+		}
+		value = hclamp(value, (int64_t)0, MaxValue);
+		this->buckets[LatencyHistogram::getBucketIndex(value)] += count;
+		this->min = (this->count > 0 ? hmin(this->min, value) : value);
+		this->max = (this->count > 0 ? hmax(this->max, value) : value);
+		this->count += count;
+		this->sum += value * count;
+	}
+
+	void LatencyHistogram::merge(const LatencyHistogram& other)
+	{
+		if (other.count == 0)
+		{
+			return;
+		}
+		for_iter (i, 0, this->buckets.size())
+		{
+			this->buckets[i] += other.buckets[i];
+		}
+		this->min = (this->count > 0 ? hmin(this->min, other.min) : other.min);
+		this->max = (this->count > 0 ? hmax(this->max, other.max) : other.max);
+		this->count += other.count;
+		this->sum += other.sum;
+	}
+
+	void LatencyHistogram::clear()
+	{
+		for_iter (i, 0, this->buckets.size())
+		{
+			this->buckets[i] = 0LL;
+		}
+		this->count = 0LL;
+		this->min = 0LL;
+		this->max = 0LL;
+		this->sum = 0LL;
+	}
+
+	hstr LatencyHistogram::toString() const
+	{
+		return hsprintf("count=%lld min=%lld mean=%.1f p50=%lld p90=%lld p99=%lld p99.9=%lld max=%lld", (long long)this->count, (long long)this->min,
+			this->getMean(), (long long)this->getPercentile(50.0), (long long)this->getPercentile(90.0), (long long)this->getPercentile(99.0),
+			(long long)this->getPercentile(99.9), (long long)this->max);
+	}
+
+}
@@ -0,0 +1,275 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <chrono>
+
+#include <hltypes/hltypesUtil.h>
+
+#include "LatencyHistogram.h"
+#include "Metrics.h"
+#include "MetricsSnapshot.h"
+
+#define GLOBAL_CELL_COUNT 16
+#define RELAXED std::memory_order_relaxed
+
+namespace sakit
+{
+	Metrics Metrics::global(GLOBAL_CELL_COUNT);
+
+	static std::atomic<int> nextThreadSlot(0);
+
+	static inline int _getThreadSlot()
+	{
+		static thread_local int slot = nextThreadSlot.fetch_add(1, RELAXED);
+		return slot;
+	}
+
+	AtomicHistogram::AtomicHistogram() :
+		count(0LL),
+		min(LatencyHistogram::MaxValue),
+		max(0LL),
+		sum(0LL)
+	{
+		this->buckets = new std::atomic<int64_t>[LatencyHistogram::BucketCount];
+		for_iter (i, 0, LatencyHistogram::BucketCount)
+		{
+			this->buckets[i].store(0LL, RELAXED);
+		}
+	}
+
+	AtomicHistogram::~AtomicHistogram()
+	{
+		delete[] this->buckets;
+	}
+
+	void AtomicHistogram::add(int64_t value)
+	{
+		value = hclamp(value, (int64_t)0, LatencyHistogram::MaxValue);
+		this->buckets[LatencyHistogram::getBucketIndex(value)].fetch_add(1LL, RELAXED);
+		this->sum.fetch_add(value, RELAXED);
+		int64_t current = this->min.load(RELAXED);
+		while (value < current && !this->min.compare_exchange_weak(current, value, RELAXED))
+		{
+		}
+		current = this->max.load(RELAXED);
+		while (value > current && !this->max.compare_exchange_weak(current, value, RELAXED))
+		{
+		}
+		this->count.fetch_add(1LL, RELAXED);
+	}
+
+	void AtomicHistogram::read(LatencyHistogram& histogram) const
+	{
+		histogram.clear();
+		int64_t count = 0LL;
+		for_iter (i, 0, LatencyHistogram::BucketCount)
+		{
+			count = this->buckets[i].load(RELAXED);
+			if (count > 0)
+			{
+				histogram.add(LatencyHistogram::getBucketValue(i), count);
+			}
+		}
+		if (histogram.count > 0)
+		{
+			// exact values instead of bucket bounds, writers might be in-flight so keep them consistent with the buckets
+			histogram.min = hmin(hmax(this->min.load(RELAXED), histogram.min), histogram.max);
+			histogram.max = hmax(this->max.load(RELAXED), histogram.min);
+			histogram.sum = hmax(this->sum.load(RELAXED), histogram.sum);
+		}
+	}
+
+	Metrics::Metrics(int cellCount, Metrics* parent) :
+		sendQueueDepth(0LL),
+		receiveQueueDepth(0LL)
+	{
+		this->cellCount = hmax(cellCount, 1);
+		this->parent = parent;
+		this->cells = new Cell[this->cellCount];
+		for_iter (i, 0, this->cellCount)
+		{
+			Cell& cell = this->cells[i];
+			cell.bytesSent.store(0LL, RELAXED);
+			cell.bytesReceived.store(0LL, RELAXED);
+			cell.messagesSent.store(0LL, RELAXED);
+			cell.messagesReceived.store(0LL, RELAXED);
+			cell.sendCalls.store(0LL, RELAXED);
+			cell.receiveCalls.store(0LL, RELAXED);
+			cell.wouldBlocks.store(0LL, RELAXED);
+			cell.accepts.store(0LL, RELAXED);
+			cell.connects.store(0LL, RELAXED);
+			cell.batchFlushes.store(0LL, RELAXED);
+			cell.batchedSends.store(0LL, RELAXED);
+		}
+	}
+
+	Metrics::~Metrics()
+	{
+		// whatever is still queued is gone now
+		this->setSendQueueDepth(0LL);
+		this->setReceiveQueueDepth(0LL);
+		delete[] this->cells;
+	}
+
+	int64_t Metrics::getTime()
+	{
+		return (int64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	Metrics::Cell& Metrics::_getCell()
+	{
+		return (this->cellCount == 1 ? this->cells[0] : this->cells[_getThreadSlot() % this->cellCount]);
+	}
+
+	void Metrics::addSendCall(int bytes, bool wouldBlock)
+	{
+		Cell& cell = this->_getCell();
+		cell.sendCalls.fetch_add(1LL, RELAXED);
+		if (bytes > 0)
+		{
+			cell.bytesSent.fetch_add(bytes, RELAXED);
+		}
+		if (wouldBlock)
+		{
+			cell.wouldBlocks.fetch_add(1LL, RELAXED);
+		}
+		if (this->parent != NULL)
+		{
+			this->parent->addSendCall(bytes, wouldBlock);
+		}
+	}
+
+	void Metrics::addReceiveCall(int bytes, bool wouldBlock)
+	{
+		Cell& cell = this->_getCell();
+		cell.receiveCalls.fetch_add(1LL, RELAXED);
+		if (bytes > 0)
+		{
+			cell.bytesReceived.fetch_add(bytes, RELAXED);
+		}
+		if (wouldBlock)
+		{
+			cell.wouldBlocks.fetch_add(1LL, RELAXED);
+		}
+		if (this->parent != NULL)
+		{
+			this->parent->addReceiveCall(bytes, wouldBlock);
+		}
+	}
+
+	void Metrics::addMessageSent(int64_t latency)
+	{
+		this->_getCell().messagesSent.fetch_add(1LL, RELAXED);
+		if (latency >= 0LL)
+		{
+			this->sendLatency.add(latency);
+		}
+		if (this->parent != NULL)
+		{
+			this->parent->addMessageSent(latency);
+		}
+	}
+
+	void Metrics::addMessageReceived()
+	{
+		this->_getCell().messagesReceived.fetch_add(1LL, RELAXED);
+		if (this->parent != NULL)
+		{
+			this->parent->addMessageReceived();
+		}
+	}
+
+	void Metrics::addAccept()
+	{
+		this->_getCell().accepts.fetch_add(1LL, RELAXED);
+		if (this->parent != NULL)
+		{
+			this->parent->addAccept();
+		}
+	}
+
+	void Metrics::addConnect(int64_t latency)
+	{
+		this->_getCell().connects.fetch_add(1LL, RELAXED);
+		this->connectLatency.add(latency);
+		if (this->parent != NULL)
+		{
+			this->parent->addConnect(latency);
+		}
+	}
+
+	void Metrics::addBatchFlush(int sendCount)
+	{
+		Cell& cell = this->_getCell();
+		cell.batchFlushes.fetch_add(1LL, RELAXED);
+		cell.batchedSends.fetch_add(sendCount, RELAXED);
+		if (this->parent != NULL)
+		{
+			this->parent->addBatchFlush(sendCount);
+		}
+	}
+
+	void Metrics::setSendQueueDepth(int64_t value)
+	{
+		int64_t difference = value - this->sendQueueDepth.exchange(value, RELAXED);
+		// the parent is an aggregate so it only receives differences
+		if (difference != 0LL && this->parent != NULL)
+		{
+			this->parent->sendQueueDepth.fetch_add(difference, RELAXED);
+		}
+	}
+
+	void Metrics::setReceiveQueueDepth(int64_t value)
+	{
+		int64_t difference = value - this->receiveQueueDepth.exchange(value, RELAXED);
+		if (difference != 0LL && this->parent != NULL)
+		{
+			this->parent->receiveQueueDepth.fetch_add(difference, RELAXED);
+		}
+	}
+
+	void Metrics::addReceiveQueueDepth(int64_t difference)
+	{
+		this->receiveQueueDepth.fetch_add(difference, RELAXED);
+		if (this->parent != NULL)
+		{
+			this->parent->receiveQueueDepth.fetch_add(difference, RELAXED);
+		}
+	}
+
+	int64_t Metrics::getReceiveQueueDepth() const
+	{
+		return this->receiveQueueDepth.load(RELAXED);
+	}
+
+	MetricsSnapshot Metrics::getSnapshot() const
+	{
+		MetricsSnapshot snapshot;
+		for_iter (i, 0, this->cellCount)
+		{
+			const Cell& cell = this->cells[i];
+			snapshot.bytesSent += cell.bytesSent.load(RELAXED);
+			snapshot.bytesReceived += cell.bytesReceived.load(RELAXED);
+			snapshot.messagesSent += cell.messagesSent.load(RELAXED);
+			snapshot.messagesReceived += cell.messagesReceived.load(RELAXED);
+			snapshot.sendCalls += cell.sendCalls.load(RELAXED);
+			snapshot.receiveCalls += cell.receiveCalls.load(RELAXED);
+			snapshot.wouldBlocks += cell.wouldBlocks.load(RELAXED);
+			snapshot.accepts += cell.accepts.load(RELAXED);
+			snapshot.connects += cell.connects.load(RELAXED);
+			snapshot.batchFlushes += cell.batchFlushes.load(RELAXED);
+			snapshot.batchedSends += cell.batchedSends.load(RELAXED);
+		}
+		snapshot.sendQueueDepth = this->sendQueueDepth.load(RELAXED);
+		snapshot.receiveQueueDepth = this->receiveQueueDepth.load(RELAXED);
+		this->connectLatency.read(snapshot.connectLatency);
+		this->sendLatency.read(snapshot.sendLatency);
+		return snapshot;
+	}
+
+}
@@ -0,0 +1,109 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines lock-free metric counters that are updated by sockets and their threads.
+
+#ifndef SAKIT_METRICS_H
+#define SAKIT_METRICS_H
+
+#include <atomic>
+
+#include <hltypes/hltypesUtil.h>
+
+#include "LatencyHistogram.h"
+#include "MetricsSnapshot.h"
+
+namespace sakit
+{
+	class AtomicHistogram
+	{
+	public:
+		AtomicHistogram();
+		~AtomicHistogram();
+
+		void add(int64_t value);
+		void read(LatencyHistogram& histogram) const;
+
+	protected:
+		std::atomic<int64_t>* buckets;
+		std::atomic<int64_t> count;
+		std::atomic<int64_t> min;
+		std::atomic<int64_t> max;
+		std::atomic<int64_t> sum;
+
+	private:
+		AtomicHistogram(const AtomicHistogram& other); // prevents copying
+
+	};
+
+	class Metrics
+	{
+	public:
+		/// @param[in] cellCount Counters are spread across this many cells by thread to avoid contention, values are aggregated on read.
+		/// @param[in] parent All values are forwarded to the parent as well.
+		Metrics(int cellCount = 1, Metrics* parent = NULL);
+		~Metrics();
+
+		void addSendCall(int bytes, bool wouldBlock);
+		void addReceiveCall(int bytes, bool wouldBlock);
+		/// @param[in] latency Microseconds since the send was requested. Negative values are not recorded in the histogram.
+		void addMessageSent(int64_t latency);
+		void addMessageReceived();
+		void addAccept();
+		void addConnect(int64_t latency);
+		/// @param[in] sendCount Number of sends that were gathered in the batch.
+		void addBatchFlush(int sendCount);
+		void setSendQueueDepth(int64_t value);
+		void setReceiveQueueDepth(int64_t value);
+		/// @note Used when the depth is changed from several threads, an absolute value could overwrite a newer one.
+		void addReceiveQueueDepth(int64_t difference);
+		int64_t getReceiveQueueDepth() const;
+
+		MetricsSnapshot getSnapshot() const;
+
+		/// @return Monotonic time in microseconds.
+		static int64_t getTime();
+
+		static Metrics global;
+
+	protected:
+		struct Cell
+		{
+			std::atomic<int64_t> bytesSent;
+			std::atomic<int64_t> bytesReceived;
+			std::atomic<int64_t> messagesSent;
+			std::atomic<int64_t> messagesReceived;
+			std::atomic<int64_t> sendCalls;
+			std::atomic<int64_t> receiveCalls;
+			std::atomic<int64_t> wouldBlocks;
+			std::atomic<int64_t> accepts;
+			std::atomic<int64_t> connects;
+			std::atomic<int64_t> batchFlushes;
+			std::atomic<int64_t> batchedSends;
+			char padding[64]; // keeps cells of different threads on separate cache lines
+		};
+
+		Cell* cells;
+		int cellCount;
+		Metrics* parent;
+		std::atomic<int64_t> sendQueueDepth;
+		std::atomic<int64_t> receiveQueueDepth;
+		AtomicHistogram connectLatency;
+		AtomicHistogram sendLatency;
+
+		Cell& _getCell();
+
+	private:
+		Metrics(const Metrics& other); // prevents copying
+
+	};
+
+}
+#endif
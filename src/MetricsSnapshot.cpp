@@ -0,0 +1,57 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/hstring.h>
+
+#include "MetricsSnapshot.h"
+
+namespace sakit
+{
+	MetricsSnapshot::MetricsSnapshot() :
+		bytesSent(0LL),
+		bytesReceived(0LL),
+		messagesSent(0LL),
+		messagesReceived(0LL),
+		sendCalls(0LL),
+		receiveCalls(0LL),
+		wouldBlocks(0LL),
+		accepts(0LL),
+		connects(0LL),
+		batchFlushes(0LL),
+		batchedSends(0LL),
+		sendQueueDepth(0LL),
+		receiveQueueDepth(0LL)
+	{
+	}
+
+	MetricsSnapshot::~MetricsSnapshot()
+	{
+	}
+
+	hstr MetricsSnapshot::toString() const
+	{
+		hstr result;
+		result += hsprintf("bytes_sent %lld\n", (long long)this->bytesSent);
+		result += hsprintf("bytes_received %lld\n", (long long)this->bytesReceived);
+		result += hsprintf("messages_sent %lld\n", (long long)this->messagesSent);
+		result += hsprintf("messages_received %lld\n", (long long)this->messagesReceived);
+		result += hsprintf("send_calls %lld\n", (long long)this->sendCalls);
+		result += hsprintf("receive_calls %lld\n", (long long)this->receiveCalls);
+		result += hsprintf("would_blocks %lld\n", (long long)this->wouldBlocks);
+		result += hsprintf("accepts %lld\n", (long long)this->accepts);
+		result += hsprintf("connects %lld\n", (long long)this->connects);
+		result += hsprintf("batch_flushes %lld\n", (long long)this->batchFlushes);
+		result += hsprintf("batched_sends %lld\n", (long long)this->batchedSends);
+		result += hsprintf("send_queue_depth %lld\n", (long long)this->sendQueueDepth);
+		result += hsprintf("receive_queue_depth %lld\n", (long long)this->receiveQueueDepth);
+		result += "connect_latency_us " + this->connectLatency.toString() + "\n";
+		result += "send_latency_us " + this->sendLatency.toString() + "\n";
+		return result;
+	}
+
+}
@@ -12,6 +12,7 @@
 #include <hltypes/hstring.h>
 
 #include "HttpResponse.h"
+#include "Metrics.h"
 #include "PlatformSocket.h"
 #include "sakit.h"
 
@@ -28,6 +29,7 @@ namespace sakit
 	{
 		this->disconnect();
 		delete[] this->receiveBuffer;
+		delete this->metrics;
 	}
 	
 	bool PlatformSocket::_printLastError(chstr basicMessage, int code)
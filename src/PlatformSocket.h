@@ -22,8 +22,10 @@
 #include <hltypes/hstring.h>
 #include <hltypes/hthread.h>
 
+#include "ConnectionStats.h"
 #include "Host.h"
 #include "NetworkAdapter.h"
+#include "SocketOptions.h"
 #include "State.h"
 
 #ifdef __APPLE__
@@ -38,6 +40,7 @@ using namespace Windows::Storage::Streams;
 
 namespace sakit
 {
+	class Metrics;
 	class Socket;
 
 	class PlatformSocket
@@ -49,32 +52,70 @@ namespace sakit
 		HL_DEFINE_IS(connected, Connected);
 		HL_DEFINE_ISSET(connectionLess, ConnectionLess);
 		HL_DEFINE_ISSET(serverMode, ServerMode); // actually used only in WinRT
+		HL_DEFINE_GET(SocketOptions, options, Options);
+		HL_DEFINE_GET(Metrics*, metrics, Metrics);
+		HL_DEFINE_IS(receiveDestination, ReceiveDestination);
+		HL_DEFINE_IS(nonBlocking, NonBlocking);
 
 		bool tryCreateSocket();
 		bool setRemoteAddress(Host remoteHost, unsigned short remotePort);
 		bool setLocalAddress(Host localHost, unsigned short localPort);
 		bool connect(Host remoteHost, unsigned short remotePort, Host& localHost, unsigned short& localPort, float timeout, float retryFrequency);
+		/// @brief Starts connecting without waiting for the connection to be established.
+		/// @param[in] resolved If true, setRemoteAddress() was already called, e.g. on another thread, and the address isn't resolved again.
+		/// @note If done is false afterwards, pollConnect() has to be called until it is true.
+		bool startConnect(Host remoteHost, unsigned short remotePort, bool& done, bool resolved = false);
+		/// @return False if the connection failed.
+		bool pollConnect(bool& done);
 		/// @note Since binding can be done on "any IP" and "any port", the set values are returned.
 		bool bind(Host localHost, unsigned short& localPort);
 		bool disconnect();
 		bool send(hstream* stream, int& sent, int& count);
+		/// @brief Sends several separate buffers with a single gathered write call.
+		/// @note Only for connected sockets. Like send(), it can send less data than given.
+		bool sendParts(const unsigned char** parts, const int* sizes, int count, int& sent);
 		bool receive(hstream* stream, int& maxCount, hmutex* mutex = NULL);
 		bool receiveFrom(hstream* stream, Host& remoteHost, unsigned short& remotePort);
+		/// @brief Like receiveFrom(), but also returns the destination address of the datagram, e.g. its multicast group.
+		/// @note The destination is only known after setReceiveDestination(true), otherwise it is an empty Host.
+		bool receiveFromDestination(hstream* stream, Host& remoteHost, unsigned short& remotePort, Host& destinationHost);
+		/// @brief Like receiveFrom(), but returns the sender as an opaque binary address without any name lookup.
+		/// @param[in,out] addressSize Capacity of address, afterwards the actual size of the returned address.
+		bool receiveFromAddress(hstream* stream, unsigned char* address, int& addressSize);
+		/// @brief Sends one datagram to an address returned by receiveFromAddress() without resolving it again.
+		bool sendToAddress(const unsigned char* address, int addressSize, hstream* stream, int& count, int& sent);
 		bool listen();
 		bool accept(Socket* socket);
 
 		bool broadcast(harray<NetworkAdapter> adapters, unsigned short remotePort, hstream* stream, int count);
-		bool joinMulticastGroup(Host interfaceHost, Host groupAddress);
-		bool leaveMulticastGroup(Host interfaceHost, Host groupAddress);
+		/// @param[in] sourceHost If not empty, only datagrams from this source are received (source-specific multicast).
+		bool joinMulticastGroup(Host interfaceHost, Host groupAddress, Host sourceHost = Host());
+		bool leaveMulticastGroup(Host interfaceHost, Host groupAddress, Host sourceHost = Host());
 
+		/// @brief Keeps a connected socket in non-blocking mode, send() then sends only what fits into the send buffer.
+		bool setNonBlocking(bool value);
 		bool setNagleAlgorithmActive(bool value);
 		bool setMulticastInterface(Host interfaceHost);
 		bool setMulticastTtl(int value);
 		bool setMulticastLoopback(bool value);
-
+		/// @brief Makes the OS report the destination address of received datagrams (IP_PKTINFO or IP_RECVDSTADDR).
+		bool setReceiveDestination(bool value);
+		/// @note If the socket was not created yet, the options are applied once it has been created.
+		bool setOptions(const SocketOptions& options);
+		SocketOptions getEffectiveOptions();
+		bool getConnectionStats(ConnectionStats& stats);
+
+		/// @brief Waits until at least one of the sockets has received data, was closed by the peer or the timeout passed.
+		/// @param[out] readySockets Sockets that can be read from without waiting.
+		/// @param[in] sendingSockets Waiting also ends when one of these can send again, e.g. non-blocking sockets with pending output.
+		/// @return False if waiting isn't possible on this platform or for these sockets, the caller has to sleep instead.
+		static bool waitForReceive(harray<PlatformSocket*> sockets, float timeout, harray<PlatformSocket*>& readySockets,
+			harray<PlatformSocket*> sendingSockets = harray<PlatformSocket*>());
 		static Host resolveHost(Host domain);
 		static Host resolveIp(Host ip);
 		static unsigned short resolveServiceName(chstr serviceName);
+		/// @brief Converts an address returned by receiveFromAddress() to a numeric host and port.
+		static bool getAddressHostPort(const unsigned char* address, int addressSize, Host& host, unsigned short& port);
 		static harray<NetworkAdapter> getNetworkAdapters();
 		
 		static void platformInit();
@@ -86,6 +127,10 @@ namespace sakit
 		char* receiveBuffer;
 		int bufferSize;
 		bool serverMode;
+		SocketOptions options;
+		Metrics* metrics;
+		bool receiveDestination;
+		bool nonBlocking;
 
 #if !defined(_WIN32) || !defined(_WINRT)
 		unsigned int sock;
@@ -98,6 +143,8 @@ namespace sakit
 		bool _checkReceivedCount(unsigned long* receivedCount);
 		bool _checkResult(int result, chstr functionName, bool disconnectOnError = true);
 		void _getLocalHostPort(Host& host, unsigned short& port);
+		bool _setOption(int level, int name, int value, chstr optionName);
+		int _getOption(int level, int name);
 #else
 		// there is no other way to make this work
 		[Windows::Foundation::Metadata::WebHostHidden]
@@ -179,6 +226,7 @@ namespace sakit
 #endif
 
 		bool _setNonBlocking(bool value);
+		bool _applyOptions();
 
 		static bool _printLastError(chstr basicMessage, int code = 0);
 
@@ -32,6 +32,7 @@ typedef int socklen_t;
 #include <sys/socket.h>
 #include <sys/select.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
@@ -44,6 +45,7 @@ typedef int socklen_t;
 #include <fcntl.h>
 #include <netdb.h>
 #include <errno.h>
+#include <stddef.h>
 
 extern int h_errno;
 
@@ -68,6 +70,7 @@ extern int h_errno;
 #include <hltypes/hstring.h>
 
 #include "Host.h"
+#include "Metrics.h"
 #include "PlatformSocket.h"
 #include "sakit.h"
 #include "Server.h"
@@ -85,6 +88,9 @@ extern int h_errno;
 	#define FAMILY_CONNECT_INET PF_INET
 #endif
 
+#define MAX_SEND_PARTS 4
+#define CONTROL_BUFFER_SIZE 256
+
 namespace sakit
 {
 	extern int bufferSize;
@@ -123,6 +129,57 @@ namespace sakit
 	#define __inet_pton inet_pton
 #endif
 
+#ifdef __linux__
+	// mirrors the kernel's struct tcp_info, libc headers often lack the newer fields; the kernel only fills as much as it knows
+	struct _TcpInfo
+	{
+		uint8_t state;
+		uint8_t caState;
+		uint8_t retransmits;
+		uint8_t probes;
+		uint8_t backoff;
+		uint8_t options;
+		uint8_t windowScales;
+		uint8_t flags;
+		uint32_t rto;
+		uint32_t ato;
+		uint32_t sendMss;
+		uint32_t receiveMss;
+		uint32_t unacked;
+		uint32_t sacked;
+		uint32_t lost;
+		uint32_t retrans;
+		uint32_t fackets;
+		uint32_t lastDataSent;
+		uint32_t lastAckSent;
+		uint32_t lastDataReceived;
+		uint32_t lastAckReceived;
+		uint32_t pmtu;
+		uint32_t receiveSsthresh;
+		uint32_t rtt;
+		uint32_t rttVariance;
+		uint32_t sendSsthresh;
+		uint32_t sendCwnd;
+		uint32_t advmss;
+		uint32_t reordering;
+		uint32_t receiveRtt;
+		uint32_t receiveSpace;
+		uint32_t totalRetrans;
+		uint64_t pacingRate;
+		uint64_t maxPacingRate;
+		uint64_t bytesAcked;
+		uint64_t bytesReceived;
+		uint32_t segmentsOut;
+		uint32_t segmentsIn;
+		uint32_t notSentBytes;
+		uint32_t minRtt;
+		uint32_t dataSegmentsIn;
+		uint32_t dataSegmentsOut;
+		uint64_t deliveryRate;
+	};
+#define _TCP_INFO_HAS(size, member) (size >= (socklen_t)(offsetof(_TcpInfo, member) + sizeof(((_TcpInfo*)NULL)->member)))
+#endif
+
 	// wrappers for thread-unsafe functions
 	static hmutex mutexInetNtoa;
 	static hmutex mutexInetAddr;
@@ -153,6 +210,15 @@ namespace sakit
 		return ntohs(netshort);
 	}
 
+	static bool _isWouldBlock()
+	{
+#ifdef _WIN32
+		return (WSAGetLastError() == WSAEWOULDBLOCK);
+#else
+		return (errno == EAGAIN || errno == EWOULDBLOCK);
+#endif
+	}
+
 	// normal methods
 
 	void PlatformSocket::platformInit()
@@ -180,22 +246,31 @@ namespace sakit
 
 	PlatformSocket::PlatformSocket() :
 		connected(false),
-		connectionLess(false)
+		connectionLess(false),
+		receiveDestination(false),
+		nonBlocking(false)
 	{
 		this->sock = -1;
 		this->socketInfo = NULL;
 		this->localInfo = NULL;
 		this->remoteInfo = NULL;
 		this->address = NULL;
+		this->metrics = new Metrics(1, &Metrics::global);
 		this->bufferSize = sakit::bufferSize;
 		this->receiveBuffer = new char[this->bufferSize];
 		memset(this->receiveBuffer, 0, this->bufferSize);
 	}
 
+	bool PlatformSocket::setNonBlocking(bool value)
+	{
+		this->nonBlocking = value;
+		return this->_setNonBlocking(value);
+	}
+
 	bool PlatformSocket::_setNonBlocking(bool value)
 	{
-		// set to blocking or non-blocking
-		int setValue = (value ? 1 : 0);
+		// set to blocking or non-blocking, a socket that was made non-blocking stays that way
+		int setValue = (value || this->nonBlocking ? 1 : 0);
 		return this->_checkResult(ioctlsocket(this->sock, FIONBIO, (unsigned long*)&setValue), "ioctlsocket()");
 	}
 
@@ -205,7 +280,12 @@ namespace sakit
 		{
 			this->connected = true;
 			this->sock = socket(this->socketInfo->ai_family, this->socketInfo->ai_socktype, this->socketInfo->ai_protocol);
-			return this->_checkResult(this->sock, "socket()");
+			if (!this->_checkResult(this->sock, "socket()"))
+			{
+				return false;
+			}
+			// options that could not be applied are only reported, the socket is still usable
+			this->_applyOptions();
 		}
 		return true;
 	}
@@ -264,6 +344,7 @@ namespace sakit
 
 	bool PlatformSocket::connect(Host remoteHost, unsigned short remotePort, Host& localHost, unsigned short& localPort, float timeout, float retryFrequency)
 	{
+		int64_t startTime = Metrics::getTime();
 		if (!this->setRemoteAddress(remoteHost, remotePort))
 		{
 			return false;
@@ -330,6 +411,84 @@ namespace sakit
 			}
 		}
 		this->_getLocalHostPort(localHost, localPort);
+		this->metrics->addConnect(Metrics::getTime() - startTime);
+		return true;
+	}
+
+	bool PlatformSocket::startConnect(Host remoteHost, unsigned short remotePort, bool& done, bool resolved)
+	{
+		done = false;
+		if (!resolved && !this->setRemoteAddress(remoteHost, remotePort))
+		{
+			return false;
+		}
+		if (!this->tryCreateSocket())
+		{
+			return false;
+		}
+		if (this->connectionLess)
+		{
+			done = true;
+			return true;
+		}
+		if (!this->setNagleAlgorithmActive(false))
+		{
+			return false;
+		}
+		// stays in non-blocking mode until pollConnect() reports the outcome
+		this->_setNonBlocking(true);
+		int result = ::connect(this->sock, this->remoteInfo->ai_addr, this->remoteInfo->ai_addrlen);
+		if (result != 0 && PlatformSocket::_printLastError("connect()")) // failed and actual error
+		{
+			this->disconnect();
+			return false;
+		}
+		if (result == 0)
+		{
+			this->_setNonBlocking(false);
+			done = true;
+		}
+		return true;
+	}
+
+	bool PlatformSocket::pollConnect(bool& done)
+	{
+		done = false;
+#ifndef _WIN32 // on Windows fd_set is a list of sockets, otherwise it's a bitset that only fits descriptors up to FD_SETSIZE
+		if (this->sock >= FD_SETSIZE)
+		{
+			hlog::error(logTag, "Cannot poll connection, socket descriptor exceeds FD_SETSIZE!");
+			this->disconnect();
+			return false;
+		}
+#endif
+		timeval interval = {0, 0};
+		fd_set writeSet;
+		FD_ZERO(&writeSet);
+		FD_SET(this->sock, &writeSet);
+		int result = select(this->sock + 1, NULL, &writeSet, NULL, &interval);
+		if (!this->_checkResult(result, "select()"))
+		{
+			return false;
+		}
+		if (result == 0)
+		{
+			return true;
+		}
+		int error;
+		socklen_t size = sizeof(error);
+		result = getsockopt(this->sock, SOL_SOCKET, SO_ERROR, (char*)&error, &size);
+		if (!this->_checkResult(result, "getsockopt()"))
+		{
+			return false;
+		}
+		if (PlatformSocket::_printLastError("", error))
+		{
+			this->disconnect();
+			return false;
+		}
+		this->_setNonBlocking(false);
+		done = true;
 		return true;
 	}
 
@@ -370,16 +529,44 @@ namespace sakit
 		port = __ntohs(address.sin_port);
 	}
 
-	bool PlatformSocket::joinMulticastGroup(Host interfaceHost, Host groupAddress)
+	bool PlatformSocket::joinMulticastGroup(Host interfaceHost, Host groupAddress, Host sourceHost)
 	{
+		if (sourceHost.toString() != "")
+		{
+#ifdef IP_ADD_SOURCE_MEMBERSHIP
+			ip_mreq_source sourceGroup;
+			memset(&sourceGroup, 0, sizeof(ip_mreq_source));
+			sourceGroup.imr_interface.s_addr = IN_ADDRT_T_TYPECAST __inet_addr(interfaceHost.toString().cStr());
+			sourceGroup.imr_multiaddr.s_addr = IN_ADDRT_T_TYPECAST __inet_addr(groupAddress.toString().cStr());
+			sourceGroup.imr_sourceaddr.s_addr = IN_ADDRT_T_TYPECAST __inet_addr(sourceHost.toString().cStr());
+			return this->_checkResult(setsockopt(this->sock, IPPROTO_IP, IP_ADD_SOURCE_MEMBERSHIP, (char*)&sourceGroup, sizeof(ip_mreq_source)), "setsockopt()", false);
+#else
+			hlog::error(logTag, "Source-specific multicast is not supported on this platform!");
+			return false;
+#endif
+		}
 		ip_mreq group;
 		group.imr_interface.s_addr = IN_ADDRT_T_TYPECAST __inet_addr(interfaceHost.toString().cStr());
 		group.imr_multiaddr.s_addr = IN_ADDRT_T_TYPECAST __inet_addr(groupAddress.toString().cStr());
 		return this->_checkResult(setsockopt(this->sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, (char*)&group, sizeof(ip_mreq)), "setsockopt()");
 	}
 
-	bool PlatformSocket::leaveMulticastGroup(Host interfaceHost, Host groupAddress)
+	bool PlatformSocket::leaveMulticastGroup(Host interfaceHost, Host groupAddress, Host sourceHost)
 	{
+		if (sourceHost.toString() != "")
+		{
+#ifdef IP_DROP_SOURCE_MEMBERSHIP
+			ip_mreq_source sourceGroup;
+			memset(&sourceGroup, 0, sizeof(ip_mreq_source));
+			sourceGroup.imr_interface.s_addr = IN_ADDRT_T_TYPECAST __inet_addr(interfaceHost.toString().cStr());
+			sourceGroup.imr_multiaddr.s_addr = IN_ADDRT_T_TYPECAST __inet_addr(groupAddress.toString().cStr());
+			sourceGroup.imr_sourceaddr.s_addr = IN_ADDRT_T_TYPECAST __inet_addr(sourceHost.toString().cStr());
+			return this->_checkResult(setsockopt(this->sock, IPPROTO_IP, IP_DROP_SOURCE_MEMBERSHIP, (char*)&sourceGroup, sizeof(ip_mreq_source)), "setsockopt()", false);
+#else
+			hlog::error(logTag, "Source-specific multicast is not supported on this platform!");
+			return false;
+#endif
+		}
 		ip_mreq group;
 		group.imr_interface.s_addr = IN_ADDRT_T_TYPECAST __inet_addr(interfaceHost.toString().cStr());
 		group.imr_multiaddr.s_addr = IN_ADDRT_T_TYPECAST __inet_addr(groupAddress.toString().cStr());
@@ -410,6 +597,221 @@ namespace sakit
 		return this->_checkResult(setsockopt(this->sock, IPPROTO_IP, IP_MULTICAST_LOOP, (char*)&loopBack, sizeof(int)), "setsockopt()");
 	}
 
+	bool PlatformSocket::setReceiveDestination(bool value)
+	{
+		int enabled = (value ? 1 : 0);
+		bool result = false;
+#if defined(IP_PKTINFO) && !defined(_WIN32)
+		result = this->_checkResult(setsockopt(this->sock, IPPROTO_IP, IP_PKTINFO, (char*)&enabled, sizeof(int)), "setsockopt()", false);
+#elif defined(IP_RECVDSTADDR) && !defined(_WIN32)
+		result = this->_checkResult(setsockopt(this->sock, IPPROTO_IP, IP_RECVDSTADDR, (char*)&enabled, sizeof(int)), "setsockopt()", false);
+#else
+		// Winsock only reports it through the WSARecvMsg() extension
+		hlog::warn(logTag, "Receiving destination addresses is not supported on this platform!");
+#endif
+		if (result)
+		{
+			this->receiveDestination = value;
+		}
+		return result;
+	}
+
+	bool PlatformSocket::setOptions(const SocketOptions& options)
+	{
+		this->options = options;
+		return this->_applyOptions();
+	}
+
+	bool PlatformSocket::_setOption(int level, int name, int value, chstr optionName)
+	{
+		return this->_checkResult(setsockopt(this->sock, level, name, (char*)&value, sizeof(int)), "setsockopt(" + optionName + ")", false);
+	}
+
+	int PlatformSocket::_getOption(int level, int name)
+	{
+		int value = 0;
+		socklen_t size = (socklen_t)sizeof(int);
+		if (getsockopt(this->sock, level, name, (char*)&value, &size) < 0)
+		{
+			return SocketOptions::Unset;
+		}
+		return value;
+	}
+
+#define APPLY_OPTION(member, level, name) \
+	if (this->options.member != SocketOptions::Unset && !this->_setOption(level, name, this->options.member, #name)) \
+	{ \
+		result = false; \
+	}
+#define SKIP_OPTION(member, name) \
+	if (this->options.member != SocketOptions::Unset) \
+	{ \
+		hlog::warn(logTag, #name " is not supported on this platform!"); \
+	}
+
+	bool PlatformSocket::_applyOptions()
+	{
+		if (this->sock == (unsigned int)-1)
+		{
+			return true; // applied as soon as the socket has been created
+		}
+		bool result = true;
+		APPLY_OPTION(receiveBufferSize, SOL_SOCKET, SO_RCVBUF);
+		APPLY_OPTION(sendBufferSize, SOL_SOCKET, SO_SNDBUF);
+#ifdef SO_BUSY_POLL
+		APPLY_OPTION(busyPoll, SOL_SOCKET, SO_BUSY_POLL);
+#else
+		SKIP_OPTION(busyPoll, SO_BUSY_POLL);
+#endif
+		APPLY_OPTION(typeOfService, IPPROTO_IP, IP_TOS);
+		if (this->connectionLess)
+		{
+			return result;
+		}
+		APPLY_OPTION(keepAlive, SOL_SOCKET, SO_KEEPALIVE);
+#ifdef TCP_KEEPIDLE
+		APPLY_OPTION(keepAliveIdle, IPPROTO_TCP, TCP_KEEPIDLE);
+#elif defined(TCP_KEEPALIVE)
+		APPLY_OPTION(keepAliveIdle, IPPROTO_TCP, TCP_KEEPALIVE);
+#else
+		SKIP_OPTION(keepAliveIdle, TCP_KEEPIDLE);
+#endif
+#ifdef TCP_KEEPINTVL
+		APPLY_OPTION(keepAliveInterval, IPPROTO_TCP, TCP_KEEPINTVL);
+#else
+		SKIP_OPTION(keepAliveInterval, TCP_KEEPINTVL);
+#endif
+#ifdef TCP_KEEPCNT
+		APPLY_OPTION(keepAliveCount, IPPROTO_TCP, TCP_KEEPCNT);
+#else
+		SKIP_OPTION(keepAliveCount, TCP_KEEPCNT);
+#endif
+#ifdef TCP_QUICKACK
+		APPLY_OPTION(quickAck, IPPROTO_TCP, TCP_QUICKACK);
+#else
+		SKIP_OPTION(quickAck, TCP_QUICKACK);
+#endif
+#ifdef TCP_CORK
+		APPLY_OPTION(cork, IPPROTO_TCP, TCP_CORK);
+#elif defined(TCP_NOPUSH)
+		APPLY_OPTION(cork, IPPROTO_TCP, TCP_NOPUSH);
+#else
+		SKIP_OPTION(cork, TCP_CORK);
+#endif
+#ifdef TCP_NOTSENT_LOWAT
+		APPLY_OPTION(notSentLowWatermark, IPPROTO_TCP, TCP_NOTSENT_LOWAT);
+#else
+		SKIP_OPTION(notSentLowWatermark, TCP_NOTSENT_LOWAT);
+#endif
+#ifdef TCP_USER_TIMEOUT
+		APPLY_OPTION(userTimeout, IPPROTO_TCP, TCP_USER_TIMEOUT);
+#else
+		SKIP_OPTION(userTimeout, TCP_USER_TIMEOUT);
+#endif
+		return result;
+	}
+
+#undef APPLY_OPTION
+#undef SKIP_OPTION
+
+	bool PlatformSocket::getConnectionStats(ConnectionStats& stats)
+	{
+		if (this->sock == (unsigned int)-1 || this->connectionLess)
+		{
+			return false;
+		}
+		stats = ConnectionStats();
+		stats.time = htickCount();
+#if defined(__linux__) && defined(TCP_INFO)
+		_TcpInfo info;
+		memset(&info, 0, sizeof(_TcpInfo));
+		socklen_t size = (socklen_t)sizeof(_TcpInfo);
+		if (!this->_checkResult(getsockopt(this->sock, IPPROTO_TCP, TCP_INFO, (char*)&info, &size), "getsockopt(TCP_INFO)", false))
+		{
+			return false;
+		}
+		stats.rtt = info.rtt * 0.001f;
+		stats.rttVariance = info.rttVariance * 0.001f;
+		stats.congestionWindow = (int64_t)info.sendCwnd * info.sendMss;
+		stats.retransmits = (int)info.totalRetrans;
+		if (_TCP_INFO_HAS(size, pacingRate) && info.pacingRate != (uint64_t)-1) // -1 means "unlimited"
+		{
+			stats.pacingRate = (int64_t)info.pacingRate;
+		}
+		if (_TCP_INFO_HAS(size, bytesAcked))
+		{
+			stats.bytesAcked = (int64_t)info.bytesAcked;
+		}
+		if (_TCP_INFO_HAS(size, deliveryRate))
+		{
+			stats.deliveryRate = (int64_t)info.deliveryRate;
+		}
+		return true;
+#elif defined(__APPLE__) && defined(TCP_CONNECTION_INFO)
+		tcp_connection_info info;
+		memset(&info, 0, sizeof(tcp_connection_info));
+		socklen_t size = (socklen_t)sizeof(tcp_connection_info);
+		if (!this->_checkResult(getsockopt(this->sock, IPPROTO_TCP, TCP_CONNECTION_INFO, (char*)&info, &size), "getsockopt(TCP_CONNECTION_INFO)", false))
+		{
+			return false;
+		}
+		stats.rtt = (float)info.tcpi_srtt;
+		stats.rttVariance = (float)info.tcpi_rttvar;
+		stats.congestionWindow = (int64_t)info.tcpi_snd_cwnd;
+		stats.retransmits = (int)info.tcpi_txretransmitpackets;
+		return true;
+#else
+		hlog::warn(logTag, "Connection stats are not supported on this platform!");
+		return false;
+#endif
+	}
+
+	SocketOptions PlatformSocket::getEffectiveOptions()
+	{
+		SocketOptions options;
+		if (this->sock == (unsigned int)-1)
+		{
+			return options;
+		}
+		options.receiveBufferSize = this->_getOption(SOL_SOCKET, SO_RCVBUF);
+		options.sendBufferSize = this->_getOption(SOL_SOCKET, SO_SNDBUF);
+#ifdef SO_BUSY_POLL
+		options.busyPoll = this->_getOption(SOL_SOCKET, SO_BUSY_POLL);
+#endif
+		options.typeOfService = this->_getOption(IPPROTO_IP, IP_TOS);
+		if (this->connectionLess)
+		{
+			return options;
+		}
+		options.keepAlive = this->_getOption(SOL_SOCKET, SO_KEEPALIVE);
+#ifdef TCP_KEEPIDLE
+		options.keepAliveIdle = this->_getOption(IPPROTO_TCP, TCP_KEEPIDLE);
+#elif defined(TCP_KEEPALIVE)
+		options.keepAliveIdle = this->_getOption(IPPROTO_TCP, TCP_KEEPALIVE);
+#endif
+#ifdef TCP_KEEPINTVL
+		options.keepAliveInterval = this->_getOption(IPPROTO_TCP, TCP_KEEPINTVL);
+#endif
+#ifdef TCP_KEEPCNT
+		options.keepAliveCount = this->_getOption(IPPROTO_TCP, TCP_KEEPCNT);
+#endif
+#ifdef TCP_QUICKACK
+		options.quickAck = this->_getOption(IPPROTO_TCP, TCP_QUICKACK);
+#endif
+#ifdef TCP_CORK
+		options.cork = this->_getOption(IPPROTO_TCP, TCP_CORK);
+#elif defined(TCP_NOPUSH)
+		options.cork = this->_getOption(IPPROTO_TCP, TCP_NOPUSH);
+#endif
+#ifdef TCP_NOTSENT_LOWAT
+		options.notSentLowWatermark = this->_getOption(IPPROTO_TCP, TCP_NOTSENT_LOWAT);
+#endif
+#ifdef TCP_USER_TIMEOUT
+		options.userTimeout = this->_getOption(IPPROTO_TCP, TCP_USER_TIMEOUT);
+#endif
+		return options;
+	}
+
 	bool PlatformSocket::disconnect()
 	{
 		if (this->socketInfo != NULL)
@@ -439,6 +841,8 @@ namespace sakit
 			closesocket(this->sock);
 			this->sock = (unsigned int)-1;
 		}
+		this->receiveDestination = false;
+		this->nonBlocking = false;
 		bool previouslyConnected = this->connected;
 		this->connected = false;
 		return previouslyConnected;
@@ -452,14 +856,17 @@ namespace sakit
 		if (!this->connectionLess)
 		{
 			result = (int)::send(this->sock, data, size, 0);
+			this->metrics->addSendCall(result, (result < 0 && _isWouldBlock()));
 		}
 		else if (this->remoteInfo != NULL)
 		{
 			result = (int)::sendto(this->sock, data, size, 0, this->remoteInfo->ai_addr, this->remoteInfo->ai_addrlen);
+			this->metrics->addSendCall(result, (result < 0 && _isWouldBlock()));
 		}
 		else if (this->address != NULL)
 		{
 			result = (int)::sendto(this->sock, data, size, 0, (sockaddr*)this->address, sizeof(*this->address));
+			this->metrics->addSendCall(result, (result < 0 && _isWouldBlock()));
 		}
 		else
 		{
@@ -472,6 +879,43 @@ namespace sakit
 			count -= result;
 			return true;
 		}
+		// a full send buffer of a non-blocking socket only means that nothing could be sent yet
+		return (this->nonBlocking && _isWouldBlock());
+	}
+
+	bool PlatformSocket::sendParts(const unsigned char** parts, const int* sizes, int count, int& sent)
+	{
+		if (this->connectionLess)
+		{
+			hlog::warn(logTag, "Gathered sending is only supported on connected sockets!");
+			return false;
+		}
+		count = hmin(count, MAX_SEND_PARTS);
+		int result = 0;
+#ifdef _WIN32
+		WSABUF buffers[MAX_SEND_PARTS];
+		for_iter (i, 0, count)
+		{
+			buffers[i].buf = (char*)parts[i];
+			buffers[i].len = (ULONG)sizes[i];
+		}
+		DWORD sentCount = 0;
+		result = (::WSASend(this->sock, buffers, (DWORD)count, &sentCount, 0, NULL, NULL) == 0 ? (int)sentCount : -1);
+#else
+		struct iovec buffers[MAX_SEND_PARTS];
+		for_iter (i, 0, count)
+		{
+			buffers[i].iov_base = (void*)parts[i];
+			buffers[i].iov_len = (size_t)sizes[i];
+		}
+		result = (int)::writev(this->sock, buffers, count);
+#endif
+		this->metrics->addSendCall(result, (result < 0 && _isWouldBlock()));
+		if (result >= 0)
+		{
+			sent = result;
+			return true;
+		}
 		return false;
 	}
 
@@ -492,6 +936,7 @@ namespace sakit
 			readCount = hmin(readCount, maxCount);
 		}
 		readCount = (int)recv(this->sock, this->receiveBuffer, readCount, 0);
+		this->metrics->addReceiveCall(readCount, (readCount < 0 && _isWouldBlock()));
 		if (!this->_checkResult(readCount, "recv()", false))
 		{
 			return false;
@@ -507,6 +952,79 @@ namespace sakit
 	}
 
 	bool PlatformSocket::receiveFrom(hstream* stream, Host& remoteHost, unsigned short& remotePort)
+	{
+		sockaddr_storage address;
+		int size = (int)sizeof(sockaddr_storage);
+		int64_t position = stream->position();
+		if (!this->receiveFromAddress(stream, (unsigned char*)&address, size))
+		{
+			return false;
+		}
+		if (stream->position() != position)
+		{
+			// get the IP and port of the connected client
+			PlatformSocket::getAddressHostPort((unsigned char*)&address, size, remoteHost, remotePort);
+		}
+		return true;
+	}
+
+	bool PlatformSocket::receiveFromDestination(hstream* stream, Host& remoteHost, unsigned short& remotePort, Host& destinationHost)
+	{
+		destinationHost = Host();
+#ifndef _WIN32
+		if (this->receiveDestination)
+		{
+			sockaddr_storage address;
+			char control[CONTROL_BUFFER_SIZE];
+			iovec buffer;
+			buffer.iov_base = this->receiveBuffer;
+			buffer.iov_len = (size_t)this->bufferSize;
+			msghdr message;
+			memset(&message, 0, sizeof(msghdr));
+			message.msg_name = &address;
+			message.msg_namelen = (socklen_t)sizeof(sockaddr_storage);
+			message.msg_iov = &buffer;
+			message.msg_iovlen = 1;
+			message.msg_control = control;
+			message.msg_controllen = sizeof(control);
+			// a non-blocking call on its own, this avoids the select(), ioctl() and fcntl() calls of receiveFrom()
+			int read = (int)recvmsg(this->sock, &message, MSG_DONTWAIT);
+			this->metrics->addReceiveCall(read, (read < 0 && _isWouldBlock()));
+			if (read < 0)
+			{
+				return (_isWouldBlock() || this->_checkResult(read, "recvmsg()"));
+			}
+			if (read > 0)
+			{
+				this->metrics->addMessageReceived(); // every datagram is a message
+				stream->writeRaw(this->receiveBuffer, read);
+				PlatformSocket::getAddressHostPort((unsigned char*)&address, (int)message.msg_namelen, remoteHost, remotePort);
+				char hostString[INET_ADDRSTRLEN] = {'\0'};
+				for (cmsghdr* header = CMSG_FIRSTHDR(&message); header != NULL; header = CMSG_NXTHDR(&message, header))
+				{
+#ifdef IP_PKTINFO
+					if (header->cmsg_level == IPPROTO_IP && header->cmsg_type == IP_PKTINFO)
+					{
+						// ipi_addr is the destination address from the IP header, ipi_spec_dst would be the local interface
+						inet_ntop(AF_INET, &((in_pktinfo*)CMSG_DATA(header))->ipi_addr, hostString, INET_ADDRSTRLEN);
+						destinationHost = Host(hostString);
+					}
+#elif defined(IP_RECVDSTADDR)
+					if (header->cmsg_level == IPPROTO_IP && header->cmsg_type == IP_RECVDSTADDR)
+					{
+						inet_ntop(AF_INET, CMSG_DATA(header), hostString, INET_ADDRSTRLEN);
+						destinationHost = Host(hostString);
+					}
+#endif
+				}
+			}
+			return true;
+		}
+#endif
+		return this->receiveFrom(stream, remoteHost, remotePort);
+	}
+
+	bool PlatformSocket::receiveFromAddress(hstream* stream, unsigned char* address, int& addressSize)
 	{
 		unsigned long receivedCount = 0;
 		if (!this->_checkReceivedCount(&receivedCount))
@@ -518,10 +1036,10 @@ namespace sakit
 			return true;
 		}
 		int read = hmin((int)receivedCount, this->bufferSize);
-		sockaddr_storage address;
-		socklen_t size = (socklen_t)sizeof(sockaddr_storage);
+		socklen_t size = (socklen_t)addressSize;
 		this->_setNonBlocking(true);
-		read = (int)recvfrom(this->sock, this->receiveBuffer, read, 0, (sockaddr*)&address, &size);
+		read = (int)recvfrom(this->sock, this->receiveBuffer, read, 0, (sockaddr*)address, &size);
+		this->metrics->addReceiveCall(read, (read < 0 && _isWouldBlock()));
 		if (!this->_checkResult(read, "recvfrom()"))
 		{
 			this->_setNonBlocking(false);
@@ -530,19 +1048,30 @@ namespace sakit
 		this->_setNonBlocking(false);
 		if (read > 0)
 		{
+			this->metrics->addMessageReceived(); // every datagram is a message
 			stream->writeRaw(this->receiveBuffer, read);
-			// get the IP and port of the connected client
-			char hostString[NI_MAXHOST] = {'\0'};
-			char portString[NI_MAXSERV] = {'\0'};
-			hmutex::ScopeLock lock(&mutexGetnameinfo);
-			getnameinfo((sockaddr*)&address, size, hostString, NI_MAXHOST, portString, NI_MAXSERV, NI_NUMERICHOST | NI_NUMERICSERV);
-			lock.release();
-			remoteHost = Host(hostString);
-			remotePort = (unsigned short)(int)hstr(portString);
+			addressSize = (int)size;
 		}
 		return true;
 	}
 
+	bool PlatformSocket::sendToAddress(const unsigned char* address, int addressSize, hstream* stream, int& count, int& sent)
+	{
+		const char* data = (const char*)&(*stream)[(int)stream->position()];
+		int size = hmin((int)(stream->size() - stream->position()), count);
+		int result = (int)::sendto(this->sock, data, size, 0, (const sockaddr*)address, (socklen_t)addressSize);
+		this->metrics->addSendCall(result, (result < 0 && _isWouldBlock()));
+		// a failed datagram must not close the socket that is shared by all peers
+		if (!this->_checkResult(result, "sendto()", false))
+		{
+			return false;
+		}
+		stream->seek(result);
+		sent += result;
+		count -= result;
+		return true;
+	}
+
 	bool PlatformSocket::_checkReceivedCount(unsigned long* receivedCount)
 	{
 #ifndef _WIN32 // Unix requires a select() call before using ioctl/ioctlsocket
@@ -564,6 +1093,66 @@ namespace sakit
 		return this->_checkResult(ioctlsocket(this->sock, FIONREAD, (unsigned long*)receivedCount), "ioctlsocket()", false);
 	}
 
+	bool PlatformSocket::waitForReceive(harray<PlatformSocket*> sockets, float timeout, harray<PlatformSocket*>& readySockets,
+		harray<PlatformSocket*> sendingSockets)
+	{
+		readySockets.clear();
+		if ((sockets.size() == 0 && sendingSockets.size() == 0) || sockets.size() > FD_SETSIZE)
+		{
+			return false;
+		}
+		fd_set readSet;
+		FD_ZERO(&readSet);
+		unsigned int maxSock = 0;
+		foreach (PlatformSocket*, it, sockets)
+		{
+#ifndef _WIN32 // on Windows fd_set is a list of sockets, otherwise it's a bitset that only fits descriptors up to FD_SETSIZE
+			if ((*it)->sock >= FD_SETSIZE)
+			{
+				return false;
+			}
+#endif
+			FD_SET((*it)->sock, &readSet);
+			maxSock = hmax(maxSock, (*it)->sock);
+		}
+		fd_set writeSet;
+		FD_ZERO(&writeSet);
+		if (sendingSockets.size() > FD_SETSIZE)
+		{
+			return false;
+		}
+		foreach (PlatformSocket*, it, sendingSockets)
+		{
+#ifndef _WIN32
+			if ((*it)->sock >= FD_SETSIZE)
+			{
+				return false;
+			}
+#endif
+			FD_SET((*it)->sock, &writeSet);
+			maxSock = hmax(maxSock, (*it)->sock);
+		}
+		int microseconds = (int)(timeout * 1000000.0f);
+		timeval interval = {microseconds / 1000000, microseconds % 1000000};
+		int result = select(maxSock + 1, &readSet, (sendingSockets.size() > 0 ? &writeSet : NULL), NULL, &interval);
+		if (result < 0)
+		{
+			PlatformSocket::_printLastError("select()");
+			return false;
+		}
+		if (result > 0)
+		{
+			foreach (PlatformSocket*, it, sockets)
+			{
+				if (FD_ISSET((*it)->sock, &readSet))
+				{
+					readySockets += (*it);
+				}
+			}
+		}
+		return true;
+	}
+
 	bool PlatformSocket::listen()
 	{
 		return this->_checkResult(::listen(this->sock, SOMAXCONN), "listen()", false);
@@ -582,6 +1171,8 @@ namespace sakit
 			return false;
 		}
 		this->_setNonBlocking(false);
+		this->metrics->addAccept();
+		other->_applyOptions();
 		// get the IP and port of the connected client
 		char hostString[NI_MAXHOST] = {'\0'};
 		char portString[NI_MAXSERV] = {'\0'};
@@ -634,6 +1225,7 @@ namespace sakit
 		{
 			address.sin_addr.s_addr = IN_ADDRT_T_TYPECAST __inet_addr((*it).toString().cStr());
 			result = (int)sendto(this->sock, data, size, 0, (sockaddr*)&address, addrSize);
+			this->metrics->addSendCall(result, (result < 0 && _isWouldBlock()));
 			if (this->_checkResult(result, "sendto", false) && result > 0)
 			{
 				maxResult = hmax(result, maxResult);
@@ -711,6 +1303,23 @@ namespace sakit
 		return port;
 	}
 
+	bool PlatformSocket::getAddressHostPort(const unsigned char* address, int addressSize, Host& host, unsigned short& port)
+	{
+		char hostString[NI_MAXHOST] = {'\0'};
+		char portString[NI_MAXSERV] = {'\0'};
+		hmutex::ScopeLock lock(&mutexGetnameinfo);
+		int result = getnameinfo((const sockaddr*)address, (socklen_t)addressSize, hostString, NI_MAXHOST, portString, NI_MAXSERV, NI_NUMERICHOST | NI_NUMERICSERV);
+		lock.release();
+		if (result != 0)
+		{
+			hlog::error(logTag, "getnameinfo() " + __gai_strerror(result));
+			return false;
+		}
+		host = Host(hostString);
+		port = (unsigned short)(int)hstr(portString);
+		return true;
+	}
+
 	harray<NetworkAdapter> PlatformSocket::getNetworkAdapters()
 	{
 		harray<NetworkAdapter> result;
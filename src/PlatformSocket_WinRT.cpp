@@ -12,6 +12,7 @@
 #include <hltypes/hstring.h>
 
 #include "Base.h"
+#include "Metrics.h"
 #include "PlatformSocket.h"
 #include "sakit.h"
 #include "Socket.h"
@@ -42,11 +43,14 @@ namespace sakit
 		connected(false),
 		connectionLess(false),
 		serverMode(false),
+		receiveDestination(false),
+		nonBlocking(false),
 		_receiveStream(this->bufferSize)
 	{
 		this->sSock = nullptr;
 		this->dSock = nullptr;
 		this->sServer = nullptr;
+		this->metrics = new Metrics(1, &Metrics::global);
 		this->bufferSize = sakit::bufferSize;
 		this->receiveBuffer = new char[this->bufferSize];
 		memset(this->receiveBuffer, 0, this->bufferSize);
@@ -141,6 +145,7 @@ namespace sakit
 				this->dSock->MessageReceived += ref new TypedEventHandler<DatagramSocket^, DatagramSocketMessageReceivedEventArgs^>(
 					this->udpReceiver, &PlatformSocket::UdpReceiver::onReceivedDatagram);
 			}
+			this->_applyOptions();
 		}
 		return true;
 	}
@@ -208,6 +213,29 @@ namespace sakit
 		return _asyncResult;
 	}
 
+	bool PlatformSocket::startConnect(Host remoteHost, unsigned short remotePort, bool& done, bool resolved)
+	{
+		// TODOsock - use ConnectAsync() without waiting for it
+		Host localHost;
+		unsigned short localPort = 0;
+		done = true;
+		return this->connect(remoteHost, remotePort, localHost, localPort, sakit::getGlobalTimeout(), sakit::getGlobalRetryFrequency());
+	}
+
+	bool PlatformSocket::pollConnect(bool& done)
+	{
+		done = true;
+		return this->connected;
+	}
+
+	bool PlatformSocket::waitForReceive(harray<PlatformSocket*> sockets, float timeout, harray<PlatformSocket*>& readySockets,
+		harray<PlatformSocket*> sendingSockets)
+	{
+		// WinRT sockets are read through async operations, there is nothing to wait on
+		readySockets.clear();
+		return false;
+	}
+
 	bool PlatformSocket::_setUdpHost(HostName^ hostName, unsigned short remotePort)
 	{
 		// open socket
@@ -327,8 +355,13 @@ namespace sakit
 		return _asyncResult;
 	}
 
-	bool PlatformSocket::joinMulticastGroup(Host interfaceHost, Host groupAddress)
+	bool PlatformSocket::joinMulticastGroup(Host interfaceHost, Host groupAddress, Host sourceHost)
 	{
+		if (sourceHost.toString() != "")
+		{
+			hlog::error(logTag, "Source-specific multicast is not supported on WinRT!");
+			return false;
+		}
 		// create host info
 		HostName^ groupAddressName = PlatformSocket::_makeHostName(groupAddress);
 		if (groupAddressName == nullptr)
@@ -340,12 +373,18 @@ namespace sakit
 		return true;
 	}
 
-	bool PlatformSocket::leaveMulticastGroup(Host interfaceHost, Host groupAddress)
+	bool PlatformSocket::leaveMulticastGroup(Host interfaceHost, Host groupAddress, Host sourceHost)
 	{
 		hlog::error(logTag, "It is not possible to leave multicast groups on WinRT!");
 		return false;
 	}
 
+	bool PlatformSocket::setNonBlocking(bool value)
+	{
+		// WinRT sockets are always used through async operations
+		return false;
+	}
+
 	bool PlatformSocket::setNagleAlgorithmActive(bool value)
 	{
 		if (this->sSock != nullptr)
@@ -374,6 +413,60 @@ namespace sakit
 		return false;
 	}
 
+	bool PlatformSocket::setReceiveDestination(bool value)
+	{
+		hlog::warn(logTag, "Receiving destination addresses is not supported on WinRT!");
+		return false;
+	}
+
+	bool PlatformSocket::setOptions(const SocketOptions& options)
+	{
+		this->options = options;
+		return this->_applyOptions();
+	}
+
+	bool PlatformSocket::_applyOptions()
+	{
+		if (this->sSock != nullptr)
+		{
+			if (this->options.keepAlive != SocketOptions::Unset)
+			{
+				this->sSock->Control->KeepAlive = (this->options.keepAlive != 0);
+			}
+			if (this->options.sendBufferSize != SocketOptions::Unset)
+			{
+				this->sSock->Control->OutboundBufferSizeInBytes = this->options.sendBufferSize;
+			}
+		}
+		SocketOptions unsupported = this->options;
+		unsupported.keepAlive = SocketOptions::Unset;
+		unsupported.sendBufferSize = SocketOptions::Unset;
+		hstr remaining = unsupported.toString();
+		if (remaining != "")
+		{
+			hlog::warn(logTag, "WinRT does not support these socket options: " + remaining);
+			return false;
+		}
+		return true;
+	}
+
+	bool PlatformSocket::getConnectionStats(ConnectionStats& stats)
+	{
+		hlog::warn(logTag, "WinRT does not support connection stats!");
+		return false;
+	}
+
+	SocketOptions PlatformSocket::getEffectiveOptions()
+	{
+		SocketOptions options;
+		if (this->sSock != nullptr)
+		{
+			options.keepAlive = (this->sSock->Control->KeepAlive ? 1 : 0);
+			options.sendBufferSize = (int)this->sSock->Control->OutboundBufferSizeInBytes;
+		}
+		return options;
+	}
+
 	bool PlatformSocket::disconnect()
 	{
 		hmutex::ScopeLock _lock(&this->_mutexReceiveAsyncOperation);
@@ -461,6 +554,7 @@ namespace sakit
 			PlatformSocket::_printLastError(_HL_PSTR_TO_HSTR(e->Message));
 			return false;
 		}
+		this->metrics->addSendCall(_asyncResultSize, false);
 		if (_asyncResultSize > 0)
 		{
 			stream->seek(_asyncResultSize);
@@ -471,6 +565,20 @@ namespace sakit
 		return _asyncResult;
 	}
 
+	bool PlatformSocket::sendParts(const unsigned char** parts, const int* sizes, int count, int& sent)
+	{
+		// WinRT output streams don't support gathered writes so the parts are joined into one buffer
+		hstream stream;
+		for_iter (i, 0, count)
+		{
+			stream.writeRaw(parts[i], sizes[i]);
+		}
+		stream.rewind();
+		int size = (int)stream.size();
+		sent = 0;
+		return this->send(&stream, size, sent);
+	}
+
 	bool PlatformSocket::receive(hstream* stream, int& maxCount, hmutex* mutex)
 	{
 		if (this->sSock != nullptr)
@@ -516,9 +624,57 @@ namespace sakit
 		}
 		stream->writeRaw(*data);
 		delete data;
+		this->metrics->addMessageReceived(); // every datagram is a message
+		return true;
+	}
+
+	bool PlatformSocket::receiveFromDestination(hstream* stream, Host& remoteHost, unsigned short& remotePort, Host& destinationHost)
+	{
+		destinationHost = Host();
+		return this->receiveFrom(stream, remoteHost, remotePort);
+	}
+
+	bool PlatformSocket::receiveFromAddress(hstream* stream, unsigned char* address, int& addressSize)
+	{
+		// WinRT doesn't expose binary addresses so the numeric host and the port are used instead
+		Host host;
+		unsigned short port = 0;
+		int64_t position = stream->position();
+		if (!this->receiveFrom(stream, host, port))
+		{
+			return false;
+		}
+		if (stream->position() != position)
+		{
+			hstr hostString = host.toString();
+			int size = hmin(hostString.size(), addressSize - 2);
+			address[0] = (unsigned char)(port >> 8);
+			address[1] = (unsigned char)(port & 0xFF);
+			memcpy(&address[2], hostString.cStr(), size);
+			addressSize = size + 2;
+		}
 		return true;
 	}
 
+	bool PlatformSocket::sendToAddress(const unsigned char* address, int addressSize, hstream* stream, int& count, int& sent)
+	{
+		Host host;
+		unsigned short port = 0;
+		if (!PlatformSocket::getAddressHostPort(address, addressSize, host, port))
+		{
+			return false;
+		}
+		HostName^ hostName = PlatformSocket::_makeHostName(host);
+		if (hostName == nullptr)
+		{
+			return false;
+		}
+		IOutputStream^ udpStream = this->udpStream;
+		bool result = (this->_setUdpHost(hostName, port) && this->send(stream, count, sent));
+		this->udpStream = udpStream;
+		return result;
+	}
+
 	bool PlatformSocket::_readStream(hstream* stream, int& maxCount, hmutex* mutex, IInputStream^ inputStream)
 	{
 		// this workaround is required due to the fact that IAsyncOperationWithProgress::Completed could be fire upon assignment and then a mutex deadlock would occur
@@ -544,6 +700,7 @@ namespace sakit
 							reader->ReadBytes(_data);
 							hmutex::ScopeLock _lock(&this->_mutexReceiveStream);
 							this->_receiveStream.writeRaw(_data->Data, _data->Length);
+							this->metrics->addReceiveCall(_data->Length, false);
 						}
 						catch (Platform::OutOfBoundsException^ e)
 						{
@@ -658,6 +815,17 @@ namespace sakit
 		return (unsigned short)(int)PlatformSocket::_resolve(Host::Any.toString(), serviceName, false, true);
 	}
 
+	bool PlatformSocket::getAddressHostPort(const unsigned char* address, int addressSize, Host& host, unsigned short& port)
+	{
+		if (addressSize < 2)
+		{
+			return false;
+		}
+		port = (unsigned short)((address[0] << 8) | address[1]);
+		host = Host(hstr((const char*)&address[2], addressSize - 2));
+		return true;
+	}
+
 	hstr PlatformSocket::_resolve(chstr host, chstr serviceName, bool wantIp, bool wantPort)
 	{
 		Windows::Networking::HostName^ hostName = nullptr;
@@ -18,9 +18,18 @@ namespace sakit
 {
 	ReceiverThread::ReceiverThread(PlatformSocket* socket, float* timeout, float* retryFrequency) :
 		TimedThread(socket, timeout, retryFrequency),
-		maxValue(0)
+		maxValue(0),
+		resultReady(false)
 	{
 		this->name = "SAKit receiver";
 	}
 
+	void ReceiverThread::_setResult(State value)
+	{
+		hmutex::ScopeLock lock(&this->resultMutex);
+		this->result = value;
+		// everything the thread queued before is visible to whoever sees this flag
+		this->resultReady.store(true, std::memory_order_release);
+	}
+
 }
@@ -13,6 +13,8 @@
 #ifndef SAKIT_RECEIVER_THREAD_H
 #define SAKIT_RECEIVER_THREAD_H
 
+#include <atomic>
+
 #include <hltypes/hltypesUtil.h>
 #include <hltypes/hmutex.h>
 #include <hltypes/hstream.h>
@@ -34,6 +36,10 @@ namespace sakit
 
 	protected:
 		int maxValue;
+		/// @brief Set after the thread stored its final result, so polling a running receiver doesn't need the result mutex.
+		std::atomic<bool> resultReady;
+
+		void _setResult(State value);
 
 	};
 
@@ -11,6 +11,7 @@
 #include <hltypes/hstream.h>
 #include <hltypes/hthread.h>
 
+#include "Metrics.h"
 #include "PlatformSocket.h"
 #include "sakit.h"
 #include "SocketDelegate.h"
@@ -20,20 +21,24 @@ namespace sakit
 {
 	SenderThread::SenderThread(PlatformSocket* socket, float* timeout, float* retryFrequency) :
 		TimedThread(socket, timeout, retryFrequency),
-		sentCount(0)
+		sentCount(0),
+		queuing(false),
+		pendingSize(0LL)
 	{
 		this->name = "SAKit sender";
 		this->stream = new hstream();
+		this->queue = new hstream();
 	}
 
 	SenderThread::~SenderThread()
 	{
 		delete this->stream;
+		delete this->queue;
 	}
 
 	void SenderThread::_updateProcess()
 	{
-		int count = (int)this->stream->size();
+		int count = this->_getNextCount();
 		int sent = 0;
 		hmutex::ScopeLock lock;
 		while (this->isRunning() && this->executing)
@@ -41,25 +46,99 @@ namespace sakit
 			sent = 0;
 			if (!this->socket->send(this->stream, count, sent))
 			{
-				lock.acquire(&this->resultMutex);
-				this->result = State::Failed;
-				lock.release();
-				this->stream->clear();
+				this->_finish(State::Failed);
 				return;
 			}
 			lock.acquire(&this->sentCountMutex);
 			this->sentCount += sent;
 			lock.release();
-			if (this->stream->eof())
+			this->_addPendingSize(-sent);
+			if (count == 0 || this->stream->eof())
 			{
-				break;
+				if (this->stream->eof() && !this->_takeQueue())
+				{
+					return;
+				}
+				// the next datagram or the queued data can be sent right away
+				count = this->_getNextCount();
+				continue;
 			}
 			hthread::sleep(*this->retryFrequency * 1000.0f);
 		}
-		lock.acquire(&this->resultMutex);
-		this->result = State::Finished;
-		lock.release();
+		this->_finish(State::Finished);
+	}
+
+	void SenderThread::_write(hstream* target, harray<int>& targetSizes, hstream* stream, int count, const unsigned char* header, int headerSize, const unsigned char* trailer, int trailerSize)
+	{
+		if (headerSize > 0)
+		{
+			target->writeRaw(header, headerSize);
+		}
+		target->writeRaw(*stream, count);
+		if (trailerSize > 0)
+		{
+			target->writeRaw(trailer, trailerSize);
+		}
+		// datagrams must keep their boundaries, stream data is simply sent as a whole
+		if (this->socket->isConnectionLess())
+		{
+			targetSizes += headerSize + count + trailerSize;
+		}
+		this->_addPendingSize(headerSize + count + trailerSize);
+	}
+
+	void SenderThread::_addPendingSize(int64_t value)
+	{
+		if (value != 0LL)
+		{
+			this->socket->getMetrics()->setSendQueueDepth(this->pendingSize.fetch_add(value) + value);
+		}
+	}
+
+	int SenderThread::_getNextCount()
+	{
+		if (this->sizes.size() > 0)
+		{
+			return this->sizes.removeFirst();
+		}
+		return (int)(this->stream->size() - this->stream->position());
+	}
+
+	bool SenderThread::_takeQueue()
+	{
+		hmutex::ScopeLock lock(&this->queueMutex);
+		if (this->queue->size() == 0)
+		{
+			this->queuing = false;
+			this->stream->clear();
+			this->sizes.clear();
+			// the result is set while the queue is still locked so a new send never sees a sender that stopped queuing but isn't finished
+			hmutex::ScopeLock lockResult(&this->resultMutex);
+			this->result = State::Finished;
+			return false;
+		}
+		hstream* stream = this->stream;
+		this->stream = this->queue;
+		this->queue = stream;
+		this->queue->clear();
+		this->stream->rewind();
+		this->sizes = this->queueSizes;
+		this->queueSizes.clear();
+		return true;
+	}
+
+	void SenderThread::_finish(State result)
+	{
+		hmutex::ScopeLock lock(&this->queueMutex);
+		this->queuing = false;
 		this->stream->clear();
+		this->sizes.clear();
+		this->queue->clear();
+		this->queueSizes.clear();
+		this->pendingSize.store(0LL);
+		this->socket->getMetrics()->setSendQueueDepth(0LL);
+		hmutex::ScopeLock lockResult(&this->resultMutex);
+		this->result = result;
 	}
 
 }
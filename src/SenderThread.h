@@ -13,7 +13,12 @@
 #ifndef SAKIT_SENDER_THREAD_H
 #define SAKIT_SENDER_THREAD_H
 
+#include <atomic>
+#include <stdint.h>
+
+#include <hltypes/harray.h>
 #include <hltypes/hltypesUtil.h>
+#include <hltypes/hmutex.h>
 #include <hltypes/hstream.h>
 
 #include "Socket.h"
@@ -34,8 +39,27 @@ namespace sakit
 
 	protected:
 		hstream* stream;
+		/// @brief Sizes of the datagrams in stream on connection-less sockets, empty on stream sockets.
+		harray<int> sizes;
 		int sentCount;
 		hmutex sentCountMutex;
+		/// @brief Data of sends issued while the thread was busy, coalesced into one stream that is sent after the current one.
+		hstream* queue;
+		/// @brief Sizes of the datagrams in queue on connection-less sockets, empty on stream sockets.
+		harray<int> queueSizes;
+		/// @brief Whether the thread will still pick up the queue, new data has to be queued then.
+		bool queuing;
+		hmutex queueMutex;
+		/// @brief Bytes in stream and queue that weren't sent yet.
+		std::atomic<int64_t> pendingSize;
+
+		void _write(hstream* target, harray<int>& targetSizes, hstream* stream, int count, const unsigned char* header, int headerSize, const unsigned char* trailer, int trailerSize);
+		void _addPendingSize(int64_t value);
+		int _getNextCount();
+		/// @brief Makes the queue the stream that is sent next.
+		/// @return False if the queue was empty, the thread is finished then.
+		bool _takeQueue();
+		void _finish(State result);
 
 		void _updateProcess() override;
 
@@ -42,7 +42,6 @@ namespace sakit
 
 	bool Server::isRunning()
 	{
-		hmutex::ScopeLock lock(&this->mutexState);
 		return (this->state == State::Running);
 	}
 
@@ -10,6 +10,7 @@
 #include <hltypes/hstream.h>
 #include <hltypes/hstring.h>
 
+#include "Metrics.h"
 #include "PlatformSocket.h"
 #include "ReceiverThread.h"
 #include "sakit.h"
@@ -19,20 +20,33 @@
 #include "SocketDelegate.h"
 #include "State.h"
 
+#define SEND_QUEUE_HIGH_WATERMARK 1048576LL
+#define SEND_QUEUE_LOW_WATERMARK 262144LL
+
 namespace sakit
 {
 	Socket::Socket(SocketDelegate* socketDelegate, State idleState) :
-		SocketBase()
+		SocketBase(),
+		sendStartTime(0LL),
+		sendQueueLimit(0LL),
+		sendQueueHighWatermark(SEND_QUEUE_HIGH_WATERMARK),
+		sendQueueLowWatermark(SEND_QUEUE_LOW_WATERMARK),
+		sendQueueHigh(false),
+		batching(false),
+		autoBatching(false),
+		batchCount(0)
 	{
 		this->socketDelegate = socketDelegate;
 		this->idleState = idleState;
 		this->sender = new SenderThread(this->socket, &this->timeout, &this->retryFrequency);
+		this->batchStream = new hstream();
 	}
 
 	Socket::~Socket()
 	{
 		this->sender->join();
 		delete this->sender;
+		delete this->batchStream;
 		if (this->receiver != NULL)
 		{
 			this->receiver->join();
@@ -42,27 +56,59 @@ namespace sakit
 
 	bool Socket::isSending()
 	{
-		hmutex::ScopeLock lock(&this->mutexState);
-		return (this->state == State::Sending || this->state == State::SendingReceiving);
+		return ((this->state.getMask() & (State::MaskSending | State::MaskSendingReceiving)) != 0);
 	}
 
 	bool Socket::isReceiving()
 	{
-		hmutex::ScopeLock lock(&this->mutexState);
-		return (this->state == State::Receiving || this->state == State::SendingReceiving);
+		return ((this->state.getMask() & (State::MaskReceiving | State::MaskSendingReceiving)) != 0);
 	}
 
 	void Socket::update(float timeDelta)
 	{
+		// the batched sends already returned successfully so the failure can only be reported here
+		if (this->autoBatching && !this->_flushBatch())
+		{
+			this->socketDelegate->onSendFailed(this);
+		}
 		this->_updateSending();
 		this->_updateReceiving();
 	}
 
+	void Socket::setSendQueueWatermarks(int64_t high, int64_t low)
+	{
+		this->sendQueueHighWatermark = hmax(high, (int64_t)0);
+		this->sendQueueLowWatermark = hclamp(low, (int64_t)0, this->sendQueueHighWatermark);
+	}
+
+	int64_t Socket::getSendQueueSize()
+	{
+		return this->sender->pendingSize.load();
+	}
+
+	void Socket::_updateSendQueue()
+	{
+		int64_t size = this->sender->pendingSize.load();
+		if (!this->sendQueueHigh)
+		{
+			if (this->sendQueueHighWatermark > 0LL && size > this->sendQueueHighWatermark)
+			{
+				this->sendQueueHigh = true;
+				this->socketDelegate->onSendQueueHigh(this);
+			}
+		}
+		else if (size <= this->sendQueueLowWatermark)
+		{
+			this->sendQueueHigh = false;
+			this->socketDelegate->onSendQueueLow(this);
+		}
+	}
+
 	void Socket::_updateSending()
 	{
+		this->_updateSendQueue();
 		int sentCount = 0;
 		hmutex::ScopeLock lock(&this->mutexState);
-		hmutex::ScopeLock lockThreadResult(&this->sender->resultMutex);
 		hmutex::ScopeLock lockThreadSentCount(&this->sender->sentCountMutex);
 		if (this->sender->sentCount > 0)
 		{
@@ -70,34 +116,44 @@ namespace sakit
 			this->sender->sentCount = 0;
 		}
 		lockThreadSentCount.release();
-		State result = this->sender->result;
-		if (result == State::Running || result == State::Idle)
-		{
-			lockThreadResult.release();
-			lock.release();
-			if (sentCount > 0)
-			{
-				this->socketDelegate->onSent(this, sentCount);
-			}
-			return;
-		}
-		this->sender->result = State::Idle;
-		this->state = (this->state == State::SendingReceiving ? State::Receiving : this->idleState);
-		lockThreadResult.release();
+		this->_collectSendResult();
+		harray<State> results = this->sendResults;
+		this->sendResults.clear();
 		lock.release();
 		if (sentCount > 0)
 		{
 			this->socketDelegate->onSent(this, sentCount);
 		}
 		// delegate calls
-		if (result == State::Finished)
+		foreach (State, it, results)
+		{
+			if ((*it) == State::Finished)
+			{
+				this->socketDelegate->onSendFinished(this);
+			}
+			else if ((*it) == State::Failed)
+			{
+				this->socketDelegate->onSendFailed(this);
+			}
+		}
+	}
+
+	void Socket::_collectSendResult()
+	{
+		hmutex::ScopeLock lockThreadResult(&this->sender->resultMutex);
+		State result = this->sender->result;
+		if (result == State::Running || result == State::Idle)
 		{
-			this->socketDelegate->onSendFinished(this);
+			return;
 		}
-		else if (result == State::Failed)
+		this->sender->result = State::Idle;
+		this->_endSending();
+		lockThreadResult.release();
+		if (result == State::Finished)
 		{
-			this->socketDelegate->onSendFailed(this);
+			this->socket->getMetrics()->addMessageSent(Metrics::getTime() - this->sendStartTime);
 		}
+		this->sendResults += result;
 	}
 
 	int Socket::send(hstream* stream, int count)
@@ -124,77 +180,247 @@ namespace sakit
 		{
 			return false;
 		}
-		hmutex::ScopeLock lock(&this->mutexState);
-		if (!this->_canSend(this->state))
+		if (!this->_checkBatchEmpty())
 		{
 			return false;
 		}
-		this->state = (this->state == State::Receiving ? State::SendingReceiving : State::Sending);
-		lock.release();
+		if (!this->_beginSending())
+		{
+			return false;
+		}
+		int64_t startTime = Metrics::getTime();
 		int result = this->_sendDirect(stream, count);
-		lock.acquire(&this->mutexState);
-		this->state = (this->state == State::SendingReceiving ? State::Receiving : this->idleState);
+		if (result > 0)
+		{
+			this->socket->getMetrics()->addMessageSent(Metrics::getTime() - startTime);
+		}
+		this->_endSending();
 		return result;
 	}
 
 	bool Socket::sendAsync(hstream* stream, int count)
+	{
+		return this->_sendAsync(stream, count);
+	}
+
+	bool Socket::_sendAsync(hstream* stream, int count, const unsigned char* header, int headerSize, const unsigned char* trailer, int trailerSize)
 	{
 		if (!this->_checkSendParameters(stream, count))
 		{
 			return false;
 		}
-		hmutex::ScopeLock lock(&this->mutexState);
-		hmutex::ScopeLock lockThreadResult(&this->sender->resultMutex);
-		if (!this->_canSend(this->state))
+		// batched data has to be rejected right away, a flush much later couldn't report it to the caller
+		if (!this->isSending() && !this->_canSend(this->state))
 		{
 			return false;
 		}
-		this->state = (this->state == State::Receiving ? State::SendingReceiving : State::Sending);
-		this->sender->result = State::Running;
+		count = (int)hmin((int64_t)count, stream->size() - stream->position());
+		if (this->_addToBatch((const unsigned char*)&(*stream)[(int)stream->position()], count, header, headerSize, trailer, trailerSize))
+		{
+			stream->seek(count);
+			return true;
+		}
+		return this->_sendAsyncDirect(stream, count, header, headerSize, trailer, trailerSize);
+	}
+
+	bool Socket::_sendAsyncDirect(hstream* stream, int count, const unsigned char* header, int headerSize, const unsigned char* trailer, int trailerSize)
+	{
+		hmutex::ScopeLock lockQueue(&this->sender->queueMutex);
+		if (!this->sender->queuing && this->isSending())
+		{
+			// a sender that finished but wasn't processed by update() yet mustn't make this send fail, the delegate is
+			// still only called from update() so delegate callbacks can't run inside of this call
+			lockQueue.release();
+			hmutex::ScopeLock lock(&this->mutexState);
+			this->_collectSendResult();
+			lock.release();
+			lockQueue.acquire(&this->sender->queueMutex);
+		}
+		if (this->sender->queuing)
+		{
+			if (this->sendQueueLimit > 0LL && this->sender->pendingSize.load() + headerSize + count + trailerSize > this->sendQueueLimit)
+			{
+				hlog::warn(logTag, "Cannot send, send queue is full!");
+				return false;
+			}
+			this->sender->_write(this->sender->queue, this->sender->queueSizes, stream, count, header, headerSize, trailer, trailerSize);
+			return true;
+		}
+		lockQueue.release();
+		if (!this->_beginSending())
+		{
+			return false;
+		}
+		lockQueue.acquire(&this->sender->queueMutex);
 		this->sender->stream->clear();
-		this->sender->stream->writeRaw(*stream, (int)hmin((int64_t)count, stream->size() - stream->position()));
+		this->sender->sizes.clear();
+		this->sender->_write(this->sender->stream, this->sender->sizes, stream, count, header, headerSize, trailer, trailerSize);
 		this->sender->stream->rewind();
+		this->sender->queuing = true;
+		lockQueue.release();
+		hmutex::ScopeLock lockThreadResult(&this->sender->resultMutex);
+		this->sender->result = State::Running;
+		this->sendStartTime = Metrics::getTime();
 		this->sender->start();
 		return true;
 	}
 
-	bool Socket::_prepareReceive(hstream* stream)
+	bool Socket::beginBatch()
 	{
-		bool result = false;
-		if (this->_checkReceiveParameters(stream))
+		if (this->socket->isConnectionLess())
 		{
-			hmutex::ScopeLock lock(&this->mutexState);
-			result = this->_canReceive(this->state);
-			if (result)
-			{
-				this->state = (this->state == State::Sending ? State::SendingReceiving : State::Receiving);
-			}
+			hlog::warn(logTag, "Cannot batch sends, datagrams have to be sent separately!");
+			return false;
+		}
+		this->batching.store(true, std::memory_order_relaxed);
+		return true;
+	}
+
+	bool Socket::flushBatch()
+	{
+		if (!this->batching.load(std::memory_order_relaxed))
+		{
+			hlog::warn(logTag, "Cannot flush, no batch was started!");
+			return false;
+		}
+		this->batching.store(this->autoBatching, std::memory_order_relaxed);
+		return this->_flushBatch();
+	}
+
+	void Socket::setAutoBatching(bool value)
+	{
+		if (value && !this->beginBatch())
+		{
+			return;
+		}
+		this->autoBatching = value;
+		if (!value && this->batching.load(std::memory_order_relaxed))
+		{
+			this->flushBatch();
+		}
+	}
+
+	bool Socket::_addToBatch(const unsigned char* data, int count, const unsigned char* header, int headerSize, const unsigned char* trailer, int trailerSize)
+	{
+		if (!this->batching.load(std::memory_order_relaxed))
+		{
+			return false;
+		}
+		hmutex::ScopeLock lock(&this->mutexBatch);
+		if (headerSize > 0)
+		{
+			this->batchStream->writeRaw(header, headerSize);
+		}
+		this->batchStream->writeRaw(data, count);
+		if (trailerSize > 0)
+		{
+			this->batchStream->writeRaw(trailer, trailerSize);
+		}
+		++this->batchCount;
+		return true;
+	}
+
+	bool Socket::_checkBatchEmpty()
+	{
+		hmutex::ScopeLock lock(&this->mutexBatch);
+		if (this->batchStream->size() > 0)
+		{
+			hlog::warn(logTag, "Cannot send synchronously, batched data has to be flushed first!");
+			return false;
 		}
+		return true;
+	}
+
+	bool Socket::_flushBatch()
+	{
+		hmutex::ScopeLock lock(&this->mutexBatch);
+		if (this->batchStream->size() == 0)
+		{
+			return true;
+		}
+		// the batch is taken out so sends during the delegate calls of the flush can start a new one
+		hstream* stream = this->batchStream;
+		int count = this->batchCount;
+		this->batchStream = new hstream();
+		this->batchCount = 0;
+		lock.release();
+		stream->rewind();
+		bool result = this->_sendAsyncDirect(stream, (int)stream->size());
+		if (result)
+		{
+			this->socket->getMetrics()->addBatchFlush(count);
+		}
+		delete stream;
 		return result;
 	}
 
+	bool Socket::_prepareReceive(hstream* stream)
+	{
+		return (this->_checkReceiveParameters(stream) && this->_beginReceiving());
+	}
+
 	int Socket::_finishReceive(int result)
 	{
-		hmutex::ScopeLock lock(&this->mutexState);
-		this->state = (this->state == State::SendingReceiving ? State::Sending : this->idleState);
+		this->_endReceiving();
 		return result;
 	}
 
 	bool Socket::_startReceiveAsync(int maxValue)
 	{
-		hmutex::ScopeLock lock(&this->mutexState);
-		hmutex::ScopeLock lockThreadResult(&this->receiver->resultMutex);
-		if (!this->_canReceive(this->state))
+		if (!this->_beginReceiving())
 		{
 			return false;
 		}
-		this->state = (this->state == State::Sending ? State::SendingReceiving : State::Receiving);
+		hmutex::ScopeLock lockThreadResult(&this->receiver->resultMutex);
 		this->receiver->result = State::Running;
+		this->receiver->resultReady.store(false, std::memory_order_relaxed);
 		this->receiver->maxValue = maxValue;
 		this->receiver->start();
 		return true;
 	}
 
+	bool Socket::_beginSending()
+	{
+		State current = this->state;
+		do
+		{
+			if (!this->_canSend(current))
+			{
+				return false;
+			}
+		} while (!this->state.compareExchange(current, current == State::Receiving ? State::SendingReceiving : State::Sending));
+		return true;
+	}
+
+	void Socket::_endSending()
+	{
+		State current = this->state;
+		while (!this->state.compareExchange(current, current == State::SendingReceiving ? State::Receiving : this->idleState))
+		{
+		}
+	}
+
+	bool Socket::_beginReceiving()
+	{
+		State current = this->state;
+		do
+		{
+			if (!this->_canReceive(current))
+			{
+				return false;
+			}
+		} while (!this->state.compareExchange(current, current == State::Sending ? State::SendingReceiving : State::Receiving));
+		return true;
+	}
+
+	void Socket::_endReceiving()
+	{
+		State current = this->state;
+		while (!this->state.compareExchange(current, current == State::SendingReceiving ? State::Sending : this->idleState))
+		{
+		}
+	}
+
 	bool Socket::stopReceive()
 	{
 		hmutex::ScopeLock lock(&this->mutexState);
@@ -233,14 +459,12 @@ namespace sakit
 
 	bool Socket::_canSend(State state)
 	{
-		harray<State> allowed = State::allowedSendStatesBasic + this->idleState;
-		return _checkState(state, allowed, "send");
+		return _checkState(state, State::allowedSendStatesBasic | this->idleState.getMask(), "send");
 	}
 
 	bool Socket::_canReceive(State state)
 	{
-		harray<State> allowed = State::allowedReceiveStatesBasic + this->idleState;
-		return _checkState(state, allowed, "receive");
+		return _checkState(state, State::allowedReceiveStatesBasic | this->idleState.getMask(), "receive");
 	}
 
 	bool Socket::_canStopReceive(State state)
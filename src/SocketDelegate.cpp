@@ -30,6 +30,14 @@ namespace sakit
 	{
 	}
 
+	void SocketDelegate::onSendQueueHigh(Socket* socket)
+	{
+	}
+
+	void SocketDelegate::onSendQueueLow(Socket* socket)
+	{
+	}
+
 	void SocketDelegate::onReceiveFinished(Socket* socket)
 	{
 	}
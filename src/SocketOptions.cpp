@@ -0,0 +1,62 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/harray.h>
+#include <hltypes/hstring.h>
+
+#include "SocketOptions.h"
+
+#define _ADD_OPTION(name) \
+	if (this->name != Unset) \
+	{ \
+		result += hstr(#name) + "=" + hstr(this->name); \
+	}
+
+namespace sakit
+{
+	const int SocketOptions::Unset = -1;
+
+	SocketOptions::SocketOptions() :
+		receiveBufferSize(Unset),
+		sendBufferSize(Unset),
+		busyPoll(Unset),
+		quickAck(Unset),
+		cork(Unset),
+		notSentLowWatermark(Unset),
+		keepAlive(Unset),
+		keepAliveIdle(Unset),
+		keepAliveInterval(Unset),
+		keepAliveCount(Unset),
+		userTimeout(Unset),
+		typeOfService(Unset)
+	{
+	}
+
+	SocketOptions::~SocketOptions()
+	{
+	}
+
+	hstr SocketOptions::toString() const
+	{
+		harray<hstr> result;
+		_ADD_OPTION(receiveBufferSize);
+		_ADD_OPTION(sendBufferSize);
+		_ADD_OPTION(busyPoll);
+		_ADD_OPTION(quickAck);
+		_ADD_OPTION(cork);
+		_ADD_OPTION(notSentLowWatermark);
+		_ADD_OPTION(keepAlive);
+		_ADD_OPTION(keepAliveIdle);
+		_ADD_OPTION(keepAliveInterval);
+		_ADD_OPTION(keepAliveCount);
+		_ADD_OPTION(userTimeout);
+		_ADD_OPTION(typeOfService);
+		return result.joined(", ");
+	}
+
+}
@@ -0,0 +1,97 @@
+/// @file
+/// @version 1.2
+///
+/// @section LICENSE
+///
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+///
+/// @section DESCRIPTION
+///
+/// Defines a bounded lock-free queue for handing data from one thread to another.
+
+#ifndef SAKIT_SPSC_QUEUE_H
+#define SAKIT_SPSC_QUEUE_H
+
+#include <atomic>
+
+namespace sakit
+{
+	/// @brief Ring buffer for exactly one producer thread and one consumer thread.
+	/// @note The capacity is rounded up to a power of 2. Queued pointers are not deleted on destruction.
+	template <typename T>
+	class SpscQueue
+	{
+	public:
+		SpscQueue(int capacity) :
+			head(0),
+			tail(0)
+		{
+			this->capacity = 1;
+			while (this->capacity < capacity)
+			{
+				this->capacity <<= 1;
+			}
+			this->items = new T[this->capacity];
+		}
+
+		~SpscQueue()
+		{
+			delete[] this->items;
+		}
+
+		int getCapacity() const
+		{
+			return this->capacity;
+		}
+
+		/// @note Exact only on the consumer thread, the producer may have added items in the meantime.
+		bool isEmpty() const
+		{
+			return (this->head.load(std::memory_order_acquire) == this->tail.load(std::memory_order_relaxed));
+		}
+
+		/// @note Must only be called by the producer thread.
+		/// @return False if the queue is full.
+		bool push(const T& item)
+		{
+			unsigned int head = this->head.load(std::memory_order_relaxed);
+			if (head - this->tail.load(std::memory_order_acquire) >= (unsigned int)this->capacity)
+			{
+				return false;
+			}
+			this->items[head & (this->capacity - 1)] = item;
+			this->head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		/// @note Must only be called by the consumer thread.
+		/// @return False if the queue is empty.
+		bool pop(T& item)
+		{
+			unsigned int tail = this->tail.load(std::memory_order_relaxed);
+			if (tail == this->head.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+			item = this->items[tail & (this->capacity - 1)];
+			this->tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+	protected:
+		T* items;
+		int capacity;
+		/// @brief Written only by the producer.
+		std::atomic<unsigned int> head;
+		char padding[64]; // keeps the producer and consumer indices on separate cache lines
+		/// @brief Written only by the consumer.
+		std::atomic<unsigned int> tail;
+
+	private:
+		SpscQueue(const SpscQueue& other); // prevents copying
+
+	};
+
+}
+#endif
@@ -12,34 +12,100 @@ namespace sakit
 {
 	HL_ENUM_CLASS_DEFINE(State,
 	(
-		HL_ENUM_DEFINE(State, Idle);
-		HL_ENUM_DEFINE(State, Binding);
-		HL_ENUM_DEFINE(State, Bound);
-		HL_ENUM_DEFINE(State, Unbinding);
-		HL_ENUM_DEFINE(State, Connecting);
-		HL_ENUM_DEFINE(State, Connected);
-		HL_ENUM_DEFINE(State, Disconnecting);
-		HL_ENUM_DEFINE(State, Running);
-		HL_ENUM_DEFINE(State, Sending);
-		HL_ENUM_DEFINE(State, Receiving);
-		HL_ENUM_DEFINE(State, SendingReceiving);
-		HL_ENUM_DEFINE(State, Finished);
-		HL_ENUM_DEFINE(State, Failed);
-
-		harray<State> State::allowedBindStates;
-		harray<State> State::allowedUnbindStates;
-		harray<State> State::allowedConnectStates;
-		harray<State> State::allowedDisconnectStates;
-		harray<State> State::allowedSendStatesBasic;
-		harray<State> State::allowedReceiveStatesBasic;
-		harray<State> State::allowedStopReceiveStates;
-		harray<State> State::allowedSetDestinationStates;
-		harray<State> State::allowedJoinMulticastGroupStates;
-		harray<State> State::allowedLeaveMulticastGroupStates;
-		harray<State> State::allowedServerStartStates;
-		harray<State> State::allowedServerStopStates;
-		harray<State> State::allowedHttpExecuteStates;
-		harray<State> State::allowedHttpAbortStates;
+		HL_ENUM_DEFINE_VALUE(State, Idle, 0);
+		HL_ENUM_DEFINE_VALUE(State, Binding, 1);
+		HL_ENUM_DEFINE_VALUE(State, Bound, 2);
+		HL_ENUM_DEFINE_VALUE(State, Unbinding, 3);
+		HL_ENUM_DEFINE_VALUE(State, Connecting, 4);
+		HL_ENUM_DEFINE_VALUE(State, Connected, 5);
+		HL_ENUM_DEFINE_VALUE(State, Disconnecting, 6);
+		HL_ENUM_DEFINE_VALUE(State, Running, 7);
+		HL_ENUM_DEFINE_VALUE(State, Sending, 8);
+		HL_ENUM_DEFINE_VALUE(State, Receiving, 9);
+		HL_ENUM_DEFINE_VALUE(State, SendingReceiving, 10);
+		HL_ENUM_DEFINE_VALUE(State, Finished, 11);
+		HL_ENUM_DEFINE_VALUE(State, Failed, 12);
+
+		constexpr unsigned int State::allowedBindStates;
+		constexpr unsigned int State::allowedUnbindStates;
+		constexpr unsigned int State::allowedConnectStates;
+		constexpr unsigned int State::allowedDisconnectStates;
+		constexpr unsigned int State::allowedSendStatesBasic;
+		constexpr unsigned int State::allowedReceiveStatesBasic;
+		constexpr unsigned int State::allowedStopReceiveStates;
+		constexpr unsigned int State::allowedSetDestinationStates;
+		constexpr unsigned int State::allowedJoinMulticastGroupStates;
+		constexpr unsigned int State::allowedLeaveMulticastGroupStates;
+		constexpr unsigned int State::allowedServerStartStates;
+		constexpr unsigned int State::allowedServerStopStates;
+		constexpr unsigned int State::allowedHttpExecuteStates;
+		constexpr unsigned int State::allowedHttpAbortStates;
 
 	));
+
+	// indexed by the state values
+	static const State* const states[] =
+	{
+		&State::Idle,
+		&State::Binding,
+		&State::Bound,
+		&State::Unbinding,
+		&State::Connecting,
+		&State::Connected,
+		&State::Disconnecting,
+		&State::Running,
+		&State::Sending,
+		&State::Receiving,
+		&State::SendingReceiving,
+		&State::Finished,
+		&State::Failed
+	};
+
+	AtomicState::AtomicState() :
+		value(State::Idle.value)
+	{
+	}
+
+	AtomicState::AtomicState(const State& state) :
+		value(state.value)
+	{
+	}
+
+	State AtomicState::get() const
+	{
+		return *states[this->value.load(std::memory_order_acquire)];
+	}
+
+	unsigned int AtomicState::getMask() const
+	{
+		return (1u << this->value.load(std::memory_order_acquire));
+	}
+
+	bool AtomicState::compareExchange(State& expected, const State& desired)
+	{
+		unsigned int current = expected.value;
+		if (this->value.compare_exchange_strong(current, desired.value, std::memory_order_acq_rel, std::memory_order_acquire))
+		{
+			return true;
+		}
+		expected = *states[current];
+		return false;
+	}
+
+	AtomicState& AtomicState::operator=(const State& other)
+	{
+		this->value.store(other.value, std::memory_order_release);
+		return (*this);
+	}
+
+	bool AtomicState::operator==(const State& other) const
+	{
+		return (this->value.load(std::memory_order_acquire) == other.value);
+	}
+
+	bool AtomicState::operator!=(const State& other) const
+	{
+		return (this->value.load(std::memory_order_acquire) != other.value);
+	}
+
 }
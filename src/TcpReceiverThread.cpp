@@ -9,45 +9,151 @@
 #include <hltypes/hstream.h>
 #include <hltypes/hthread.h>
 
+#include "Metrics.h"
 #include "PlatformSocket.h"
 #include "sakit.h"
 #include "SocketDelegate.h"
 #include "TcpReceiverThread.h"
 
+#define QUEUE_CAPACITY 64
+#define HIGH_WATERMARK 16777216LL
+#define LOW_WATERMARK 4194304LL
+
 namespace sakit
 {
 	TcpReceiverThread::TcpReceiverThread(PlatformSocket* socket, float* timeout, float* retryFrequency) :
-		ReceiverThread(socket, timeout, retryFrequency)
+		ReceiverThread(socket, timeout, retryFrequency),
+		streams(QUEUE_CAPACITY),
+		queuedSize(0LL),
+		remainder(NULL),
+		highWatermark(HIGH_WATERMARK),
+		lowWatermark(LOW_WATERMARK),
+		paused(false)
 	{
 		this->name = "SAKit TCP receiver";
-		this->stream = new hstream();
 	}
 
 	TcpReceiverThread::~TcpReceiverThread()
 	{
-		delete this->stream;
+		hstream* stream = this->_dequeue(true);
+		if (stream != NULL)
+		{
+			delete stream;
+		}
 	}
 
 	void TcpReceiverThread::_updateProcess()
 	{
 		int remaining = this->maxValue;
-		hmutex::ScopeLock lock;
+		hstream* stream = new hstream();
+		this->paused.store(false, std::memory_order_relaxed);
 		while (this->isRunning() && this->executing)
 		{
-			if (!this->socket->receive(this->stream, remaining, &this->streamMutex))
+			// while the queue is full or over the watermark nothing is read, the data waits in the OS buffer and TCP flow control slows down the peer
+			if (!this->_updatePaused() && this->_queue(stream))
 			{
-				lock.acquire(&this->resultMutex);
-				this->result = State::Failed;
-				return;
+				if (!this->socket->receive(stream, remaining))
+				{
+					this->_finish(stream, State::Failed);
+					return;
+				}
+				this->_queue(stream);
+				if (this->maxValue > 0 && remaining == 0)
+				{
+					break;
+				}
 			}
-			if (this->maxValue > 0 && remaining == 0)
+			hthread::sleep(*this->retryFrequency * 1000.0f);
+		}
+		this->_finish(stream, State::Finished);
+	}
+
+	bool TcpReceiverThread::_queue(hstream*& stream)
+	{
+		int64_t size = stream->size();
+		if (size == 0)
+		{
+			return true;
+		}
+		if (!this->streams.push(stream))
+		{
+			return false;
+		}
+		this->queuedSize.fetch_add(size);
+		this->socket->getMetrics()->addReceiveQueueDepth(size);
+		stream = new hstream();
+		return true;
+	}
+
+	void TcpReceiverThread::_finish(hstream* stream, State result)
+	{
+		if (this->_queue(stream))
+		{
+			delete stream;
+		}
+		else
+		{
+			this->remainder = stream;
+		}
+		this->_setResult(result);
+	}
+
+	bool TcpReceiverThread::_updatePaused()
+	{
+		int64_t size = this->queuedSize.load(std::memory_order_relaxed);
+		int64_t high = this->highWatermark.load(std::memory_order_relaxed);
+		int64_t globalSize = Metrics::global.getReceiveQueueDepth();
+		int64_t globalHigh = sakit::getGlobalReceiveHighWatermark();
+		if (this->paused.load(std::memory_order_relaxed))
+		{
+			if ((high <= 0LL || size <= this->lowWatermark.load(std::memory_order_relaxed)) &&
+				(globalHigh <= 0LL || size == 0LL || globalSize <= sakit::getGlobalReceiveLowWatermark()))
 			{
-				break;
+				this->paused.store(false, std::memory_order_release);
 			}
-			hthread::sleep(*this->retryFrequency * 1000.0f);
 		}
-		lock.acquire(&this->resultMutex);
-		this->result = State::Finished;
+		// only sockets with waiting data are paused by the global limit so every paused socket gets drained by update()
+		else if ((high > 0LL && size > high) || (globalHigh > 0LL && size > 0LL && globalSize > globalHigh))
+		{
+			this->paused.store(true, std::memory_order_release);
+		}
+		return this->paused.load(std::memory_order_relaxed);
+	}
+
+	hstream* TcpReceiverThread::_dequeue(bool finished)
+	{
+		hstream* result = NULL;
+		hstream* stream = NULL;
+		int64_t size = 0LL;
+		while (this->streams.pop(stream) || (finished && this->remainder != NULL))
+		{
+			if (stream == NULL)
+			{
+				stream = this->remainder;
+				this->remainder = NULL;
+			}
+			else
+			{
+				size += stream->size();
+			}
+			if (result == NULL)
+			{
+				result = stream;
+			}
+			else
+			{
+				stream->rewind();
+				result->writeRaw(*stream);
+				delete stream;
+			}
+			stream = NULL;
+		}
+		if (size > 0LL)
+		{
+			this->queuedSize.fetch_sub(size);
+			this->socket->getMetrics()->addReceiveQueueDepth(-size);
+		}
+		return result;
 	}
 
 }
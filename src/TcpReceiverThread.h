@@ -19,6 +19,7 @@
 
 #include "Socket.h"
 #include "ReceiverThread.h"
+#include "SpscQueue.h"
 
 namespace sakit
 {
@@ -34,8 +35,27 @@ namespace sakit
 		~TcpReceiverThread();
 
 	protected:
-		hstream* stream;
-		hmutex streamMutex;
+		/// @brief Received chunks, handed to TcpSocket::_updateReceiving() without locking.
+		SpscQueue<hstream*> streams;
+		/// @brief Size of all queued chunks.
+		std::atomic<int64_t> queuedSize;
+		/// @brief Data that didn't fit into the queue when the thread stopped, may only be accessed after resultReady was set.
+		hstream* remainder;
+		/// @brief Reading stops when queuedSize exceeds this, 0 means unlimited.
+		std::atomic<int64_t> highWatermark;
+		/// @brief Reading continues when queuedSize drops to this.
+		std::atomic<int64_t> lowWatermark;
+		/// @brief Whether reading is paused by the per-socket or global watermarks.
+		std::atomic<bool> paused;
+
+		bool _queue(hstream*& stream);
+		void _finish(hstream* stream, State result);
+		/// @brief Takes all queued chunks, called by the consumer only.
+		/// @param[in] finished Whether resultReady was set, the remainder is only taken then.
+		/// @return All queued data joined into one stream or NULL if there was none.
+		hstream* _dequeue(bool finished);
+		/// @return Whether reading has to pause, with hysteresis between the high and low watermarks.
+		bool _updatePaused();
 
 		void _updateProcess() override;
 
@@ -24,9 +24,9 @@ namespace sakit
 	TcpServer::TcpServer(TcpServerDelegate* tcpServerDelegate, TcpSocketDelegate* acceptedDelegate) :
 		Server(dynamic_cast<ServerDelegate*>(tcpServerDelegate))
 	{
-		this->serverThread = this->tcpServerThread = new TcpServerThread(this->socket, this->acceptedDelegate, &this->timeout, &this->retryFrequency);
 		this->tcpServerDelegate = tcpServerDelegate;
 		this->acceptedDelegate = acceptedDelegate;
+		this->serverThread = this->tcpServerThread = new TcpServerThread(this->socket, this->acceptedDelegate, &this->acceptedOptions, &this->timeout, &this->retryFrequency);
 		this->socket->setConnectionLess(false);
 		this->__register();
 	}
@@ -83,6 +83,7 @@ namespace sakit
 		this->state = State::Running;
 		lock.release();
 		TcpSocket* tcpSocket = new TcpSocket(this->acceptedDelegate);
+		tcpSocket->setOptions(this->acceptedOptions);
 		hmutex::ScopeLock lockUpdate(&updateMutex);
 		lock.acquire(&connectionsMutex);
 		connections -= tcpSocket;
@@ -22,11 +22,12 @@ namespace sakit
 	extern hmutex connectionsMutex;
 	extern hmutex updateMutex;
 
-	TcpServerThread::TcpServerThread(PlatformSocket* socket, TcpSocketDelegate* acceptedDelegate, float* timeout, float* retryFrequency) :
+	TcpServerThread::TcpServerThread(PlatformSocket* socket, TcpSocketDelegate* acceptedDelegate, SocketOptions* acceptedOptions, float* timeout, float* retryFrequency) :
 		TimedThread(socket, timeout, retryFrequency)
 	{
 		this->name = "SAKit TCP server";
 		this->acceptedDelegate = acceptedDelegate;
+		this->acceptedOptions = acceptedOptions;
 	}
 
 	TcpServerThread::~TcpServerThread()
@@ -44,6 +45,7 @@ namespace sakit
 	void TcpServerThread::_updateProcess()
 	{
 		TcpSocket* tcpSocket = new TcpSocket(this->acceptedDelegate);
+		tcpSocket->setOptions(*this->acceptedOptions);
 		hmutex::ScopeLock lockUpdate(&updateMutex);
 		hmutex::ScopeLock lock(&connectionsMutex);
 		connections -= tcpSocket;
@@ -65,6 +67,7 @@ namespace sakit
 				this->sockets += tcpSocket;
 				lock.release();
 				tcpSocket = new TcpSocket(this->acceptedDelegate);
+				tcpSocket->setOptions(*this->acceptedOptions);
 				lockUpdate.acquire(&updateMutex);
 				lock.acquire(&connectionsMutex);
 				connections -= tcpSocket;
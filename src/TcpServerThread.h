@@ -17,6 +17,7 @@
 #include <hltypes/hltypesUtil.h>
 
 #include "Server.h"
+#include "SocketOptions.h"
 #include "TimedThread.h"
 
 namespace sakit
@@ -29,13 +30,16 @@ namespace sakit
 	class TcpServerThread : public TimedThread
 	{
 	public:
+		friend class HttpServer;
 		friend class TcpServer;
+		friend class WebSocketServer;
 
-		TcpServerThread(PlatformSocket* socket, TcpSocketDelegate* acceptedDelegate, float* timeout, float* retryFrequency);
+		TcpServerThread(PlatformSocket* socket, TcpSocketDelegate* acceptedDelegate, SocketOptions* acceptedOptions, float* timeout, float* retryFrequency);
 		~TcpServerThread();
 
 	protected:
 		TcpSocketDelegate* acceptedDelegate;
+		SocketOptions* acceptedOptions;
 		harray<TcpSocket*> sockets;
 		hmutex socketsMutex;
 
@@ -6,12 +6,18 @@
 /// This program is free software; you can redistribute it and/or modify it under
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
+#include <string.h>
+
 #include <hltypes/hlog.h>
 #include <hltypes/hmutex.h>
 #include <hltypes/hstring.h>
 #include <hltypes/hstream.h>
+#include <hltypes/hthread.h>
 
 #include "ConnectorThread.h"
+#include "DelimiterScanner.h"
+#include "Framing.h"
+#include "Metrics.h"
 #include "PlatformSocket.h"
 #include "sakit.h"
 #include "sakitUtil.h"
@@ -20,11 +26,23 @@
 #include "TcpSocket.h"
 #include "TcpSocketDelegate.h"
 
+#define MAX_HEADER_SIZE 5
+#define MAX_VARINT_SIZE 5
+
 namespace sakit
 {
 	TcpSocket::TcpSocket(TcpSocketDelegate* socketDelegate) :
 		Socket(dynamic_cast<SocketDelegate*>(socketDelegate), State::Connected),
-		Connector(this->socket, dynamic_cast<ConnectorDelegate*>(socketDelegate))
+		Connector(this->socket, dynamic_cast<ConnectorDelegate*>(socketDelegate)),
+		statsSamplingInterval(0.0f),
+		lastStatsSampleTime(0LL),
+		statsSamplesCapacity(0),
+		statsSamplesIndex(0),
+		framing(Framing::None),
+		framingDelimiter("\n"),
+		maxMessageSize(16777216),
+		framingFailed(false),
+		receivePaused(false)
 	{
 		this->tcpSocketDelegate = socketDelegate;
 		this->socket->setConnectionLess(false);
@@ -43,25 +61,152 @@ namespace sakit
 		return this->socket->setNagleAlgorithmActive(value);
 	}
 
+	void TcpSocket::setFraming(Framing value)
+	{
+		this->framing = value;
+		this->framingBuffer.clear();
+		this->framingFailed = false;
+	}
+
+	ConnectionStats TcpSocket::getConnectionStats()
+	{
+		ConnectionStats stats;
+		this->socket->getConnectionStats(stats);
+		return stats;
+	}
+
+	void TcpSocket::startStatsSampling(float interval, int capacity)
+	{
+		hmutex::ScopeLock lock(&this->mutexStatsSamples);
+		this->statsSamplingInterval = hmax(interval, 0.001f);
+		this->statsSamplesCapacity = hmax(capacity, 1);
+		this->statsSamplesIndex = 0;
+		this->lastStatsSampleTime = 0LL;
+		this->statsSamples.clear();
+	}
+
+	void TcpSocket::stopStatsSampling()
+	{
+		hmutex::ScopeLock lock(&this->mutexStatsSamples);
+		this->statsSamplingInterval = 0.0f;
+	}
+
+	bool TcpSocket::isStatsSampling()
+	{
+		hmutex::ScopeLock lock(&this->mutexStatsSamples);
+		return (this->statsSamplingInterval > 0.0f);
+	}
+
+	harray<ConnectionStats> TcpSocket::getStatsSamples()
+	{
+		hmutex::ScopeLock lock(&this->mutexStatsSamples);
+		if (this->statsSamples.size() < this->statsSamplesCapacity)
+		{
+			return this->statsSamples;
+		}
+		// ring is full, the oldest sample is the one that gets overwritten next
+		return (this->statsSamples(this->statsSamplesIndex, this->statsSamples.size() - this->statsSamplesIndex) + this->statsSamples(0, this->statsSamplesIndex));
+	}
+
+	void TcpSocket::setReceiveWatermarks(int64_t high, int64_t low)
+	{
+		high = hmax(high, (int64_t)0);
+		this->tcpReceiver->lowWatermark.store(hclamp(low, (int64_t)0, high), std::memory_order_relaxed);
+		this->tcpReceiver->highWatermark.store(high, std::memory_order_relaxed);
+	}
+
+	int64_t TcpSocket::getReceiveHighWatermark()
+	{
+		return this->tcpReceiver->highWatermark.load(std::memory_order_relaxed);
+	}
+
+	int64_t TcpSocket::getReceiveLowWatermark()
+	{
+		return this->tcpReceiver->lowWatermark.load(std::memory_order_relaxed);
+	}
+
+	bool TcpSocket::isReceivePaused()
+	{
+		return this->tcpReceiver->paused.load(std::memory_order_relaxed);
+	}
+
 	void TcpSocket::update(float timeDelta)
 	{
 		Socket::update(timeDelta);
 		Connector::_update(timeDelta);
+		this->_updateStatsSampling();
+	}
+
+	void TcpSocket::_updateReceivePaused()
+	{
+		bool paused = this->tcpReceiver->paused.load(std::memory_order_acquire);
+		if (paused == this->receivePaused)
+		{
+			return;
+		}
+		this->receivePaused = paused;
+		if (paused)
+		{
+			this->tcpSocketDelegate->onReceivePaused(this);
+		}
+		else
+		{
+			this->tcpSocketDelegate->onReceiveResumed(this);
+		}
+	}
+
+	void TcpSocket::_updateStatsSampling()
+	{
+		hmutex::ScopeLock lock(&this->mutexStatsSamples);
+		if (this->statsSamplingInterval <= 0.0f || !this->isConnected())
+		{
+			return;
+		}
+		int64_t time = htickCount();
+		if (this->lastStatsSampleTime > 0LL && time - this->lastStatsSampleTime < (int64_t)(this->statsSamplingInterval * 1000.0f))
+		{
+			return;
+		}
+		this->lastStatsSampleTime = time;
+		ConnectionStats stats;
+		if (!this->socket->getConnectionStats(stats))
+		{
+			return;
+		}
+		if (this->statsSamples.size() < this->statsSamplesCapacity)
+		{
+			this->statsSamples += stats;
+		}
+		else
+		{
+			this->statsSamples[this->statsSamplesIndex] = stats;
+		}
+		this->statsSamplesIndex = (this->statsSamplesIndex + 1) % this->statsSamplesCapacity;
 	}
 
 	void TcpSocket::_updateReceiving()
 	{
-		hstream* stream = NULL;
-		hmutex::ScopeLock lock(&this->mutexState);
-		hmutex::ScopeLock lockThreadResult(&this->receiver->resultMutex);
-		hmutex::ScopeLock lockThreadStream(&this->tcpReceiver->streamMutex);
-		if (this->tcpReceiver->stream->size() > 0)
+		this->_updateReceivePaused();
+		// polling a receiver without new data or result costs only atomic loads
+		bool finished = this->tcpReceiver->resultReady.load(std::memory_order_acquire);
+		if (!finished && this->tcpReceiver->streams.isEmpty())
 		{
-			stream = this->tcpReceiver->stream;
-			this->tcpReceiver->stream = new hstream();
+			return;
+		}
+		hstream* stream = this->tcpReceiver->_dequeue(finished);
+		if (stream != NULL)
+		{
+			this->socket->getMetrics()->addMessageReceived();
+		}
+		hmutex::ScopeLock lock;
+		hmutex::ScopeLock lockThreadResult;
+		State result = State::Running;
+		if (finished)
+		{
+			lock.acquire(&this->mutexState);
+			lockThreadResult.acquire(&this->receiver->resultMutex);
+			result = this->receiver->result;
 		}
-		lockThreadStream.release();
-		State result = this->receiver->result;
 		if (result == State::Running || result == State::Idle)
 		{
 			lockThreadResult.release();
@@ -69,19 +214,23 @@ namespace sakit
 			if (stream != NULL)
 			{
 				stream->rewind();
-				this->tcpSocketDelegate->onReceived(this, stream);
+				this->_processReceived(stream);
 				delete stream;
 			}
 			return;
 		}
+		this->tcpReceiver->resultReady.store(false, std::memory_order_relaxed);
+		// the thread is done so a pause simply ends with it
+		this->tcpReceiver->paused.store(false, std::memory_order_relaxed);
+		this->receivePaused = false;
 		this->receiver->result = State::Idle;
-		this->state = (this->state == State::SendingReceiving ? State::Sending : this->idleState);
+		this->_endReceiving();
 		lockThreadResult.release();
 		lock.release();
 		if (stream != NULL)
 		{
 			stream->rewind();
-			this->tcpSocketDelegate->onReceived(this, stream);
+			this->_processReceived(stream);
 			delete stream;
 		}
 		// delegate calls
@@ -95,13 +244,190 @@ namespace sakit
 		}
 	}
 
+	void TcpSocket::_processReceived(hstream* stream)
+	{
+		if (this->framing == Framing::None)
+		{
+			this->tcpSocketDelegate->onReceived(this, stream);
+			return;
+		}
+		if (this->framingFailed)
+		{
+			return;
+		}
+		int offset = 0;
+		if (this->framingBuffer.size() > 0)
+		{
+			offset = this->_completeMessage(stream);
+			if (offset < 0)
+			{
+				return;
+			}
+		}
+		const unsigned char* data = (const unsigned char*)&(*stream)[0];
+		int size = (int)stream->size();
+		int messageSize = 0;
+		int payloadOffset = 0;
+		int payloadSize = 0;
+		int requiredSize = 0;
+		while (offset < size && this->framing != Framing::None && !this->framingFailed)
+		{
+			messageSize = this->_findMessage(&data[offset], size - offset, 0, payloadOffset, payloadSize, requiredSize);
+			if (messageSize < 0)
+			{
+				this->_failFraming("Received message is too large or not properly framed, receiving stopped!");
+				return;
+			}
+			if (messageSize == 0)
+			{
+				// only the beginning of an incomplete message is copied
+				this->framingBuffer.writeRaw(&data[offset], size - offset);
+				return;
+			}
+			// messages that arrived whole are delivered straight from the received data
+			stream->seek(offset + payloadOffset, hseek::Start);
+			this->tcpSocketDelegate->onReceivedMessage(this, stream, payloadSize);
+			offset += messageSize;
+		}
+	}
+
+	int TcpSocket::_completeMessage(hstream* stream)
+	{
+		const unsigned char* data = (const unsigned char*)&(*stream)[0];
+		int size = (int)stream->size();
+		int previousSize = (int)this->framingBuffer.size();
+		int payloadOffset = 0;
+		int payloadSize = 0;
+		int requiredSize = -1;
+		int searchOffset = 0;
+		if (this->framing == Framing::Delimiter)
+		{
+			// the delimiter could have been split between the old and new data
+			searchOffset = hmax(previousSize - this->framingDelimiter.size() + 1, 0);
+		}
+		else
+		{
+			this->_findMessage((const unsigned char*)&this->framingBuffer[0], previousSize, 0, payloadOffset, payloadSize, requiredSize);
+		}
+		// once the size of the message is known, only its own remaining data is copied
+		int count = (requiredSize > 0 ? hmin(requiredSize - previousSize, size) : size);
+		this->framingBuffer.writeRaw(data, count);
+		int messageSize = this->_findMessage((const unsigned char*)&this->framingBuffer[0], (int)this->framingBuffer.size(), searchOffset, payloadOffset, payloadSize, requiredSize);
+		if (messageSize < 0)
+		{
+			this->_failFraming("Received message is too large or not properly framed, receiving stopped!");
+			return -1;
+		}
+		if (messageSize == 0)
+		{
+			return count;
+		}
+		this->framingBuffer.seek(payloadOffset, hseek::Start);
+		this->tcpSocketDelegate->onReceivedMessage(this, &this->framingBuffer, payloadSize);
+		this->framingBuffer.clear();
+		// anything copied past the end of this message belongs to the following ones
+		return (messageSize - previousSize);
+	}
+
+	int TcpSocket::_findMessage(const unsigned char* data, int size, int searchOffset, int& payloadOffset, int& payloadSize, int& requiredSize)
+	{
+		payloadOffset = 0;
+		payloadSize = 0;
+		requiredSize = -1;
+		if (this->framing == Framing::Delimiter)
+		{
+			const unsigned char* delimiter = (const unsigned char*)this->framingDelimiter.cStr();
+			int delimiterSize = this->framingDelimiter.size();
+			if (delimiterSize == 0)
+			{
+				return -1;
+			}
+			int index = searchOffset;
+			int found = 0;
+			while (index <= size - delimiterSize)
+			{
+				found = DelimiterScanner::findByte(&data[index], size - delimiterSize + 1 - index, delimiter[0]);
+				if (found < 0)
+				{
+					break;
+				}
+				index += found;
+				if (memcmp(&data[index], delimiter, delimiterSize) == 0)
+				{
+					if (index > this->maxMessageSize)
+					{
+						return -1;
+					}
+					payloadSize = index;
+					return (index + delimiterSize);
+				}
+				++index;
+			}
+			return (size - delimiterSize > this->maxMessageSize ? -1 : 0);
+		}
+		unsigned int length = 0;
+		int headerSize = 0;
+		if (this->framing == Framing::Fixed32)
+		{
+			if (size < 4)
+			{
+				return 0;
+			}
+			length = (((unsigned int)data[0] << 24) | ((unsigned int)data[1] << 16) | ((unsigned int)data[2] << 8) | (unsigned int)data[3]);
+			headerSize = 4;
+		}
+		else
+		{
+			while (true)
+			{
+				if (headerSize >= size)
+				{
+					return 0;
+				}
+				// the last byte can only hold the top 4 bits of a 32 bit value
+				if (headerSize == MAX_VARINT_SIZE - 1 && (data[headerSize] & 0xF0) != 0)
+				{
+					return -1;
+				}
+				length |= ((unsigned int)(data[headerSize] & 0x7F) << (7 * headerSize));
+				++headerSize;
+				if ((data[headerSize - 1] & 0x80) == 0)
+				{
+					break;
+				}
+			}
+		}
+		if (length > (unsigned int)this->maxMessageSize)
+		{
+			return -1;
+		}
+		payloadOffset = headerSize;
+		payloadSize = (int)length;
+		requiredSize = headerSize + payloadSize;
+		return (size >= requiredSize ? requiredSize : 0);
+	}
+
+	void TcpSocket::_failFraming(chstr message)
+	{
+		hlog::warn(logTag, message);
+		this->framingBuffer.clear();
+		this->framingFailed = true;
+		this->stopReceiveAsync();
+		this->tcpSocketDelegate->onReceiveFailed(this);
+	}
+
 	int TcpSocket::receive(hstream* stream, int maxCount)
 	{
 		if (!this->_prepareReceive(stream))
 		{
 			return 0;
 		}
-		return this->_finishReceive(this->_receiveDirect(stream, maxCount));
+		int result = this->_receiveDirect(stream, maxCount);
+		if (result > 0)
+		{
+			this->socket->getMetrics()->addMessageReceived();
+		}
+		return this->_finishReceive(result);
 	}
 	
 	hstr TcpSocket::receive(int maxCount)
@@ -115,7 +441,163 @@ namespace sakit
 
 	bool TcpSocket::startReceiveAsync(int maxCount)
 	{
-		return this->_startReceiveAsync(maxCount);
+		if (!this->_startReceiveAsync(maxCount))
+		{
+			return false;
+		}
+		this->framingBuffer.clear();
+		this->framingFailed = false;
+		return true;
+	}
+
+	int TcpSocket::sendMessage(hstream* stream, int count)
+	{
+		if (!this->_checkSendParameters(stream, count))
+		{
+			return 0;
+		}
+		count = (int)hmin((int64_t)count, stream->size() - stream->position());
+		if (count <= 0)
+		{
+			hlog::warn(logTag, "Cannot send message, no data to send!");
+			return 0;
+		}
+		unsigned char header[MAX_HEADER_SIZE];
+		int headerSize = this->_makeMessageHeader(count, header);
+		if (headerSize < 0)
+		{
+			return 0;
+		}
+		int trailerSize = (this->framing == Framing::Delimiter ? this->framingDelimiter.size() : 0);
+		if (!this->_checkBatchEmpty() || !this->_beginSending())
+		{
+			return 0;
+		}
+		int64_t startTime = Metrics::getTime();
+		int result = this->_sendMessageDirect(header, headerSize, (const unsigned char*)&(*stream)[(int)stream->position()], count,
+			(const unsigned char*)this->framingDelimiter.cStr(), trailerSize);
+		if (result > 0)
+		{
+			this->socket->getMetrics()->addMessageSent(Metrics::getTime() - startTime);
+		}
+		this->_endSending();
+		return result;
+	}
+
+	int TcpSocket::sendMessage(chstr data)
+	{
+		hstream stream;
+		stream.write(data);
+		stream.rewind();
+		return this->sendMessage(&stream, (int)stream.size());
+	}
+
+	bool TcpSocket::sendMessageAsync(hstream* stream, int count)
+	{
+		if (!this->_checkSendParameters(stream, count))
+		{
+			return false;
+		}
+		unsigned char header[MAX_HEADER_SIZE];
+		int headerSize = this->_makeMessageHeader((int)hmin((int64_t)count, stream->size() - stream->position()), header);
+		if (headerSize < 0)
+		{
+			return false;
+		}
+		int trailerSize = (this->framing == Framing::Delimiter ? this->framingDelimiter.size() : 0);
+		return this->_sendAsync(stream, count, header, headerSize, (const unsigned char*)this->framingDelimiter.cStr(), trailerSize);
+	}
+
+	bool TcpSocket::sendMessageAsync(chstr data)
+	{
+		hstream stream;
+		stream.write(data);
+		stream.rewind();
+		return this->sendMessageAsync(&stream, (int)stream.size());
+	}
+
+	int TcpSocket::_makeMessageHeader(int size, unsigned char* header)
+	{
+		if (this->framing == Framing::None)
+		{
+			hlog::warn(logTag, "Cannot send message, framing is not set!");
+			return -1;
+		}
+		if (size > this->maxMessageSize)
+		{
+			hlog::warn(logTag, "Cannot send message, it exceeds the maximum message size!");
+			return -1;
+		}
+		if (this->framing == Framing::Fixed32)
+		{
+			header[0] = (unsigned char)((size >> 24) & 0xFF);
+			header[1] = (unsigned char)((size >> 16) & 0xFF);
+			header[2] = (unsigned char)((size >> 8) & 0xFF);
+			header[3] = (unsigned char)(size & 0xFF);
+			return 4;
+		}
+		if (this->framing == Framing::Varint)
+		{
+			unsigned int value = (unsigned int)size;
+			int headerSize = 0;
+			do
+			{
+				header[headerSize] = (unsigned char)(value & 0x7F);
+				value >>= 7;
+				if (value > 0)
+				{
+					header[headerSize] |= 0x80;
+				}
+				++headerSize;
+			} while (value > 0);
+			return headerSize;
+		}
+		if (this->framingDelimiter.size() == 0)
+		{
+			hlog::warn(logTag, "Cannot send message, delimiter is empty!");
+			return -1;
+		}
+		return 0;
+	}
+
+	int TcpSocket::_sendMessageDirect(const unsigned char* header, int headerSize, const unsigned char* data, int size, const unsigned char* trailer, int trailerSize)
+	{
+		const unsigned char* parts[3] = { header, data, trailer };
+		int sizes[3] = { headerSize, size, trailerSize };
+		int total = headerSize + size + trailerSize;
+		int remaining = total;
+		int first = 0;
+		int sent = 0;
+		int count = 0;
+		while (remaining > 0)
+		{
+			while (sizes[first] == 0)
+			{
+				++first;
+			}
+			if (!this->socket->sendParts(&parts[first], &sizes[first], 3 - first, sent))
+			{
+				break;
+			}
+			remaining -= sent;
+			while (sent > 0)
+			{
+				count = hmin(sent, sizes[first]);
+				parts[first] += count;
+				sizes[first] -= count;
+				sent -= count;
+				if (sizes[first] == 0)
+				{
+					++first;
+				}
+			}
+			if (remaining > 0)
+			{
+				hthread::sleep(this->retryFrequency * 1000.0f);
+			}
+		}
+		// the framing doesn't count as sent data
+		return hclamp(total - remaining - headerSize, 0, size);
 	}
 
 	void TcpSocket::_activateConnection(Host remoteHost, unsigned short remotePort, Host localHost, unsigned short localPort)
@@ -24,4 +24,16 @@ namespace sakit
 	{
 	}
 
+	void TcpSocketDelegate::onReceivePaused(TcpSocket* socket)
+	{
+	}
+
+	void TcpSocketDelegate::onReceiveResumed(TcpSocket* socket)
+	{
+	}
+
+	void TcpSocketDelegate::onReceivedMessage(TcpSocket* socket, hstream* stream, int size)
+	{
+	}
+
 }
@@ -0,0 +1,1019 @@
+/// @file
+/// @version 1.2
+///
+/// @section LICENSE
+///
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/harray.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
+#include "Metrics.h"
+#include "sakit.h"
+#include "UdpChannel.h"
+#include "UdpChannelDelegate.h"
+#include "UdpSocket.h"
+
+#define PROTOCOL_ID 0xA7
+#define PACKET_FLAG_ACK 0x01
+#define MESSAGE_FLAG_FRAGMENT 0x01
+// protocol ID, flags, sequence, ack, ack bits
+#define PACKET_HEADER_SIZE 10
+// type, flags, sequence, size
+#define MESSAGE_HEADER_SIZE 6
+// fragment index, fragment count
+#define FRAGMENT_HEADER_SIZE 4
+#define DELIVERY_UNRELIABLE 0
+#define DELIVERY_UNRELIABLE_SEQUENCED 1
+#define DELIVERY_RELIABLE_ORDERED 2
+#define SENT_PACKET_WINDOW 1024
+#define RECEIVE_WINDOW 1024
+#define FAST_RETRANSMIT_THRESHOLD 3
+// fraction of the RTT by which a packet has to be older than an acknowledged one to be considered lost
+#define REORDER_WINDOW_DIVISOR 4
+#define MAX_REASSEMBLIES 256
+#define MIN_MTU 64
+#define MAX_MTU 65507
+#define INITIAL_CONGESTION_WINDOW 10
+#define MAX_CONGESTION_WINDOW 4194304
+#define MAX_BACKOFF_SHIFT 6
+// times in microseconds
+#define INITIAL_RETRANSMIT_TIMEOUT 250000
+#define MIN_RETRANSMIT_TIMEOUT 50000
+#define MAX_RETRANSMIT_TIMEOUT 2000000
+#define REASSEMBLY_TIMEOUT 5000000
+
+namespace sakit
+{
+	static inline bool _isNewer(unsigned short sequence, unsigned short other)
+	{
+		return (sequence != other && (unsigned short)(sequence - other) < 0x8000);
+	}
+
+	static inline bool _isReliableReassembly(unsigned int key)
+	{
+		// the key is the message type followed by the sequence, the delivery is in the upper 2 bits of the type
+		return (((key >> 22) & 0x3) == DELIVERY_RELIABLE_ORDERED);
+	}
+
+	static inline unsigned short _readShort(const unsigned char* data)
+	{
+		return (unsigned short)((data[0] << 8) | data[1]);
+	}
+
+	static inline unsigned int _readInt(const unsigned char* data)
+	{
+		return (((unsigned int)data[0] << 24) | ((unsigned int)data[1] << 16) | ((unsigned int)data[2] << 8) | (unsigned int)data[3]);
+	}
+
+	static inline void _writeShort(hstream& stream, unsigned short value)
+	{
+		unsigned char data[2] = { (unsigned char)(value >> 8), (unsigned char)(value & 0xFF) };
+		stream.writeRaw(data, 2);
+	}
+
+	static inline void _writeInt(hstream& stream, unsigned int value)
+	{
+		unsigned char data[4] = { (unsigned char)(value >> 24), (unsigned char)((value >> 16) & 0xFF), (unsigned char)((value >> 8) & 0xFF), (unsigned char)(value & 0xFF) };
+		stream.writeRaw(data, 4);
+	}
+
+	UdpChannel::OutgoingMessage::OutgoingMessage(unsigned int id, unsigned char type, unsigned short sequence, unsigned short fragmentIndex, unsigned short fragmentCount) :
+		size(0),
+		sendCount(0),
+		sendTime(0LL)
+	{
+		this->id = id;
+		this->type = type;
+		this->sequence = sequence;
+		this->fragmentIndex = fragmentIndex;
+		this->fragmentCount = fragmentCount;
+	}
+
+	UdpChannel::SentPacket::SentPacket() :
+		sequence(0),
+		time(0LL),
+		pending(false)
+	{
+	}
+
+	UdpChannel::MessageHeader::MessageHeader() :
+		type(0),
+		flags(0),
+		sequence(0),
+		fragmentIndex(0),
+		fragmentCount(1),
+		offset(0),
+		size(0)
+	{
+	}
+
+	UdpChannel::Reassembly::Reassembly(unsigned short fragmentCount, int64_t time) :
+		size(0)
+	{
+		this->fragmentCount = fragmentCount;
+		this->time = time;
+	}
+
+	UdpChannel::Reassembly::~Reassembly()
+	{
+		foreach_map (unsigned short, hstream*, it, this->fragments)
+		{
+			delete it->second;
+		}
+	}
+
+	UdpChannel::DelayedDatagram::DelayedDatagram(int64_t time)
+	{
+		this->time = time;
+	}
+
+	UdpChannel::UdpChannel(UdpChannelDelegate* channelDelegate, UdpSocket* socket) :
+		mtu(1200),
+		maxMessageSize(1048576),
+		sendRate(0),
+		maxRetransmits(15),
+		simulatedLoss(0.0f),
+		simulatedLatency(0.0f),
+		simulatedJitter(0.0f)
+	{
+		this->channelDelegate = channelDelegate;
+		this->socket = socket;
+		for_iter (i, 0, SENT_PACKET_WINDOW)
+		{
+			this->sentPackets += SentPacket();
+		}
+		this->_clear();
+	}
+
+	UdpChannel::~UdpChannel()
+	{
+		this->_clear();
+	}
+
+	void UdpChannel::setMtu(int value)
+	{
+		this->mtu = hclamp(value, MIN_MTU, MAX_MTU);
+	}
+
+	float UdpChannel::getRtt() const
+	{
+		return (this->smoothedRtt / 1000000.0f);
+	}
+
+	float UdpChannel::getRetransmitTimeout() const
+	{
+		return (this->retransmitTimeout / 1000000.0f);
+	}
+
+	int UdpChannel::getQueuedCount() const
+	{
+		return this->sendQueue.size();
+	}
+
+	void UdpChannel::reset()
+	{
+		this->_clear();
+	}
+
+	void UdpChannel::_clear()
+	{
+		foreach (OutgoingMessage*, it, this->sendQueue)
+		{
+			delete (*it);
+		}
+		this->sendQueue.clear();
+		foreach_map (unsigned int, OutgoingMessage*, it, this->unackedMessages)
+		{
+			delete it->second;
+		}
+		this->unackedMessages.clear();
+		foreach_map (unsigned int, hstream*, it, this->pendingMessages)
+		{
+			delete it->second;
+		}
+		this->pendingMessages.clear();
+		foreach_map (unsigned int, Reassembly*, it, this->reassemblies)
+		{
+			delete it->second;
+		}
+		this->reassemblies.clear();
+		foreach (DelayedDatagram*, it, this->delayedDatagrams)
+		{
+			delete (*it);
+		}
+		this->delayedDatagrams.clear();
+		for_iter (i, 0, this->sentPackets.size())
+		{
+			this->sentPackets[i] = SentPacket();
+		}
+		for_iter (i, 0, SAKIT_UDP_CHANNEL_LANES)
+		{
+			this->sendSequences[DELIVERY_UNRELIABLE][i] = 0;
+			this->sendSequences[DELIVERY_UNRELIABLE_SEQUENCED][i] = 0;
+			this->sendSequences[DELIVERY_RELIABLE_ORDERED][i] = 0;
+			this->receiveSequences[i] = 0;
+			this->sequencedReceived[i] = false;
+			this->sequencedSequences[i] = 0;
+		}
+		this->failed = false;
+		this->nextMessageId = 0;
+		this->localSequence = 0;
+		this->ackReceived = false;
+		this->highestAck = 0;
+		this->latestAckedTime = 0LL;
+		this->smoothedRtt = 0LL;
+		this->rttVariance = 0LL;
+		this->retransmitTimeout = (int64_t)INITIAL_RETRANSMIT_TIMEOUT;
+		this->congestionWindow = INITIAL_CONGESTION_WINDOW * this->mtu;
+		this->slowStartThreshold = MAX_CONGESTION_WINDOW;
+		this->bytesInFlight = 0;
+		this->recoveryEndTime = 0LL;
+		this->paced = false;
+		this->pacingTokens = 0;
+		this->lastPacingTime = 0LL;
+		this->retransmitCount = 0LL;
+		this->packetReceived = false;
+		this->remoteSequence = 0;
+		this->receivedBits = 0;
+		this->ackPending = false;
+	}
+
+	void UdpChannel::_fail()
+	{
+		if (this->failed)
+		{
+			return;
+		}
+		hlog::warn(logTag, "UDP channel failed, a reliable message could not be delivered!");
+		this->failed = true;
+		this->channelDelegate->onFailed(this);
+	}
+
+	bool UdpChannel::send(hstream* stream, int count, Delivery delivery, int lane)
+	{
+		if (stream == NULL)
+		{
+			hlog::warn(logTag, "Cannot send, stream is NULL!");
+			return false;
+		}
+		if (lane < 0 || lane >= SAKIT_UDP_CHANNEL_LANES)
+		{
+			hlog::warnf(logTag, "Cannot send, lane %d is not valid!", lane);
+			return false;
+		}
+		if (this->failed)
+		{
+			hlog::warn(logTag, "Cannot send, UDP channel failed!");
+			return false;
+		}
+		count = (int)hmin((int64_t)count, stream->size() - stream->position());
+		if (count <= 0)
+		{
+			hlog::warn(logTag, "Cannot send, no data to send!");
+			return false;
+		}
+		if (count > this->maxMessageSize)
+		{
+			hlog::warn(logTag, "Cannot send, message exceeds the maximum message size!");
+			return false;
+		}
+		int fragmentSize = this->mtu - PACKET_HEADER_SIZE - MESSAGE_HEADER_SIZE;
+		int fragmentCount = 1;
+		if (count > fragmentSize)
+		{
+			fragmentSize -= FRAGMENT_HEADER_SIZE;
+			fragmentCount = (count + fragmentSize - 1) / fragmentSize;
+			if (fragmentCount > 0xFFFF)
+			{
+				hlog::warn(logTag, "Cannot send, message needs too many fragments for the MTU!");
+				return false;
+			}
+		}
+		int deliveryCode = _getDeliveryCode(delivery);
+		unsigned char type = (unsigned char)((deliveryCode << 6) | lane);
+		unsigned short sequence = this->sendSequences[deliveryCode][lane]++;
+		const unsigned char* data = (const unsigned char*)&(*stream)[(int)stream->position()];
+		OutgoingMessage* message = NULL;
+		int size = 0;
+		for_iter (i, 0, fragmentCount)
+		{
+			message = new OutgoingMessage(this->nextMessageId++, type, sequence, (unsigned short)i, (unsigned short)fragmentCount);
+			size = hmin(fragmentSize, count - i * fragmentSize);
+			message->data.writeRaw(&data[i * fragmentSize], size);
+			message->size = MESSAGE_HEADER_SIZE + (fragmentCount > 1 ? FRAGMENT_HEADER_SIZE : 0) + size;
+			this->sendQueue += message;
+		}
+		stream->seek(count);
+		return true;
+	}
+
+	bool UdpChannel::send(chstr data, Delivery delivery, int lane)
+	{
+		hstream stream;
+		stream.write(data);
+		stream.rewind();
+		return this->send(&stream, (int)stream.size(), delivery, lane);
+	}
+
+	bool UdpChannel::processDatagram(hstream* stream)
+	{
+		if (stream == NULL || this->failed)
+		{
+			return false;
+		}
+		int size = (int)(stream->size() - stream->position());
+		if (size < PACKET_HEADER_SIZE)
+		{
+			return false;
+		}
+		const unsigned char* data = (const unsigned char*)&(*stream)[(int)stream->position()];
+		if (data[0] != PROTOCOL_ID)
+		{
+			return false;
+		}
+		// a malformed datagram is dropped as a whole before it changes anything
+		MessageHeader header;
+		int offset = PACKET_HEADER_SIZE;
+		while (offset < size)
+		{
+			if (!this->_readMessageHeader(data, size, offset, header))
+			{
+				return false;
+			}
+			offset = header.offset + header.size;
+		}
+		int64_t time = Metrics::getTime();
+		if ((data[1] & PACKET_FLAG_ACK) != 0)
+		{
+			this->_processAcks(_readShort(&data[4]), _readInt(&data[6]), time);
+		}
+		bool acknowledge = true;
+		offset = PACKET_HEADER_SIZE;
+		while (offset < size && !this->failed)
+		{
+			this->_readMessageHeader(data, size, offset, header);
+			if (!this->_receiveMessage(header, &data[header.offset], time))
+			{
+				acknowledge = false;
+			}
+			offset = header.offset + header.size;
+		}
+		// the sender forgets acknowledged messages, a packet with a dropped reliable message has to be retransmitted
+		if (acknowledge)
+		{
+			this->_markReceived(_readShort(&data[2]));
+		}
+		stream->seek(size);
+		return true;
+	}
+
+	bool UdpChannel::_readMessageHeader(const unsigned char* data, int size, int offset, MessageHeader& header)
+	{
+		if (size - offset < MESSAGE_HEADER_SIZE)
+		{
+			return false;
+		}
+		header.type = data[offset];
+		header.flags = data[offset + 1];
+		header.sequence = _readShort(&data[offset + 2]);
+		header.size = (int)_readShort(&data[offset + 4]);
+		header.fragmentIndex = 0;
+		header.fragmentCount = 1;
+		offset += MESSAGE_HEADER_SIZE;
+		if ((header.flags & MESSAGE_FLAG_FRAGMENT) != 0)
+		{
+			if (size - offset < FRAGMENT_HEADER_SIZE)
+			{
+				return false;
+			}
+			header.fragmentIndex = _readShort(&data[offset]);
+			header.fragmentCount = _readShort(&data[offset + 2]);
+			offset += FRAGMENT_HEADER_SIZE;
+			if (header.fragmentCount < 2 || header.fragmentIndex >= header.fragmentCount)
+			{
+				return false;
+			}
+		}
+		header.offset = offset;
+		return ((header.type >> 6) <= DELIVERY_RELIABLE_ORDERED && header.size > 0 && size - offset >= header.size);
+	}
+
+	void UdpChannel::_markReceived(unsigned short sequence)
+	{
+		if (!this->packetReceived)
+		{
+			this->packetReceived = true;
+			this->remoteSequence = sequence;
+			this->receivedBits = 0;
+			return;
+		}
+		if (_isNewer(sequence, this->remoteSequence))
+		{
+			unsigned short shift = (unsigned short)(sequence - this->remoteSequence);
+			// bit N stands for the packet N + 1 sequence numbers before the latest one
+			this->receivedBits = (shift < 32 ? (this->receivedBits << shift) : 0);
+			if (shift <= 32)
+			{
+				this->receivedBits |= (1U << (shift - 1));
+			}
+			this->remoteSequence = sequence;
+			return;
+		}
+		unsigned short distance = (unsigned short)(this->remoteSequence - sequence);
+		if (distance >= 1 && distance <= 32)
+		{
+			this->receivedBits |= (1U << (distance - 1));
+		}
+	}
+
+	void UdpChannel::_processAcks(unsigned short ack, unsigned int ackBits, int64_t time)
+	{
+		this->_acknowledgePacket(ack, time);
+		for_iter (i, 0, 32)
+		{
+			if ((ackBits & (1U << i)) != 0)
+			{
+				this->_acknowledgePacket((unsigned short)(ack - 1 - i), time);
+			}
+		}
+		if (!this->ackReceived || _isNewer(ack, this->highestAck))
+		{
+			this->ackReceived = true;
+			this->highestAck = ack;
+		}
+		this->_detectLosses(time);
+	}
+
+	void UdpChannel::_acknowledgePacket(unsigned short sequence, int64_t time)
+	{
+		SentPacket& packet = this->sentPackets[sequence % SENT_PACKET_WINDOW];
+		if (packet.sequence != sequence)
+		{
+			return;
+		}
+		this->latestAckedTime = hmax(this->latestAckedTime, packet.time);
+		if (!packet.pending)
+		{
+			return;
+		}
+		packet.pending = false;
+		// every transmission has its own packet sequence number so acknowledgements of retransmissions are never ambiguous
+		this->_addRttSample(time - packet.time);
+		int ackedBytes = 0;
+		OutgoingMessage* message = NULL;
+		foreach (unsigned int, it, packet.messageIds)
+		{
+			message = this->unackedMessages.tryGet(*it, NULL);
+			if (message != NULL)
+			{
+				ackedBytes += message->size;
+				this->unackedMessages.removeKey(*it);
+				delete message;
+			}
+		}
+		packet.messageIds.clear();
+		this->bytesInFlight -= ackedBytes;
+		if (this->congestionWindow < this->slowStartThreshold)
+		{
+			this->congestionWindow += ackedBytes;
+		}
+		else if (ackedBytes > 0)
+		{
+			this->congestionWindow += hmax((int)((int64_t)this->mtu * ackedBytes / this->congestionWindow), 1);
+		}
+		this->congestionWindow = hmin(this->congestionWindow, MAX_CONGESTION_WINDOW);
+	}
+
+	void UdpChannel::_detectLosses(int64_t time)
+	{
+		bool lost = false;
+		OutgoingMessage* message = NULL;
+		// reordered packets are not lost, a packet has to be a few packets and a part of the RTT older than an acknowledged one
+		int64_t lostTime = this->latestAckedTime - this->smoothedRtt / REORDER_WINDOW_DIVISOR;
+		for_iter (i, 0, this->sentPackets.size())
+		{
+			SentPacket& packet = this->sentPackets[i];
+			if (packet.pending && _isNewer(this->highestAck, packet.sequence) && (unsigned short)(this->highestAck - packet.sequence) >= FAST_RETRANSMIT_THRESHOLD &&
+				packet.time < lostTime)
+			{
+				packet.pending = false;
+				foreach (unsigned int, it, packet.messageIds)
+				{
+					message = this->unackedMessages.tryGet(*it, NULL);
+					if (message != NULL)
+					{
+						message->sendTime = 0LL;
+					}
+				}
+				packet.messageIds.clear();
+				lost = true;
+			}
+		}
+		if (lost)
+		{
+			this->_reduceCongestionWindow(time);
+		}
+	}
+
+	void UdpChannel::_addRttSample(int64_t rtt)
+	{
+		rtt = hmax(rtt, (int64_t)1);
+		// RFC 6298
+		if (this->smoothedRtt == 0LL)
+		{
+			this->smoothedRtt = rtt;
+			this->rttVariance = rtt / 2;
+		}
+		else
+		{
+			this->rttVariance = (3 * this->rttVariance + hmax(this->smoothedRtt - rtt, rtt - this->smoothedRtt)) / 4;
+			this->smoothedRtt = (7 * this->smoothedRtt + rtt) / 8;
+		}
+		this->retransmitTimeout = hclamp(this->smoothedRtt + 4 * this->rttVariance, (int64_t)MIN_RETRANSMIT_TIMEOUT, (int64_t)MAX_RETRANSMIT_TIMEOUT);
+	}
+
+	void UdpChannel::_reduceCongestionWindow(int64_t time)
+	{
+		// only once per round trip, all losses of one window belong to the same congestion event
+		if (time < this->recoveryEndTime)
+		{
+			return;
+		}
+		this->slowStartThreshold = hmax(this->congestionWindow / 2, 2 * this->mtu);
+		this->congestionWindow = this->slowStartThreshold;
+		this->recoveryEndTime = time + (this->smoothedRtt > 0LL ? this->smoothedRtt : this->retransmitTimeout);
+	}
+
+	bool UdpChannel::_receiveMessage(const MessageHeader& header, const unsigned char* data, int64_t time)
+	{
+		int deliveryCode = (header.type >> 6);
+		int lane = (header.type & 0x3F);
+		if (deliveryCode == DELIVERY_RELIABLE_ORDERED)
+		{
+			// duplicates are acknowledged as well, the previous acknowledgement might have been lost
+			this->ackPending = true;
+			// too far ahead to be held back, the sender has to retransmit it once the window moved on
+			unsigned short distance = (unsigned short)(header.sequence - this->receiveSequences[lane]);
+			if (distance >= RECEIVE_WINDOW && distance < 0x8000)
+			{
+				return false;
+			}
+		}
+		if (!this->_acceptMessage(deliveryCode, lane, header.sequence))
+		{
+			return true;
+		}
+		if (header.fragmentCount <= 1)
+		{
+			this->message.clear();
+			this->message.writeRaw(data, header.size);
+			this->message.rewind();
+			this->_deliverMessage(deliveryCode, lane, header.sequence, &this->message);
+			return true;
+		}
+		unsigned int key = (((unsigned int)header.type << 16) | header.sequence);
+		Reassembly* reassembly = this->reassemblies.tryGet(key, NULL);
+		if (reassembly == NULL)
+		{
+			if (this->reassemblies.size() >= MAX_REASSEMBLIES && !this->_evictReassembly())
+			{
+				return (deliveryCode != DELIVERY_RELIABLE_ORDERED);
+			}
+			reassembly = new Reassembly(header.fragmentCount, time);
+			this->reassemblies[key] = reassembly;
+		}
+		if (reassembly->fragmentCount != header.fragmentCount || reassembly->fragments.hasKey(header.fragmentIndex))
+		{
+			return true;
+		}
+		if (reassembly->size + header.size > this->maxMessageSize)
+		{
+			hlog::warn(logTag, "Received fragmented message exceeds the maximum message size, dropping it!");
+			this->reassemblies.removeKey(key);
+			delete reassembly;
+			// the lane can't continue without it
+			if (deliveryCode == DELIVERY_RELIABLE_ORDERED)
+			{
+				this->_fail();
+			}
+			return true;
+		}
+		hstream* fragment = new hstream();
+		fragment->writeRaw(data, header.size);
+		fragment->rewind();
+		reassembly->fragments[header.fragmentIndex] = fragment;
+		reassembly->size += header.size;
+		if (reassembly->fragments.size() < (int)reassembly->fragmentCount)
+		{
+			return true;
+		}
+		this->reassemblies.removeKey(key);
+		this->message.clear(reassembly->size);
+		// hmap is ordered by key, the fragments come out in order
+		foreach_map (unsigned short, hstream*, it, reassembly->fragments)
+		{
+			this->message.writeRaw(*it->second);
+		}
+		delete reassembly;
+		this->message.rewind();
+		if (this->_acceptMessage(deliveryCode, lane, header.sequence))
+		{
+			this->_deliverMessage(deliveryCode, lane, header.sequence, &this->message);
+		}
+		return true;
+	}
+
+	bool UdpChannel::_acceptMessage(int deliveryCode, int lane, unsigned short sequence)
+	{
+		if (deliveryCode == DELIVERY_UNRELIABLE_SEQUENCED)
+		{
+			return (!this->sequencedReceived[lane] || _isNewer(sequence, this->sequencedSequences[lane]));
+		}
+		if (deliveryCode == DELIVERY_RELIABLE_ORDERED)
+		{
+			// anything before the next expected message was delivered already, too far ahead is outside of the window
+			unsigned short distance = (unsigned short)(sequence - this->receiveSequences[lane]);
+			return (distance < RECEIVE_WINDOW && !this->pendingMessages.hasKey(((unsigned int)lane << 16) | sequence));
+		}
+		return true;
+	}
+
+	void UdpChannel::_deliverMessage(int deliveryCode, int lane, unsigned short sequence, hstream* stream)
+	{
+		if (deliveryCode == DELIVERY_UNRELIABLE_SEQUENCED)
+		{
+			this->sequencedReceived[lane] = true;
+			this->sequencedSequences[lane] = sequence;
+		}
+		else if (deliveryCode == DELIVERY_RELIABLE_ORDERED)
+		{
+			if (sequence != this->receiveSequences[lane])
+			{
+				hstream* pending = new hstream();
+				pending->writeRaw(*stream);
+				pending->rewind();
+				this->pendingMessages[((unsigned int)lane << 16) | sequence] = pending;
+				return;
+			}
+			++this->receiveSequences[lane];
+		}
+		Delivery delivery = _getDelivery(deliveryCode);
+		this->channelDelegate->onReceived(this, stream, delivery, lane);
+		if (deliveryCode != DELIVERY_RELIABLE_ORDERED)
+		{
+			return;
+		}
+		// messages that arrived ahead of this one can follow now
+		unsigned int key = 0;
+		hstream* pending = NULL;
+		while (!this->failed)
+		{
+			key = (((unsigned int)lane << 16) | this->receiveSequences[lane]);
+			pending = this->pendingMessages.tryGet(key, NULL);
+			if (pending == NULL)
+			{
+				break;
+			}
+			this->pendingMessages.removeKey(key);
+			++this->receiveSequences[lane];
+			this->channelDelegate->onReceived(this, pending, delivery, lane);
+			delete pending;
+		}
+	}
+
+	bool UdpChannel::_evictReassembly()
+	{
+		unsigned int key = 0;
+		Reassembly* oldest = NULL;
+		foreach_map (unsigned int, Reassembly*, it, this->reassemblies)
+		{
+			if (!_isReliableReassembly(it->first) && (oldest == NULL || it->second->time < oldest->time))
+			{
+				key = it->first;
+				oldest = it->second;
+			}
+		}
+		if (oldest == NULL)
+		{
+			return false;
+		}
+		this->reassemblies.removeKey(key);
+		delete oldest;
+		return true;
+	}
+
+	void UdpChannel::_expireReassemblies(int64_t time)
+	{
+		harray<unsigned int> keys;
+		foreach_map (unsigned int, Reassembly*, it, this->reassemblies)
+		{
+			// acknowledged fragments of reliable messages are never sent again, so those have to be kept until complete
+			if (!_isReliableReassembly(it->first) && time - it->second->time >= (int64_t)REASSEMBLY_TIMEOUT)
+			{
+				keys += it->first;
+			}
+		}
+		foreach (unsigned int, it, keys)
+		{
+			delete this->reassemblies[*it];
+			this->reassemblies.removeKey(*it);
+		}
+	}
+
+	void UdpChannel::update(float timeDelta)
+	{
+		int64_t time = Metrics::getTime();
+		this->_sendDelayedDatagrams(time);
+		if (this->failed)
+		{
+			return;
+		}
+		this->_expireReassemblies(time);
+		this->_updatePacing(time);
+		harray<OutgoingMessage*> retransmissions = this->_getDueMessages(time);
+		if (this->failed)
+		{
+			return;
+		}
+		// the receiver only holds back messages up to RECEIVE_WINDOW ahead of the oldest one it's missing
+		bool laneUnacked[SAKIT_UDP_CHANNEL_LANES] = { false };
+		unsigned short oldestSequences[SAKIT_UDP_CHANNEL_LANES] = { 0 };
+		int lane = 0;
+		// IDs grow with the sequence numbers of each lane, so the first unacknowledged message of a lane is its oldest one
+		foreach_map (unsigned int, OutgoingMessage*, it, this->unackedMessages)
+		{
+			lane = (it->second->type & 0x3F);
+			if (!laneUnacked[lane])
+			{
+				laneUnacked[lane] = true;
+				oldestSequences[lane] = it->second->sequence;
+			}
+		}
+		harray<OutgoingMessage*> messages;
+		OutgoingMessage* message = NULL;
+		int packetSize = PACKET_HEADER_SIZE;
+		int retransmissionIndex = 0;
+		int queueIndex = 0;
+		bool windowFull = false;
+		bool retransmission = false;
+		while (!this->paced || this->pacingTokens > 0)
+		{
+			message = NULL;
+			retransmission = (retransmissionIndex < retransmissions.size());
+			if (retransmission)
+			{
+				message = retransmissions[retransmissionIndex];
+			}
+			else
+			{
+				while (queueIndex < this->sendQueue.size())
+				{
+					message = this->sendQueue[queueIndex];
+					if ((message->type >> 6) != DELIVERY_RELIABLE_ORDERED)
+					{
+						break;
+					}
+					lane = (message->type & 0x3F);
+					if (laneUnacked[lane] && (unsigned short)(message->sequence - oldestSequences[lane]) >= RECEIVE_WINDOW)
+					{
+						message = NULL;
+						++queueIndex;
+						continue;
+					}
+					// new reliable data has to fit into the congestion window, unreliable data is only paced
+					if (!windowFull && (this->bytesInFlight == 0 || this->bytesInFlight + message->size <= this->congestionWindow))
+					{
+						break;
+					}
+					windowFull = true;
+					message = NULL;
+					++queueIndex;
+				}
+			}
+			if (message == NULL)
+			{
+				break;
+			}
+			// a lowered MTU doesn't affect already fragmented messages, those are sent alone
+			if (messages.size() > 0 && packetSize + message->size > this->mtu)
+			{
+				this->_sendPacket(messages, time);
+				packetSize = PACKET_HEADER_SIZE;
+				continue;
+			}
+			if (retransmission)
+			{
+				++retransmissionIndex;
+				++this->retransmitCount;
+			}
+			else
+			{
+				this->sendQueue.removeAt(queueIndex);
+				if ((message->type >> 6) == DELIVERY_RELIABLE_ORDERED)
+				{
+					this->unackedMessages[message->id] = message;
+					this->bytesInFlight += message->size;
+					lane = (message->type & 0x3F);
+					if (!laneUnacked[lane])
+					{
+						laneUnacked[lane] = true;
+						oldestSequences[lane] = message->sequence;
+					}
+				}
+			}
+			++message->sendCount;
+			message->sendTime = time;
+			messages += message;
+			packetSize += message->size;
+		}
+		if (messages.size() > 0 || this->ackPending)
+		{
+			this->_sendPacket(messages, time);
+		}
+	}
+
+	void UdpChannel::_updatePacing(int64_t time)
+	{
+		int64_t rate = (int64_t)this->sendRate;
+		if (rate <= 0 && this->smoothedRtt > 0LL)
+		{
+			// a bit faster than one window per round trip so that the window can still grow
+			rate = (int64_t)this->congestionWindow * 1250000LL / this->smoothedRtt;
+		}
+		this->paced = (rate > 0LL);
+		if (!this->paced)
+		{
+			this->lastPacingTime = time;
+			return;
+		}
+		int64_t capacity = hmax(rate / 50, (int64_t)this->mtu * 2);
+		int64_t tokens = (int64_t)this->pacingTokens + (time - this->lastPacingTime) * rate / 1000000LL;
+		this->pacingTokens = (int)hmin(tokens, capacity);
+		this->lastPacingTime = time;
+	}
+
+	harray<UdpChannel::OutgoingMessage*> UdpChannel::_getDueMessages(int64_t time)
+	{
+		harray<OutgoingMessage*> result;
+		bool timedOut = false;
+		bool exceeded = false;
+		int64_t timeout = 0LL;
+		foreach_map (unsigned int, OutgoingMessage*, it, this->unackedMessages)
+		{
+			if (it->second->sendTime > 0LL)
+			{
+				timeout = hmin(this->retransmitTimeout << hmin(it->second->sendCount - 1, MAX_BACKOFF_SHIFT), (int64_t)MAX_RETRANSMIT_TIMEOUT);
+				if (time - it->second->sendTime < timeout)
+				{
+					continue;
+				}
+				timedOut = true;
+			}
+			if (it->second->sendCount > this->maxRetransmits)
+			{
+				exceeded = true;
+				break;
+			}
+			result += it->second;
+		}
+		if (exceeded)
+		{
+			this->_fail();
+			return harray<OutgoingMessage*>();
+		}
+		if (timedOut)
+		{
+			this->_reduceCongestionWindow(time);
+		}
+		return result;
+	}
+
+	void UdpChannel::_sendPacket(harray<OutgoingMessage*>& messages, int64_t time)
+	{
+		unsigned short sequence = this->localSequence++;
+		this->packet.clear();
+		unsigned char header[2] = { PROTOCOL_ID, (unsigned char)(this->packetReceived ? PACKET_FLAG_ACK : 0) };
+		this->packet.writeRaw(header, 2);
+		_writeShort(this->packet, sequence);
+		_writeShort(this->packet, this->remoteSequence);
+		_writeInt(this->packet, this->receivedBits);
+		SentPacket& sentPacket = this->sentPackets[sequence % SENT_PACKET_WINDOW];
+		sentPacket.sequence = sequence;
+		sentPacket.time = time;
+		sentPacket.pending = false;
+		sentPacket.messageIds.clear();
+		unsigned char messageHeader[2] = { 0, 0 };
+		foreach (OutgoingMessage*, it, messages)
+		{
+			messageHeader[0] = (*it)->type;
+			messageHeader[1] = (unsigned char)((*it)->fragmentCount > 1 ? MESSAGE_FLAG_FRAGMENT : 0);
+			this->packet.writeRaw(messageHeader, 2);
+			_writeShort(this->packet, (*it)->sequence);
+			_writeShort(this->packet, (unsigned short)(*it)->data.size());
+			if ((*it)->fragmentCount > 1)
+			{
+				_writeShort(this->packet, (*it)->fragmentIndex);
+				_writeShort(this->packet, (*it)->fragmentCount);
+			}
+			this->packet.writeRaw(&(*it)->data[0], (int)(*it)->data.size());
+			if (((*it)->type >> 6) == DELIVERY_RELIABLE_ORDERED)
+			{
+				sentPacket.pending = true;
+				sentPacket.messageIds += (*it)->id;
+			}
+			else
+			{
+				delete (*it);
+			}
+		}
+		messages.clear();
+		this->ackPending = false;
+		if (this->paced)
+		{
+			this->pacingTokens -= (int)this->packet.size();
+		}
+		this->packet.rewind();
+		this->_sendDatagram(&this->packet, time);
+	}
+
+	void UdpChannel::_sendDatagram(hstream* stream, int64_t time)
+	{
+		if (this->simulatedLoss > 0.0f && hrandf(1.0f) < this->simulatedLoss)
+		{
+			return;
+		}
+		if (this->simulatedLatency <= 0.0f && this->simulatedJitter <= 0.0f)
+		{
+			this->_writeDatagram(stream);
+			return;
+		}
+		float delay = this->simulatedLatency + (this->simulatedJitter > 0.0f ? hrandf(this->simulatedJitter) : 0.0f);
+		DelayedDatagram* datagram = new DelayedDatagram(time + (int64_t)(delay * 1000000.0f));
+		datagram->stream.writeRaw(*stream);
+		datagram->stream.rewind();
+		this->delayedDatagrams += datagram;
+	}
+
+	void UdpChannel::_writeDatagram(hstream* stream)
+	{
+		if (this->socket != NULL)
+		{
+			this->socket->send(stream);
+		}
+		else
+		{
+			this->channelDelegate->onSendDatagram(this, stream);
+		}
+	}
+
+	void UdpChannel::_sendDelayedDatagrams(int64_t time)
+	{
+		int i = 0;
+		DelayedDatagram* datagram = NULL;
+		while (i < this->delayedDatagrams.size())
+		{
+			datagram = this->delayedDatagrams[i];
+			if (datagram->time > time)
+			{
+				++i;
+				continue;
+			}
+			this->delayedDatagrams.removeAt(i);
+			this->_writeDatagram(&datagram->stream);
+			delete datagram;
+		}
+	}
+
+	int UdpChannel::_getDeliveryCode(Delivery delivery)
+	{
+		if (delivery == Delivery::UnreliableSequenced)
+		{
+			return DELIVERY_UNRELIABLE_SEQUENCED;
+		}
+		if (delivery == Delivery::ReliableOrdered)
+		{
+			return DELIVERY_RELIABLE_ORDERED;
+		}
+		return DELIVERY_UNRELIABLE;
+	}
+
+	Delivery UdpChannel::_getDelivery(int deliveryCode)
+	{
+		if (deliveryCode == DELIVERY_UNRELIABLE_SEQUENCED)
+		{
+			return Delivery::UnreliableSequenced;
+		}
+		if (deliveryCode == DELIVERY_RELIABLE_ORDERED)
+		{
+			return Delivery::ReliableOrdered;
+		}
+		return Delivery::Unreliable;
+	}
+
+}
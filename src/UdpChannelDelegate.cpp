@@ -0,0 +1,35 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/hstream.h>
+
+#include "UdpChannelDelegate.h"
+
+namespace sakit
+{
+	UdpChannelDelegate::UdpChannelDelegate()
+	{
+	}
+
+	UdpChannelDelegate::~UdpChannelDelegate()
+	{
+	}
+
+	void UdpChannelDelegate::onSendDatagram(UdpChannel* channel, hstream* stream)
+	{
+	}
+
+	void UdpChannelDelegate::onReceived(UdpChannel* channel, hstream* stream, Delivery delivery, int lane)
+	{
+	}
+
+	void UdpChannelDelegate::onFailed(UdpChannel* channel)
+	{
+	}
+
+}
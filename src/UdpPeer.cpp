@@ -0,0 +1,65 @@
+/// @file
+/// @version 1.2
+///
+/// @section LICENSE
+///
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <string.h>
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstring.h>
+
+#include "PlatformSocket.h"
+#include "UdpPeer.h"
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+namespace sakit
+{
+	UdpPeer::UdpPeer(const unsigned char* address, int addressSize, uint64_t hash, int64_t time) :
+		next(NULL),
+		port(0),
+		userData(NULL),
+		receivedCount(0LL),
+		receivedBytes(0LL),
+		sentCount(0LL),
+		sentBytes(0LL),
+		sendFailedCount(0LL)
+	{
+		this->addressSize = hclamp(addressSize, 0, SAKIT_UDP_PEER_ADDRESS_SIZE);
+		memcpy(this->address, address, this->addressSize);
+		this->hash = hash;
+		this->addedTime = time;
+		this->lastReceivedTime = time;
+		// numeric conversion only, done once per peer instead of once per datagram
+		PlatformSocket::getAddressHostPort(this->address, this->addressSize, this->host, this->port);
+	}
+
+	UdpPeer::~UdpPeer()
+	{
+	}
+
+	float UdpPeer::getIdleTime() const
+	{
+		return (float)((int64_t)htickCount() - this->lastReceivedTime) * 0.001f;
+	}
+
+	bool UdpPeer::_hasAddress(const unsigned char* address, int addressSize) const
+	{
+		return (this->addressSize == addressSize && memcmp(this->address, address, addressSize) == 0);
+	}
+
+	uint64_t UdpPeer::_makeHash(const unsigned char* address, int addressSize)
+	{
+		uint64_t result = FNV_OFFSET_BASIS;
+		for_iter (i, 0, addressSize)
+		{
+			result = (result ^ address[i]) * FNV_PRIME;
+		}
+		return result;
+	}
+
+}
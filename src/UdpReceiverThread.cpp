@@ -14,59 +14,111 @@
 #include "SocketDelegate.h"
 #include "UdpReceiverThread.h"
 
+#define RECEIVE_BATCH_SIZE 64
+#define QUEUE_CAPACITY 1024
+
 namespace sakit
 {
+	UdpReceiverThread::Datagram::Datagram() :
+		remotePort(0),
+		stream(NULL)
+	{
+	}
+
 	UdpReceiverThread::UdpReceiverThread(PlatformSocket* socket, float* timeout, float* retryFrequency) :
-		ReceiverThread(socket, timeout, retryFrequency)
+		ReceiverThread(socket, timeout, retryFrequency),
+		datagrams(QUEUE_CAPACITY)
 	{
 		this->name = "SAKit UDP receiver";
 	}
 
 	UdpReceiverThread::~UdpReceiverThread()
 	{
-		hmutex::ScopeLock lock(&this->streamsMutex);
-		harray<hstream*> streams = this->streams;
-		this->streams.clear();
-		this->remoteHosts.clear();
-		this->remotePorts.clear();
-		lock.release();
-		foreach (hstream*, it, streams)
+		Datagram datagram;
+		while (this->_dequeue(datagram, true))
 		{
-			delete (*it);
+			delete datagram.stream;
 		}
 	}
 
 	void UdpReceiverThread::_updateProcess()
 	{
-		Host host;
-		unsigned short port = 0;
-		hstream* stream = new hstream();
+		Datagram datagram;
+		datagram.stream = new hstream();
 		int count = this->maxValue;
-		hmutex::ScopeLock lock;
-		while (this->isRunning() && this->executing)
+		int received = 0;
+		bool finished = false;
+		while (this->isRunning() && this->executing && !finished)
 		{
-			if (this->socket->receiveFrom(stream, host, port) && stream->size() > 0)
+			// pending datagrams are drained in batches, the thread only sleeps when there is nothing to read
+			received = 0;
+			while (received < RECEIVE_BATCH_SIZE && !finished)
 			{
-				stream->rewind();
-				lock.acquire(&this->streamsMutex);
-				this->remoteHosts += host;
-				this->remotePorts += port;
-				this->streams += stream;
-				lock.release();
-				host = Host();
-				port = 0;
-				stream = new hstream();
+				// while the queue is full nothing is read, datagrams wait in the OS buffer
+				if (!this->_queue(datagram))
+				{
+					break;
+				}
+				--count;
+				finished = (this->maxValue > 0 && count == 0);
+				if (!this->socket->receiveFromDestination(datagram.stream, datagram.remoteHost, datagram.remotePort, datagram.destinationHost) ||
+					datagram.stream->size() == 0)
+				{
+					break;
+				}
+				++received;
 			}
-			--count;
-			if (this->maxValue > 0 && count == 0)
+			this->_queue(datagram);
+			if (received < RECEIVE_BATCH_SIZE && !finished)
 			{
-				break;
+				hthread::sleep(*this->retryFrequency * 1000.0f);
 			}
-			hthread::sleep(*this->retryFrequency * 1000.0f);
 		}
-		delete stream;
-		lock.acquire(&this->resultMutex);
-		this->result = State::Finished;
+		this->_finish(datagram, State::Finished);
+	}
+
+	bool UdpReceiverThread::_queue(Datagram& datagram)
+	{
+		if (datagram.stream->size() == 0)
+		{
+			return true;
+		}
+		datagram.stream->rewind();
+		if (!this->datagrams.push(datagram))
+		{
+			return false;
+		}
+		datagram = Datagram();
+		datagram.stream = new hstream();
+		return true;
+	}
+
+	void UdpReceiverThread::_finish(Datagram& datagram, State result)
+	{
+		if (this->_queue(datagram))
+		{
+			delete datagram.stream;
+		}
+		else
+		{
+			this->remainder = datagram;
+		}
+		this->_setResult(result);
+	}
+
+	bool UdpReceiverThread::_dequeue(Datagram& datagram, bool finished)
+	{
+		if (this->datagrams.pop(datagram))
+		{
+			return true;
+		}
+		if (finished && this->remainder.stream != NULL)
+		{
+			datagram = this->remainder;
+			this->remainder = Datagram();
+			return true;
+		}
+		return false;
 	}
 
 }
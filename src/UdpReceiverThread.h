@@ -18,6 +18,7 @@
 
 #include "Host.h"
 #include "ReceiverThread.h"
+#include "SpscQueue.h"
 
 namespace sakit
 {
@@ -33,10 +34,29 @@ namespace sakit
 		~UdpReceiverThread();
 
 	protected:
-		harray<Host> remoteHosts;
-		harray<unsigned short> remotePorts;
-		harray<hstream*> streams;
-		hmutex streamsMutex;
+		class Datagram
+		{
+		public:
+			Host remoteHost;
+			unsigned short remotePort;
+			/// @brief Destination address of the datagram, e.g. its multicast group, empty if unknown.
+			Host destinationHost;
+			hstream* stream;
+
+			Datagram();
+
+		};
+
+		/// @brief Received datagrams, handed to UdpSocket::_updateReceiving() without locking.
+		SpscQueue<Datagram> datagrams;
+		/// @brief Datagram that didn't fit into the queue when the thread stopped, may only be accessed after resultReady was set.
+		Datagram remainder;
+
+		bool _queue(Datagram& datagram);
+		void _finish(Datagram& datagram, State result);
+		/// @brief Takes the next received datagram, called by the consumer only.
+		/// @param[in] finished Whether resultReady was set, the remainder is only taken then.
+		bool _dequeue(Datagram& datagram, bool finished);
 
 		void _updateProcess() override;
 
@@ -6,7 +6,12 @@
 /// This program is free software; you can redistribute it and/or modify it under
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
+#include <string.h>
+
+#include <hltypes/harray.h>
 #include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
 #include <hltypes/hmutex.h>
 #include <hltypes/hstream.h>
 #include <hltypes/hstring.h>
@@ -15,16 +20,28 @@
 #include "sakit.h"
 #include "SenderThread.h"
 #include "State.h"
+#include "UdpPeer.h"
 #include "UdpServer.h"
 #include "UdpServerDelegate.h"
 #include "UdpServerThread.h"
 #include "UdpSocket.h"
 
+#define EXPIRE_INTERVAL 1000
+#define MAX_PEERS 4096
+#define PEER_BUCKETS 64
+
 namespace sakit
 {
 	UdpServer::UdpServer(UdpServerDelegate* udpServerDelegate) :
-		Server(dynamic_cast<ServerDelegate*>(udpServerDelegate))
+		Server(dynamic_cast<ServerDelegate*>(udpServerDelegate)),
+		peerTimeout(60.0f),
+		maxPeers(MAX_PEERS),
+		peerBucketCount(PEER_BUCKETS),
+		peerCount(0),
+		lastExpireTime(0LL)
 	{
+		this->peerBuckets = new UdpPeer*[this->peerBucketCount];
+		memset(this->peerBuckets, 0, this->peerBucketCount * sizeof(UdpPeer*));
 		this->socket->setConnectionLess(true);
 		this->udpServerDelegate = udpServerDelegate;
 		this->serverThread = this->udpServerThread = new UdpServerThread(this->socket, &this->timeout, &this->retryFrequency);
@@ -34,33 +51,87 @@ namespace sakit
 	UdpServer::~UdpServer()
 	{
 		this->__unregister();
+		UdpPeer* next = NULL;
+		for_iter (i, 0, this->peerBucketCount)
+		{
+			for (UdpPeer* peer = this->peerBuckets[i]; peer != NULL; peer = next)
+			{
+				next = peer->next;
+				delete peer;
+			}
+		}
+		delete[] this->peerBuckets;
+	}
+
+	int UdpServer::getPeerCount()
+	{
+		hmutex::ScopeLock lock(&this->peersMutex);
+		return this->peerCount;
+	}
+
+	harray<UdpPeer*> UdpServer::getPeers()
+	{
+		harray<UdpPeer*> result;
+		hmutex::ScopeLock lock(&this->peersMutex);
+		for_iter (i, 0, this->peerBucketCount)
+		{
+			for (UdpPeer* peer = this->peerBuckets[i]; peer != NULL; peer = peer->next)
+			{
+				result += peer;
+			}
+		}
+		return result;
 	}
-	
+
 	void UdpServer::update(float timeDelta)
 	{
-		harray<Host> hosts;
-		harray<unsigned short> ports;
-		harray<hstream*> streams;
+		harray<UdpServerThread::Datagram> datagrams;
 		hmutex::ScopeLock lock(&this->mutexState);
 		hmutex::ScopeLock lockThreadResult(&this->udpServerThread->resultMutex);
 		hmutex::ScopeLock lockThreadStreams(&this->udpServerThread->streamsMutex);
-		if (this->udpServerThread->streams.size() > 0)
+		if (this->udpServerThread->datagrams.size() > 0)
 		{
-			hosts = this->udpServerThread->remoteHosts;
-			ports = this->udpServerThread->remotePorts;
-			streams = this->udpServerThread->streams;
-			this->udpServerThread->remoteHosts.clear();
-			this->udpServerThread->remotePorts.clear();
-			this->udpServerThread->streams.clear();
+			datagrams = this->udpServerThread->datagrams;
+			this->udpServerThread->datagrams.clear();
 		}
 		lockThreadStreams.release();
 		lockThreadResult.release();
 		lock.release();
-		for_iter (i, 0, streams.size())
+		int64_t time = (int64_t)htickCount();
+		uint64_t hash = 0;
+		UdpPeer* peer = NULL;
+		bool added = false;
+		foreach (UdpServerThread::Datagram, it, datagrams)
 		{
-			this->udpServerDelegate->onReceived(this, hosts[i], ports[i], streams[i]);
-			delete streams[i];
+			// the lookup of a known sender doesn't allocate anything
+			hash = UdpPeer::_makeHash((*it).address, (*it).addressSize);
+			lock.acquire(&this->peersMutex);
+			peer = this->_findPeer((*it).address, (*it).addressSize, hash);
+			added = (peer == NULL);
+			if (added)
+			{
+				// every sender address creates a peer so the table has to be bounded against spoofed floods
+				if (this->maxPeers > 0 && this->peerCount >= this->maxPeers)
+				{
+					lock.release();
+					delete (*it).stream;
+					continue;
+				}
+				peer = new UdpPeer((*it).address, (*it).addressSize, hash, time);
+				this->_addPeer(peer);
+			}
+			peer->lastReceivedTime = time;
+			++peer->receivedCount;
+			peer->receivedBytes += (*it).stream->size();
+			lock.release();
+			if (added)
+			{
+				this->udpServerDelegate->onPeerAdded(this, peer);
+			}
+			this->udpServerDelegate->onPeerReceived(this, peer, (*it).stream);
+			delete (*it).stream;
 		}
+		this->_expirePeers();
 		Server::update(timeDelta);
 	}
 
@@ -97,4 +168,144 @@ namespace sakit
 		return result;
 	}
 
+	bool UdpServer::sendTo(UdpPeer* peer, hstream* stream, int count)
+	{
+		hmutex::ScopeLock lock(&this->mutexState);
+		if (this->state != State::Bound && this->state != State::Running)
+		{
+			hlog::warn(logTag, "Cannot send, server is not bound!");
+			return false;
+		}
+		lock.release();
+		int64_t position = stream->position();
+		int size = hmin((int)(stream->size() - position), count);
+		int sent = 0;
+		// a datagram is either sent completely or not at all
+		bool result = (this->socket->sendToAddress(peer->address, peer->addressSize, stream, count, sent) && sent == size);
+		stream->seek(position, hseek::Start);
+		lock.acquire(&this->peersMutex);
+		if (result)
+		{
+			++peer->sentCount;
+			peer->sentBytes += sent;
+		}
+		else
+		{
+			++peer->sendFailedCount;
+		}
+		return result;
+	}
+
+	bool UdpServer::sendTo(UdpPeer* peer, chstr data)
+	{
+		hstream stream;
+		stream.write(data);
+		stream.rewind();
+		return this->sendTo(peer, &stream, (int)stream.size());
+	}
+
+	void UdpServer::removePeer(UdpPeer* peer)
+	{
+		hmutex::ScopeLock lock(&this->peersMutex);
+		if (!this->_removePeer(peer))
+		{
+			return;
+		}
+		lock.release();
+		this->udpServerDelegate->onPeerRemoved(this, peer);
+		delete peer;
+	}
+
+	UdpPeer* UdpServer::_findPeer(const unsigned char* address, int addressSize, uint64_t hash)
+	{
+		for (UdpPeer* peer = this->peerBuckets[hash & (this->peerBucketCount - 1)]; peer != NULL; peer = peer->next)
+		{
+			// different addresses can have the same hash
+			if (peer->hash == hash && peer->_hasAddress(address, addressSize))
+			{
+				return peer;
+			}
+		}
+		return NULL;
+	}
+
+	void UdpServer::_addPeer(UdpPeer* peer)
+	{
+		if (this->peerCount >= this->peerBucketCount)
+		{
+			// rehashing keeps the chains short, it only happens when a peer is added
+			int count = this->peerBucketCount * 2;
+			UdpPeer** buckets = new UdpPeer*[count];
+			memset(buckets, 0, count * sizeof(UdpPeer*));
+			UdpPeer* next = NULL;
+			int index = 0;
+			for_iter (i, 0, this->peerBucketCount)
+			{
+				for (UdpPeer* current = this->peerBuckets[i]; current != NULL; current = next)
+				{
+					next = current->next;
+					index = (int)(current->hash & (count - 1));
+					current->next = buckets[index];
+					buckets[index] = current;
+				}
+			}
+			delete[] this->peerBuckets;
+			this->peerBuckets = buckets;
+			this->peerBucketCount = count;
+		}
+		int index = (int)(peer->hash & (this->peerBucketCount - 1));
+		peer->next = this->peerBuckets[index];
+		this->peerBuckets[index] = peer;
+		++this->peerCount;
+	}
+
+	bool UdpServer::_removePeer(UdpPeer* peer)
+	{
+		UdpPeer** link = &this->peerBuckets[peer->hash & (this->peerBucketCount - 1)];
+		while (*link != NULL)
+		{
+			if (*link == peer)
+			{
+				*link = peer->next;
+				peer->next = NULL;
+				--this->peerCount;
+				return true;
+			}
+			link = &(*link)->next;
+		}
+		return false;
+	}
+
+	void UdpServer::_expirePeers()
+	{
+		if (this->peerTimeout <= 0.0f)
+		{
+			return;
+		}
+		int64_t time = (int64_t)htickCount();
+		if (time - this->lastExpireTime < EXPIRE_INTERVAL)
+		{
+			return;
+		}
+		this->lastExpireTime = time;
+		int64_t maxIdleTime = (int64_t)(this->peerTimeout * 1000.0f);
+		harray<UdpPeer*> expiredPeers;
+		hmutex::ScopeLock lock(&this->peersMutex);
+		for_iter (i, 0, this->peerBucketCount)
+		{
+			for (UdpPeer* peer = this->peerBuckets[i]; peer != NULL; peer = peer->next)
+			{
+				if (time - peer->lastReceivedTime >= maxIdleTime)
+				{
+					expiredPeers += peer;
+				}
+			}
+		}
+		lock.release();
+		foreach (UdpPeer*, it, expiredPeers)
+		{
+			this->removePeer(*it);
+		}
+	}
+
 }
@@ -6,6 +6,7 @@
 /// This program is free software; you can redistribute it and/or modify it under
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
+#include "UdpPeer.h"
 #include "UdpServerDelegate.h"
 
 namespace sakit
@@ -19,4 +20,17 @@ namespace sakit
 	{
 	}
 
+	void UdpServerDelegate::onPeerReceived(UdpServer* server, UdpPeer* peer, hstream* stream)
+	{
+		this->onReceived(server, peer->getHost(), peer->getPort(), stream);
+	}
+
+	void UdpServerDelegate::onPeerAdded(UdpServer* server, UdpPeer* peer)
+	{
+	}
+
+	void UdpServerDelegate::onPeerRemoved(UdpServer* server, UdpPeer* peer)
+	{
+	}
+
 }
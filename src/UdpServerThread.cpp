@@ -18,6 +18,12 @@
 
 namespace sakit
 {
+	UdpServerThread::Datagram::Datagram() :
+		addressSize(0),
+		stream(NULL)
+	{
+	}
+
 	UdpServerThread::UdpServerThread(PlatformSocket* socket, float* timeout, float* retryFrequency) :
 		TimedThread(socket, timeout, retryFrequency)
 	{
@@ -27,40 +33,35 @@ namespace sakit
 	UdpServerThread::~UdpServerThread()
 	{
 		hmutex::ScopeLock lock(&this->streamsMutex);
-		harray<hstream*> streams = this->streams;
-		this->remoteHosts.clear();
-		this->remotePorts.clear();
-		this->streams.clear();
+		harray<Datagram> datagrams = this->datagrams;
+		this->datagrams.clear();
 		lock.release();
-		foreach (hstream*, it, streams)
+		foreach (Datagram, it, datagrams)
 		{
-			delete (*it);
+			delete (*it).stream;
 		}
 	}
 
 	void UdpServerThread::_updateProcess()
 	{
-		Host remoteHost;
-		unsigned short remotePort = 0;
-		hstream* stream = new hstream();
+		Datagram datagram;
+		datagram.stream = new hstream();
 		hmutex::ScopeLock lock;
 		while (this->isRunning() && this->executing)
 		{
-			if (this->socket->receiveFrom(stream, remoteHost, remotePort) && stream->size() > 0)
+			// the sender is kept as a binary address, hosts are only resolved for new peers
+			datagram.addressSize = SAKIT_UDP_PEER_ADDRESS_SIZE;
+			if (this->socket->receiveFromAddress(datagram.stream, datagram.address, datagram.addressSize) && datagram.stream->size() > 0)
 			{
-				stream->rewind();
+				datagram.stream->rewind();
 				lock.acquire(&this->streamsMutex);
-				this->remoteHosts += remoteHost;
-				this->remotePorts += remotePort;
-				this->streams += stream;
+				this->datagrams += datagram;
 				lock.release();
-				remoteHost = Host();
-				remotePort = 0;
-				stream = new hstream();
+				datagram.stream = new hstream();
 			}
 			hthread::sleep(*this->retryFrequency * 1000.0f);
 		}
-		delete stream;
+		delete datagram.stream;
 		lock.acquire(&this->resultMutex);
 		this->result = State::Finished;
 	}
@@ -18,6 +18,7 @@
 
 #include "Server.h"
 #include "TimedThread.h"
+#include "UdpPeer.h"
 
 namespace sakit
 {
@@ -33,9 +34,18 @@ namespace sakit
 		~UdpServerThread();
 
 	protected:
-		harray<Host> remoteHosts;
-		harray<unsigned short> remotePorts;
-		harray<hstream*> streams;
+		class Datagram
+		{
+		public:
+			unsigned char address[SAKIT_UDP_PEER_ADDRESS_SIZE];
+			int addressSize;
+			hstream* stream;
+
+			Datagram();
+
+		};
+
+		harray<Datagram> datagrams;
 		hmutex streamsMutex;
 
 		void _updateProcess() override;
@@ -22,6 +22,18 @@
 
 namespace sakit
 {
+	UdpSocket::MulticastMembership::MulticastMembership(Host interfaceHost, Host groupAddress, Host sourceHost)
+	{
+		this->interfaceHost = interfaceHost;
+		this->groupAddress = groupAddress;
+		this->sourceHost = sourceHost;
+	}
+
+	bool UdpSocket::MulticastMembership::operator==(const MulticastMembership& other) const
+	{
+		return (this->interfaceHost == other.interfaceHost && this->groupAddress == other.groupAddress && this->sourceHost == other.sourceHost);
+	}
+
 	UdpSocket::UdpSocket(UdpSocketDelegate* socketDelegate) :
 		Socket(dynamic_cast<SocketDelegate*>(socketDelegate), State::Bound),
 		Binder(this->socket, dynamic_cast<BinderDelegate*>(socketDelegate))
@@ -53,17 +65,22 @@ namespace sakit
 		this->localHost = Host();
 		this->localPort = 0;
 		this->multicastHosts.clear();
+		this->multicastMemberships.clear();
+		this->groupDelegates.clear();
 		this->socket->disconnect();
 	}
 
 	bool UdpSocket::setDestination(Host remoteHost, unsigned short remotePort)
 	{
 		hmutex::ScopeLock lock(&this->mutexState);
-		if (!this->_canSetDestination(this->state))
+		State state = this->state;
+		do
 		{
-			return false;
-		}
-		this->state = State::Connecting; // just a precaution
+			if (!this->_canSetDestination(state))
+			{
+				return false;
+			}
+		} while (!this->state.compareExchange(state, State::Connecting)); // just a precaution
 		lock.release();
 		// this is not a real connect on UDP, it just does its job of setting a proper remote host
 		bool result = this->socket->connect(remoteHost, remotePort, this->localHost, this->localPort, this->timeout, this->retryFrequency);
@@ -83,6 +100,11 @@ namespace sakit
 	}
 
 	bool UdpSocket::joinMulticastGroup(Host interfaceHost, Host groupAddress)
+	{
+		return this->joinMulticastGroup(interfaceHost, groupAddress, Host());
+	}
+
+	bool UdpSocket::joinMulticastGroup(Host interfaceHost, Host groupAddress, Host sourceHost, UdpSocketDelegate* groupDelegate)
 	{
 		hmutex::ScopeLock lock(&this->mutexState);
 		if (!this->_canJoinMulticastGroup(this->state))
@@ -90,20 +112,44 @@ namespace sakit
 			return false;
 		}
 		lock.release();
-		bool result = this->socket->joinMulticastGroup(interfaceHost, groupAddress);
+		bool result = this->socket->joinMulticastGroup(interfaceHost, groupAddress, sourceHost);
 		if (result)
 		{
-			this->multicastHosts += std::pair<Host, Host>(interfaceHost, groupAddress);
+			if (!this->socket->isReceiveDestination())
+			{
+				// without it datagrams can't be told apart by group, they still arrive though
+				this->socket->setReceiveDestination(true);
+			}
+			std::pair<Host, Host> pair(interfaceHost, groupAddress);
+			if (!this->multicastHosts.has(pair))
+			{
+				this->multicastHosts += pair;
+			}
+			this->multicastMemberships += MulticastMembership(interfaceHost, groupAddress, sourceHost);
+			this->groupDelegates[groupAddress.toString()] = (groupDelegate != NULL ? groupDelegate : this->udpSocketDelegate);
 		}
 		return result;
 	}
 
 	bool UdpSocket::leaveMulticastGroup(Host interfaceHost, Host groupAddress)
 	{
-		std::pair<Host, Host> pair(interfaceHost, groupAddress);
-		if (!this->multicastHosts.has(pair))
+		return this->leaveMulticastGroup(interfaceHost, groupAddress, Host());
+	}
+
+	bool UdpSocket::leaveMulticastGroup(Host interfaceHost, Host groupAddress, Host sourceHost)
+	{
+		MulticastMembership membership(interfaceHost, groupAddress, sourceHost);
+		if (!this->multicastMemberships.has(membership))
 		{
-			hlog::warnf(logTag, "Cannot leave multicast group, interface %s is not assigned to group %s!", interfaceHost.toString().cStr(), groupAddress.toString().cStr());
+			if (sourceHost.toString() != "")
+			{
+				hlog::warnf(logTag, "Cannot leave multicast group, interface %s is not assigned to group %s with source %s!",
+					interfaceHost.toString().cStr(), groupAddress.toString().cStr(), sourceHost.toString().cStr());
+			}
+			else
+			{
+				hlog::warnf(logTag, "Cannot leave multicast group, interface %s is not assigned to group %s!", interfaceHost.toString().cStr(), groupAddress.toString().cStr());
+			}
 			return false;
 		}
 		hmutex::ScopeLock lock(&this->mutexState);
@@ -112,10 +158,31 @@ namespace sakit
 			return false;
 		}
 		lock.release();
-		bool result = this->socket->leaveMulticastGroup(interfaceHost, groupAddress);
+		bool result = this->socket->leaveMulticastGroup(interfaceHost, groupAddress, sourceHost);
 		if (result)
 		{
-			this->multicastHosts -= pair;
+			this->multicastMemberships -= membership;
+			bool interfaceJoined = false;
+			bool groupJoined = false;
+			foreach (MulticastMembership, it, this->multicastMemberships)
+			{
+				if ((*it).groupAddress == groupAddress)
+				{
+					groupJoined = true;
+					if ((*it).interfaceHost == interfaceHost)
+					{
+						interfaceJoined = true;
+					}
+				}
+			}
+			if (!interfaceJoined)
+			{
+				this->multicastHosts -= std::pair<Host, Host>(interfaceHost, groupAddress);
+			}
+			if (!groupJoined)
+			{
+				this->groupDelegates.removeKey(groupAddress.toString());
+			}
 		}
 		return result;
 	}
@@ -147,7 +214,7 @@ namespace sakit
 			return;
 		}
 		this->broadcaster->result = State::Idle;
-		this->state = (this->state == State::SendingReceiving ? State::Receiving : this->idleState);
+		this->_endSending();
 		lockThreadResult.release();
 		lock.release();
 		// delegate calls
@@ -163,43 +230,35 @@ namespace sakit
 
 	void UdpSocket::_updateReceiving()
 	{
-		harray<Host> remoteHosts;
-		harray<unsigned short> remotePorts;
-		harray<hstream*> streams;
-		hmutex::ScopeLock lock(&this->mutexState);
-		hmutex::ScopeLock lockThreadResult(&this->receiver->resultMutex);
-		hmutex::ScopeLock lockThreadStreams(&this->udpReceiver->streamsMutex);
-		if (this->udpReceiver->streams.size() > 0)
+		// polling a receiver without new data or result costs only atomic loads
+		bool finished = this->udpReceiver->resultReady.load(std::memory_order_acquire);
+		if (!finished && this->udpReceiver->datagrams.isEmpty())
+		{
+			return;
+		}
+		UdpReceiverThread::Datagram datagram;
+		while (this->udpReceiver->_dequeue(datagram, finished))
 		{
-			remoteHosts = this->udpReceiver->remoteHosts;
-			remotePorts = this->udpReceiver->remotePorts;
-			streams = this->udpReceiver->streams;
-			this->udpReceiver->remoteHosts.clear();
-			this->udpReceiver->remotePorts.clear();
-			this->udpReceiver->streams.clear();
+			this->_dispatchReceived(datagram.remoteHost, datagram.remotePort, datagram.destinationHost, datagram.stream);
+			delete datagram.stream;
 		}
-		lockThreadStreams.release();
+		if (!finished)
+		{
+			return;
+		}
+		hmutex::ScopeLock lock(&this->mutexState);
+		hmutex::ScopeLock lockThreadResult(&this->receiver->resultMutex);
 		State result = this->receiver->result;
+		// a delegate call could have stopped receiving and processed the result already
 		if (result == State::Running || result == State::Idle)
 		{
-			lockThreadResult.release();
-			lock.release();
-			for_iter (i, 0, streams.size())
-			{
-				this->udpSocketDelegate->onReceived(this, remoteHosts[i], remotePorts[i], streams[i]);
-				delete streams[i];
-			}
 			return;
 		}
+		this->udpReceiver->resultReady.store(false, std::memory_order_relaxed);
 		this->receiver->result = State::Idle;
-		this->state = (this->state == State::SendingReceiving ? State::Sending : this->idleState);
+		this->_endReceiving();
 		lockThreadResult.release();
 		lock.release();
-		for_iter (i, 0, streams.size())
-		{
-			this->udpSocketDelegate->onReceived(this, remoteHosts[i], remotePorts[i], streams[i]);
-			delete streams[i];
-		}
 		// delegate calls
 		if (result == State::Finished)
 		{
@@ -207,6 +266,20 @@ namespace sakit
 		}
 	}
 
+	void UdpSocket::_dispatchReceived(Host remoteHost, unsigned short remotePort, Host destinationHost, hstream* stream)
+	{
+		// unicast and broadcast datagrams have a destination that isn't a joined group
+		UdpSocketDelegate* groupDelegate = (this->groupDelegates.size() > 0 ? this->groupDelegates.tryGet(destinationHost.toString(), NULL) : NULL);
+		if (groupDelegate != NULL)
+		{
+			groupDelegate->onReceivedMulticast(this, destinationHost, remoteHost, remotePort, stream);
+		}
+		else
+		{
+			this->udpSocketDelegate->onReceived(this, remoteHost, remotePort, stream);
+		}
+	}
+
 	int UdpSocket::receive(hstream* stream, Host& remoteHost, unsigned short& remotePort)
 	{
 		if (!this->_prepareReceive(stream))
@@ -246,16 +319,12 @@ namespace sakit
 		{
 			return false;
 		}
-		hmutex::ScopeLock lock(&this->mutexState);
-		if (!this->_canSend(this->state))
+		if (!this->_beginSending())
 		{
 			return false;
 		}
-		this->state = (this->state == State::Receiving ? State::SendingReceiving : State::Sending);
-		lock.release();
 		bool result = this->socket->broadcast(adapters, remotePort, stream, count);
-		lock.acquire(&this->mutexState);
-		this->state = (this->state == State::SendingReceiving ? State::Receiving : this->idleState);
+		this->_endSending();
 		return result;
 	}
 
@@ -286,13 +355,11 @@ namespace sakit
 		{
 			return false;
 		}
-		hmutex::ScopeLock lock(&this->mutexState);
-		hmutex::ScopeLock lockThreadResult(&this->broadcaster->resultMutex);
-		if (!this->_canSend(this->state))
+		if (!this->_beginSending())
 		{
 			return false;
 		}
-		this->state = (this->state == State::Receiving ? State::SendingReceiving : State::Sending);
+		hmutex::ScopeLock lockThreadResult(&this->broadcaster->resultMutex);
 		this->broadcaster->result = State::Running;
 		this->broadcaster->stream->clear();
 		this->broadcaster->stream->writeRaw(*stream, (int)hmin((int64_t)count, stream->size() - stream->position()));
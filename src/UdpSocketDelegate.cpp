@@ -20,6 +20,11 @@ namespace sakit
 	{
 	}
 
+	void UdpSocketDelegate::onReceivedMulticast(UdpSocket* socket, Host groupAddress, Host remoteHost, unsigned short remotePort, hstream* stream)
+	{
+		this->onReceived(socket, remoteHost, remotePort, stream);
+	}
+
 	void UdpSocketDelegate::onBroadcastFinished(UdpSocket* socket)
 	{
 	}
@@ -78,6 +78,17 @@ namespace sakit
 			this->scheme = SAKIT_HTTPS_SCHEME;
 			hlog::warn(logTag, "URL uses HTTPS, but SSL isn't properly supported in SAKit yet: " + url);
 		}
+		else if (url.startsWith(SAKIT_WS_SCHEME))
+		{
+			newUrl = newUrl(strlen(SAKIT_WS_SCHEME), -1);
+			this->scheme = SAKIT_WS_SCHEME;
+		}
+		else if (url.startsWith(SAKIT_WSS_SCHEME))
+		{
+			newUrl = newUrl(strlen(SAKIT_WSS_SCHEME), -1);
+			this->scheme = SAKIT_WSS_SCHEME;
+			hlog::warn(logTag, "URL uses WSS, but SSL isn't properly supported in SAKit yet: " + url);
+		}
 		this->host = newUrl;
 		int index = 0;
 		hstr query;
@@ -0,0 +1,1039 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define _SAKIT_SSE2
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define _SAKIT_NEON
+#endif
+
+#ifdef _SAKIT_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef _SAKIT_NEON
+#include <arm_neon.h>
+#endif
+#include <string.h>
+
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
+#include "HttpServerRequest.h"
+#include "HttpSocket.h"
+#include "sakit.h"
+#include "TcpSocket.h"
+#include "WebSocket.h"
+#include "WebSocketDelegate.h"
+#include "WebSocketServer.h"
+#include "WebSocketServerDelegate.h"
+
+#define OPCODE_CONTINUATION 0x0
+#define OPCODE_TEXT 0x1
+#define OPCODE_BINARY 0x2
+#define OPCODE_CLOSE 0x8
+#define OPCODE_PING 0x9
+#define OPCODE_PONG 0xA
+
+#define HEADER_HOST "Host"
+#define HEADER_UPGRADE "Upgrade"
+#define HEADER_SEC_WEB_SOCKET_KEY "Sec-WebSocket-Key"
+#define HEADER_SEC_WEB_SOCKET_ACCEPT "Sec-WebSocket-Accept"
+#define HEADER_SEC_WEB_SOCKET_VERSION "Sec-WebSocket-Version"
+#define WEB_SOCKET_VERSION "13"
+#define WEB_SOCKET_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define MAX_HANDSHAKE_SIZE 16384
+#define MAX_CONTROL_PAYLOAD_SIZE 125
+
+namespace sakit
+{
+	static inline unsigned int _rotateLeft(unsigned int value, int count)
+	{
+		return ((value << count) | (value >> (32 - count)));
+	}
+
+	static void _sha1(const unsigned char* data, int size, unsigned char* digest)
+	{
+		unsigned int h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+		unsigned int w[80];
+		unsigned char block[64];
+		unsigned int a = 0;
+		unsigned int b = 0;
+		unsigned int c = 0;
+		unsigned int d = 0;
+		unsigned int e = 0;
+		unsigned int f = 0;
+		unsigned int k = 0;
+		unsigned int temp = 0;
+		int64_t bitSize = (int64_t)size * 8;
+		// the message is padded with 0x80, zeros and the size in bits to a multiple of 64 bytes
+		int blockCount = (size + 8) / 64 + 1;
+		int offset = 0;
+		for_iter (i, 0, blockCount)
+		{
+			for_iter (j, 0, 64)
+			{
+				offset = i * 64 + j;
+				if (offset < size)
+				{
+					block[j] = data[offset];
+				}
+				else if (offset == size)
+				{
+					block[j] = 0x80;
+				}
+				else if (i == blockCount - 1 && j >= 56)
+				{
+					block[j] = (unsigned char)(bitSize >> ((63 - j) * 8));
+				}
+				else
+				{
+					block[j] = 0;
+				}
+			}
+			for_iter (j, 0, 16)
+			{
+				w[j] = ((unsigned int)block[j * 4] << 24) | ((unsigned int)block[j * 4 + 1] << 16) | ((unsigned int)block[j * 4 + 2] << 8) | block[j * 4 + 3];
+			}
+			for_iter (j, 16, 80)
+			{
+				w[j] = _rotateLeft(w[j - 3] ^ w[j - 8] ^ w[j - 14] ^ w[j - 16], 1);
+			}
+			a = h[0];
+			b = h[1];
+			c = h[2];
+			d = h[3];
+			e = h[4];
+			for_iter (j, 0, 80)
+			{
+				if (j < 20)
+				{
+					f = (b & c) | (~b & d);
+					k = 0x5A827999;
+				}
+				else if (j < 40)
+				{
+					f = b ^ c ^ d;
+					k = 0x6ED9EBA1;
+				}
+				else if (j < 60)
+				{
+					f = (b & c) | (b & d) | (c & d);
+					k = 0x8F1BBCDC;
+				}
+				else
+				{
+					f = b ^ c ^ d;
+					k = 0xCA62C1D6;
+				}
+				temp = _rotateLeft(a, 5) + f + e + k + w[j];
+				e = d;
+				d = c;
+				c = _rotateLeft(b, 30);
+				b = a;
+				a = temp;
+			}
+			h[0] += a;
+			h[1] += b;
+			h[2] += c;
+			h[3] += d;
+			h[4] += e;
+		}
+		for_iter (i, 0, 20)
+		{
+			digest[i] = (unsigned char)(h[i / 4] >> ((3 - i % 4) * 8));
+		}
+	}
+
+	static hstr _encodeBase64(const unsigned char* data, int size)
+	{
+		static const char* characters = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+		hstr result;
+		unsigned int value = 0;
+		for (int i = 0; i < size; i += 3)
+		{
+			value = (unsigned int)data[i] << 16;
+			if (i + 1 < size)
+			{
+				value |= (unsigned int)data[i + 1] << 8;
+			}
+			if (i + 2 < size)
+			{
+				value |= data[i + 2];
+			}
+			result += characters[(value >> 18) & 0x3F];
+			result += characters[(value >> 12) & 0x3F];
+			result += (i + 1 < size ? characters[(value >> 6) & 0x3F] : '=');
+			result += (i + 2 < size ? characters[value & 0x3F] : '=');
+		}
+		return result;
+	}
+
+	WebSocket::WebSocket(WebSocketDelegate* webSocketDelegate) :
+		TcpSocketDelegate(),
+		server(NULL),
+		state(State::Idle),
+		maxMessageSize(16777216),
+		maxFrameSize(0),
+		opened(false),
+		handshakeRequest(NULL),
+		acceptTime(0LL),
+		headerSize(0),
+		frameStarted(false),
+		frameOpcode(0),
+		frameFinal(false),
+		frameMasked(false),
+		frameRemaining(0LL),
+		maskOffset(0),
+		messageOpcode(0),
+		closeSent(false),
+		closeReceived(false),
+		closeCode(SAKIT_WEB_SOCKET_CLOSE_NO_STATUS)
+	{
+		this->webSocketDelegate = webSocketDelegate;
+		this->socket = new TcpSocket(this);
+	}
+
+	WebSocket::WebSocket(WebSocketServer* server, TcpSocket* socket) :
+		TcpSocketDelegate(),
+		state(State::Connecting),
+		opened(false),
+		headerSize(0),
+		frameStarted(false),
+		frameOpcode(0),
+		frameFinal(false),
+		frameMasked(false),
+		frameRemaining(0LL),
+		maskOffset(0),
+		messageOpcode(0),
+		closeSent(false),
+		closeReceived(false),
+		closeCode(SAKIT_WEB_SOCKET_CLOSE_NO_STATUS)
+	{
+		this->webSocketDelegate = server->webSocketDelegate;
+		this->socket = socket;
+		this->server = server;
+		this->maxMessageSize = server->maxMessageSize;
+		this->maxFrameSize = server->maxFrameSize;
+		this->handshakeRequest = new HttpServerRequest();
+		this->acceptTime = (int64_t)htickCount();
+		this->socket->startReceiveAsync();
+	}
+
+	WebSocket::~WebSocket()
+	{
+		delete this->socket;
+		if (this->handshakeRequest != NULL)
+		{
+			delete this->handshakeRequest;
+		}
+	}
+
+	bool WebSocket::isOpen()
+	{
+		return (this->state == State::Connected);
+	}
+
+	bool WebSocket::isClosing()
+	{
+		return (this->state == State::Disconnecting);
+	}
+
+	bool WebSocket::connect(Url url, hmap<hstr, hstr> customHeaders)
+	{
+		if (!this->_prepareConnect(url))
+		{
+			return false;
+		}
+		unsigned short port = (url.getPort() == 0 ? HttpSocket::DefaultPort : url.getPort());
+		if (!this->socket->connect(Host(url.getHost()), port))
+		{
+			return false;
+		}
+		hstr request = this->_makeHandshake(url, customHeaders);
+		this->state = State::Connecting;
+		if (this->socket->send(request) != request.size())
+		{
+			this->socket->disconnect();
+			this->state = State::Idle;
+			return false;
+		}
+		// the handshake is received synchronously, everything after it asynchronously
+		hstream stream;
+		int count = 0;
+		while (this->state == State::Connecting)
+		{
+			stream.clear();
+			if (this->socket->receive(&stream) == 0)
+			{
+				break;
+			}
+			count = this->_processClientHandshake(&stream[0], (int)stream.size());
+			if (count < 0)
+			{
+				break;
+			}
+		}
+		if (this->state != State::Connected)
+		{
+			hlog::warn(logTag, "WebSocket handshake failed: " + url.toString());
+			this->socket->disconnect();
+			this->state = State::Idle;
+			return false;
+		}
+		this->opened = true;
+		this->socket->startReceiveAsync();
+		if (count < stream.size())
+		{
+			this->_processData(&stream[count], (int)stream.size() - count);
+		}
+		return true;
+	}
+
+	bool WebSocket::connectAsync(Url url, hmap<hstr, hstr> customHeaders)
+	{
+		if (!this->_prepareConnect(url))
+		{
+			return false;
+		}
+		unsigned short port = (url.getPort() == 0 ? HttpSocket::DefaultPort : url.getPort());
+		hstr request = this->_makeHandshake(url, customHeaders);
+		if (!this->socket->connectAsync(Host(url.getHost()), port))
+		{
+			return false;
+		}
+		this->sendQueue.writeRaw(request.cStr(), request.size());
+		this->state = State::Connecting;
+		return true;
+	}
+
+	bool WebSocket::sendText(chstr text)
+	{
+		return this->_sendMessage(OPCODE_TEXT, (const unsigned char*)text.cStr(), text.size());
+	}
+
+	bool WebSocket::sendBinary(hstream* stream, int count)
+	{
+		count = (int)hmin((int64_t)count, stream->size() - stream->position());
+		if (count <= 0)
+		{
+			return this->_sendMessage(OPCODE_BINARY, NULL, 0);
+		}
+		bool result = this->_sendMessage(OPCODE_BINARY, &(*stream)[(int)stream->position()], count);
+		if (result)
+		{
+			stream->seek(count);
+		}
+		return result;
+	}
+
+	bool WebSocket::ping(chstr payload)
+	{
+		if (payload.size() > MAX_CONTROL_PAYLOAD_SIZE)
+		{
+			hlog::warn(logTag, "Cannot ping, payload is too large!");
+			return false;
+		}
+		return this->_sendMessage(OPCODE_PING, (const unsigned char*)payload.cStr(), payload.size());
+	}
+
+	bool WebSocket::close(unsigned short code, chstr reason)
+	{
+		if (this->state != State::Connected)
+		{
+			hlog::warn(logTag, "Cannot close, WebSocket is not open!");
+			return false;
+		}
+		this->_queueClose(code, reason);
+		this->closeCode = code;
+		this->closeReason = reason;
+		this->state = State::Disconnecting;
+		return this->_flushSend();
+	}
+
+	void WebSocket::onConnected(Connector* connector, Host remoteHost, unsigned short remotePort)
+	{
+		// the handshake request was already queued
+		this->_flushSend();
+		this->socket->startReceiveAsync();
+	}
+
+	void WebSocket::onConnectFailed(Connector* connector, Host remoteHost, unsigned short remotePort)
+	{
+		this->sendQueue.clear();
+		this->state = State::Idle;
+		this->webSocketDelegate->onOpenFailed(this);
+	}
+
+	void WebSocket::onReceived(TcpSocket* socket, hstream* stream)
+	{
+		if (stream->size() > 0)
+		{
+			this->_processData(&(*stream)[0], (int)stream->size());
+		}
+	}
+
+	void WebSocket::onReceiveFinished(Socket* socket)
+	{
+		this->_updateClose();
+	}
+
+	void WebSocket::onReceiveFailed(TcpSocket* socket)
+	{
+		this->_abort();
+	}
+
+	void WebSocket::onSendFinished(Socket* socket)
+	{
+		this->_flushSend();
+		this->_updateClose();
+	}
+
+	void WebSocket::onSendFailed(Socket* socket)
+	{
+		this->_abort();
+	}
+
+	bool WebSocket::_prepareConnect(Url& url)
+	{
+		if (this->server != NULL)
+		{
+			hlog::warn(logTag, "Cannot connect, WebSocket was accepted by a server!");
+			return false;
+		}
+		if (this->state != State::Idle)
+		{
+			hlog::warn(logTag, "Cannot connect, WebSocket is already connected!");
+			return false;
+		}
+		if (!url.isValid())
+		{
+			hlog::warn(logTag, "Cannot connect, URL is not valid!");
+			return false;
+		}
+		this->handshake.clear();
+		this->sendQueue.clear();
+		this->message.clear();
+		this->control.clear();
+		this->headerSize = 0;
+		this->frameStarted = false;
+		this->messageOpcode = 0;
+		this->closeSent = false;
+		this->closeReceived = false;
+		this->closeCode = SAKIT_WEB_SOCKET_CLOSE_NO_STATUS;
+		this->closeReason = "";
+		return true;
+	}
+
+	hstr WebSocket::_makeHandshake(Url& url, hmap<hstr, hstr> customHeaders)
+	{
+		unsigned char nonce[16];
+		for_iter (i, 0, 16)
+		{
+			nonce[i] = (unsigned char)hrand(256);
+		}
+		this->key = _encodeBase64(nonce, 16);
+		if (!customHeaders.hasKey(HEADER_HOST))
+		{
+			customHeaders[HEADER_HOST] = (url.getPort() == 0 ? url.getHost() : url.getHost() + ":" + hstr(url.getPort()));
+		}
+		customHeaders[HEADER_UPGRADE] = "websocket";
+		customHeaders[SAKIT_HTTP_REQUEST_HEADER_CONNECTION] = "Upgrade";
+		customHeaders[HEADER_SEC_WEB_SOCKET_KEY] = this->key;
+		customHeaders[HEADER_SEC_WEB_SOCKET_VERSION] = WEB_SOCKET_VERSION;
+		hstr path = url.toString(false, true);
+		if (!path.startsWith("/"))
+		{
+			path = "/" + path;
+		}
+		hstr request = "GET " + path + " HTTP/1.1\r\n";
+		foreach_map (hstr, hstr, it, customHeaders)
+		{
+			request += it->first + ": " + it->second + "\r\n";
+		}
+		request += "\r\n";
+		return request;
+	}
+
+	int WebSocket::_processClientHandshake(const unsigned char* data, int size)
+	{
+		int previousSize = (int)this->handshake.size();
+		this->handshake.writeRaw(data, size);
+		hstr text((const char*)&this->handshake[0], (int)this->handshake.size());
+		int index = text.indexOf("\r\n\r\n");
+		if (index < 0)
+		{
+			return (text.size() <= MAX_HANDSHAKE_SIZE ? size : -1);
+		}
+		harray<hstr> lines = text(0, index).split("\r\n");
+		harray<hstr> status = lines.removeFirst().split(' ', 2);
+		if (status.size() < 2 || status[1] != "101")
+		{
+			return -1;
+		}
+		hmap<hstr, hstr> headers;
+		int colon = 0;
+		foreach (hstr, it, lines)
+		{
+			colon = (*it).indexOf(':');
+			if (colon > 0)
+			{
+				headers[(*it)(0, colon).lowered()] = (*it)(colon + 1, -1).trimmed();
+			}
+		}
+		if (headers.tryGet("upgrade", "").lowered() != "websocket" || !headers.tryGet("connection", "").lowered().contains("upgrade") ||
+			headers.tryGet("sec-websocket-accept", "") != WebSocket::_makeAccept(this->key))
+		{
+			return -1;
+		}
+		this->handshake.clear();
+		this->state = State::Connected;
+		return (index + 4 - previousSize);
+	}
+
+	int WebSocket::_processServerHandshake(const unsigned char* data, int size)
+	{
+		int previousSize = (int)this->handshake.size();
+		this->handshake.writeRaw(data, size);
+		HttpServerRequest* request = this->handshakeRequest;
+		int result = request->_parse(&this->handshake[0], (int)this->handshake.size(), MAX_HANDSHAKE_SIZE, 0);
+		if (result == 0)
+		{
+			return size;
+		}
+		hstr key = request->getHeader(HEADER_SEC_WEB_SOCKET_KEY);
+		if (result < 0 || request->method != "GET" || request->getHeader(HEADER_UPGRADE).lowered() != "websocket" ||
+			!request->getHeader(SAKIT_HTTP_REQUEST_HEADER_CONNECTION).lowered().contains("upgrade") ||
+			request->getHeader(HEADER_SEC_WEB_SOCKET_VERSION) != WEB_SOCKET_VERSION || key == "")
+		{
+			hstr response = "HTTP/1.1 400 Bad Request\r\n" HEADER_SEC_WEB_SOCKET_VERSION ": " WEB_SOCKET_VERSION "\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+			this->sendQueue.writeRaw(response.cStr(), response.size());
+			return -1;
+		}
+		hstr response = "HTTP/1.1 101 Switching Protocols\r\n" HEADER_UPGRADE ": websocket\r\nConnection: Upgrade\r\n" HEADER_SEC_WEB_SOCKET_ACCEPT ": " +
+			WebSocket::_makeAccept(key) + "\r\n\r\n";
+		this->sendQueue.writeRaw(response.cStr(), response.size());
+		this->_flushSend();
+		this->handshake.clear();
+		delete this->handshakeRequest;
+		this->handshakeRequest = NULL;
+		this->state = State::Connected;
+		return (result - previousSize);
+	}
+
+	void WebSocket::_failHandshake()
+	{
+		this->closeSent = true;
+		this->closeReceived = true;
+		this->state = State::Disconnecting;
+		this->_flushSend();
+		if (this->server == NULL)
+		{
+			this->webSocketDelegate->onOpenFailed(this);
+		}
+		this->_updateClose();
+	}
+
+	void WebSocket::_processData(const unsigned char* data, int size)
+	{
+		int offset = 0;
+		int count = 0;
+		if (this->state == State::Connecting)
+		{
+			offset = (this->server != NULL ? this->_processServerHandshake(data, size) : this->_processClientHandshake(data, size));
+			if (offset < 0)
+			{
+				this->_failHandshake();
+				return;
+			}
+			if (this->state != State::Connected)
+			{
+				return;
+			}
+			this->opened = true;
+			if (this->server != NULL)
+			{
+				this->server->webSocketServerDelegate->onOpened(this->server, this);
+			}
+			else
+			{
+				this->webSocketDelegate->onOpened(this);
+			}
+		}
+		while (offset < size && !this->closeReceived)
+		{
+			if (!this->frameStarted)
+			{
+				count = this->_readFrameHeader(&data[offset], size - offset);
+				if (count < 0)
+				{
+					return;
+				}
+				offset += count;
+			}
+			else
+			{
+				count = (int)hmin(this->frameRemaining, (int64_t)(size - offset));
+				this->_readPayload(&data[offset], count);
+				offset += count;
+			}
+			if (this->frameStarted && this->frameRemaining == 0 && !this->_finishFrame())
+			{
+				return;
+			}
+		}
+	}
+
+	int WebSocket::_readFrameHeader(const unsigned char* data, int size)
+	{
+		int count = 0;
+		int requiredSize = 2;
+		unsigned char lengthCode = 0;
+		while (true)
+		{
+			if (this->headerSize >= 2)
+			{
+				lengthCode = (this->header[1] & 0x7F);
+				requiredSize = 2 + (lengthCode == 126 ? 2 : (lengthCode == 127 ? 8 : 0)) + ((this->header[1] & 0x80) != 0 ? 4 : 0);
+			}
+			if (this->headerSize >= requiredSize)
+			{
+				break;
+			}
+			if (count >= size)
+			{
+				return count;
+			}
+			this->header[this->headerSize] = data[count];
+			++this->headerSize;
+			++count;
+		}
+		this->headerSize = 0;
+		unsigned char opcode = (this->header[0] & 0x0F);
+		bool final = ((this->header[0] & 0x80) != 0);
+		bool masked = ((this->header[1] & 0x80) != 0);
+		int offset = 2;
+		int64_t length = lengthCode;
+		if (lengthCode == 126)
+		{
+			length = ((int64_t)this->header[2] << 8) | this->header[3];
+			offset = 4;
+		}
+		else if (lengthCode == 127)
+		{
+			length = 0LL;
+			for_iter (i, 2, 10)
+			{
+				length = (length << 8) | this->header[i];
+			}
+			offset = 10;
+		}
+		// no extensions are negotiated so the reserved bits have to be 0, only clients mask their frames
+		if ((this->header[0] & 0x70) != 0 || masked != (this->server != NULL) || length < 0)
+		{
+			this->_fail(SAKIT_WEB_SOCKET_CLOSE_PROTOCOL_ERROR);
+			return -1;
+		}
+		if (opcode >= OPCODE_CLOSE)
+		{
+			if (opcode > OPCODE_PONG || !final || length > MAX_CONTROL_PAYLOAD_SIZE)
+			{
+				this->_fail(SAKIT_WEB_SOCKET_CLOSE_PROTOCOL_ERROR);
+				return -1;
+			}
+		}
+		else
+		{
+			// continuations need a started message and new messages can't start before the current one is finished
+			if (opcode > OPCODE_BINARY || (opcode == OPCODE_CONTINUATION) != (this->messageOpcode != 0))
+			{
+				this->_fail(SAKIT_WEB_SOCKET_CLOSE_PROTOCOL_ERROR);
+				return -1;
+			}
+			// written as a difference so a huge length can't overflow the sum
+			if (length > (int64_t)this->maxMessageSize - this->message.size())
+			{
+				this->_fail(SAKIT_WEB_SOCKET_CLOSE_MESSAGE_TOO_BIG);
+				return -1;
+			}
+			if (opcode != OPCODE_CONTINUATION)
+			{
+				this->messageOpcode = opcode;
+			}
+		}
+		if (masked)
+		{
+			memcpy(this->frameMask, &this->header[offset], 4);
+		}
+		this->frameStarted = true;
+		this->frameOpcode = opcode;
+		this->frameFinal = final;
+		this->frameMasked = masked;
+		this->frameRemaining = length;
+		this->maskOffset = 0;
+		return count;
+	}
+
+	void WebSocket::_readPayload(const unsigned char* data, int size)
+	{
+		// the payload is unmasked right where it's copied to, there is no intermediate buffer
+		hstream* stream = (this->frameOpcode >= OPCODE_CLOSE ? &this->control : &this->message);
+		int position = (int)stream->size();
+		stream->writeRaw(data, size);
+		if (this->frameMasked && size > 0)
+		{
+			WebSocket::_applyMask(&(*stream)[position], size, this->frameMask, this->maskOffset);
+			this->maskOffset = (this->maskOffset + size) & 3;
+		}
+		this->frameRemaining -= size;
+	}
+
+	bool WebSocket::_finishFrame()
+	{
+		this->frameStarted = false;
+		if (this->frameOpcode < OPCODE_CLOSE)
+		{
+			if (this->frameFinal)
+			{
+				bool binary = (this->messageOpcode == OPCODE_BINARY);
+				this->messageOpcode = 0;
+				if (!binary && this->message.size() > 0 && !WebSocket::_isValidUtf8(&this->message[0], (int)this->message.size()))
+				{
+					this->message.clear();
+					this->_fail(SAKIT_WEB_SOCKET_CLOSE_INVALID_PAYLOAD);
+					return false;
+				}
+				this->message.rewind();
+				this->webSocketDelegate->onMessage(this, &this->message, binary);
+				this->message.clear();
+			}
+			return true;
+		}
+		int size = (int)this->control.size();
+		this->control.rewind();
+		if (this->frameOpcode == OPCODE_PING)
+		{
+			if (this->state == State::Connected)
+			{
+				this->_queueFrame(OPCODE_PONG, true, (size > 0 ? &this->control[0] : NULL), size);
+				this->_flushSend();
+			}
+			this->webSocketDelegate->onPing(this, &this->control);
+		}
+		else if (this->frameOpcode == OPCODE_PONG)
+		{
+			this->webSocketDelegate->onPong(this, &this->control);
+		}
+		else
+		{
+			if (size == 1)
+			{
+				this->control.clear();
+				this->_fail(SAKIT_WEB_SOCKET_CLOSE_PROTOCOL_ERROR);
+				return false;
+			}
+			if (size > 2 && !WebSocket::_isValidUtf8(&this->control[2], size - 2))
+			{
+				this->control.clear();
+				this->_fail(SAKIT_WEB_SOCKET_CLOSE_INVALID_PAYLOAD);
+				return false;
+			}
+			if (!this->closeSent)
+			{
+				this->closeCode = SAKIT_WEB_SOCKET_CLOSE_NO_STATUS;
+				this->closeReason = "";
+				if (size >= 2)
+				{
+					this->closeCode = (unsigned short)((this->control[0] << 8) | this->control[1]);
+					this->closeReason = hstr((const char*)&this->control[2], size - 2);
+				}
+				// the close frame is answered with the same code
+				this->_queueClose((this->closeCode != SAKIT_WEB_SOCKET_CLOSE_NO_STATUS ? this->closeCode : SAKIT_WEB_SOCKET_CLOSE_NORMAL), "");
+				this->_flushSend();
+			}
+			this->closeReceived = true;
+			this->state = State::Disconnecting;
+			this->control.clear();
+			this->_updateClose();
+			return false;
+		}
+		this->control.clear();
+		return true;
+	}
+
+	bool WebSocket::_sendMessage(unsigned char opcode, const unsigned char* data, int size)
+	{
+		if (this->state != State::Connected)
+		{
+			hlog::warn(logTag, "Cannot send, WebSocket is not open!");
+			return false;
+		}
+		int frameSize = size;
+		if (opcode < OPCODE_CLOSE && this->maxFrameSize > 0)
+		{
+			frameSize = this->maxFrameSize;
+		}
+		int offset = 0;
+		int count = 0;
+		do
+		{
+			count = hmin(size - offset, frameSize);
+			this->_queueFrame((offset == 0 ? opcode : OPCODE_CONTINUATION), (offset + count >= size), (count > 0 ? &data[offset] : NULL), count);
+			offset += count;
+		} while (offset < size);
+		return this->_flushSend();
+	}
+
+	void WebSocket::_queueFrame(unsigned char opcode, bool final, const unsigned char* data, int size)
+	{
+		unsigned char frameHeader[14];
+		int frameHeaderSize = 2;
+		frameHeader[0] = ((final ? 0x80 : 0x00) | opcode);
+		if (size < 126)
+		{
+			frameHeader[1] = (unsigned char)size;
+		}
+		else if (size <= 0xFFFF)
+		{
+			frameHeader[1] = 126;
+			frameHeader[2] = (unsigned char)(size >> 8);
+			frameHeader[3] = (unsigned char)size;
+			frameHeaderSize = 4;
+		}
+		else
+		{
+			frameHeader[1] = 127;
+			for_iter (i, 0, 8)
+			{
+				frameHeader[2 + i] = (unsigned char)((int64_t)size >> ((7 - i) * 8));
+			}
+			frameHeaderSize = 10;
+		}
+		// clients have to mask every frame
+		unsigned char* mask = NULL;
+		if (this->server == NULL)
+		{
+			frameHeader[1] |= 0x80;
+			mask = &frameHeader[frameHeaderSize];
+			for_iter (i, 0, 4)
+			{
+				mask[i] = (unsigned char)hrand(256);
+			}
+			frameHeaderSize += 4;
+		}
+		this->sendQueue.writeRaw(frameHeader, frameHeaderSize);
+		if (size > 0)
+		{
+			int position = (int)this->sendQueue.size();
+			this->sendQueue.writeRaw(data, size);
+			if (mask != NULL)
+			{
+				WebSocket::_applyMask(&this->sendQueue[position], size, mask, 0);
+			}
+		}
+	}
+
+	void WebSocket::_queueClose(unsigned short code, chstr reason)
+	{
+		unsigned char payload[MAX_CONTROL_PAYLOAD_SIZE];
+		payload[0] = (unsigned char)(code >> 8);
+		payload[1] = (unsigned char)code;
+		int size = hmin(reason.size(), MAX_CONTROL_PAYLOAD_SIZE - 2);
+		if (size > 0)
+		{
+			memcpy(&payload[2], reason.cStr(), size);
+		}
+		this->_queueFrame(OPCODE_CLOSE, true, payload, size + 2);
+		this->closeSent = true;
+	}
+
+	bool WebSocket::_flushSend()
+	{
+		if (this->sendQueue.size() == 0 || this->socket->isSending() || !this->socket->isConnected())
+		{
+			return true;
+		}
+		this->sendQueue.rewind();
+		bool result = this->socket->sendAsync(&this->sendQueue);
+		this->sendQueue.clear();
+		return result;
+	}
+
+	void WebSocket::_fail(unsigned short code)
+	{
+		if (!this->closeSent && this->state == State::Connected)
+		{
+			this->_queueClose(code, "");
+			this->_flushSend();
+		}
+		this->closeCode = code;
+		this->closeReason = "";
+		this->closeSent = true;
+		this->closeReceived = true;
+		this->state = State::Disconnecting;
+		this->_updateClose();
+	}
+
+	void WebSocket::_abort()
+	{
+		if (this->state == State::Idle)
+		{
+			return;
+		}
+		bool connecting = (this->state == State::Connecting);
+		this->sendQueue.clear();
+		this->closeCode = SAKIT_WEB_SOCKET_CLOSE_ABNORMAL;
+		this->closeReason = "";
+		this->closeSent = true;
+		this->closeReceived = true;
+		this->state = State::Disconnecting;
+		if (connecting && this->server == NULL)
+		{
+			this->webSocketDelegate->onOpenFailed(this);
+		}
+		this->_updateClose();
+	}
+
+	void WebSocket::_updateClose()
+	{
+		if (this->state != State::Disconnecting || !this->closeSent || !this->closeReceived || this->sendQueue.size() > 0 || this->socket->isSending())
+		{
+			return;
+		}
+		// the receiver has to finish before disconnecting, this gets called again from onReceiveFinished()
+		if (this->socket->isReceiving())
+		{
+			this->socket->stopReceiveAsync();
+			return;
+		}
+		this->socket->disconnect();
+		this->state = State::Idle;
+		if (this->opened)
+		{
+			this->opened = false;
+			this->webSocketDelegate->onClosed(this, this->closeCode, this->closeReason);
+		}
+	}
+
+	hstr WebSocket::_makeAccept(chstr key)
+	{
+		hstr value = key + WEB_SOCKET_GUID;
+		unsigned char digest[20];
+		_sha1((const unsigned char*)value.cStr(), value.size(), digest);
+		return _encodeBase64(digest, 20);
+	}
+
+	void WebSocket::_applyMask(unsigned char* data, int size, const unsigned char* mask, int offset)
+	{
+		// the mask repeated 4 times so 16 bytes can be processed at once, 16 is a multiple of 4 so the pattern stays aligned
+		unsigned char pattern[16];
+		for_iter (i, 0, 16)
+		{
+			pattern[i] = mask[(offset + i) & 3];
+		}
+		int i = 0;
+#ifdef _SAKIT_SSE2
+		const __m128i vector = _mm_loadu_si128((const __m128i*)pattern);
+		for (; i + 16 <= size; i += 16)
+		{
+			_mm_storeu_si128((__m128i*)&data[i], _mm_xor_si128(_mm_loadu_si128((const __m128i*)&data[i]), vector));
+		}
+#elif defined(_SAKIT_NEON)
+		const uint8x16_t vector = vld1q_u8(pattern);
+		for (; i + 16 <= size; i += 16)
+		{
+			vst1q_u8(&data[i], veorq_u8(vld1q_u8(&data[i]), vector));
+		}
+#endif
+		uint64_t word = 0;
+		uint64_t value = 0;
+		memcpy(&word, pattern, 8);
+		for (; i + 8 <= size; i += 8)
+		{
+			memcpy(&value, &data[i], 8);
+			value ^= word;
+			memcpy(&data[i], &value, 8);
+		}
+		for (; i < size; ++i)
+		{
+			data[i] ^= pattern[i & 15];
+		}
+	}
+
+	bool WebSocket::_isValidUtf8(const unsigned char* data, int size)
+	{
+		int i = 0;
+		int count = 0;
+		unsigned int codePoint = 0;
+		uint64_t word = 0;
+		while (i < size)
+		{
+			// ASCII is checked 8 bytes at a time
+			if (i + 8 <= size)
+			{
+				memcpy(&word, &data[i], 8);
+				if ((word & 0x8080808080808080ULL) == 0)
+				{
+					i += 8;
+					continue;
+				}
+			}
+			if (data[i] < 0x80)
+			{
+				++i;
+				continue;
+			}
+			if (data[i] >= 0xC2 && data[i] <= 0xDF)
+			{
+				count = 1;
+				codePoint = (data[i] & 0x1F);
+			}
+			else if ((data[i] & 0xF0) == 0xE0)
+			{
+				count = 2;
+				codePoint = (data[i] & 0x0F);
+			}
+			else if (data[i] >= 0xF0 && data[i] <= 0xF4)
+			{
+				count = 3;
+				codePoint = (data[i] & 0x07);
+			}
+			else
+			{
+				return false;
+			}
+			if (i + count >= size)
+			{
+				return false;
+			}
+			for_iter (j, 1, count + 1)
+			{
+				if ((data[i + j] & 0xC0) != 0x80)
+				{
+					return false;
+				}
+				codePoint = ((codePoint << 6) | (data[i + j] & 0x3F));
+			}
+			if (count == 2 && (codePoint < 0x800 || (codePoint >= 0xD800 && codePoint <= 0xDFFF)))
+			{
+				return false;
+			}
+			if (count == 3 && (codePoint < 0x10000 || codePoint > 0x10FFFF))
+			{
+				return false;
+			}
+			i += count + 1;
+		}
+		return true;
+	}
+
+}
@@ -0,0 +1,48 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
+#include "WebSocketDelegate.h"
+
+namespace sakit
+{
+	WebSocketDelegate::WebSocketDelegate()
+	{
+	}
+
+	WebSocketDelegate::~WebSocketDelegate()
+	{
+	}
+
+	void WebSocketDelegate::onOpened(WebSocket* webSocket)
+	{
+	}
+
+	void WebSocketDelegate::onOpenFailed(WebSocket* webSocket)
+	{
+	}
+
+	void WebSocketDelegate::onMessage(WebSocket* webSocket, hstream* message, bool binary)
+	{
+	}
+
+	void WebSocketDelegate::onPong(WebSocket* webSocket, hstream* payload)
+	{
+	}
+
+	void WebSocketDelegate::onPing(WebSocket* webSocket, hstream* payload)
+	{
+	}
+
+	void WebSocketDelegate::onClosed(WebSocket* webSocket, unsigned short code, chstr reason)
+	{
+	}
+
+}
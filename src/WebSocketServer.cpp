@@ -0,0 +1,154 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/harray.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+
+#include "sakit.h"
+#include "Socket.h"
+#include "TcpServerThread.h"
+#include "TcpSocket.h"
+#include "WebSocket.h"
+#include "WebSocketServer.h"
+#include "WebSocketServerDelegate.h"
+
+namespace sakit
+{
+	WebSocketServer::WebSocketServer(WebSocketServerDelegate* serverDelegate, WebSocketDelegate* webSocketDelegate) :
+		TcpServer(serverDelegate, this),
+		TcpSocketDelegate(),
+		maxMessageSize(16777216),
+		maxFrameSize(0),
+		handshakeTimeout(10.0f)
+	{
+		this->webSocketServerDelegate = serverDelegate;
+		this->webSocketDelegate = webSocketDelegate;
+	}
+
+	WebSocketServer::~WebSocketServer()
+	{
+		foreach (WebSocket*, it, this->webSockets)
+		{
+			delete (*it);
+		}
+	}
+
+	harray<WebSocket*> WebSocketServer::getWebSockets()
+	{
+		harray<WebSocket*> result;
+		foreach (WebSocket*, it, this->webSockets)
+		{
+			if ((*it)->isOpen())
+			{
+				result += (*it);
+			}
+		}
+		return result;
+	}
+
+	void WebSocketServer::update(float timeDelta)
+	{
+		// accepted connections are taken over before TcpServer::update() would hand them to the delegate
+		hmutex::ScopeLock lock(&this->tcpServerThread->socketsMutex);
+		harray<TcpSocket*> sockets = this->tcpServerThread->sockets;
+		this->tcpServerThread->sockets.clear();
+		lock.release();
+		WebSocket* webSocket = NULL;
+		foreach (TcpSocket*, it, sockets)
+		{
+			webSocket = new WebSocket(this, (*it));
+			this->webSockets += webSocket;
+			this->socketWebSockets[(*it)] = webSocket;
+		}
+		harray<WebSocket*> webSockets = this->webSockets;
+		foreach (WebSocket*, it, webSockets)
+		{
+			(*it)->socket->update(timeDelta);
+		}
+		// clients that never finish the handshake would otherwise keep their connection forever
+		int64_t now = (int64_t)htickCount();
+		foreach (WebSocket*, it, webSockets)
+		{
+			if ((*it)->state == State::Connecting && now - (*it)->acceptTime >= (int64_t)(this->handshakeTimeout * 1000.0f))
+			{
+				hlog::warn(logTag, "WebSocket handshake timed out!");
+				(*it)->_failHandshake();
+			}
+		}
+		this->_removeClosedWebSockets();
+		Server::update(timeDelta);
+	}
+
+	void WebSocketServer::onReceived(TcpSocket* socket, hstream* stream)
+	{
+		TcpSocketDelegate* socketDelegate = this->_getSocketDelegate(socket);
+		if (socketDelegate != NULL)
+		{
+			socketDelegate->onReceived(socket, stream);
+		}
+	}
+
+	void WebSocketServer::onReceiveFinished(Socket* socket)
+	{
+		TcpSocketDelegate* socketDelegate = this->_getSocketDelegate(socket);
+		if (socketDelegate != NULL)
+		{
+			socketDelegate->onReceiveFinished(socket);
+		}
+	}
+
+	void WebSocketServer::onReceiveFailed(TcpSocket* socket)
+	{
+		TcpSocketDelegate* socketDelegate = this->_getSocketDelegate(socket);
+		if (socketDelegate != NULL)
+		{
+			socketDelegate->onReceiveFailed(socket);
+		}
+	}
+
+	void WebSocketServer::onSendFinished(Socket* socket)
+	{
+		TcpSocketDelegate* socketDelegate = this->_getSocketDelegate(socket);
+		if (socketDelegate != NULL)
+		{
+			socketDelegate->onSendFinished(socket);
+		}
+	}
+
+	void WebSocketServer::onSendFailed(Socket* socket)
+	{
+		TcpSocketDelegate* socketDelegate = this->_getSocketDelegate(socket);
+		if (socketDelegate != NULL)
+		{
+			socketDelegate->onSendFailed(socket);
+		}
+	}
+
+	TcpSocketDelegate* WebSocketServer::_getSocketDelegate(Socket* socket)
+	{
+		return this->socketWebSockets.tryGet(socket, NULL);
+	}
+
+	void WebSocketServer::_removeClosedWebSockets()
+	{
+		harray<WebSocket*> webSockets = this->webSockets;
+		foreach (WebSocket*, it, webSockets)
+		{
+			if ((*it)->state == State::Idle)
+			{
+				this->webSockets.remove(*it);
+				this->socketWebSockets.removeKey((*it)->socket);
+				delete (*it);
+			}
+		}
+	}
+
+}
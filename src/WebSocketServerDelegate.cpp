@@ -0,0 +1,22 @@
+/// @file
+/// @version 1.2
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include "WebSocketServerDelegate.h"
+
+namespace sakit
+{
+	WebSocketServerDelegate::WebSocketServerDelegate() :
+		TcpServerDelegate()
+	{
+	}
+
+	void WebSocketServerDelegate::onOpened(WebSocketServer* server, WebSocket* webSocket)
+	{
+	}
+
+}
@@ -6,12 +6,15 @@
 /// This program is free software; you can redistribute it and/or modify it under
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
+#include <atomic>
+
 #define __HL_INCLUDE_PLATFORM_HEADERS
 #include <hltypes/hlog.h>
 #include <hltypes/hmap.h>
 #include <hltypes/hplatform.h>
 #include <hltypes/hstring.h>
 
+#include "Metrics.h"
 #include "PlatformSocket.h"
 #include "sakit.h"
 #include "Socket.h"
@@ -29,6 +32,9 @@ namespace sakit
 	float timeout = 10.0f;
 	float retryFrequency = 0.01f;
 	int bufferSize = 65536;
+	// read by all receiver threads while the application may change them
+	std::atomic<int64_t> globalReceiveHighWatermark(0LL);
+	std::atomic<int64_t> globalReceiveLowWatermark(0LL);
 	harray<Base*> connections;
 	hmutex connectionsMutex;
 	hmutex updateMutex;
@@ -309,29 +315,6 @@ namespace sakit
 		{
 			reverseMapping[it->second] = hstr::fromUnicode(it->first);
 		}
-		// init states
-		State::allowedBindStates += State::Idle;
-		State::allowedUnbindStates += State::Bound;
-		State::allowedConnectStates += State::Idle;
-		State::allowedDisconnectStates += State::Connected;
-		State::allowedSendStatesBasic += State::Receiving;
-		State::allowedReceiveStatesBasic += State::Sending;
-		State::allowedStopReceiveStates += State::Receiving;
-		State::allowedStopReceiveStates += State::SendingReceiving;
-		State::allowedSetDestinationStates += State::Bound;
-		State::allowedJoinMulticastGroupStates += State::Bound;
-		State::allowedJoinMulticastGroupStates += State::Sending;
-		State::allowedJoinMulticastGroupStates += State::Receiving;
-		State::allowedJoinMulticastGroupStates += State::SendingReceiving;
-		State::allowedLeaveMulticastGroupStates += State::Bound;
-		State::allowedLeaveMulticastGroupStates += State::Sending;
-		State::allowedLeaveMulticastGroupStates += State::Receiving;
-		State::allowedLeaveMulticastGroupStates += State::SendingReceiving;
-		State::allowedServerStartStates += State::Bound;
-		State::allowedServerStopStates += State::Running;
-		State::allowedHttpExecuteStates += State::Idle;
-		State::allowedHttpExecuteStates += State::Connected;
-		State::allowedHttpAbortStates += State::Running;
 		// threading
 		if (threadedUpdate)
 		{
@@ -340,6 +323,11 @@ namespace sakit
 		}
 	}
 	
+	MetricsSnapshot getGlobalMetrics()
+	{
+		return Metrics::global.getSnapshot();
+	}
+
 	hstr getHostName()
 	{
 #ifdef _WIN32
@@ -421,6 +409,23 @@ namespace sakit
 		bufferSize = value;
 	}
 
+	int64_t getGlobalReceiveHighWatermark()
+	{
+		return globalReceiveHighWatermark.load(std::memory_order_relaxed);
+	}
+
+	int64_t getGlobalReceiveLowWatermark()
+	{
+		return globalReceiveLowWatermark.load(std::memory_order_relaxed);
+	}
+
+	void setGlobalReceiveWatermarks(int64_t high, int64_t low)
+	{
+		high = hmax(high, (int64_t)0);
+		globalReceiveHighWatermark.store(high, std::memory_order_relaxed);
+		globalReceiveLowWatermark.store(hclamp(low, (int64_t)0, high), std::memory_order_relaxed);
+	}
+
 	float getGlobalTimeout()
 	{
 		return timeout;
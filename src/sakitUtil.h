@@ -22,14 +22,15 @@
 
 namespace sakit
 {
-	inline bool _checkState(State current, const harray<State>& allowed, chstr action)
+	/// @param[in] allowed Bitmask of the allowed states.
+	inline bool _checkState(State current, unsigned int allowed, chstr action)
 	{
 		if (!sakit::isInitialized())
 		{
 			hlog::error(logTag, "SAKit is not initialized!");
 			return false;
 		}
-		if (allowed.has(current))
+		if ((current.getMask() & allowed) != 0)
 		{
 			return true;
 		}